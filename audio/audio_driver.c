@@ -43,6 +43,7 @@
 #include "../retroarch.h"
 #include "../verbosity.h"
 #include "../list_special.h"
+#include "../performance_counters.h"
 
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 
@@ -146,6 +147,9 @@ static int16_t *audio_driver_output_samples_conv_buf     = NULL;
 
 static unsigned audio_driver_free_samples_buf[AUDIO_BUFFER_FREE_SAMPLES_COUNT];
 static uint64_t audio_driver_free_samples_count          = 0;
+/* Times the driver buffer was found empty on write. */
+static uint64_t audio_driver_underrun_count              = 0;
+static struct retro_perf_counter audio_flush_perf;
 
 static size_t audio_driver_buffer_size                   = 0;
 static size_t audio_driver_data_ptr                      = 0;
@@ -155,6 +159,7 @@ static bool audio_driver_mixer_mute_enable               = false;
 static bool audio_driver_mute_enable                     = false;
 static bool audio_driver_use_float                       = false;
 static bool audio_driver_active                          = false;
+static bool audio_driver_discard_samples                 = false;
 static bool audio_driver_data_own                        = false;
 static bool audio_mixer_active                           = false;
 
@@ -234,6 +239,63 @@ static void compute_audio_buffer_statistics(void)
          (100.0 * high_water_count) / (samples - 1));
 }
 
+/* Amount of most recent samples the live buffer
+ * statistics are computed over. */
+#define AUDIO_BUFFER_STATS_WINDOW 1024
+
+/**
+ * audio_driver_get_buffer_stats:
+ * @stats              : Statistics to fill in.
+ *
+ * Computes audio buffer fill over the most recent writes,
+ * along with the amount of buffer underruns.
+ *
+ * Buffer fill is only sampled while audio rate control is
+ * active, since it relies on the driver's write_avail.
+ *
+ * Returns: true (1) if there were buffer fill samples,
+ * otherwise false (0).
+ **/
+bool audio_driver_get_buffer_stats(audio_buffer_stats_t *stats)
+{
+   unsigned i;
+   uint64_t accum     = 0;
+   unsigned max_avail = 0;
+   uint64_t count     = audio_driver_free_samples_count;
+   unsigned samples   = (unsigned)MIN(count, AUDIO_BUFFER_STATS_WINDOW);
+
+   if (!stats)
+      return false;
+
+   memset(stats, 0, sizeof(*stats));
+   stats->underruns = audio_driver_underrun_count;
+
+   if (samples == 0 || audio_driver_buffer_size == 0)
+      return false;
+
+   for (i = 0; i < samples; i++)
+   {
+      unsigned avail = audio_driver_free_samples_buf[
+         (count - 1 - i) & (AUDIO_BUFFER_FREE_SAMPLES_COUNT - 1)];
+
+      if (i == 0)
+         stats->fill_current = 100.0f -
+            (100.0f * avail) / audio_driver_buffer_size;
+
+      accum += avail;
+      if (avail > max_avail)
+         max_avail = avail;
+   }
+
+   stats->samples  = samples;
+   stats->fill_avg = 100.0f -
+      (100.0f * accum) / ((float)samples * audio_driver_buffer_size);
+   stats->fill_min = 100.0f -
+      (100.0f * max_avail) / audio_driver_buffer_size;
+
+   return true;
+}
+
 /**
  * audio_driver_find_handle:
  * @idx                : index of driver to get handle to.
@@ -486,6 +548,7 @@ static bool audio_driver_init_internal(bool audio_cb_inited)
    command_event(CMD_EVENT_DSP_FILTER_INIT, NULL);
 
    audio_driver_free_samples_count = 0;
+   audio_driver_underrun_count     = 0;
 
    audio_mixer_init(settings->uints.audio_out_rate);
 
@@ -558,6 +621,10 @@ static bool audio_driver_flush(const int16_t *data, size_t samples)
    if (!audio_driver_active || !audio_driver_input_data)
       return false;
 
+   FRAME_TRACE_BEGIN(FRAME_TRACE_AUDIO_FLUSH);
+   performance_counter_init(audio_flush_perf, "audio_flush");
+   performance_counter_start_plus(is_perfcnt_enable, audio_flush_perf);
+
    convert_s16_to_float(audio_driver_input_data, data, samples,
          audio_volume_gain);
 
@@ -607,6 +674,8 @@ static bool audio_driver_flush(const int16_t *data, size_t samples)
 
       audio_driver_free_samples_buf
          [write_idx]               = avail;
+      if (avail >= (int)audio_driver_buffer_size)
+         audio_driver_underrun_count++;
       audio_source_ratio_current   = 
          audio_source_ratio_original * adjust;
 
@@ -655,9 +724,13 @@ static bool audio_driver_flush(const int16_t *data, size_t samples)
             output_data, output_frames * 2) < 0)
    {
       audio_driver_active = false;
+      performance_counter_stop_plus(is_perfcnt_enable, audio_flush_perf);
+      FRAME_TRACE_END(FRAME_TRACE_AUDIO_FLUSH);
       return false;
    }
 
+   performance_counter_stop_plus(is_perfcnt_enable, audio_flush_perf);
+   FRAME_TRACE_END(FRAME_TRACE_AUDIO_FLUSH);
    return true;
 }
 
@@ -670,6 +743,9 @@ static bool audio_driver_flush(const int16_t *data, size_t samples)
  **/
 void audio_driver_sample(int16_t left, int16_t right)
 {
+   if (audio_driver_discard_samples)
+      return;
+
    audio_driver_output_samples_conv_buf[audio_driver_data_ptr++] = left;
    audio_driver_output_samples_conv_buf[audio_driver_data_ptr++] = right;
 
@@ -694,6 +770,9 @@ void audio_driver_sample(int16_t left, int16_t right)
  **/
 size_t audio_driver_sample_batch(const int16_t *data, size_t frames)
 {
+   if (audio_driver_discard_samples)
+      return frames;
+
    if (frames > (AUDIO_CHUNK_SIZE_NONBLOCKING >> 1))
       frames = AUDIO_CHUNK_SIZE_NONBLOCKING >> 1;
 
@@ -1251,6 +1330,13 @@ void audio_driver_set_active(void)
    audio_driver_active = true;
 }
 
+/* Samples the core hands over while set are dropped,
+ * e.g. those of the frames run-ahead rolls back. */
+void audio_driver_set_discard_samples(bool discard)
+{
+   audio_driver_discard_samples = discard;
+}
+
 void audio_driver_destroy(void)
 {
    audio_driver_active   = false;
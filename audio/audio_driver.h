@@ -153,6 +153,8 @@ void audio_driver_unset_own_driver(void);
 
 void audio_driver_set_active(void);
 
+void audio_driver_set_discard_samples(bool discard);
+
 void audio_driver_destroy(void);
 
 void audio_driver_deinit_resampler(void);
@@ -202,6 +204,16 @@ void audio_driver_sample_rewind(int16_t left, int16_t right);
 
 size_t audio_driver_sample_batch_rewind(const int16_t *data, size_t frames);
 
+typedef struct audio_buffer_stats
+{
+   /* Buffer fill, in percent of the driver buffer size. */
+   float fill_current;
+   float fill_avg;
+   float fill_min;
+   unsigned samples;
+   uint64_t underruns;
+} audio_buffer_stats_t;
+
 bool audio_driver_mixer_extension_supported(const char *ext);
 
 void audio_driver_dsp_filter_free(void);
@@ -216,6 +228,8 @@ void audio_driver_setup_rewind(void);
 
 void audio_driver_monitor_adjust_system_rates(void);
 
+bool audio_driver_get_buffer_stats(audio_buffer_stats_t *stats);
+
 bool audio_driver_set_callback(const void *data);
 
 bool audio_driver_callback(void);
@@ -221,6 +221,54 @@ typedef struct
    unsigned count;
 } cheevos_condition_t;
 
+enum
+{
+   CHEEVOS_PASS_LESS    = 1 << 0,
+   CHEEVOS_PASS_EQUAL   = 1 << 1,
+   CHEEVOS_PASS_GREATER = 1 << 2
+}; /* cheevos_insn_t.pass */
+
+/* A condition compiled for the per-frame test. The operands are slots
+ * in the program values, and pass holds the outcomes of comparing the
+ * source with the target that make the condition true. */
+typedef struct
+{
+   unsigned source;
+   unsigned target;
+   unsigned pass;
+   unsigned req_hits;
+   unsigned curr_hits;
+} cheevos_insn_t;
+
+/* A compiled condition set: its Pause If, standard and Reset If
+ * conditions, in that order, starting at first_insn. */
+typedef struct
+{
+   unsigned first_insn;
+   unsigned pause_count;
+   unsigned standard_count;
+   unsigned reset_count;
+} cheevos_insn_set_t;
+
+typedef struct
+{
+   cheevos_insn_t     *insns;
+   cheevos_insn_set_t *sets;
+
+   /* Host addresses of the memory read each frame: bytes (shifted and
+    * masked for bits and nibbles), then 16-bit and 32-bit values. */
+   const uint8_t **memory;
+   uint8_t        *shifts;
+   uint8_t        *masks;
+   unsigned        byte_count;
+   unsigned        word_count;
+   unsigned        dword_count;
+
+   /* The values of that memory on this frame and on the previous one,
+    * followed by the constants. */
+   unsigned       *values;
+} cheevos_program_t;
+
 typedef struct
 {
    unsigned    id;
@@ -233,6 +281,7 @@ typedef struct
    int         active;
    int         last;
    int         modified;
+   unsigned    first_set; /* in the compiled program */
 
    cheevos_condition_t condition;
 } cheevo_t;
@@ -330,6 +379,7 @@ typedef struct
 
    cheevoset_t core;
    cheevoset_t unofficial;
+   cheevos_program_t program;
    cheevos_leaderboard_t *leaderboards;
    unsigned lboard_count;
 
@@ -347,6 +397,7 @@ static cheevos_locals_t cheevos_locals =
    /* add_hits            */ 0,
    /* core                */ {NULL, 0},
    /* unofficial          */ {NULL, 0},
+   /* program             */ {NULL, NULL, NULL, NULL, NULL, 0, 0, 0, NULL},
    /* leaderboards        */ NULL,
    /* lboard_count        */ 0,
    /* token               */ {0},
@@ -1364,8 +1415,7 @@ static int cheevos_parse_condition(cheevos_condition_t *condition, const char* m
    return 0;
 }
 
-#ifdef CHEEVOS_ENABLE_LBOARDS
-static void cheevos_free_condition(cheevos_condition_t* condition)
+static void cheevos_free_condition(const cheevos_condition_t* condition)
 {
    unsigned i;
 
@@ -1377,7 +1427,6 @@ static void cheevos_free_condition(cheevos_condition_t* condition)
       free((void*)condition->condsets);
    }
 }
-#endif
 
 /*****************************************************************************
 Parse the Mem field of leaderboards.
@@ -1789,6 +1838,362 @@ uint8_t *cheevos_get_memory(const cheevos_var_t *var)
    return memory;
 }
 
+enum
+{
+   CHEEVOS_OPERAND_BYTE = 0,
+   CHEEVOS_OPERAND_WORD,
+   CHEEVOS_OPERAND_DWORD,
+   CHEEVOS_OPERAND_CONST
+};
+
+/* An operand of a condition being compiled, and where its slot goes. */
+typedef struct
+{
+   unsigned       kind;
+   const uint8_t *memory;
+   unsigned       shift;
+   unsigned       mask; /* or the constant */
+   int            delta;
+   unsigned      *slot;
+} cheevos_operand_t;
+
+/* What unmapped addresses read. */
+static const uint8_t cheevos_unmapped[4] = {0};
+
+static void cheevos_free_program(cheevos_program_t *program)
+{
+   free(program->insns);
+   free(program->sets);
+   free((void*)program->memory);
+   free(program->shifts);
+   free(program->masks);
+   free(program->values);
+
+   memset(program, 0, sizeof(*program));
+}
+
+static void cheevos_add_operand(cheevos_operand_t *operand,
+      const cheevos_var_t *var, unsigned *slot)
+{
+   operand->kind   = CHEEVOS_OPERAND_CONST;
+   operand->memory = NULL;
+   operand->shift  = 0;
+   operand->mask   = 0;
+   operand->delta  = 0;
+   operand->slot   = slot;
+
+   switch (var->type)
+   {
+      case CHEEVOS_VAR_TYPE_VALUE_COMP:
+         operand->mask = var->value;
+         return;
+      case CHEEVOS_VAR_TYPE_ADDRESS:
+      case CHEEVOS_VAR_TYPE_DELTA_MEM:
+         break;
+      default:
+         return;
+   }
+
+   operand->kind   = CHEEVOS_OPERAND_BYTE;
+   operand->memory = cheevos_get_memory(var);
+   operand->mask   = 0xff;
+   operand->delta  = var->type == CHEEVOS_VAR_TYPE_DELTA_MEM;
+
+   if (!operand->memory)
+      operand->memory = cheevos_unmapped;
+
+   switch (var->size)
+   {
+      case CHEEVOS_VAR_SIZE_BIT_0:
+      case CHEEVOS_VAR_SIZE_BIT_1:
+      case CHEEVOS_VAR_SIZE_BIT_2:
+      case CHEEVOS_VAR_SIZE_BIT_3:
+      case CHEEVOS_VAR_SIZE_BIT_4:
+      case CHEEVOS_VAR_SIZE_BIT_5:
+      case CHEEVOS_VAR_SIZE_BIT_6:
+      case CHEEVOS_VAR_SIZE_BIT_7:
+         operand->shift = var->size - CHEEVOS_VAR_SIZE_BIT_0;
+         operand->mask  = 1;
+         break;
+      case CHEEVOS_VAR_SIZE_NIBBLE_LOWER:
+         operand->mask  = 0x0f;
+         break;
+      case CHEEVOS_VAR_SIZE_NIBBLE_UPPER:
+         operand->shift = 4;
+         operand->mask  = 0x0f;
+         break;
+      case CHEEVOS_VAR_SIZE_SIXTEEN_BITS:
+         operand->kind  = CHEEVOS_OPERAND_WORD;
+         break;
+      case CHEEVOS_VAR_SIZE_THIRTYTWO_BITS:
+         operand->kind  = CHEEVOS_OPERAND_DWORD;
+         break;
+      default:
+         break;
+   }
+}
+
+static int cheevos_cmp_operand(const void *a, const void *b)
+{
+   const cheevos_operand_t *x = (const cheevos_operand_t*)a;
+   const cheevos_operand_t *y = (const cheevos_operand_t*)b;
+
+   if (x->kind != y->kind)
+      return x->kind < y->kind ? -1 : 1;
+
+   if (x->memory != y->memory)
+      return (uintptr_t)x->memory < (uintptr_t)y->memory ? -1 : 1;
+
+   if (x->shift != y->shift)
+      return x->shift < y->shift ? -1 : 1;
+
+   if (x->mask != y->mask)
+      return x->mask < y->mask ? -1 : 1;
+
+   return 0;
+}
+
+static INLINE int cheevos_same_operand(const cheevos_operand_t *a,
+      const cheevos_operand_t *b)
+{
+   return a->kind == b->kind && a->memory == b->memory
+      && a->shift == b->shift && a->mask == b->mask;
+}
+
+/**
+ * cheevos_compile:
+ * @program              : the program to build.
+ *
+ * Compiles the conditions of all achievements into a program. Each
+ * condition becomes an instruction, grouped by set and type; the memory
+ * they read is resolved to host addresses once, deduplicated and sorted
+ * by size and address so it can be read in one pass per frame.
+ * Must be called after the addresses have been patched.
+ *
+ * Returns: 0 on success, -1 on failure.
+ **/
+static int cheevos_compile(cheevos_program_t *program)
+{
+   static const unsigned types[] =
+   {
+      CHEEVOS_COND_TYPE_PAUSE_IF,
+      CHEEVOS_COND_TYPE_STANDARD,
+      CHEEVOS_COND_TYPE_RESET_IF
+   };
+   static const unsigned passes[CHEEVOS_COND_OP_LAST] =
+   {
+      /* EQUALS                */ CHEEVOS_PASS_EQUAL,
+      /* LESS_THAN             */ CHEEVOS_PASS_LESS,
+      /* LESS_THAN_OR_EQUAL    */ CHEEVOS_PASS_LESS | CHEEVOS_PASS_EQUAL,
+      /* GREATER_THAN          */ CHEEVOS_PASS_GREATER,
+      /* GREATER_THAN_OR_EQUAL */ CHEEVOS_PASS_GREATER | CHEEVOS_PASS_EQUAL,
+      /* NOT_EQUAL_TO          */ CHEEVOS_PASS_LESS | CHEEVOS_PASS_GREATER
+   };
+   cheevoset_t *cheevosets[2];
+   unsigned i, j, k, t;
+   unsigned insn_count         = 0;
+   unsigned set_count          = 0;
+   unsigned memory_count       = 0;
+   unsigned const_count        = 0;
+   unsigned memory_index       = 0;
+   unsigned const_index        = 0;
+   cheevos_insn_t *insn        = NULL;
+   cheevos_insn_set_t *set     = NULL;
+   cheevos_operand_t *operands = NULL;
+   cheevos_operand_t *operand  = NULL;
+   cheevos_operand_t *end      = NULL;
+
+   cheevos_free_program(program);
+
+   cheevosets[0] = &cheevos_locals.core;
+   cheevosets[1] = &cheevos_locals.unofficial;
+
+   for (i = 0; i < ARRAY_SIZE(cheevosets); i++)
+   {
+      for (j = 0; j < cheevosets[i]->count; j++)
+      {
+         const cheevos_condition_t *condition = &cheevosets[i]->cheevos[j].condition;
+
+         set_count += condition->count;
+
+         for (k = 0; k < condition->count; k++)
+         {
+            const cheevos_condset_t *condset = &condition->condsets[k];
+            const cheevos_cond_t *cond       = condset->conds;
+            const cheevos_cond_t *cond_end   = cond + condset->count;
+
+            for (; cond < cond_end; cond++)
+            {
+               if (     cond->type == CHEEVOS_COND_TYPE_STANDARD
+                     || cond->type == CHEEVOS_COND_TYPE_PAUSE_IF
+                     || cond->type == CHEEVOS_COND_TYPE_RESET_IF)
+                  insn_count++;
+            }
+         }
+      }
+   }
+
+   program->insns = (cheevos_insn_t*)calloc(insn_count + 1, sizeof(cheevos_insn_t));
+   program->sets  = (cheevos_insn_set_t*)calloc(set_count + 1, sizeof(cheevos_insn_set_t));
+   operands       = (cheevos_operand_t*)malloc((insn_count * 2 + 1) * sizeof(cheevos_operand_t));
+
+   if (!program->insns || !program->sets || !operands)
+      goto error;
+
+   insn    = program->insns;
+   set     = program->sets;
+   operand = operands;
+
+   for (i = 0; i < ARRAY_SIZE(cheevosets); i++)
+   {
+      for (j = 0; j < cheevosets[i]->count; j++)
+      {
+         cheevo_t *cheevo = &cheevosets[i]->cheevos[j];
+
+         cheevo->first_set = (unsigned)(set - program->sets);
+
+         for (k = 0; k < cheevo->condition.count; k++, set++)
+         {
+            const cheevos_condset_t *condset = &cheevo->condition.condsets[k];
+
+            set->first_insn = (unsigned)(insn - program->insns);
+
+            for (t = 0; t < ARRAY_SIZE(types); t++)
+            {
+               const cheevos_cond_t *cond     = condset->conds;
+               const cheevos_cond_t *cond_end = cond + condset->count;
+               unsigned count                 = 0;
+
+               for (; cond < cond_end; cond++)
+               {
+                  if (cond->type != types[t])
+                     continue;
+
+                  insn->pass      = cond->op < CHEEVOS_COND_OP_LAST ? passes[cond->op] : 0;
+                  insn->req_hits  = cond->req_hits;
+                  insn->curr_hits = 0;
+                  cheevos_add_operand(operand++, &cond->source, &insn->source);
+                  cheevos_add_operand(operand++, &cond->target, &insn->target);
+                  insn++;
+                  count++;
+               }
+
+               switch (types[t])
+               {
+                  case CHEEVOS_COND_TYPE_PAUSE_IF:
+                     set->pause_count = count;
+                     break;
+                  case CHEEVOS_COND_TYPE_STANDARD:
+                     set->standard_count = count;
+                     break;
+                  case CHEEVOS_COND_TYPE_RESET_IF:
+                     set->reset_count = count;
+                     break;
+               }
+            }
+         }
+      }
+   }
+
+   /* Give each distinct operand a slot, memory first. */
+   end = operand;
+   qsort(operands, end - operands, sizeof(*operands), cheevos_cmp_operand);
+
+   for (operand = operands; operand < end; operand++)
+   {
+      if (operand > operands && cheevos_same_operand(operand, operand - 1))
+         continue;
+
+      switch (operand->kind)
+      {
+         case CHEEVOS_OPERAND_BYTE:
+            program->byte_count++;
+            break;
+         case CHEEVOS_OPERAND_WORD:
+            program->word_count++;
+            break;
+         case CHEEVOS_OPERAND_DWORD:
+            program->dword_count++;
+            break;
+         default:
+            const_count++;
+            break;
+      }
+   }
+
+   memory_count     = program->byte_count + program->word_count + program->dword_count;
+   program->memory  = (const uint8_t**)malloc((memory_count + 1) * sizeof(uint8_t*));
+   program->shifts  = (uint8_t*)malloc(program->byte_count + 1);
+   program->masks   = (uint8_t*)malloc(program->byte_count + 1);
+   program->values  = (unsigned*)calloc(memory_count * 2 + const_count + 1, sizeof(unsigned));
+
+   if (!program->memory || !program->shifts || !program->masks || !program->values)
+      goto error;
+
+   for (operand = operands; operand < end; operand++)
+   {
+      if (operand > operands && !cheevos_same_operand(operand, operand - 1))
+      {
+         if (operand[-1].kind == CHEEVOS_OPERAND_CONST)
+            const_index++;
+         else
+            memory_index++;
+      }
+
+      if (operand->kind == CHEEVOS_OPERAND_CONST)
+      {
+         program->values[memory_count * 2 + const_index] = operand->mask;
+         *operand->slot = memory_count * 2 + const_index;
+         continue;
+      }
+
+      program->memory[memory_index] = operand->memory;
+
+      if (operand->kind == CHEEVOS_OPERAND_BYTE)
+      {
+         program->shifts[memory_index] = operand->shift;
+         program->masks[memory_index]  = operand->mask;
+      }
+
+      *operand->slot = operand->delta ? memory_count + memory_index : memory_index;
+   }
+
+   free(operands);
+
+   RARCH_LOG("CHEEVOS compiled %u conditions reading %u memory addresses.\n",
+         insn_count, memory_count);
+   return 0;
+
+error:
+   free(operands);
+   cheevos_free_program(program);
+   return -1;
+}
+
+/* Keeps the previous values of the memory the program reads for the
+ * deltas, and reads the current ones. */
+static void cheevos_read_memory(cheevos_program_t *program)
+{
+   unsigned i;
+   const uint8_t **memory = program->memory;
+   unsigned *values       = program->values;
+   unsigned words         = program->byte_count + program->word_count;
+   unsigned count         = words + program->dword_count;
+
+   memcpy(values + count, values, count * sizeof(*values));
+
+   for (i = 0; i < program->byte_count; i++)
+      values[i] = (memory[i][0] >> program->shifts[i]) & program->masks[i];
+
+   for (; i < words; i++)
+      values[i] = memory[i][0] | memory[i][1] << 8;
+
+   for (; i < count; i++)
+      values[i] = memory[i][0] | memory[i][1] << 8 | memory[i][2] << 16
+         | (unsigned)memory[i][3] << 24;
+}
+
+#ifdef CHEEVOS_ENABLE_LBOARDS
 static unsigned cheevos_get_var_value(cheevos_var_t *var)
 {
    if (var->type == CHEEVOS_VAR_TYPE_VALUE_COMP)
@@ -2028,27 +2433,95 @@ static int cheevos_reset_cond_set(cheevos_condset_t *condset, int deltas)
 
    return dirty;
 }
+#endif
 
-static int cheevos_test_cheevo(cheevo_t *cheevo)
+static INLINE int cheevos_test_insn(const cheevos_insn_t *insn,
+      const unsigned *values)
 {
-   int dirty;
-   int dirty_conds              = 0;
-   int reset_conds              = 0;
-   int ret_val                  = 0;
-   int ret_val_sub_cond         = cheevo->condition.count == 1;
-   cheevos_condset_t *condset   = cheevo->condition.condsets;
-   const cheevos_condset_t *end = condset + cheevo->condition.count;
+   unsigned sval = values[insn->source];
+   unsigned tval = values[insn->target];
 
-   if (condset < end)
+   return (insn->pass >> ((sval >= tval) + (sval > tval))) & 1;
+}
+
+static int cheevos_test_insn_set(const cheevos_insn_set_t *set,
+      int *dirty_conds, int *reset_conds)
+{
+   const unsigned *values    = cheevos_locals.program.values;
+   cheevos_insn_t *insn      = cheevos_locals.program.insns + set->first_insn;
+   const cheevos_insn_t *end = insn + set->pause_count;
+   int set_valid             = 1;
+
+   /* If any Pause condition is true, do not process further
+    * (retain old state). */
+   for (; insn < end; insn++)
    {
-      ret_val = cheevos_test_cond_set(condset, &dirty_conds, &reset_conds, 0);
-      condset++;
+      /* Reset by default, set to 1 if hit! */
+      insn->curr_hits = 0;
+
+      if (cheevos_test_insn(insn, values))
+      {
+         insn->curr_hits = 1;
+         *dirty_conds    = 1;
+         return 0;
+      }
    }
 
-   while (condset < end)
+   /* Standard conditions. */
+   for (end += set->standard_count; insn < end; insn++)
    {
-      ret_val_sub_cond |= cheevos_test_cond_set(condset, &dirty_conds, &reset_conds, 0);
-      condset++;
+      int cond_valid;
+
+      if (insn->req_hits != 0 && insn->curr_hits >= insn->req_hits)
+         continue;
+
+      cond_valid = cheevos_test_insn(insn, values);
+
+      if (cond_valid)
+      {
+         insn->curr_hits++;
+         *dirty_conds = 1;
+
+         /* Not entirely valid yet if it needs more hits. */
+         if (insn->req_hits != 0 && insn->curr_hits < insn->req_hits)
+            cond_valid = 0;
+      }
+
+      set_valid &= cond_valid;
+   }
+
+   /* Reset conditions: the first true one resets all hits. */
+   for (end += set->reset_count; insn < end; insn++)
+   {
+      if (cheevos_test_insn(insn, values))
+      {
+         *reset_conds = 1;
+         return 0;
+      }
+   }
+
+   return set_valid;
+}
+
+static int cheevos_test_cheevo(cheevo_t *cheevo)
+{
+   int dirty_conds               = 0;
+   int reset_conds               = 0;
+   int ret_val                   = 0;
+   int ret_val_sub_cond          = cheevo->condition.count == 1;
+   const cheevos_insn_set_t *set = cheevos_locals.program.sets + cheevo->first_set;
+   const cheevos_insn_set_t *end = set + cheevo->condition.count;
+
+   if (set < end)
+   {
+      ret_val = cheevos_test_insn_set(set, &dirty_conds, &reset_conds);
+      set++;
+   }
+
+   while (set < end)
+   {
+      ret_val_sub_cond |= cheevos_test_insn_set(set, &dirty_conds, &reset_conds);
+      set++;
    }
 
    if (dirty_conds)
@@ -2056,10 +2529,20 @@ static int cheevos_test_cheevo(cheevo_t *cheevo)
 
    if (reset_conds)
    {
-      dirty = 0;
-
-      for (condset = cheevo->condition.condsets; condset < end; condset++)
-         dirty |= cheevos_reset_cond_set(condset, 0);
+      /* The sets of an achievement are contiguous in the program. */
+      const cheevos_insn_set_t *last = end - 1;
+      cheevos_insn_t *insn           = cheevos_locals.program.insns
+         + cheevos_locals.program.sets[cheevo->first_set].first_insn;
+      const cheevos_insn_t *insn_end = cheevos_locals.program.insns
+         + last->first_insn + last->pause_count
+         + last->standard_count + last->reset_count;
+      int dirty                      = 0;
+
+      for (; insn < insn_end; insn++)
+      {
+         dirty |= insn->curr_hits != 0;
+         insn->curr_hits = 0;
+      }
 
       if (dirty)
          cheevo->dirty |= CHEEVOS_DIRTY_CONDITIONS;
@@ -2347,18 +2830,13 @@ static void cheevos_test_leaderboards(void)
 Free the loaded achievements.
 *****************************************************************************/
 
-static void cheevos_free_condset(const cheevos_condset_t *set)
-{
-   free((void*)set->conds);
-}
-
 static void cheevos_free_cheevo(const cheevo_t *cheevo)
 {
    free((void*)cheevo->title);
    free((void*)cheevo->description);
    free((void*)cheevo->author);
    free((void*)cheevo->badge);
-   cheevos_free_condset(cheevo->condition.condsets);
+   cheevos_free_condition(&cheevo->condition);
 }
 
 static void cheevos_free_cheevo_set(const cheevoset_t *set)
@@ -2618,6 +3096,8 @@ bool cheevos_unload(void)
    cheevos_locals.unofficial.cheevos = NULL;
    cheevos_locals.unofficial.count = 0;
 
+   cheevos_free_program(&cheevos_locals.program);
+
    cheevos_loaded = 0;
 
    return true;
@@ -2704,13 +3184,20 @@ void cheevos_test(void)
       cheevos_patch_addresses(&cheevos_locals.core);
       cheevos_patch_addresses(&cheevos_locals.unofficial);
 
+      if (cheevos_compile(&cheevos_locals.program))
+         RARCH_ERR("CHEEVOS error compiling the achievement conditions.\n");
+
       cheevos_locals.addrs_patched = true;
    }
 
-   cheevos_test_cheevo_set(&cheevos_locals.core);
+   if (cheevos_locals.program.values)
+   {
+      cheevos_read_memory(&cheevos_locals.program);
+      cheevos_test_cheevo_set(&cheevos_locals.core);
 
-   if (settings->bools.cheevos_test_unofficial)
-      cheevos_test_cheevo_set(&cheevos_locals.unofficial);
+      if (settings->bools.cheevos_test_unofficial)
+         cheevos_test_cheevo_set(&cheevos_locals.unofficial);
+   }
 
 #ifdef CHEEVOS_ENABLE_LBOARDS
    cheevos_test_leaderboards();
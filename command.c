@@ -61,6 +61,7 @@
 #include "input/input_config.h"
 #include "frontend/frontend_driver.h"
 #include "audio/audio_driver.h"
+#include "gfx/video_driver.h"
 #include "record/record_driver.h"
 #include "file_path_special.h"
 #include "autosave.h"
@@ -122,7 +123,6 @@ static struct sockaddr_storage lastcmd_net_source;
 static socklen_t lastcmd_net_source_len;
 #endif
 
-#ifdef HAVE_CHEEVOS
 #if defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING)
 static bool command_reply(const char * data, size_t len)
 {
@@ -144,7 +144,6 @@ static bool command_reply(const char * data, size_t len)
    return false;
 }
 #endif
-#endif
 
 struct cmd_map
 {
@@ -255,12 +254,77 @@ static bool command_write_ram(const char *arg)
 }
 #endif
 
+#if defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING)
+static bool command_get_stats(const char *arg)
+{
+   char reply[512];
+   video_frame_time_stats_t video_stats;
+   audio_buffer_stats_t audio_stats;
+   record_stats_t record_stats;
+   bool recording = false;
+   int len        = 0;
+
+   (void)arg;
+
+   video_driver_get_frame_time_stats(&video_stats);
+   audio_driver_get_buffer_stats(&audio_stats);
+   recording = recording_driver_get_stats(&record_stats);
+
+   len = snprintf(reply, sizeof(reply),
+         "GET_STATS"
+         " frame_time_p50=%u frame_time_p95=%u frame_time_p99=%u"
+         " frame_time_samples=%u frames=%llu dropped_frames=%llu"
+         " audio_fill=%.1f audio_fill_avg=%.1f audio_fill_min=%.1f"
+         " audio_samples=%u audio_underruns=%llu"
+         " recording=%d record_dropped=%u"
+         " record_scale_queue=%u record_scale_queue_max=%u"
+         " record_encode_queue=%u record_encode_queue_max=%u\n",
+         (unsigned)video_stats.p50,
+         (unsigned)video_stats.p95,
+         (unsigned)video_stats.p99,
+         video_stats.samples,
+         (unsigned long long)video_stats.frames,
+         (unsigned long long)video_stats.dropped,
+         audio_stats.fill_current,
+         audio_stats.fill_avg,
+         audio_stats.fill_min,
+         audio_stats.samples,
+         (unsigned long long)audio_stats.underruns,
+         recording ? 1 : 0,
+         record_stats.frames_dropped,
+         record_stats.scale_queue_depth,
+         record_stats.scale_queue_max,
+         record_stats.encode_queue_depth,
+         record_stats.encode_queue_max);
+
+   if (len < 0)
+      return false;
+   if ((size_t)len >= sizeof(reply))
+      len = sizeof(reply) - 1;
+
+   return command_reply(reply, len);
+}
+#endif
+
+#ifdef HAVE_FRAME_TRACE
+static bool command_frame_trace_dump(const char *arg)
+{
+   return frame_trace_dump(arg);
+}
+#endif
+
 static const struct cmd_action_map action_map[] = {
    { "SET_SHADER", command_set_shader, "<shader path>" },
 #ifdef HAVE_CHEEVOS
    { "READ_CORE_RAM", command_read_ram, "<address> <number of bytes>" },
    { "WRITE_CORE_RAM", command_write_ram, "<address> <byte1> <byte2> ..." },
 #endif
+#ifdef HAVE_FRAME_TRACE
+   { "FRAME_TRACE_DUMP", command_frame_trace_dump, "<trace path>" },
+#endif
+#if defined(HAVE_STDIN_CMD) || defined(HAVE_NETWORK_CMD) && defined(HAVE_NETWORKING)
+   { "GET_STATS", command_get_stats, NULL },
+#endif
 };
 
 static const struct cmd_map map[] = {
@@ -331,11 +395,21 @@ static bool command_get_arg(const char *tok,
       if (str == tok)
       {
          const char *argument = str + strlen(action_map[i].str);
-         if (*argument != ' ')
+
+         /* Actions without an argument description
+          * are queries which take no argument. */
+         if (!action_map[i].arg_desc)
+         {
+            if (*argument != '\0')
+               return false;
+         }
+         else if (*argument != ' ')
             return false;
+         else
+            argument++;
 
          if (arg)
-            *arg = argument + 1;
+            *arg = argument;
 
          if (index)
             *index = i;
@@ -433,7 +507,8 @@ static bool command_verify(const char *cmd)
       RARCH_ERR("\t\t%s\n", map[i].str);
 
    for (i = 0; i < sizeof(action_map) / sizeof(action_map[0]); i++)
-      RARCH_ERR("\t\t%s %s\n", action_map[i].str, action_map[i].arg_desc);
+      RARCH_ERR("\t\t%s %s\n", action_map[i].str,
+            action_map[i].arg_desc ? action_map[i].arg_desc : "");
 
    return false;
 }
@@ -1045,6 +1120,7 @@ static void command_event_deinit_core(bool reinit)
    cheevos_unload();
 #endif
 
+   core_run_ahead_deinit();
    core_unload_game();
    core_unload();
    core_uninit_symbols();
@@ -2583,6 +2659,13 @@ TODO: Add a setting for these tweaks */
          break;
       case CMD_EVENT_PERFCNT_REPORT_FRONTEND_LOG:
          rarch_perf_log();
+#ifdef HAVE_FRAME_TRACE
+         {
+            settings_t *settings = config_get_ptr();
+            if (!string_is_empty(settings->paths.path_frame_trace))
+               frame_trace_dump(settings->paths.path_frame_trace);
+         }
+#endif
          break;
       case CMD_EVENT_VOLUME_UP:
          command_event_set_volume(0.5f);
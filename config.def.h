@@ -141,6 +141,19 @@ static const unsigned hard_sync_frames = 0;
  */
 static const unsigned frame_delay = 0;
 
+/* Picks the frame delay automatically from the measured frame time
+ * of the core, backing off when a frame runs late.
+ * Overrides frame_delay.
+ */
+static const bool frame_delay_auto = false;
+
+/* Runs the core ahead by this many frames and rolls it back with
+ * a savestate every frame, hiding the core's own input lag.
+ * Costs roughly one extra core run per frame.
+ */
+static const bool run_ahead_enabled = false;
+static const unsigned run_ahead_frames = 1;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated
  * ghosting. video_refresh_rate should still be configured as if it
@@ -511,6 +524,10 @@ static const bool savestate_auto_load = false;
 
 static const bool savestate_thumbnail_enable = false;
 
+/* Compresses savestates written to disk. Compressed and
+ * uncompressed savestates can both be loaded either way. */
+static const bool savestate_file_compression = false;
+
 /* Slowmotion ratio. */
 static const float slowmotion_ratio = 3.0;
 
@@ -578,6 +595,10 @@ static const unsigned input_bind_timeout = 5;
 
 static const unsigned menu_thumbnails_default = 3;
 
+/* Size of the thumbnail texture cache, in megabytes.
+ * 0 disables caching and prefetching. */
+static const unsigned menu_thumbnail_cache_size = 64;
+
 #ifdef IOS
 static const bool ui_companion_start_on_boot = false;
 #else
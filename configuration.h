@@ -52,6 +52,8 @@ typedef struct settings
       bool video_windowed_fullscreen;
       bool video_vsync;
       bool video_hard_sync;
+      bool video_frame_delay_auto;
+      bool run_ahead_enabled;
       bool video_black_frame_insertion;
 #ifdef GEKKO
       bool video_vfilter;
@@ -195,6 +197,7 @@ typedef struct settings
       bool savestate_auto_save;
       bool savestate_auto_load;
       bool savestate_thumbnail_enable;
+      bool savestate_file_compression;
       bool network_cmd_enable;
       bool stdin_cmd_enable;
       bool network_remote_enable;
@@ -309,6 +312,7 @@ typedef struct settings
       unsigned video_swap_interval;
       unsigned video_hard_sync_frames;
       unsigned video_frame_delay;
+      unsigned run_ahead_frames;
 #ifdef GEKKO
       unsigned video_viwidth;
 #endif
@@ -316,6 +320,7 @@ typedef struct settings
       unsigned video_rotation;
 
       unsigned menu_thumbnails;
+      unsigned menu_thumbnail_cache_size;
       unsigned menu_dpi_override_value;
       unsigned menu_entry_normal_color;
       unsigned menu_entry_hover_color;
@@ -380,6 +385,7 @@ typedef struct settings
       char path_menu_wallpaper[PATH_MAX_LENGTH];
       char path_audio_dsp_plugin[PATH_MAX_LENGTH];
       char path_softfilter_plugin[PATH_MAX_LENGTH];
+      char path_frame_trace[PATH_MAX_LENGTH];
       char path_core_options[PATH_MAX_LENGTH];
       char path_content_history[PATH_MAX_LENGTH];
       char path_content_music_history[PATH_MAX_LENGTH];
@@ -170,6 +170,10 @@ bool core_set_poll_type(unsigned *type);
 /* Runs the core for one frame. */
 bool core_run(void);
 
+bool core_run_ahead(unsigned frames, bool perfcnt);
+
+void core_run_ahead_deinit(void);
+
 bool core_init(void);
 
 bool core_deinit(void *data);
@@ -25,6 +25,7 @@
 #include <boolean.h>
 #include <lists/string_list.h>
 #include <string/stdstring.h>
+#include <features/features_cpu.h>
 #include <libretro.h>
 
 #ifdef HAVE_CONFIG_H
@@ -41,12 +42,27 @@
 #include "msg_hash.h"
 #include "managers/state_manager.h"
 #include "verbosity.h"
+#include "performance_counters.h"
 #include "gfx/video_driver.h"
 #include "audio/audio_driver.h"
+#include "retroarch.h"
 
 struct                     retro_callbacks retro_ctx;
 struct                     retro_core_t current_core;
 
+/* Savestate the core is rolled back to after running ahead. */
+static void *runahead_state                = NULL;
+static size_t runahead_state_size          = 0;
+/* Cleared once the core fails to serialize, until it is unloaded. */
+static bool runahead_available             = true;
+static retro_time_t runahead_time          = 0;
+static uint64_t runahead_frames            = 0;
+static struct retro_perf_counter runahead_perf;
+#ifdef HAVE_NETWORKING
+static struct retro_perf_counter netplay_pre_frame_perf;
+static struct retro_perf_counter netplay_post_frame_perf;
+#endif
+
 static void retro_run_null(void)
 {
 }
@@ -390,7 +406,15 @@ bool core_unload_game(void)
 bool core_run(void)
 {
 #ifdef HAVE_NETWORKING
-   if (!netplay_driver_ctl(RARCH_NETPLAY_CTL_PRE_FRAME, NULL))
+   bool perfcnt = rarch_ctl(RARCH_CTL_IS_PERFCNT_ENABLE, NULL);
+   bool running = false;
+
+   performance_counter_init(netplay_pre_frame_perf, "netplay_pre_frame");
+   performance_counter_start_plus(perfcnt, netplay_pre_frame_perf);
+   running = netplay_driver_ctl(RARCH_NETPLAY_CTL_PRE_FRAME, NULL);
+   performance_counter_stop_plus(perfcnt, netplay_pre_frame_perf);
+
+   if (!running)
    {
       /* Paused due to netplay. We must poll and display something so that a
        * netplay peer pausing doesn't just hang. */
@@ -418,12 +442,155 @@ bool core_run(void)
       input_poll();
 
 #ifdef HAVE_NETWORKING
+   performance_counter_init(netplay_post_frame_perf, "netplay_post_frame");
+   performance_counter_start_plus(perfcnt, netplay_post_frame_perf);
    netplay_driver_ctl(RARCH_NETPLAY_CTL_POST_FRAME, NULL);
+   performance_counter_stop_plus(perfcnt, netplay_post_frame_perf);
+#endif
+
+   return true;
+}
+
+/* Mutes the video and/or audio output of the core. The core's
+ * callbacks stay as they are, the drivers drop what they get. */
+static void core_run_ahead_mute(bool video, bool audio)
+{
+   video_driver_set_discard_frames(video);
+   audio_driver_set_discard_samples(audio);
+}
+
+static void core_run_ahead_disable(const char *reason)
+{
+   RARCH_WARN("[Run-ahead]: %s, disabling run-ahead for this core.\n",
+         reason);
+   runahead_available = false;
+}
+
+/**
+ * core_run_ahead:
+ * @frames         : Number of frames to run ahead.
+ * @perfcnt        : Update the run-ahead performance counter.
+ *
+ * Runs the core for one frame like core_run(), but only outputs
+ * its audio. The core state is then saved, @frames more frames are
+ * run with the same input and without audio, the video of the last
+ * one is presented, and the saved state is restored.
+ *
+ * Falls back to core_run() when the core can't save its state.
+ * If the state can't be restored, the core is left ahead of the
+ * game, so the content is shut down as if the core asked for it.
+ *
+ * Returns: true on success, otherwise false.
+ **/
+bool core_run_ahead(unsigned frames, bool perfcnt)
+{
+   unsigned i;
+   retro_time_t start;
+   retro_ctx_serialize_info_t info;
+   size_t size;
+
+   if (!frames || !runahead_available || state_manager_frame_is_reversed())
+      return core_run();
+
+#ifdef HAVE_NETWORKING
+   /* Netplay owns the callbacks and does its own rollback. */
+   if (netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_DATA_INITED, NULL))
+      return core_run();
 #endif
 
+   size = current_core.retro_serialize_size();
+
+   if (!size)
+   {
+      core_run_ahead_disable("Core does not support savestates");
+      return core_run();
+   }
+
+   if (size != runahead_state_size)
+   {
+      void *state = realloc(runahead_state, size);
+
+      if (!state)
+      {
+         core_run_ahead_disable("Out of memory");
+         return core_run();
+      }
+
+      runahead_state      = state;
+      runahead_state_size = size;
+   }
+
+   core_run_ahead_mute(true, false);
+   core_run();
+
+   performance_counter_init(runahead_perf, "run_ahead");
+   performance_counter_start_plus(perfcnt, runahead_perf);
+   start     = cpu_features_get_time_usec();
+
+   info.data       = runahead_state;
+   info.data_const = runahead_state;
+   info.size       = size;
+
+   if (!core_serialize(&info))
+   {
+      core_run_ahead_mute(false, false);
+      core_run_ahead_disable("Failed to save state");
+      video_driver_cached_frame();
+      return true;
+   }
+
+   for (i = 0; i < frames; i++)
+   {
+      core_run_ahead_mute(i != frames - 1, true);
+      core_run();
+   }
+
+   core_run_ahead_mute(false, false);
+
+   /* The core is now ahead of the game by @frames, there is
+    * no carrying on from here. */
+   if (!current_core.retro_unserialize(info.data_const, info.size))
+   {
+      RARCH_ERR("[Run-ahead]: %s\n",
+            msg_hash_to_str(MSG_RUN_AHEAD_FAILED_TO_ROLL_BACK));
+      runloop_msg_queue_push(
+            msg_hash_to_str(MSG_RUN_AHEAD_FAILED_TO_ROLL_BACK),
+            2, 180, true);
+      core_run_ahead_disable("Failed to load state");
+      rarch_ctl(RARCH_CTL_SET_SHUTDOWN,      NULL);
+      rarch_ctl(RARCH_CTL_SET_CORE_SHUTDOWN, NULL);
+      performance_counter_stop_plus(perfcnt, runahead_perf);
+      return false;
+   }
+
+   runahead_time   += cpu_features_get_time_usec() - start;
+   runahead_frames += frames;
+   performance_counter_stop_plus(perfcnt, runahead_perf);
+
    return true;
 }
 
+/**
+ * core_run_ahead_deinit:
+ *
+ * Frees the run-ahead savestate and reports the average
+ * cost of a run-ahead frame, savestate included.
+ **/
+void core_run_ahead_deinit(void)
+{
+   if (runahead_frames)
+      RARCH_LOG("[Run-ahead]: %u frames, %.3f ms per frame.\n",
+            (unsigned)runahead_frames,
+            runahead_time / (1000.0 * runahead_frames));
+
+   free(runahead_state);
+   runahead_state      = NULL;
+   runahead_state_size = 0;
+   runahead_available  = true;
+   runahead_time       = 0;
+   runahead_frames     = 0;
+}
+
 bool core_load(unsigned poll_type_behavior)
 {
    current_core.poll_type = poll_type_behavior;
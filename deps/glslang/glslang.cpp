@@ -17,6 +17,7 @@
 
 #include "glslang/glslang/Public/ShaderLang.h"
 #include "GlslangToSpv.h"
+#include "InitializeDll.h"
 #include <vector>
 #include <iostream>
 #include <cstring>
@@ -386,3 +387,7 @@ bool glslang::compile_spirv(const string &source, Stage stage, std::vector<uint3
    return true;
 }
 
+void glslang::detach_thread()
+{
+   DetachThread();
+}
@@ -18,6 +18,10 @@ namespace glslang
     };
 
     bool compile_spirv(const std::string &source, Stage stage, std::vector<uint32_t> *spirv);
+
+    /* glslang keeps a pool allocator per compiling thread.
+     * Threads other than the main one must call this before exiting. */
+    void detach_thread();
 }
 
 #endif
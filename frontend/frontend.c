@@ -35,6 +35,7 @@
 
 #include "../driver.h"
 #include "../paths.h"
+#include "../performance_counters.h"
 #include "../retroarch.h"
 
 #ifndef HAVE_MAIN
@@ -131,7 +132,11 @@ int rarch_main(int argc, char *argv[], void *data)
       int           ret = runloop_iterate(&sleep_ms);
 
       if (ret == 1 && sleep_ms > 0)
+      {
+         FRAME_TRACE_BEGIN(FRAME_TRACE_SLEEP);
          retro_sleep(sleep_ms);
+         FRAME_TRACE_END(FRAME_TRACE_SLEEP);
+      }
 
       task_queue_check();
 
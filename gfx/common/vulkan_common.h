@@ -391,6 +391,30 @@ typedef struct vk
    } tracker;
 
    void *filter_chain;
+
+#ifdef HAVE_THREADS
+   /* Slang presets are compiled on a worker thread while the
+    * current chain keeps rendering, and swapped in at the
+    * start of a frame once ready. A new request bumps generation;
+    * the worker drops results of older generations itself. */
+   struct
+   {
+      sthread_t *thread;
+      slock_t *lock;
+      scond_t *cond;
+      unsigned generation;
+      /* Request, handed to the worker. */
+      char *path;
+      char *cache_dir;
+      bool pending;
+      /* Result, handed back to the video thread. */
+      void *preset;
+      bool done;
+      bool quit;
+      /* Owned by the video thread: the preset being waited for. */
+      char *target;
+   } shader_compile;
+#endif
 } vk_t;
 
 uint32_t vulkan_find_memory_type(
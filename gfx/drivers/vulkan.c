@@ -20,6 +20,9 @@
 #include <string.h>
 
 #include <compat/strl.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/video_frame.h>
 #include <formats/image.h>
@@ -724,25 +727,34 @@ static void vulkan_deinit_framebuffers(vk_t *vk)
    vkDestroyRenderPass(vk->context->device, vk->render_pass, NULL);
 }
 
+static void vulkan_init_filter_chain_info(vk_t *vk,
+      struct vulkan_filter_chain_create_info *info)
+{
+   settings_t *settings = config_get_ptr();
+
+   memset(info, 0, sizeof(*info));
+
+   info->device                = vk->context->device;
+   info->gpu                   = vk->context->gpu;
+   info->memory_properties     = &vk->context->memory_properties;
+   info->pipeline_cache        = vk->pipelines.cache;
+   info->shader_cache_dir      = settings->paths.directory_cache;
+   info->queue                 = vk->context->queue;
+   info->command_pool          = vk->swapchain[vk->context->current_swapchain_index].cmd_pool;
+   info->max_input_size.width  = vk->tex_w;
+   info->max_input_size.height = vk->tex_h;
+   info->swapchain.viewport    = vk->vk_vp;
+   info->swapchain.format      = vk->context->swapchain_format;
+   info->swapchain.render_pass = vk->render_pass;
+   info->swapchain.num_indices = vk->context->num_swapchain_images;
+   info->original_format       = vk->tex_fmt;
+}
+
 static bool vulkan_init_default_filter_chain(vk_t *vk)
 {
    struct vulkan_filter_chain_create_info info;
 
-   memset(&info, 0, sizeof(info));
-
-   info.device                = vk->context->device;
-   info.gpu                   = vk->context->gpu;
-   info.memory_properties     = &vk->context->memory_properties;
-   info.pipeline_cache        = vk->pipelines.cache;
-   info.queue                 = vk->context->queue;
-   info.command_pool          = vk->swapchain[vk->context->current_swapchain_index].cmd_pool;
-   info.max_input_size.width  = vk->tex_w;
-   info.max_input_size.height = vk->tex_h;
-   info.swapchain.viewport    = vk->vk_vp;
-   info.swapchain.format      = vk->context->swapchain_format;
-   info.swapchain.render_pass = vk->render_pass;
-   info.swapchain.num_indices = vk->context->num_swapchain_images;
-   info.original_format       = vk->tex_fmt;
+   vulkan_init_filter_chain_info(vk, &info);
 
    vk->filter_chain           = vulkan_filter_chain_create_default(
          &info,
@@ -762,21 +774,7 @@ static bool vulkan_init_filter_chain_preset(vk_t *vk, const char *shader_path)
 {
    struct vulkan_filter_chain_create_info info;
 
-   memset(&info, 0, sizeof(info));
-
-   info.device                = vk->context->device;
-   info.gpu                   = vk->context->gpu;
-   info.memory_properties     = &vk->context->memory_properties;
-   info.pipeline_cache        = vk->pipelines.cache;
-   info.queue                 = vk->context->queue;
-   info.command_pool          = vk->swapchain[vk->context->current_swapchain_index].cmd_pool;
-   info.max_input_size.width  = vk->tex_w;
-   info.max_input_size.height = vk->tex_h;
-   info.swapchain.viewport    = vk->vk_vp;
-   info.swapchain.format      = vk->context->swapchain_format;
-   info.swapchain.render_pass = vk->render_pass;
-   info.swapchain.num_indices = vk->context->num_swapchain_images;
-   info.original_format       = vk->tex_fmt;
+   vulkan_init_filter_chain_info(vk, &info);
 
    vk->filter_chain           = vulkan_filter_chain_create_from_preset(
          &info, shader_path,
@@ -792,6 +790,217 @@ static bool vulkan_init_filter_chain_preset(vk_t *vk, const char *shader_path)
    return true;
 }
 
+#ifdef HAVE_THREADS
+/* One worker per driver instance. It waits for a request, compiles
+ * it without holding the lock, and publishes the result only if no
+ * newer request has come in meanwhile; stale results are freed here
+ * so the video thread never has to wait for a compile. */
+static void vulkan_shader_compile_thread(void *data)
+{
+   vk_t *vk = (vk_t*)data;
+
+   slock_lock(vk->shader_compile.lock);
+
+   for (;;)
+   {
+      unsigned generation;
+      char *path      = NULL;
+      char *cache_dir = NULL;
+      void *preset    = NULL;
+
+      while (!vk->shader_compile.quit && !vk->shader_compile.pending)
+         scond_wait(vk->shader_compile.cond, vk->shader_compile.lock);
+
+      if (vk->shader_compile.quit)
+         break;
+
+      generation                   = vk->shader_compile.generation;
+      path                         = vk->shader_compile.path;
+      cache_dir                    = vk->shader_compile.cache_dir;
+      vk->shader_compile.path      = NULL;
+      vk->shader_compile.cache_dir = NULL;
+      vk->shader_compile.pending   = false;
+      slock_unlock(vk->shader_compile.lock);
+
+      preset = vulkan_filter_chain_preset_compile(path, cache_dir);
+      free(path);
+      free(cache_dir);
+
+      slock_lock(vk->shader_compile.lock);
+      if (generation == vk->shader_compile.generation)
+      {
+         vk->shader_compile.preset = preset;
+         vk->shader_compile.done   = true;
+      }
+      else if (preset)
+         vulkan_filter_chain_preset_free(
+               (vulkan_filter_chain_preset_t*)preset);
+   }
+
+   slock_unlock(vk->shader_compile.lock);
+
+   vulkan_filter_chain_preset_compile_deinit();
+}
+
+/* Abandons any queued or in-flight compile without waiting for it. */
+static void vulkan_shader_compile_cancel(vk_t *vk)
+{
+   if (!vk->shader_compile.thread)
+      return;
+
+   slock_lock(vk->shader_compile.lock);
+   vk->shader_compile.generation++;
+   vk->shader_compile.pending = false;
+   vk->shader_compile.done    = false;
+
+   free(vk->shader_compile.path);
+   free(vk->shader_compile.cache_dir);
+   vk->shader_compile.path      = NULL;
+   vk->shader_compile.cache_dir = NULL;
+
+   if (vk->shader_compile.preset)
+      vulkan_filter_chain_preset_free(
+            (vulkan_filter_chain_preset_t*)vk->shader_compile.preset);
+   vk->shader_compile.preset = NULL;
+   slock_unlock(vk->shader_compile.lock);
+}
+
+static bool vulkan_shader_compile_init(vk_t *vk)
+{
+   if (vk->shader_compile.thread)
+      return true;
+
+   if (!vk->shader_compile.lock)
+      vk->shader_compile.lock = slock_new();
+   if (!vk->shader_compile.cond)
+      vk->shader_compile.cond = scond_new();
+   if (!vk->shader_compile.lock || !vk->shader_compile.cond)
+      return false;
+
+   vk->shader_compile.thread = sthread_create(
+         vulkan_shader_compile_thread, vk);
+
+   return vk->shader_compile.thread != NULL;
+}
+
+static void vulkan_shader_compile_deinit(vk_t *vk)
+{
+   if (vk->shader_compile.thread)
+   {
+      vulkan_shader_compile_cancel(vk);
+
+      slock_lock(vk->shader_compile.lock);
+      vk->shader_compile.quit = true;
+      scond_signal(vk->shader_compile.cond);
+      slock_unlock(vk->shader_compile.lock);
+
+      /* Only teardown waits for a compile still running. */
+      sthread_join(vk->shader_compile.thread);
+      vk->shader_compile.thread = NULL;
+   }
+
+   if (vk->shader_compile.cond)
+      scond_free(vk->shader_compile.cond);
+   if (vk->shader_compile.lock)
+      slock_free(vk->shader_compile.lock);
+   vk->shader_compile.cond = NULL;
+   vk->shader_compile.lock = NULL;
+
+   if (vk->shader_compile.target)
+      video_driver_set_shader_pending(false);
+   free(vk->shader_compile.target);
+   vk->shader_compile.target = NULL;
+}
+
+static bool vulkan_shader_compile_start(vk_t *vk, const char *path)
+{
+   settings_t *settings = config_get_ptr();
+   char *target         = strdup(path);
+   char *cache_dir      = strdup(settings->paths.directory_cache);
+
+   if (!target || !cache_dir || !vulkan_shader_compile_init(vk))
+   {
+      free(target);
+      free(cache_dir);
+      return false;
+   }
+
+   free(vk->shader_compile.target);
+   vk->shader_compile.target = target;
+
+   slock_lock(vk->shader_compile.lock);
+   vk->shader_compile.generation++;
+   free(vk->shader_compile.path);
+   free(vk->shader_compile.cache_dir);
+   vk->shader_compile.path      = strdup(target);
+   vk->shader_compile.cache_dir = cache_dir;
+   vk->shader_compile.pending   = vk->shader_compile.path != NULL;
+   scond_signal(vk->shader_compile.cond);
+   slock_unlock(vk->shader_compile.lock);
+
+   /* The caller persists the preset as soon as we return; it
+    * is told later whether it could be built. */
+   video_driver_set_shader_pending(true);
+
+   return true;
+}
+
+/* Called at the start of a frame. If the worker has finished,
+ * build the new chain and swap it in. On failure, the current
+ * chain is kept and the main thread is told, so it can put the
+ * shader settings back to match it. */
+static void vulkan_shader_compile_poll(vk_t *vk)
+{
+   bool done                    = false;
+   void *preset                 = NULL;
+   vulkan_filter_chain_t *chain = NULL;
+   struct vulkan_filter_chain_create_info info;
+
+   if (!vk->shader_compile.target)
+      return;
+
+   slock_lock(vk->shader_compile.lock);
+   done                      = vk->shader_compile.done;
+   preset                    = vk->shader_compile.preset;
+   vk->shader_compile.done   = false;
+   vk->shader_compile.preset = NULL;
+   slock_unlock(vk->shader_compile.lock);
+
+   if (!done)
+      return;
+
+   if (preset)
+   {
+      vulkan_init_filter_chain_info(vk, &info);
+      chain = vulkan_filter_chain_create_from_compiled_preset(&info,
+            (vulkan_filter_chain_preset_t*)preset,
+            vk->video.smooth ?
+            VULKAN_FILTER_CHAIN_LINEAR : VULKAN_FILTER_CHAIN_NEAREST);
+      vulkan_filter_chain_preset_free(
+            (vulkan_filter_chain_preset_t*)preset);
+   }
+
+   if (chain)
+   {
+      if (vk->filter_chain)
+         vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
+      vk->filter_chain = chain;
+      video_driver_set_shader_pending(false);
+   }
+   else
+   {
+      RARCH_ERR("[Vulkan]: Failed to create filter chain: \"%s\". Keeping current shader.\n",
+            vk->shader_compile.target);
+      runloop_msg_queue_push(msg_hash_to_str(MSG_FAILED_TO_APPLY_SHADER),
+            1, 180, true);
+      video_driver_set_shader_failed(vk->shader_compile.target);
+   }
+
+   free(vk->shader_compile.target);
+   vk->shader_compile.target = NULL;
+}
+#endif
+
 static bool vulkan_init_filter_chain(vk_t *vk)
 {
    settings_t *settings = config_get_ptr();
@@ -829,18 +1038,126 @@ static void vulkan_init_resources(vk_t *vk)
    vulkan_init_command_buffers(vk);
 }
 
+static bool vulkan_pipeline_cache_path(char *s, size_t len)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (string_is_empty(settings->paths.directory_cache))
+      return false;
+
+   fill_pathname_join(s, settings->paths.directory_cache,
+         "vulkan_pipeline.cache", len);
+   return true;
+}
+
+/* Only hand back pipeline cache data which was created by
+ * this exact driver and GPU, some drivers do not validate
+ * the header themselves. */
+static bool vulkan_pipeline_cache_is_compatible(vk_t *vk,
+      const uint8_t *data, size_t size)
+{
+   uint32_t header_size, header_version, vendor_id, device_id;
+   const VkPhysicalDeviceProperties *props = &vk->context->gpu_properties;
+
+   if (size < 16 + VK_UUID_SIZE)
+      return false;
+
+   memcpy(&header_size,    data + 0,  sizeof(uint32_t));
+   memcpy(&header_version, data + 4,  sizeof(uint32_t));
+   memcpy(&vendor_id,      data + 8,  sizeof(uint32_t));
+   memcpy(&device_id,      data + 12, sizeof(uint32_t));
+
+   if (header_size < 16 + VK_UUID_SIZE || header_size > size)
+      return false;
+   if (header_version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+      return false;
+   if (vendor_id != props->vendorID || device_id != props->deviceID)
+      return false;
+
+   return memcmp(data + 16, props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static void vulkan_load_pipeline_cache(vk_t *vk)
+{
+   char path[PATH_MAX_LENGTH];
+   void *data                      = NULL;
+   ssize_t size                    = 0;
+   VkPipelineCacheCreateInfo cache = { 
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+
+   path[0] = '\0';
+
+   if (     vulkan_pipeline_cache_path(path, sizeof(path))
+         && path_file_exists(path)
+         && filestream_read_file(path, &data, &size))
+   {
+      if (vulkan_pipeline_cache_is_compatible(vk,
+               (const uint8_t*)data, (size_t)size))
+      {
+         cache.initialDataSize = (size_t)size;
+         cache.pInitialData    = data;
+      }
+      else
+         RARCH_WARN("[Vulkan]: Discarding incompatible pipeline cache \"%s\".\n",
+               path);
+   }
+
+   if (vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache) != VK_SUCCESS
+         && cache.pInitialData)
+   {
+      cache.initialDataSize = 0;
+      cache.pInitialData    = NULL;
+      vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache);
+   }
+   else if (cache.pInitialData)
+      RARCH_LOG("[Vulkan]: Loaded pipeline cache \"%s\" (%u bytes).\n",
+            path, (unsigned)size);
+
+   free(data);
+}
+
+static void vulkan_save_pipeline_cache(vk_t *vk)
+{
+   char path[PATH_MAX_LENGTH];
+   void *data  = NULL;
+   size_t size = 0;
+
+   path[0] = '\0';
+
+   if (vk->pipelines.cache == VK_NULL_HANDLE)
+      return;
+   if (!vulkan_pipeline_cache_path(path, sizeof(path)))
+      return;
+
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &size, NULL) != VK_SUCCESS || !size)
+      return;
+
+   data = malloc(size);
+   if (!data)
+      return;
+
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &size, data) == VK_SUCCESS)
+   {
+      if (!filestream_write_file(path, data, size))
+         RARCH_WARN("[Vulkan]: Failed to save pipeline cache \"%s\".\n", path);
+   }
+
+   free(data);
+}
+
 static void vulkan_init_static_resources(vk_t *vk)
 {
    unsigned i;
    uint32_t blank[4 * 4];
    VkCommandPoolCreateInfo pool_info = { 
       VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
-   /* Create the pipeline cache. */
-   VkPipelineCacheCreateInfo cache   = { 
-      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
 
-   vkCreatePipelineCache(vk->context->device,
-         &cache, NULL, &vk->pipelines.cache);
+   /* Create the pipeline cache, seeded from disk if possible. */
+   vulkan_load_pipeline_cache(vk);
 
    pool_info.queueFamilyIndex = vk->context->graphics_queue_index;
 
@@ -858,6 +1175,7 @@ static void vulkan_init_static_resources(vk_t *vk)
 static void vulkan_deinit_static_resources(vk_t *vk)
 {
    unsigned i;
+   vulkan_save_pipeline_cache(vk);
    vkDestroyPipelineCache(vk->context->device,
          vk->pipelines.cache, NULL);
    vulkan_destroy_texture(
@@ -925,6 +1243,10 @@ static void vulkan_free(void *data)
       video_context_driver_free();
    }
 
+#ifdef HAVE_THREADS
+   vulkan_shader_compile_deinit(vk);
+#endif
+
    scaler_ctx_gen_reset(&vk->readback.scaler);
    free(vk);
 }
@@ -1291,6 +1613,21 @@ static bool vulkan_set_shader(void *data,
       path = NULL;
    }
 
+#ifdef HAVE_THREADS
+   /* A newer request always supersedes one still compiling. */
+   vulkan_shader_compile_cancel(vk);
+
+   /* Compile off-thread and keep presenting with the current
+    * chain; the switch happens in vulkan_frame once ready. */
+   if (path && vk->filter_chain && vulkan_shader_compile_start(vk, path))
+      return true;
+
+   /* Applied synchronously below; nothing is left pending. */
+   free(vk->shader_compile.target);
+   vk->shader_compile.target = NULL;
+   video_driver_set_shader_pending(false);
+#endif
+
    if (vk->filter_chain)
       vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
    vk->filter_chain = NULL;
@@ -1597,6 +1934,10 @@ static bool vulkan_frame(void *data, const void *frame,
    unsigned frame_index                          = 
       vk->context->current_swapchain_index;
 
+#ifdef HAVE_THREADS
+   vulkan_shader_compile_poll(vk);
+#endif
+
    /* Bookkeeping on start of frame. */
    chain     = &vk->swapchain[frame_index];
    vk->chain = chain;
@@ -17,7 +17,6 @@
 
 #include <stdlib.h>
 
-#include <encodings/utf.h>
 #include <string/stdstring.h>
 #include <retro_math.h>
 
@@ -40,8 +39,6 @@
    font_lut_tex_coord[    2 * (6 * i + c) + 1] = gl->coords.lut_tex_coord[1]; \
 } while(0)
 
-#define MAX_MSG_LEN_CHUNK 64
-
 typedef struct
 {
    gl_t *gl;
@@ -51,6 +48,7 @@ typedef struct
    const font_renderer_driver_t *font_driver;
    void *font_data;
    struct font_atlas *atlas;
+   font_glyph_run_cache_t runs;
 
    video_font_raster_block_t *block;
 } gl_raster_t;
@@ -65,6 +63,8 @@ static void gl_raster_font_free_font(void *data,
    if (font->font_driver && font->font_data)
       font->font_driver->free(font->font_data);
 
+   font_glyph_run_cache_free(&font->runs);
+
    if (is_threaded)
       video_context_driver_make_current(true);
 
@@ -220,9 +220,8 @@ error:
 static int gl_get_message_width(void *data, const char *msg,
       unsigned msg_len, float scale)
 {
-   gl_raster_t *font   = (gl_raster_t*)data;
-   const char* msg_end = msg + msg_len;
-   int delta_x         = 0;
+   const font_glyph_run_t *run = NULL;
+   gl_raster_t *font           = (gl_raster_t*)data;
 
    if (     !font
          || !font->font_driver
@@ -230,21 +229,13 @@ static int gl_get_message_width(void *data, const char *msg,
          || !font->font_data )
       return 0;
 
-   while (msg < msg_end)
-   {
-      unsigned code                  = utf8_walk(&msg);
-      const struct font_glyph *glyph = font->font_driver->get_glyph(
-            font->font_data, code);
+   run = font_glyph_run_cache_get(&font->runs,
+         font->font_driver, font->font_data, msg, msg_len);
 
-      if (!glyph) /* Do something smarter here ... */
-         glyph = font->font_driver->get_glyph(font->font_data, '?');
-      if (!glyph)
-         continue;
-
-      delta_x += glyph->advance_x;
-   }
+   if (!run)
+      return 0;
 
-   return delta_x * scale;
+   return run->width * scale;
 }
 
 static void gl_raster_font_draw_vertices(gl_raster_t *font, const video_coords_t *coords)
@@ -271,60 +262,81 @@ static void gl_raster_font_draw_vertices(gl_raster_t *font, const video_coords_t
    glDrawArrays(GL_TRIANGLES, 0, coords->vertices);
 }
 
+/* The vertices of a run are cached as one block of floats:
+ * positions, texture coordinates, colors and LUT coordinates. */
+#define GL_RASTER_FONT_FLOATS_PER_VERTEX (2 + 2 + 4 + 2)
+
 static void gl_raster_font_render_line(
       gl_raster_t *font, const char *msg, unsigned msg_len,
       GLfloat scale, const GLfloat color[4], GLfloat pos_x,
       GLfloat pos_y, unsigned text_align)
 {
    unsigned i;
+   unsigned vertices;
+   font_run_vertex_key_t key;
    struct video_coords coords;
-   GLfloat font_tex_coords[2 * 6 * MAX_MSG_LEN_CHUNK];
-   GLfloat font_vertex[2 * 6 * MAX_MSG_LEN_CHUNK];
-   GLfloat font_color[4 * 6 * MAX_MSG_LEN_CHUNK];
-   GLfloat font_lut_tex_coord[2 * 6 * MAX_MSG_LEN_CHUNK];
+   const GLfloat *cached = NULL;
    gl_t      *gl        = font->gl;
-   const char* msg_end  = msg + msg_len;
    int x                = roundf(pos_x * gl->vp.width);
    int y                = roundf(pos_y * gl->vp.height);
-   int delta_x          = 0;
-   int delta_y          = 0;
    float inv_tex_size_x = 1.0f / font->tex_width;
    float inv_tex_size_y = 1.0f / font->tex_height;
    float inv_win_width  = 1.0f / font->gl->vp.width;
    float inv_win_height = 1.0f / font->gl->vp.height;
+   font_glyph_run_t *run = font_glyph_run_cache_get(&font->runs,
+         font->font_driver, font->font_data, msg, msg_len);
+
+   if (!run || !run->count)
+      return;
 
    switch (text_align)
    {
       case TEXT_ALIGN_RIGHT:
-         x -= gl_get_message_width(font, msg, msg_len, scale);
+         x -= run->width * scale;
          break;
       case TEXT_ALIGN_CENTER:
-         x -= gl_get_message_width(font, msg, msg_len, scale) / 2.0;
+         x -= run->width * scale / 2.0;
          break;
    }
 
-   while (msg < msg_end)
+   key.x          = x;
+   key.y          = y;
+   key.scale      = scale;
+   key.color[0]   = color[0];
+   key.color[1]   = color[1];
+   key.color[2]   = color[2];
+   key.color[3]   = color[3];
+   key.width      = gl->vp.width;
+   key.height     = gl->vp.height;
+   key.tex_width  = font->tex_width;
+   key.tex_height = font->tex_height;
+
+   vertices       = run->count * 6;
+   cached         = (const GLfloat*)font_glyph_run_get_vertices(run, &key);
+
+   if (!cached)
    {
-      i = 0;
-      while ((i < MAX_MSG_LEN_CHUNK) && (msg < msg_end))
-      {         
-         int off_x, off_y, tex_x, tex_y, width, height;
-         unsigned                  code = utf8_walk(&msg);
-         const struct font_glyph *glyph = font->font_driver->get_glyph(
-               font->font_data, code);
-
-         if (!glyph) /* Do something smarter here ... */
-            glyph = font->font_driver->get_glyph(font->font_data, '?');
-
-         if (!glyph)
-            continue;
-
-         off_x  = glyph->draw_offset_x;
-         off_y  = glyph->draw_offset_y;
-         tex_x  = glyph->atlas_offset_x;
-         tex_y  = glyph->atlas_offset_y;
-         width  = glyph->width;
-         height = glyph->height;
+      GLfloat *font_vertex        = (GLfloat*)font_glyph_run_new_vertices(
+            run, &key, vertices * GL_RASTER_FONT_FLOATS_PER_VERTEX
+            * sizeof(GLfloat));
+      GLfloat *font_tex_coords    = font_vertex     + 2 * vertices;
+      GLfloat *font_color         = font_tex_coords + 2 * vertices;
+      GLfloat *font_lut_tex_coord = font_color      + 4 * vertices;
+
+      if (!font_vertex)
+         return;
+
+      for (i = 0; i < run->count; i++)
+      {
+         const struct font_run_glyph *item = &run->glyphs[i];
+         int delta_x = item->pen_x;
+         int delta_y = -item->pen_y;
+         int off_x   = item->glyph.draw_offset_x;
+         int off_y   = item->glyph.draw_offset_y;
+         int tex_x   = item->glyph.atlas_offset_x;
+         int tex_y   = item->glyph.atlas_offset_y;
+         int width   = item->glyph.width;
+         int height  = item->glyph.height;
 
          gl_raster_font_emit(0, 0, 1); /* Bottom-left */
          gl_raster_font_emit(1, 1, 1); /* Bottom-right */
@@ -333,24 +345,21 @@ static void gl_raster_font_render_line(
          gl_raster_font_emit(3, 1, 0); /* Top-right */
          gl_raster_font_emit(4, 0, 0); /* Top-left */
          gl_raster_font_emit(5, 1, 1); /* Bottom-right */
-
-         i++;
-
-         delta_x += glyph->advance_x;
-         delta_y -= glyph->advance_y;
       }
 
-      coords.tex_coord     = font_tex_coords;
-      coords.vertex        = font_vertex;
-      coords.color         = font_color;
-      coords.vertices      = i * 6;
-      coords.lut_tex_coord = font_lut_tex_coord;
-
-      if (font->block)
-         video_coord_array_append(&font->block->carr, &coords, coords.vertices);
-      else
-         gl_raster_font_draw_vertices(font, &coords);
+      cached = font_vertex;
    }
+
+   coords.vertex        = cached;
+   coords.tex_coord     = cached + 2 * vertices;
+   coords.color         = cached + 4 * vertices;
+   coords.lut_tex_coord = cached + 8 * vertices;
+   coords.vertices      = vertices;
+
+   if (font->block)
+      video_coord_array_append(&font->block->carr, &coords, coords.vertices);
+   else
+      gl_raster_font_draw_vertices(font, &coords);
 }
 
 static void gl_raster_font_render_message(
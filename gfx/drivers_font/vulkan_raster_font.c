@@ -30,6 +30,7 @@ typedef struct
    const font_renderer_driver_t *font_driver;
    void *font_data;
    struct font_atlas *atlas;
+   font_glyph_run_cache_t runs;
    bool needs_update;
 
    struct vk_vertex *pv;
@@ -94,6 +95,8 @@ static void vulkan_raster_font_free_font(void *data, bool is_threaded)
    if (font->font_driver && font->font_data)
       font->font_driver->free(font->font_data);
 
+   font_glyph_run_cache_free(&font->runs);
+
    vkQueueWaitIdle(font->vk->context->queue);
    vulkan_destroy_texture( 
          font->vk->context->device, &font->texture);
@@ -103,50 +106,65 @@ static void vulkan_raster_font_free_font(void *data, bool is_threaded)
    free(font);
 }
 
+static INLINE void vulkan_raster_font_copy_glyph(vulkan_raster_t *font,
+      const struct font_glyph *glyph)
+{
+   int row;
+   for (row = glyph->atlas_offset_y; row < (glyph->atlas_offset_y + glyph->height); row++)
+   {
+      uint8_t* src = font->atlas->buffer + row * font->atlas->width + glyph->atlas_offset_x;
+      uint8_t* dst = (uint8_t*)font->texture.mapped + row * font->texture.stride + glyph->atlas_offset_x;
+      memcpy(dst, src, glyph->width);
+   }
+}
+
 static INLINE void vulkan_raster_font_update_glyph(vulkan_raster_t *font, const struct font_glyph *glyph)
 {
    if(font->atlas->dirty)
    {
-      int row;
-      for(row = glyph->atlas_offset_y; row < (glyph->atlas_offset_y + glyph->height); row++)
-      {
-         uint8_t* src = font->atlas->buffer + row * font->atlas->width + glyph->atlas_offset_x;
-         uint8_t* dst = (uint8_t*)font->texture.mapped + row * font->texture.stride + glyph->atlas_offset_x;
-         memcpy(dst, src, glyph->width);
-      }
+      vulkan_raster_font_copy_glyph(font, glyph);
+
+      font->atlas->dirty = false;
+      font->needs_update = true;
+   }
+}
+
+/* Laying out a run may rasterize several glyphs before any of
+ * them is drawn, so copy all of them once the run is built. */
+static font_glyph_run_t *vulkan_raster_font_get_run(
+      vulkan_raster_t *font, const char *msg, unsigned msg_len)
+{
+   font_glyph_run_t *run = font_glyph_run_cache_get(&font->runs,
+         font->font_driver, font->font_data, msg, msg_len);
+
+   if (run && font->atlas->dirty)
+   {
+      unsigned i;
+      for (i = 0; i < run->count; i++)
+         vulkan_raster_font_copy_glyph(font, &run->glyphs[i].glyph);
 
       font->atlas->dirty = false;
       font->needs_update = true;
    }
+
+   return run;
 }
 
 static int vulkan_get_message_width(void *data, const char *msg,
       unsigned msg_len, float scale)
 {
-   vulkan_raster_t *font = (vulkan_raster_t*)data;
-      
-   unsigned i;
-   int delta_x = 0;
+   const font_glyph_run_t *run = NULL;
+   vulkan_raster_t *font       = (vulkan_raster_t*)data;
 
    if (!font)
       return 0;
 
-   for (i = 0; i < msg_len; i++)
-   {
-      const struct font_glyph *glyph = 
-         font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
-      if (!glyph) /* Do something smarter here ... */
-         glyph = font->font_driver->get_glyph(font->font_data, '?');
-
+   run = vulkan_raster_font_get_run(font, msg, msg_len);
 
-      if (glyph)
-      {
-         vulkan_raster_font_update_glyph(font, glyph);
-         delta_x += glyph->advance_x;
-      }
-   }
+   if (!run)
+      return 0;
 
-   return delta_x * scale;
+   return run->width * scale;
 }
 
 static void vulkan_raster_font_render_line(
@@ -154,17 +172,24 @@ static void vulkan_raster_font_render_line(
       float scale, const float color[4], float pos_x,
       float pos_y, unsigned text_align)
 {
+   unsigned i;
+   unsigned vertices;
    struct vk_color vk_color;
+   font_run_vertex_key_t key;
+   struct vk_vertex *pv = NULL;
+   const void *cached   = NULL;
    vk_t *vk             = font->vk;
-   const char* msg_end  = msg + msg_len;
    int x                = roundf(pos_x * vk->vp.width);
    int y                = roundf((1.0f - pos_y) * vk->vp.height);
-   int delta_x          = 0;
-   int delta_y          = 0;
    float inv_tex_size_x = 1.0f / font->texture.width;
    float inv_tex_size_y = 1.0f / font->texture.height;
    float inv_win_width  = 1.0f / font->vk->vp.width;
    float inv_win_height = 1.0f / font->vk->vp.height;
+   font_glyph_run_t *run = vulkan_raster_font_get_run(
+         font, msg, msg_len);
+
+   if (!run || !run->count)
+      return;
 
    vk_color.r           = color[0];
    vk_color.g           = color[1];
@@ -174,37 +199,57 @@ static void vulkan_raster_font_render_line(
    switch (text_align)
    {
       case TEXT_ALIGN_RIGHT:
-         x -= vulkan_get_message_width(font, msg, msg_len, scale);
+         x -= run->width * scale;
          break;
       case TEXT_ALIGN_CENTER:
-         x -= vulkan_get_message_width(font, msg, msg_len, scale) / 2;
+         x -= run->width * scale / 2;
          break;
    }
 
-   while (msg < msg_end)
+   key.x          = x;
+   key.y          = y;
+   key.scale      = scale;
+   key.color[0]   = color[0];
+   key.color[1]   = color[1];
+   key.color[2]   = color[2];
+   key.color[3]   = color[3];
+   key.width      = vk->vp.width;
+   key.height     = vk->vp.height;
+   key.tex_width  = font->texture.width;
+   key.tex_height = font->texture.height;
+
+   vertices       = run->count * 6;
+   cached         = font_glyph_run_get_vertices(run, &key);
+
+   if (cached)
    {
-      int off_x, off_y, tex_x, tex_y, width, height;
-      unsigned code                  = utf8_walk(&msg);
-      const struct font_glyph *glyph =
-         font->font_driver->get_glyph(font->font_data, code);
+      memcpy(font->pv + font->vertices, cached,
+            vertices * sizeof(struct vk_vertex));
+      font->vertices += vertices;
+      return;
+   }
 
-      if (!glyph) /* Do something smarter here ... */
-         glyph = font->font_driver->get_glyph(font->font_data, '?');
-      if (!glyph)
-         continue;
+   /* Built once in the run, then copied like a cached one. */
+   pv = (struct vk_vertex*)font_glyph_run_new_vertices(run, &key,
+         vertices * sizeof(struct vk_vertex));
 
-      vulkan_raster_font_update_glyph(font, glyph);
-
-      off_x  = glyph->draw_offset_x;
-      off_y  = glyph->draw_offset_y;
-      tex_x  = glyph->atlas_offset_x;
-      tex_y  = glyph->atlas_offset_y;
-      width  = glyph->width;
-      height = glyph->height;
+   if (!pv)
+      return;
 
-      vulkan_write_quad_vbo(font->pv + font->vertices,
-            (x + off_x + delta_x * scale) * inv_win_width,
-            (y + off_y + delta_y * scale) * inv_win_height,
+   for (i = 0; i < run->count; i++)
+   {
+      const struct font_run_glyph *item = &run->glyphs[i];
+      const struct font_glyph *glyph    = &item->glyph;
+      int off_x                         = glyph->draw_offset_x;
+      int off_y                         = glyph->draw_offset_y;
+      int tex_x                         = glyph->atlas_offset_x;
+      int tex_y                         = glyph->atlas_offset_y;
+      int width                         = glyph->width;
+      int height                        = glyph->height;
+
+      vulkan_write_quad_vbo(pv + i * 6,
+            (x + off_x + item->pen_x * scale) * inv_win_width,
+            (y + off_y + item->pen_y * scale) * inv_win_height,
             width * scale * inv_win_width,
             height * scale * inv_win_height,
             tex_x * inv_tex_size_x,
@@ -212,12 +257,11 @@ static void vulkan_raster_font_render_line(
             width * inv_tex_size_x,
             height * inv_tex_size_y,
             &vk_color);
-
-      font->vertices += 6;
-
-      delta_x        += glyph->advance_x;
-      delta_y        += glyph->advance_y;
    }
+
+   memcpy(font->pv + font->vertices, pv,
+         vertices * sizeof(struct vk_vertex));
+   font->vertices += vertices;
 }
 
 static void vulkan_raster_font_render_message(
@@ -89,12 +89,17 @@ static freetype_atlas_slot_t* font_renderer_get_slot(ft_font_renderer_t *handle)
    /* remove from map */
    map_id = handle->atlas_slots[oldest].charcode & 0xFF;
    if(handle->uc_map[map_id] == &handle->atlas_slots[oldest])
+   {
       handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
+      handle->atlas.generation++;
+   }
    else if (handle->uc_map[map_id])
    {
       freetype_atlas_slot_t* ptr = handle->uc_map[map_id];
       while(ptr->next && ptr->next != &handle->atlas_slots[oldest])
          ptr = ptr->next;
+      if (ptr->next)
+         handle->atlas.generation++;
       ptr->next = handle->atlas_slots[oldest].next;
    }
 
@@ -94,12 +94,17 @@ static stb_unicode_atlas_slot_t* font_renderer_stb_unicode_get_slot(stb_unicode_
    /* remove from map */
    map_id = handle->atlas_slots[oldest].charcode & 0xFF;
    if(handle->uc_map[map_id] == &handle->atlas_slots[oldest])
+   {
       handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
+      handle->atlas.generation++;
+   }
    else if (handle->uc_map[map_id])
    {
       stb_unicode_atlas_slot_t* ptr = handle->uc_map[map_id];
       while(ptr->next && ptr->next != &handle->atlas_slots[oldest])
          ptr = ptr->next;
+      if (ptr->next)
+         handle->atlas.generation++;
       ptr->next = handle->atlas_slots[oldest].next;
    }
 
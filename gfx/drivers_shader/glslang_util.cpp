@@ -20,10 +20,14 @@
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <compat/strl.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
 #include <lists/string_list.h>
 #include <string/stdstring.h>
+#include <rhash.h>
+
+#include <glslang/Include/revision.h>
 
 #include "glslang_util.hpp"
 #include "glslang.hpp"
@@ -227,6 +231,11 @@ const char *glslang_format_to_string(enum glslang_format fmt)
    return glslang_formats[fmt];
 }
 
+void glslang_detach_thread(void)
+{
+   glslang::detach_thread();
+}
+
 static glslang_format glslang_find_format(const char *fmt)
 {
 #undef FMT
@@ -363,11 +372,125 @@ bool glslang_parse_meta(const vector<string> &lines, glslang_meta *meta)
    return true;
 }
 
-bool glslang_compile_shader(const char *shader_path, glslang_output *output)
+/* Bump whenever the on-disk layout of cached SPIR-V,
+ * or the way stage sources are built, changes. */
+#define SLANG_CACHE_MAGIC   0x43535241 /* 'ARSC' */
+#define SLANG_CACHE_VERSION 1
+
+struct slang_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t vertex_words;
+   uint32_t fragment_words;
+};
+
+static void glslang_cache_path(char *s, size_t len, const char *cache_dir,
+      const string &vertex_source, const string &fragment_source)
+{
+   char hash[65];
+   char name[80];
+   string key;
+
+   /* Key on everything that can change the generated SPIR-V:
+    * the fully preprocessed (include-expanded) stage sources
+    * and the compiler revision. */
+   key.reserve(vertex_source.size() + fragment_source.size() + 64);
+   key += GLSLANG_REVISION;
+   key += '\0';
+   key += to_string(SLANG_CACHE_VERSION);
+   key += '\0';
+   key += vertex_source;
+   key += '\0';
+   key += fragment_source;
+
+   hash[0] = '\0';
+   sha256_hash(hash, (const uint8_t*)key.data(), key.size());
+   snprintf(name, sizeof(name), "%s.spv", hash);
+
+   fill_pathname_join(s, cache_dir, "slang", len);
+   fill_pathname_slash(s, len);
+   strlcat(s, name, len);
+}
+
+static bool glslang_cache_load(const char *path, glslang_output *output)
+{
+   struct slang_cache_header header;
+   uint8_t *buf      = NULL;
+   ssize_t len       = 0;
+   size_t vert_size  = 0;
+   size_t frag_size  = 0;
+
+   if (!path_file_exists(path))
+      return false;
+
+   if (!filestream_read_file(path, (void**)&buf, &len))
+      return false;
+
+   if ((size_t)len < sizeof(header))
+      goto error;
+
+   memcpy(&header, buf, sizeof(header));
+
+   if (     header.magic   != SLANG_CACHE_MAGIC
+         || header.version != SLANG_CACHE_VERSION)
+      goto error;
+
+   vert_size = header.vertex_words   * sizeof(uint32_t);
+   frag_size = header.fragment_words * sizeof(uint32_t);
+
+   if ((size_t)len != sizeof(header) + vert_size + frag_size)
+      goto error;
+
+   output->vertex.resize(header.vertex_words);
+   output->fragment.resize(header.fragment_words);
+   memcpy(output->vertex.data(), buf + sizeof(header), vert_size);
+   memcpy(output->fragment.data(), buf + sizeof(header) + vert_size, frag_size);
+
+   free(buf);
+   return true;
+
+error:
+   RARCH_WARN("[slang]: Ignoring invalid shader cache entry \"%s\".\n", path);
+   free(buf);
+   return false;
+}
+
+static void glslang_cache_save(const char *path, const glslang_output *output)
+{
+   char dir[PATH_MAX_LENGTH];
+   struct slang_cache_header header;
+   vector<uint8_t> buf;
+   size_t vert_size      = output->vertex.size()   * sizeof(uint32_t);
+   size_t frag_size      = output->fragment.size() * sizeof(uint32_t);
+
+   header.magic          = SLANG_CACHE_MAGIC;
+   header.version        = SLANG_CACHE_VERSION;
+   header.vertex_words   = (uint32_t)output->vertex.size();
+   header.fragment_words = (uint32_t)output->fragment.size();
+
+   buf.resize(sizeof(header) + vert_size + frag_size);
+   memcpy(buf.data(), &header, sizeof(header));
+   memcpy(buf.data() + sizeof(header), output->vertex.data(), vert_size);
+   memcpy(buf.data() + sizeof(header) + vert_size,
+         output->fragment.data(), frag_size);
+
+   fill_pathname_basedir(dir, path, sizeof(dir));
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+      return;
+
+   if (!filestream_write_file(path, buf.data(), buf.size()))
+      RARCH_WARN("[slang]: Failed to write shader cache entry \"%s\".\n", path);
+}
+
+bool glslang_compile_shader(const char *shader_path,
+      const char *cache_dir, glslang_output *output)
 {
+   char cache_path[PATH_MAX_LENGTH];
    vector<string> lines;
+   bool use_cache = !string_is_empty(cache_dir);
 
-   RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
+   cache_path[0] = '\0';
 
    if (!glslang_read_shader_file(shader_path, &lines, true))
       return false;
@@ -375,20 +498,39 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
    if (!glslang_parse_meta(lines, &output->meta))
       return false;
 
-   if (    !glslang::compile_spirv(build_stage_source(lines, "vertex"),
+   string vertex_source   = build_stage_source(lines, "vertex");
+   string fragment_source = build_stage_source(lines, "fragment");
+
+   if (use_cache)
+   {
+      glslang_cache_path(cache_path, sizeof(cache_path), cache_dir,
+            vertex_source, fragment_source);
+
+      if (glslang_cache_load(cache_path, output))
+      {
+         RARCH_LOG("[slang]: Using cached SPIR-V for \"%s\".\n", shader_path);
+         return true;
+      }
+   }
+
+   RARCH_LOG("[slang]: Compiling shader \"%s\".\n", shader_path);
+
+   if (    !glslang::compile_spirv(vertex_source,
             glslang::StageVertex, &output->vertex))
    {
       RARCH_ERR("Failed to compile vertex shader stage.\n");
       return false;
    }
 
-   if (    !glslang::compile_spirv(build_stage_source(lines, "fragment"),
+   if (    !glslang::compile_spirv(fragment_source,
             glslang::StageFragment, &output->fragment))
    {
       RARCH_ERR("Failed to compile fragment shader stage.\n");
       return false;
    }
 
+   if (use_cache)
+      glslang_cache_save(cache_path, output);
+
    return true;
 }
-
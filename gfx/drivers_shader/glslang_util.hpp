@@ -87,8 +87,14 @@ struct glslang_output
    glslang_meta meta;
 };
 
-bool glslang_compile_shader(const char *shader_path, glslang_output *output);
+/* If cache_dir is non-empty, compiled SPIR-V is looked up in and
+ * stored to <cache_dir>/slang/, keyed on the preprocessed source
+ * and the compiler revision, so warm loads skip glslang entirely. */
+bool glslang_compile_shader(const char *shader_path,
+      const char *cache_dir, glslang_output *output);
 const char *glslang_format_to_string(enum glslang_format fmt);
+/* Frees the compiler state of the calling thread. */
+void glslang_detach_thread(void);
 
 // Helpers for internal use.
 bool glslang_read_shader_file(const char *path, std::vector<std::string> *output, bool root_file);
@@ -2850,23 +2850,86 @@ error:
    return false;
 }
 
-vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
-      const struct vulkan_filter_chain_create_info *info,
-      const char *path, vulkan_filter_chain_filter filter)
+struct vulkan_filter_chain_preset
+{
+   unique_ptr<video_shader> shader;
+   unique_ptr<config_file_t, ConfigDeleter> conf;
+   vector<glslang_output> passes;
+};
+
+vulkan_filter_chain_preset_t *vulkan_filter_chain_preset_compile(
+      const char *path, const char *shader_cache_dir)
 {
    unsigned i;
-   unique_ptr<video_shader> shader{ new video_shader() };
-   if (!shader)
+   unique_ptr<vulkan_filter_chain_preset> preset{ new vulkan_filter_chain_preset() };
+   if (!preset)
+      return nullptr;
+
+   preset->shader.reset(new video_shader());
+   if (!preset->shader)
       return nullptr;
 
-   unique_ptr<config_file_t, ConfigDeleter> conf{ config_file_new(path) };
-   if (!conf)
+   preset->conf.reset(config_file_new(path));
+   if (!preset->conf)
       return nullptr;
 
-   if (!video_shader_read_conf_cgp(conf.get(), shader.get()))
+   if (!video_shader_read_conf_cgp(preset->conf.get(), preset->shader.get()))
+      return nullptr;
+
+   video_shader_resolve_relative(preset->shader.get(), path);
+
+   preset->passes.resize(preset->shader->passes);
+
+   for (i = 0; i < preset->shader->passes; i++)
+   {
+      const video_shader_pass *pass = &preset->shader->pass[i];
+
+      if (!glslang_compile_shader(pass->source.path,
+               shader_cache_dir, &preset->passes[i]))
+      {
+         RARCH_ERR("Failed to compile shader: \"%s\".\n",
+               pass->source.path);
+         return nullptr;
+      }
+   }
+
+   return preset.release();
+}
+
+void vulkan_filter_chain_preset_free(vulkan_filter_chain_preset_t *preset)
+{
+   delete preset;
+}
+
+void vulkan_filter_chain_preset_compile_deinit(void)
+{
+   glslang_detach_thread();
+}
+
+vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
+      const struct vulkan_filter_chain_create_info *info,
+      const char *path, vulkan_filter_chain_filter filter)
+{
+   unique_ptr<vulkan_filter_chain_preset> preset{
+      vulkan_filter_chain_preset_compile(path, info->shader_cache_dir) };
+   if (!preset)
       return nullptr;
 
-   video_shader_resolve_relative(shader.get(), path);
+   return vulkan_filter_chain_create_from_compiled_preset(
+         info, preset.get(), filter);
+}
+
+vulkan_filter_chain_t *vulkan_filter_chain_create_from_compiled_preset(
+      const struct vulkan_filter_chain_create_info *info,
+      vulkan_filter_chain_preset_t *preset,
+      vulkan_filter_chain_filter filter)
+{
+   unsigned i;
+   /* The chain takes ownership of the parsed preset. */
+   unique_ptr<video_shader> shader = move(preset->shader);
+   config_file_t *conf             = preset->conf.get();
+   if (!shader)
+      return nullptr;
 
    bool last_pass_is_fbo = shader->pass[shader->passes - 1].fbo.valid;
    auto tmpinfo          = *info;
@@ -2883,7 +2946,7 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
 
    for (i = 0; i < shader->passes; i++)
    {
-      glslang_output output;
+      glslang_output &output = preset->passes[i];
       struct vulkan_filter_chain_pass_info pass_info;
       const video_shader_pass *pass      = &shader->pass[i];
       const video_shader_pass *next_pass =
@@ -2899,13 +2962,6 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
       pass_info.address       = VULKAN_FILTER_CHAIN_ADDRESS_REPEAT;
       pass_info.max_levels    = 0;
 
-      if (!glslang_compile_shader(pass->source.path, &output))
-      {
-         RARCH_ERR("Failed to compile shader: \"%s\".\n",
-               pass->source.path);
-         return nullptr;
-      }
-
       for (auto &meta_param : output.meta.parameters)
       {
          if (shader->num_parameters >= GFX_MAX_PARAMETERS)
@@ -3104,7 +3160,7 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
             sizeof(opaque_frag) / sizeof(uint32_t));
    }
 
-   if (!video_shader_resolve_current_parameters(conf.get(), shader.get()))
+   if (!video_shader_resolve_current_parameters(conf, shader.get()))
       return nullptr;
 
    chain->set_shader_preset(move(shader));
@@ -28,6 +28,7 @@
 RETRO_BEGIN_DECLS
 
 typedef struct vulkan_filter_chain vulkan_filter_chain_t;
+typedef struct vulkan_filter_chain_preset vulkan_filter_chain_preset_t;
 
 enum vulkan_filter_chain_filter
 {
@@ -98,6 +99,8 @@ struct vulkan_filter_chain_create_info
    VkPhysicalDevice gpu;
    const VkPhysicalDeviceMemoryProperties *memory_properties;
    VkPipelineCache pipeline_cache;
+   /* Directory for cached SPIR-V, NULL or empty to always compile. */
+   const char *shader_cache_dir;
    VkQueue queue;
    VkCommandPool command_pool;
    unsigned num_passes;
@@ -161,6 +164,23 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
       const struct vulkan_filter_chain_create_info *info,
       const char *path, enum vulkan_filter_chain_filter filter);
 
+/* Parses a preset and compiles all of its passes to SPIR-V.
+ * Does not touch the device, so it is safe to call from a
+ * worker thread while another chain is rendering. */
+vulkan_filter_chain_preset_t *vulkan_filter_chain_preset_compile(
+      const char *path, const char *shader_cache_dir);
+void vulkan_filter_chain_preset_free(vulkan_filter_chain_preset_t *preset);
+/* Releases the compiler state of a worker thread that called
+ * vulkan_filter_chain_preset_compile. Call before the thread exits. */
+void vulkan_filter_chain_preset_compile_deinit(void);
+
+/* Builds the GPU side of a chain from a compiled preset.
+ * Must be called from the thread owning the queue. */
+vulkan_filter_chain_t *vulkan_filter_chain_create_from_compiled_preset(
+      const struct vulkan_filter_chain_create_info *info,
+      vulkan_filter_chain_preset_t *preset,
+      enum vulkan_filter_chain_filter filter);
+
 struct video_shader *vulkan_filter_chain_get_preset(
       vulkan_filter_chain_t *chain);
 
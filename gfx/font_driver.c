@@ -25,6 +25,9 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
+
+#include <encodings/utf.h>
 
 static const font_renderer_driver_t *font_backends[] = {
 #ifdef HAVE_FREETYPE
@@ -46,6 +49,246 @@ static const font_renderer_driver_t *font_backends[] = {
 
 static void *video_font_driver = NULL;
 
+static uint32_t font_glyph_run_hash(const char *msg, unsigned msg_len)
+{
+   unsigned i;
+   uint32_t hash = 5381;
+
+   for (i = 0; i < msg_len; i++)
+      hash = (hash << 5) + hash + (uint8_t)msg[i];
+
+   return hash;
+}
+
+static bool font_glyph_run_layout(font_glyph_run_t *run,
+      const font_renderer_driver_t *driver, void *font_data,
+      const char *msg, unsigned msg_len)
+{
+   unsigned i;
+   int pen_x           = 0;
+   int pen_y           = 0;
+   const char *msg_end = msg + msg_len;
+
+   /* Every glyph takes at least one byte. */
+   if (!run->glyphs || run->capacity < msg_len)
+   {
+      char *new_msg                   = (char*)realloc(run->msg, msg_len + 1);
+      struct font_run_glyph *glyphs   = NULL;
+
+      if (!new_msg)
+         return false;
+      run->msg = new_msg;
+
+      glyphs   = (struct font_run_glyph*)
+         realloc(run->glyphs, (msg_len + 1) * sizeof(*glyphs));
+      if (!glyphs)
+         return false;
+      run->glyphs   = glyphs;
+      run->capacity = msg_len;
+   }
+
+   memcpy(run->msg, msg, msg_len);
+   run->msg[msg_len] = '\0';
+   run->msg_len      = msg_len;
+   run->count        = 0;
+
+   for (i = 0; i < FONT_GLYPH_RUN_VERTEX_SETS; i++)
+      run->vertex_sets[i].valid = false;
+
+   while (msg < msg_end)
+   {
+      struct font_run_glyph *item    = NULL;
+      unsigned code                  = utf8_walk(&msg);
+      const struct font_glyph *glyph = driver->get_glyph(font_data, code);
+
+      if (!glyph) /* Do something smarter here ... */
+         glyph = driver->get_glyph(font_data, '?');
+      if (!glyph)
+         continue;
+
+      item        = &run->glyphs[run->count++];
+      item->pen_x = pen_x;
+      item->pen_y = pen_y;
+      item->glyph = *glyph;
+
+      pen_x      += glyph->advance_x;
+      pen_y      += glyph->advance_y;
+   }
+
+   run->width = pen_x;
+
+   return true;
+}
+
+/**
+ * font_glyph_run_cache_get:
+ * @cache                : Glyph run cache of the font.
+ * @driver               : Font renderer backend.
+ * @font_data            : Font renderer backend handle.
+ * @msg                  : Line of text, need not be NUL-terminated.
+ * @msg_len              : Length of @msg in bytes.
+ *
+ * Looks up the layout of @msg, laying it out again when it is
+ * not cached or a glyph was evicted from the atlas since it was.
+ * Uploading new glyphs alone keeps the cached runs.
+ *
+ * Returns: the glyph run, valid until the next call, or NULL
+ * on allocation failure.
+ **/
+font_glyph_run_t *font_glyph_run_cache_get(
+      font_glyph_run_cache_t *cache,
+      const font_renderer_driver_t *driver, void *font_data,
+      const char *msg, unsigned msg_len)
+{
+   uint32_t hash            = font_glyph_run_hash(msg, msg_len);
+   font_glyph_run_t *run    = &cache->runs[
+      hash & (FONT_GLYPH_RUN_CACHE_SIZE - 1)];
+   struct font_atlas *atlas = driver->get_atlas
+      ? driver->get_atlas(font_data) : NULL;
+
+   if (atlas && atlas->generation != cache->generation)
+   {
+      font_glyph_run_cache_clear(cache);
+      cache->generation = atlas->generation;
+   }
+   else if (run->valid
+         && run->hash    == hash
+         && run->msg_len == msg_len
+         && !memcmp(run->msg, msg, msg_len))
+      return run;
+
+   run->valid = false;
+
+   if (!font_glyph_run_layout(run, driver, font_data, msg, msg_len))
+      return NULL;
+
+   /* Rasterizing a new glyph may have evicted one that other
+    * runs still point at. */
+   if (atlas && atlas->generation != cache->generation)
+   {
+      font_glyph_run_cache_clear(cache);
+      cache->generation = atlas->generation;
+   }
+
+   run->hash  = hash;
+   run->valid = true;
+
+   return run;
+}
+
+static bool font_run_vertex_key_equal(const font_run_vertex_key_t *a,
+      const font_run_vertex_key_t *b)
+{
+   return a->x          == b->x
+      &&  a->y          == b->y
+      &&  a->scale      == b->scale
+      &&  a->color[0]   == b->color[0]
+      &&  a->color[1]   == b->color[1]
+      &&  a->color[2]   == b->color[2]
+      &&  a->color[3]   == b->color[3]
+      &&  a->width      == b->width
+      &&  a->height     == b->height
+      &&  a->tex_width  == b->tex_width
+      &&  a->tex_height == b->tex_height;
+}
+
+/**
+ * font_glyph_run_get_vertices:
+ * @run                  : Glyph run.
+ * @key                  : Parameters the vertices are wanted for.
+ *
+ * Returns: the vertices a font driver built for @run with
+ * font_glyph_run_new_vertices() and the same @key, or NULL.
+ **/
+const void *font_glyph_run_get_vertices(const font_glyph_run_t *run,
+      const font_run_vertex_key_t *key)
+{
+   unsigned i;
+
+   for (i = 0; i < FONT_GLYPH_RUN_VERTEX_SETS; i++)
+   {
+      const font_run_vertex_set_t *set = &run->vertex_sets[i];
+
+      if (set->valid && font_run_vertex_key_equal(&set->key, key))
+         return set->data;
+   }
+
+   return NULL;
+}
+
+/**
+ * font_glyph_run_new_vertices:
+ * @run                  : Glyph run.
+ * @key                  : Parameters the vertices are built for.
+ * @size                 : Size of the vertices in bytes.
+ *
+ * Replaces the oldest vertex set of @run with one for @key.
+ * The font driver builds its vertices in the returned buffer,
+ * and font_glyph_run_get_vertices() hands them back until the
+ * run is laid out again.
+ *
+ * Returns: a buffer of @size bytes, or NULL on allocation failure.
+ **/
+void *font_glyph_run_new_vertices(font_glyph_run_t *run,
+      const font_run_vertex_key_t *key, size_t size)
+{
+   font_run_vertex_set_t *set = &run->vertex_sets[run->next_vertex_set];
+
+   run->next_vertex_set = (run->next_vertex_set + 1)
+      % FONT_GLYPH_RUN_VERTEX_SETS;
+   set->valid           = false;
+
+   if (!set->data || set->capacity < size)
+   {
+      void *data = realloc(set->data, size);
+
+      if (!data)
+         return NULL;
+      set->data     = data;
+      set->capacity = size;
+   }
+
+   set->key   = *key;
+   set->valid = true;
+
+   return set->data;
+}
+
+void font_glyph_run_cache_clear(font_glyph_run_cache_t *cache)
+{
+   unsigned i;
+
+   for (i = 0; i < FONT_GLYPH_RUN_CACHE_SIZE; i++)
+      cache->runs[i].valid = false;
+}
+
+void font_glyph_run_cache_free(font_glyph_run_cache_t *cache)
+{
+   unsigned i;
+
+   for (i = 0; i < FONT_GLYPH_RUN_CACHE_SIZE; i++)
+   {
+      unsigned j;
+      font_glyph_run_t *run = &cache->runs[i];
+
+      for (j = 0; j < FONT_GLYPH_RUN_VERTEX_SETS; j++)
+      {
+         free(run->vertex_sets[j].data);
+         run->vertex_sets[j].data     = NULL;
+         run->vertex_sets[j].capacity = 0;
+         run->vertex_sets[j].valid    = false;
+      }
+
+      free(run->msg);
+      free(run->glyphs);
+
+      run->msg      = NULL;
+      run->glyphs   = NULL;
+      run->capacity = 0;
+      run->valid    = false;
+   }
+}
+
 int font_renderer_create_default(const void **data, void **handle,
       const char *font_path, unsigned font_size)
 {
@@ -80,6 +80,9 @@ struct font_atlas
    unsigned width;
    unsigned height;
    bool dirty;
+   /* Bumped when a glyph handed out earlier is evicted and its
+    * slot reused, unlike dirty which is set on every upload. */
+   unsigned generation;
 };
 
 struct font_params
@@ -136,6 +139,76 @@ typedef struct font_renderer_driver
    int (*get_line_height)(void* data);
 } font_renderer_driver_t;
 
+#define FONT_GLYPH_RUN_CACHE_SIZE 256
+
+/* Vertex sets kept per run: enough for a message and its
+ * drop shadow, drawn every frame with different parameters. */
+#define FONT_GLYPH_RUN_VERTEX_SETS 2
+
+/* A glyph of a laid-out line, along with the unscaled pen
+ * position it is drawn at relative to the start of the line. */
+struct font_run_glyph
+{
+   int pen_x;
+   int pen_y;
+   struct font_glyph glyph;
+};
+
+/* What the vertices of a run depend on besides the run itself:
+ * the pen position in pixels once aligned, the scale, the color,
+ * and the viewport and atlas texture sizes. */
+typedef struct font_run_vertex_key
+{
+   int x;
+   int y;
+   float scale;
+   float color[4];
+   unsigned width;
+   unsigned height;
+   unsigned tex_width;
+   unsigned tex_height;
+} font_run_vertex_key_t;
+
+/* Vertices a font driver built for a run, in its own format,
+ * ready to be submitted again while the key stays the same. */
+typedef struct font_run_vertex_set
+{
+   font_run_vertex_key_t key;
+   void *data;
+   size_t capacity;
+   bool valid;
+} font_run_vertex_set_t;
+
+/* A line of text laid out against a font atlas. */
+typedef struct font_glyph_run
+{
+   char *msg;
+   unsigned msg_len;
+   unsigned capacity;
+   uint32_t hash;
+   bool valid;
+
+   /* Sum of the glyph advances, unscaled. */
+   int width;
+
+   unsigned count;
+   struct font_run_glyph *glyphs;
+
+   /* Dropped whenever the run is laid out again. */
+   unsigned next_vertex_set;
+   font_run_vertex_set_t vertex_sets[FONT_GLYPH_RUN_VERTEX_SETS];
+} font_glyph_run_t;
+
+/* Laid-out lines of a single font, keyed on their text.
+ * Every run is dropped when the atlas generation changes, since
+ * renderers with a glyph LRU may hand an evicted glyph's
+ * atlas slot to a different code point. */
+typedef struct font_glyph_run_cache
+{
+   unsigned generation;
+   font_glyph_run_t runs[FONT_GLYPH_RUN_CACHE_SIZE];
+} font_glyph_run_cache_t;
+
 typedef struct
 {
    const font_renderer_t *renderer;
@@ -147,6 +220,21 @@ typedef struct
 int font_renderer_create_default(const void **driver,
       void **handle, const char *font_path, unsigned font_size);
       
+font_glyph_run_t *font_glyph_run_cache_get(
+      font_glyph_run_cache_t *cache,
+      const font_renderer_driver_t *driver, void *font_data,
+      const char *msg, unsigned msg_len);
+
+const void *font_glyph_run_get_vertices(const font_glyph_run_t *run,
+      const font_run_vertex_key_t *key);
+
+void *font_glyph_run_new_vertices(font_glyph_run_t *run,
+      const font_run_vertex_key_t *key, size_t size);
+
+void font_glyph_run_cache_clear(font_glyph_run_cache_t *cache);
+
+void font_glyph_run_cache_free(font_glyph_run_cache_t *cache);
+
 void font_driver_render_msg(video_frame_info_t *video_info,
       void *font_data, const char *msg, const void *params);
 
@@ -15,6 +15,7 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <compat/strl.h>
@@ -64,6 +65,7 @@
 #include "../core.h"
 #include "../command.h"
 #include "../msg_hash.h"
+#include "../performance_counters.h"
 #include "../verbosity.h"
 
 #define MEASURE_FRAME_TIME_SAMPLES_COUNT (2 * 1024)
@@ -162,6 +164,15 @@ static bool video_driver_window_title_update             = true;
 
 static retro_time_t video_driver_frame_time_samples[MEASURE_FRAME_TIME_SAMPLES_COUNT];
 static uint64_t video_driver_frame_time_count            = 0;
+/* Refresh periods missed by frames that arrived late. */
+static uint64_t video_driver_frame_drop_count            = 0;
+/* Last frame taken into account for the drop count, 0 while
+ * the content is not running at its normal pace. */
+static retro_time_t video_driver_frame_drop_time         = 0;
+static struct retro_perf_counter video_filter_perf;
+static struct retro_perf_counter video_present_perf;
+/* Time at which the core last handed over a frame. */
+static retro_time_t video_driver_frame_time_last           = 0;
 static uint64_t video_driver_frame_count                 = 0;
 
 static void *video_driver_data                           = NULL;
@@ -189,6 +200,13 @@ hw_render_context_negotiation                            = NULL;
 static bool video_driver_use_rgba                        = false;
 static bool video_driver_data_own                        = false;
 static bool video_driver_active                          = false;
+static bool video_driver_discard_frames                  = false;
+
+/* Drivers that build shaders off-thread report back here;
+ * the main thread, which owns the settings, reads it. */
+static bool video_driver_shader_pending                  = false;
+static bool video_driver_shader_failed                   = false;
+static char video_driver_shader_failed_path[PATH_MAX_LENGTH] = {0};
 
 static video_driver_frame_t frame_bak                    = NULL;
 
@@ -635,6 +653,72 @@ bool video_driver_set_shader(enum rarch_shader_type type,
    return false;
 }
 
+/**
+ * video_driver_set_shader_pending:
+ * @pending              : true if the last set_shader call returned
+ *                         before the shader was built.
+ *
+ * Called by the video driver, on any thread. A pending shader
+ * that builds fine is reported with @pending false.
+ **/
+void video_driver_set_shader_pending(bool pending)
+{
+   video_driver_lock();
+   video_driver_shader_pending = pending;
+   video_driver_unlock();
+}
+
+/**
+ * video_driver_set_shader_failed:
+ * @path                 : Path of the pending shader.
+ *
+ * Called by the video driver, on any thread, when a pending
+ * shader failed to build and the previous one was kept.
+ **/
+void video_driver_set_shader_failed(const char *path)
+{
+   video_driver_lock();
+   video_driver_shader_pending = false;
+   video_driver_shader_failed  = true;
+   strlcpy(video_driver_shader_failed_path, path ? path : "",
+         sizeof(video_driver_shader_failed_path));
+   video_driver_unlock();
+}
+
+bool video_driver_is_shader_pending(void)
+{
+   bool pending;
+
+   video_driver_lock();
+   pending = video_driver_shader_pending;
+   video_driver_unlock();
+
+   return pending;
+}
+
+/**
+ * video_driver_get_shader_failed:
+ * @s                    : Output for the path of the failed shader.
+ * @len                  : Size of @s.
+ *
+ * Takes the failure reported by video_driver_set_shader_failed().
+ *
+ * Returns: true if a pending shader failed since the last call.
+ **/
+bool video_driver_get_shader_failed(char *s, size_t len)
+{
+   bool failed;
+
+   video_driver_lock();
+   failed = video_driver_shader_failed;
+   if (failed)
+      strlcpy(s, video_driver_shader_failed_path, len);
+   video_driver_shader_failed = false;
+   video_driver_unlock();
+
+   return failed;
+}
+
 static void video_driver_filter_free(void)
 {
    if (video_driver_state_filter)
@@ -1321,6 +1405,71 @@ bool video_monitor_fps_statistics(double *refresh_rate,
 
 
 
+/**
+ * video_driver_get_frame_time_last:
+ *
+ * Returns: time (in microseconds) at which the core last
+ * handed a frame to the video driver, before it was rendered.
+ **/
+retro_time_t video_driver_get_frame_time_last(void)
+{
+   return video_driver_frame_time_last;
+}
+
+static int video_driver_frame_time_cmp(const void *a, const void *b)
+{
+   retro_time_t x = *(const retro_time_t*)a;
+   retro_time_t y = *(const retro_time_t*)b;
+   return (x > y) - (x < y);
+}
+
+/**
+ * video_driver_get_frame_time_stats:
+ * @stats              : Statistics to fill in.
+ *
+ * Computes frame time percentiles over the last
+ * MEASURE_FRAME_TIME_SAMPLES_COUNT frames, along with the
+ * total amount of frames and dropped frames.
+ *
+ * Can be called from another thread; samples may be
+ * slightly stale in that case.
+ *
+ * Returns: true (1) if there were frame time samples
+ * to compute percentiles from, otherwise false (0).
+ **/
+bool video_driver_get_frame_time_stats(video_frame_time_stats_t *stats)
+{
+   retro_time_t *sorted = NULL;
+   unsigned samples     = MIN(MEASURE_FRAME_TIME_SAMPLES_COUNT,
+         (unsigned)video_driver_frame_time_count);
+
+   if (!stats)
+      return false;
+
+   memset(stats, 0, sizeof(*stats));
+   stats->frames  = video_driver_frame_count;
+   stats->dropped = video_driver_frame_drop_count;
+
+   if (samples == 0)
+      return false;
+
+   sorted = (retro_time_t*)malloc(samples * sizeof(*sorted));
+   if (!sorted)
+      return false;
+
+   memcpy(sorted, video_driver_frame_time_samples,
+         samples * sizeof(*sorted));
+   qsort(sorted, samples, sizeof(*sorted), video_driver_frame_time_cmp);
+
+   stats->samples = samples;
+   stats->p50     = sorted[(samples - 1) * 50 / 100];
+   stats->p95     = sorted[(samples - 1) * 95 / 100];
+   stats->p99     = sorted[(samples - 1) * 99 / 100];
+
+   free(sorted);
+   return true;
+}
+
 float video_driver_get_aspect_ratio(void)
 {
    return video_driver_aspect_ratio;
@@ -1763,6 +1912,8 @@ void video_driver_free(void)
 void video_driver_monitor_reset(void)
 {
    video_driver_frame_time_count = 0;
+   video_driver_frame_drop_count = 0;
+   video_driver_frame_drop_time  = 0;
 }
 
 void video_driver_set_aspect_ratio(void)
@@ -2055,6 +2206,13 @@ bool video_driver_is_active(void)
    return video_driver_active;
 }
 
+/* Frames the core hands over while set are dropped,
+ * e.g. the frames run-ahead runs and rolls back. */
+void video_driver_set_discard_frames(bool discard)
+{
+   video_driver_discard_frames = discard;
+}
+
 void video_driver_get_record_status(
       bool *has_gpu_record, 
       uint8_t **gpu_buf)
@@ -2254,9 +2412,13 @@ void video_driver_frame(const void *data, unsigned width,
    retro_time_t        new_time                      = 
       cpu_features_get_time_usec();
 
-   if (!video_driver_active)
+   if (!video_driver_active || video_driver_discard_frames)
       return;
 
+   video_driver_frame_time_last = new_time;
+
+   FRAME_TRACE_BEGIN(FRAME_TRACE_VIDEO_FRAME);
+
    if (video_driver_scaler_ptr && data &&
          (video_driver_pix_fmt == RETRO_PIXEL_FORMAT_0RGB1555) &&
          (data != RETRO_HW_FRAME_BUFFER_VALID))
@@ -2287,6 +2449,36 @@ void video_driver_frame(const void *data, unsigned width,
          video_driver_frame_time_count++ & 
          (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1);
       video_driver_frame_time_samples[write_index] = new_time - fps_time;
+
+      /* A frame arriving n refresh periods after the previous one
+       * means n - 1 frames were dropped. Pausing, the menu, fast
+       * forward and slow motion are not drops, so the baseline is
+       * reset while any of them is active. */
+      if (     video_info.runloop_is_paused
+            || video_info.runloop_is_idle
+            || video_info.runloop_is_slowmotion
+            || video_info.menu_is_alive
+            || video_info.input_driver_nonblock_state
+            || video_info.refresh_rate <= 0.0f)
+         video_driver_frame_drop_time = 0;
+      else
+      {
+         if (video_driver_frame_drop_time)
+         {
+            retro_time_t period = (retro_time_t)
+               (1000000.0f / video_info.refresh_rate);
+            retro_time_t gap    = new_time - video_driver_frame_drop_time;
+
+            /* Round to the nearest period so jitter under half
+             * a period is not counted. */
+            if (period > 0 && gap * 2 > period * 3)
+               video_driver_frame_drop_count +=
+                  (uint64_t)((gap + period / 2) / period - 1);
+         }
+
+         video_driver_frame_drop_time = new_time;
+      }
+
       fps_time                                     = new_time;
 
       if ((video_driver_frame_count % FPS_UPDATE_INTERVAL) == 0)
@@ -2367,6 +2559,10 @@ void video_driver_frame(const void *data, unsigned width,
       )
       recording_dump_frame(data, width, height, pitch, video_info.runloop_is_idle);
 
+   FRAME_TRACE_BEGIN(FRAME_TRACE_VIDEO_FILTER);
+   performance_counter_init(video_filter_perf, "video_filter");
+   performance_counter_start_plus(video_info.is_perfcnt_enable,
+         video_filter_perf);
    if (data && video_driver_state_filter &&
          video_driver_frame_filter(data, &video_info, width, height, pitch,
             &output_width, &output_height, &output_pitch))
@@ -2376,6 +2572,9 @@ void video_driver_frame(const void *data, unsigned width,
       height = output_height;
       pitch  = output_pitch;
    }
+   performance_counter_stop_plus(video_info.is_perfcnt_enable,
+         video_filter_perf);
+   FRAME_TRACE_END(FRAME_TRACE_VIDEO_FILTER);
 
    video_driver_msg[0] = '\0';
 
@@ -2384,15 +2583,24 @@ void video_driver_frame(const void *data, unsigned width,
          && msg)
       strlcpy(video_driver_msg, msg, sizeof(video_driver_msg));
 
+   FRAME_TRACE_BEGIN(FRAME_TRACE_PRESENT);
+   performance_counter_init(video_present_perf, "video_present");
+   performance_counter_start_plus(video_info.is_perfcnt_enable,
+         video_present_perf);
    video_driver_active = current_video->frame(
          video_driver_data, data, width, height,
          video_driver_frame_count,
          (unsigned)pitch, video_driver_msg, &video_info);
+   performance_counter_stop_plus(video_info.is_perfcnt_enable,
+         video_present_perf);
+   FRAME_TRACE_END(FRAME_TRACE_PRESENT);
 
    video_driver_frame_count++;
 
    if (video_info.fps_show)
       runloop_msg_queue_push(video_info.fps_text, 1, 1, false);
+
+   FRAME_TRACE_END(FRAME_TRACE_VIDEO_FRAME);
 }
 
 void video_driver_display_type_set(enum rarch_display_type type)
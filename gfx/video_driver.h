@@ -405,6 +405,17 @@ typedef struct video_info
 #endif
 } video_info_t;
 
+typedef struct video_frame_time_stats
+{
+   /* Frame time percentiles, in microseconds. */
+   retro_time_t p50;
+   retro_time_t p95;
+   retro_time_t p99;
+   unsigned samples;
+   uint64_t frames;
+   uint64_t dropped;
+} video_frame_time_stats_t;
+
 typedef struct video_frame_info
 {
    bool input_driver_nonblock_state;
@@ -876,6 +887,7 @@ void video_driver_set_video_cache_context_ack(void);
 bool video_driver_is_video_cache_context_ack(void);
 void video_driver_set_active(void);
 bool video_driver_is_active(void);
+void video_driver_set_discard_frames(bool discard);
 bool video_driver_gpu_record_init(unsigned size);
 void video_driver_gpu_record_deinit(void);
 bool video_driver_get_current_software_framebuffer(struct 
@@ -938,6 +950,14 @@ retro_proc_address_t video_driver_get_proc_address(const char *sym);
 bool video_driver_set_shader(enum rarch_shader_type type,
       const char *shader);
 
+void video_driver_set_shader_pending(bool pending);
+
+void video_driver_set_shader_failed(const char *path);
+
+bool video_driver_is_shader_pending(void);
+
+bool video_driver_get_shader_failed(char *s, size_t len);
+
 bool video_driver_set_rotation(unsigned rotation);
 
 bool video_driver_set_video_mode(unsigned width,
@@ -1021,6 +1041,10 @@ struct video_viewport *video_viewport_get_custom(void);
  **/
 void video_monitor_set_refresh_rate(float hz);
 
+retro_time_t video_driver_get_frame_time_last(void);
+
+bool video_driver_get_frame_time_stats(video_frame_time_stats_t *stats);
+
 /**
  * video_monitor_fps_statistics
  * @refresh_rate       : Monitor refresh rate.
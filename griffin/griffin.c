@@ -73,6 +73,7 @@ COMPRESSION
 
 #ifdef HAVE_ZLIB
 #include "../libretro-common/streams/trans_stream_zlib.c"
+#include "../libretro-common/streams/zip_stream.c"
 #endif
 
 /*============================================================
@@ -112,6 +113,9 @@ COMPATIBILITY
 
 #include "../libretro-common/compat/compat_fnmatch.c"
 #include "../libretro-common/memmap/memalign.c"
+#ifdef HAVE_MMAP
+#include "../libretro-common/memmap/memmap.c"
+#endif
 
 /*============================================================
 CONFIG FILE
@@ -1012,6 +1016,7 @@ MENU
 #include "../menu/menu_shader.c"
 #include "../menu/menu_displaylist.c"
 #include "../menu/menu_animation.c"
+#include "../menu/menu_thumbnail_cache.c"
 
 #include "../menu/drivers/null.c"
 #include "../menu/drivers/menu_generic.c"
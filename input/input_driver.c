@@ -45,6 +45,7 @@
 #include "../movie.h"
 #include "../list_special.h"
 #include "../verbosity.h"
+#include "../performance_counters.h"
 #include "../tasks/tasks_internal.h"
 #include "../command.h"
 
@@ -387,7 +388,9 @@ void input_poll(void)
    settings_t *settings           = config_get_ptr();
    unsigned max_users             = input_driver_max_users;
    
+   FRAME_TRACE_BEGIN(FRAME_TRACE_INPUT_POLL);
    current_input->poll(current_input_data);
+   FRAME_TRACE_END(FRAME_TRACE_INPUT_POLL);
 
    input_driver_turbo_btns.count++;
 
@@ -869,6 +869,8 @@ MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_AUTO_LOAD,
       "savestate_auto_load")
 MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_THUMBNAIL_ENABLE,
       "savestate_thumbnails")
+MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION,
+      "savestate_file_compression")
 MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_AUTO_SAVE,
       "savestate_auto_save")
 MSG_HASH(MENU_ENUM_LABEL_SAVESTATE_DIRECTORY,
@@ -955,6 +957,8 @@ MSG_HASH(MENU_ENUM_LABEL_THREADED_DATA_RUNLOOP_ENABLE,
       "threaded_data_runloop_enable")
 MSG_HASH(MENU_ENUM_LABEL_THUMBNAILS,
       "thumbnails")
+MSG_HASH(MENU_ENUM_LABEL_THUMBNAIL_CACHE_SIZE,
+      "menu_thumbnail_cache_size")
 MSG_HASH(MENU_ENUM_LABEL_THUMBNAILS_DIRECTORY,
       "thumbnails_directory")
 MSG_HASH(MENU_ENUM_LABEL_THUMBNAILS_UPDATER_LIST,
@@ -1043,6 +1047,12 @@ MSG_HASH(MENU_ENUM_LABEL_VIDEO_FORCE_SRGB_DISABLE,
       "video_force_srgb_disable")
 MSG_HASH(MENU_ENUM_LABEL_VIDEO_FRAME_DELAY,
       "video_frame_delay")
+MSG_HASH(MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
+      "video_frame_delay_auto")
+MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,
+      "run_ahead_enabled")
+MSG_HASH(MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,
+      "run_ahead_frames")
 MSG_HASH(MENU_ENUM_LABEL_VIDEO_FULLSCREEN,
       "video_fullscreen")
 MSG_HASH(MENU_ENUM_LABEL_VIDEO_GAMMA,
@@ -1321,6 +1321,17 @@ int menu_hash_get_help_us_enum(enum msg_hash_enums msg, char *s, size_t len) {
                              "with this path on startup if 'Auto Load State\n"
                              "is enabled.");
             break;
+        case MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION:
+            snprintf(s, len,
+                     "Compress savestates written to disk.\n"
+                             " \n"
+                             "States are compressed in the background\n"
+                             "and take a fraction of the space, at the\n"
+                             "cost of some time spent saving and loading.\n"
+                             " \n"
+                             "Savestates are loaded whether they are\n"
+                             "compressed or not.");
+            break;
         case MENU_ENUM_LABEL_VIDEO_THREADED:
             snprintf(s, len,
                      "Use threaded video driver.\n"
@@ -1364,6 +1375,34 @@ int menu_hash_get_help_us_enum(enum msg_hash_enums msg, char *s, size_t len) {
                              " \n"
                              "Maximum is 15.");
             break;
+        case MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO:
+            snprintf(s, len,
+                     "Picks the frame delay automatically.\n"
+                             " \n"
+                             "The time the core takes to run a frame\n"
+                             "is measured over the last frames, and\n"
+                             "the largest delay that still leaves room\n"
+                             "for it is used. The delay backs off as\n"
+                             "soon as a frame runs late.\n"
+                             " \n"
+                             "The chosen delay is reported by the\n"
+                             "'frame_delay_*' frontend counters.");
+            break;
+        case MENU_ENUM_LABEL_RUN_AHEAD_FRAMES:
+            snprintf(s, len,
+                     "Sets how many frames the core is run\n"
+                             "ahead of the displayed frame.\n"
+                             " \n"
+                             "Each frame, the core state is saved,\n"
+                             "the extra frames are run without audio\n"
+                             "and the state is restored. Every frame\n"
+                             "costs about one extra run of the core.\n"
+                             " \n"
+                             "The measured cost is reported by the\n"
+                             "'run_ahead' frontend counter.\n"
+                             " \n"
+                             "Maximum is 6.");
+            break;
         case MENU_ENUM_LABEL_VIDEO_HARD_SYNC_FRAMES:
             snprintf(s, len,
                      "Sets how many frames CPU can \n"
@@ -1277,6 +1277,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_DIRECTORY,
       "Savestate")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_THUMBNAIL_ENABLE,
       "Savestate Thumbnails")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_COMPRESSION,
+      "Savestate Compression")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVE_CURRENT_CONFIG,
       "Save Current Configuration")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_SAVE_CURRENT_CONFIG_OVERRIDE_CORE,
@@ -1509,6 +1511,8 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_THREADED_DATA_RUNLOOP_ENABLE,
       "Threaded tasks")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAILS,
       "Thumbnails")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAIL_CACHE_SIZE,
+      "Thumbnail Cache Size (MB)")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAILS_DIRECTORY,
       "Thumbnails")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_THUMBNAILS_UPDATER_LIST,
@@ -1609,6 +1613,12 @@ MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FORCE_SRGB_DISABLE,
       "Force-disable sRGB FBO")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY,
       "Frame Delay")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO,
+      "Automatic Frame Delay")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_RUN_AHEAD_ENABLED,
+      "Run-Ahead to Reduce Latency")
+MSG_HASH(MENU_ENUM_LABEL_VALUE_RUN_AHEAD_FRAMES,
+      "Number of Frames to Run Ahead")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_FULLSCREEN,
       "Use Fullscreen Mode")
 MSG_HASH(MENU_ENUM_LABEL_VALUE_VIDEO_GAMMA,
@@ -1855,6 +1865,12 @@ MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_BLACK_FRAME_INSERTION,
       "Inserts a black frame inbetween frames. Useful for users with 120Hz screens who want to play 60Hz content to eliminate ghosting.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY,
       "Reduces latency at the cost of a higher risk of video stuttering. Adds a delay after V-Sync (in ms).")
+MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_FRAME_DELAY_AUTO,
+      "Picks the largest frame delay the core leaves room for, based on the time of the last frames. Overrides 'Frame Delay'.")
+MSG_HASH(MENU_ENUM_SUBLABEL_RUN_AHEAD_ENABLED,
+      "Runs the core ahead of the displayed frame and rolls it back with a savestate, hiding the core's own input lag. Needs a core with savestate support.")
+MSG_HASH(MENU_ENUM_SUBLABEL_RUN_AHEAD_FRAMES,
+      "How many frames to run ahead. Each frame costs roughly one extra core run; too many causes stuttering or jittery input.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_HARD_SYNC_FRAMES,
       "Sets how many frames the CPU can run ahead of the GPU when using 'Hard GPU Sync'.")
 MSG_HASH(MENU_ENUM_SUBLABEL_VIDEO_MAX_SWAPCHAIN_IMAGES,
@@ -2001,6 +2017,8 @@ MSG_HASH(MSG_FAILED_TO_LOAD_OVERLAY,
       "Failed to load overlay.")
 MSG_HASH(MSG_FAILED_TO_LOAD_STATE,
       "Failed to load state from")
+MSG_HASH(MSG_RUN_AHEAD_FAILED_TO_ROLL_BACK,
+      "Run-ahead failed to restore the core's state, closing content")
 MSG_HASH(MSG_FAILED_TO_OPEN_LIBRETRO_CORE,
       "Failed to open libretro core")
 MSG_HASH(MSG_FAILED_TO_PATCH,
@@ -2596,6 +2614,10 @@ MSG_HASH(
       MENU_ENUM_SUBLABEL_SAVESTATE_THUMBNAIL_ENABLE,
       "Show thumbnails of save states inside the menu."
       )
+MSG_HASH(
+      MENU_ENUM_SUBLABEL_SAVESTATE_FILE_COMPRESSION,
+      "Compress save states written to disk. Smaller files, at the cost of some time spent saving and loading."
+      )
 MSG_HASH(
       MENU_ENUM_SUBLABEL_AUTOSAVE_INTERVAL,
       "Autosaves the non-volatile Save RAM at a regular interval. This is disabled by default unless set otherwise. The interval is measured in seconds. A value of 0 disables autosave."
@@ -2756,6 +2778,10 @@ MSG_HASH(
       MENU_ENUM_SUBLABEL_THUMBNAILS,
       "Type of thumbnail to display."
       )
+MSG_HASH(
+      MENU_ENUM_SUBLABEL_THUMBNAIL_CACHE_SIZE,
+      "Memory used to keep thumbnails loaded while scrolling. Thumbnails of nearby entries are loaded ahead of time. 0 disables it."
+      )
 MSG_HASH(
       MENU_ENUM_SUBLABEL_TIMEDATE_ENABLE,
       "Shows current date and/or time inside the menu."
@@ -42,6 +42,9 @@
 #include <file/archive_file.h>
 #include <file/file_path.h>
 #include <streams/file_stream.h>
+#ifdef HAVE_ZLIB
+#include <streams/zip_stream.h>
+#endif
 #include <retro_miscellaneous.h>
 #include <lists/string_list.h>
 #include <string/stdstring.h>
@@ -152,6 +155,11 @@ error:
 }
 #endif
 
+#ifdef HAVE_ZLIB
+static int file_archive_zip_stream_read(const char *path, void **buf,
+      const char *optional_filename, ssize_t *length);
+#endif
+
 static int file_archive_get_file_list_cb(
       const char *path,
       const char *valid_exts,
@@ -484,6 +492,105 @@ static bool file_archive_walk(const char *file, const char *valid_exts,
    return returnerr;
 }
 
+#ifdef HAVE_ZLIB
+/* Same as file_archive_walk, but served from the cached central
+ * directory index instead of mapping and walking the archive.
+ * The callback gets no compressed data. */
+static bool file_archive_zip_walk_index(const char *file,
+      const char *valid_exts, file_archive_file_cb file_cb,
+      struct archive_extract_userdata *userdata)
+{
+   size_t i;
+   file_archive_zip_index_t *index = file_archive_zip_index_acquire(file);
+
+   if (!index)
+      return false;
+
+   strlcpy(userdata->archive_path, file, sizeof(userdata->archive_path));
+
+   for (i = 0; i < file_archive_zip_index_count(index); i++)
+   {
+      const struct file_archive_zip_entry *entry =
+         file_archive_zip_index_at(index, i);
+
+      userdata->extracted_file_path = (char*)entry->name;
+      userdata->crc                 = entry->crc32;
+
+      if (!file_cb(entry->name, valid_exts, NULL, entry->cmode,
+               entry->csize, entry->size, entry->crc32, userdata))
+         break;
+   }
+
+   userdata->extracted_file_path = NULL;
+   file_archive_zip_index_release(index);
+   return true;
+}
+
+/* Looks the member up in the central directory index and
+ * streams it out, rather than walking and mapping the archive. */
+static bool file_archive_zip_extract_file(const char *archive_path,
+      const struct string_list *ext_list,
+      const char *extraction_directory,
+      char *out_path, size_t len)
+{
+   size_t i;
+   char new_path[PATH_MAX_LENGTH];
+   char member_path[PATH_MAX_LENGTH];
+   ssize_t size                               = 0;
+   const struct file_archive_zip_entry *found = NULL;
+   const char *delim                = path_get_archive_delim(archive_path);
+   file_archive_zip_index_t *index  = file_archive_zip_index_acquire(archive_path);
+   bool ret                         = false;
+
+   if (!index)
+      return false;
+
+   /* Extract the first file that matches our list, or the
+    * requested one if the path names a file inside the archive. */
+   for (i = 0; i < file_archive_zip_index_count(index); i++)
+   {
+      const struct file_archive_zip_entry *entry =
+         file_archive_zip_index_at(index, i);
+      const char *ext = path_get_extension(entry->name);
+
+      if (!ext || !string_list_find_elem(ext_list, ext))
+         continue;
+      if (delim && !string_is_equal_noncase(entry->name, delim + 1))
+         continue;
+
+      found = entry;
+      break;
+   }
+
+   if (!found)
+      goto end;
+
+   new_path[0] = '\0';
+   if (extraction_directory)
+      fill_pathname_join(new_path, extraction_directory,
+            path_basename(found->name), sizeof(new_path));
+   else
+      fill_pathname_resolve_relative(new_path, archive_path,
+            path_basename(found->name), sizeof(new_path));
+
+   strlcpy(member_path, archive_path, sizeof(member_path));
+   if (delim)
+      member_path[delim - archive_path] = '\0';
+   strlcat(member_path, "#", sizeof(member_path));
+   strlcat(member_path, found->name, sizeof(member_path));
+
+   if (file_archive_zip_stream_read(member_path, NULL, new_path, &size))
+   {
+      strlcpy(out_path, new_path, len);
+      ret = true;
+   }
+
+end:
+   file_archive_zip_index_release(index);
+   return ret;
+}
+#endif
+
 int file_archive_parse_file_progress(file_archive_transfer_t *state)
 {
    /* FIXME: this estimate is worse than before */
@@ -546,6 +653,15 @@ bool file_archive_extract_file(
       goto end;
    }
 
+#ifdef HAVE_ZLIB
+   if (file_archive_get_file_backend(archive_path) == &zlib_backend)
+   {
+      ret = file_archive_zip_extract_file(archive_path, list,
+            extraction_directory, out_path, len);
+      goto end;
+   }
+#endif
+
    if (!file_archive_walk(archive_path, valid_exts,
             file_archive_extract_cb, &userdata))
    {
@@ -607,6 +723,12 @@ struct string_list *file_archive_get_file_list(const char *path,
    if (!userdata.list)
       goto error;
 
+#ifdef HAVE_ZLIB
+   if (file_archive_get_file_backend(path) == &zlib_backend)
+      ret = file_archive_zip_walk_index(path, valid_exts,
+            file_archive_get_file_list_cb, &userdata);
+   else
+#endif
    ret = file_archive_walk(path, valid_exts,
          file_archive_get_file_list_cb, &userdata);
 
@@ -716,6 +838,79 @@ error:
    return NULL;
 }
 
+#ifdef HAVE_ZLIB
+#define ARCHIVE_STREAM_CHUNK_SIZE (256 * 1024)
+
+/* Reads a ZIP member straight out of the archive instead of
+ * mapping the whole archive and inflating the member into a
+ * scratch buffer first. Extraction to optional_filename goes
+ * through a small chunk buffer, so memory use does not grow
+ * with the size of the member. */
+static int file_archive_zip_stream_read(const char *path, void **buf,
+      const char *optional_filename, ssize_t *length)
+{
+   ssize_t size;
+   uint8_t *data       = NULL;
+   RFILE *out          = NULL;
+   zipstream_t *stream = zipstream_open(path);
+
+   if (!stream)
+      goto error;
+
+   size = zipstream_get_size(stream);
+
+   if (optional_filename)
+   {
+      /* Called in case core has need_fullpath enabled. */
+      ssize_t done = 0;
+
+      out  = filestream_open(optional_filename, RFILE_MODE_WRITE, -1);
+      data = (uint8_t*)malloc(ARCHIVE_STREAM_CHUNK_SIZE);
+      if (!out || !data)
+         goto error;
+
+      while (done < size)
+      {
+         ssize_t ret = zipstream_read(stream, data, ARCHIVE_STREAM_CHUNK_SIZE);
+         if (ret <= 0 || filestream_write(out, data, ret) != ret)
+            goto error;
+         done += ret;
+      }
+
+      filestream_close(out);
+      free(data);
+      *length = 0;
+   }
+   else
+   {
+      /* Called in case core has need_fullpath disabled.
+       * Inflates directly into the buffer handed to the core. */
+      data = (uint8_t*)malloc(size ? size : 1);
+      if (!data || zipstream_read(stream, data, size) != size)
+         goto error;
+
+      *buf    = data;
+      *length = size;
+   }
+
+   zipstream_close(stream);
+   return 1;
+
+error:
+   if (out)
+   {
+      /* Don't leave a truncated file behind; it would be
+       * mistaken for a finished extraction next time. */
+      filestream_close(out);
+      remove(optional_filename);
+   }
+   free(data);
+   zipstream_close(stream);
+   *length = 0;
+   return 0;
+}
+#endif
+
 /* Generic compressed file loader.
  * Extracts to buf, unless optional_filename != 0
  * Then extracts to optional_filename and leaves buf alone.
@@ -752,6 +947,19 @@ int file_archive_compressed_read(
 
    backend = file_archive_get_file_backend(str_list->elems[0].data);
 
+   if (!backend)
+      goto error;
+
+#ifdef HAVE_ZLIB
+   if (backend == &zlib_backend)
+   {
+      ret = file_archive_zip_stream_read(path, buf,
+            optional_filename, length);
+      string_list_free(str_list);
+      return ret;
+   }
+#endif
+
    *length = backend->compressed_file_read(str_list->elems[0].data,
          str_list->elems[1].data, buf, optional_filename);
 
@@ -768,6 +976,40 @@ error:
    return 0;
 }
 
+void file_archive_init(void)
+{
+#ifdef HAVE_ZLIB
+   file_archive_zip_index_init();
+#endif
+#ifdef HAVE_7ZIP
+   file_archive_7z_init();
+#endif
+}
+
+void file_archive_deinit(void)
+{
+#ifdef HAVE_ZLIB
+   file_archive_zip_index_deinit();
+#endif
+#ifdef HAVE_7ZIP
+   file_archive_7z_deinit();
+#endif
+}
+
+void file_archive_release_cache(void)
+{
+#ifdef HAVE_7ZIP
+   file_archive_7z_release_cache();
+#endif
+}
+
+void file_archive_set_cache_limit(size_t limit)
+{
+#ifdef HAVE_7ZIP
+   file_archive_7z_set_cache_limit(limit);
+#endif
+}
+
 const struct file_archive_file_backend *file_archive_get_zlib_file_backend(void)
 {
 #ifdef HAVE_ZLIB
@@ -849,6 +1091,30 @@ uint32_t file_archive_get_file_crc32(const char *path)
          archive_path += 1;
    }
 
+#ifdef HAVE_ZLIB
+   if (backend == &zlib_backend)
+   {
+      /* Straight from the central directory index */
+      uint32_t crc                               = 0;
+      const struct file_archive_zip_entry *entry = NULL;
+      file_archive_zip_index_t *index = file_archive_zip_index_acquire(path);
+
+      if (!index)
+         return 0;
+
+      if (archive_path)
+         entry = file_archive_zip_index_find(index, archive_path);
+      else
+         entry = file_archive_zip_index_at(index, 0);
+
+      if (entry)
+         crc = entry->crc32;
+
+      file_archive_zip_index_release(index);
+      return crc;
+   }
+#endif
+
    state.type          = ARCHIVE_TRANSFER_INIT;
    state.archive_size  = 0;
    state.handle        = NULL;
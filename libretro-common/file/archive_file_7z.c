@@ -30,7 +30,11 @@
 #include <string/stdstring.h>
 #include <lists/string_list.h>
 #include <file/file_path.h>
+#include <features/features_cpu.h>
 #include <compat/strl.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 #include "../../deps/7zip/7z.h"
 #include "../../deps/7zip/7zCrc.h"
 #include "../../deps/7zip/7zFile.h"
@@ -38,6 +42,65 @@
 #define SEVENZIP_MAGIC "7z\xBC\xAF\x27\x1C"
 #define SEVENZIP_MAGIC_LEN 6
 
+/* Size of the signature header at the start of every archive.
+ * It holds the offset, size and CRC of the archive database,
+ * so together with the file size it identifies an archive's
+ * contents well enough to tell when a cached one went stale. */
+#define SEVENZIP_START_HEADER_SIZE 32
+
+/* The last archive read with sevenzip_file_read stays open along
+ * with its most recently decoded block, so reading several members
+ * of one solid block (multi-disc sets, subsystem content) only
+ * decodes it once. A block is only kept if it holds more than one
+ * member and fits in the budget set with file_archive_set_cache_limit(),
+ * SEVENZIP_CACHE_DEFAULT_LIMIT bytes unless the frontend sizes it to
+ * the machine. Anything unused for longer than SEVENZIP_CACHE_TIMEOUT
+ * microseconds is dropped on the next read, and
+ * file_archive_release_cache() drops it all once content is loaded. */
+#define SEVENZIP_CACHE_DEFAULT_LIMIT \
+   ((size_t)(sizeof(void*) >= 8 ? 2048 : 256) * 1024 * 1024)
+#define SEVENZIP_CACHE_TIMEOUT  (30 * 1000000)
+
+/* When a walk extracts members from more than one block, the
+ * blocks after the current one are decoded on up to
+ * SEVENZIP_MAX_THREADS threads, with at most
+ * SEVENZIP_READAHEAD_MAX_SIZE bytes queued or waiting. */
+#define SEVENZIP_MAX_THREADS        8
+#define SEVENZIP_READAHEAD_MAX_SIZE (256 * 1024 * 1024)
+
+#ifdef HAVE_THREADS
+enum sevenzip_block_state
+{
+   SEVENZIP_BLOCK_FREE = 0,
+   SEVENZIP_BLOCK_QUEUED,
+   SEVENZIP_BLOCK_DECODING,
+   SEVENZIP_BLOCK_READY
+};
+
+struct sevenzip_block
+{
+   uint8_t *data;
+   size_t size;
+   uint64_t unpack_size;
+   uint32_t folder;
+   SRes res;
+   enum sevenzip_block_state state;
+};
+
+struct sevenzip_readahead
+{
+   struct sevenzip_context_t *context;
+   slock_t *lock;
+   scond_t *cond;
+   sthread_t *threads[SEVENZIP_MAX_THREADS];
+   struct sevenzip_block blocks[SEVENZIP_MAX_THREADS * 2];
+   unsigned num_threads;
+   unsigned num_blocks;
+   uint32_t next_folder;
+   bool quit;
+};
+#endif
+
 struct sevenzip_context_t {
    CFileInStream archiveStream;
    CLookToRead lookStream;
@@ -45,13 +108,28 @@ struct sevenzip_context_t {
    ISzAlloc allocTempImp;
    CSzArEx db;
    size_t temp_size;
+   size_t output_size;
+   uint64_t archive_size;
+   retro_time_t last_used;
    uint32_t block_index;
    uint32_t index;
    uint32_t packIndex;
+   bool sequential;
    uint8_t *output;
    file_archive_file_handle_t *handle;
+#ifdef HAVE_THREADS
+   struct sevenzip_readahead *readahead;
+#endif
+   uint8_t start_header[SEVENZIP_START_HEADER_SIZE];
+   char path[PATH_MAX_LENGTH];
 };
 
+static struct sevenzip_context_t *sevenzip_cache;
+static size_t sevenzip_cache_limit = SEVENZIP_CACHE_DEFAULT_LIMIT;
+#ifdef HAVE_THREADS
+static slock_t *sevenzip_cache_lock;
+#endif
+
 static void *sevenzip_stream_alloc_impl(void *p, size_t size)
 {
    if (size == 0)
@@ -78,6 +156,9 @@ static void* sevenzip_stream_new(void)
    struct sevenzip_context_t *sevenzip_context =
          (struct sevenzip_context_t*)calloc(1, sizeof(struct sevenzip_context_t));
 
+   if (!sevenzip_context)
+      return NULL;
+
    /* These are the allocation routines - currently using
     * the non-standard 7zip choices. */
    sevenzip_context->allocImp.Alloc     = sevenzip_stream_alloc_impl;
@@ -88,9 +169,401 @@ static void* sevenzip_stream_new(void)
    sevenzip_context->output             = NULL;
    sevenzip_context->handle             = NULL;
 
+   File_Construct(&sevenzip_context->archiveStream.file);
+   SzArEx_Init(&sevenzip_context->db);
+
    return sevenzip_context;
 }
 
+/* Reads the size and start header of an open archive, leaving
+ * the file positioned at its start. */
+static bool sevenzip_read_start_header(CSzFile *file,
+      uint64_t *size, uint8_t *start_header)
+{
+   int64_t pos = 0;
+   size_t len  = SEVENZIP_START_HEADER_SIZE;
+
+   if (File_GetLength(file, size) != 0)
+      return false;
+   if (File_Read(file, start_header, &len) != 0
+         || len != SEVENZIP_START_HEADER_SIZE)
+      return false;
+   return File_Seek(file, &pos, SZ_SEEK_SET) == 0;
+}
+
+static bool sevenzip_context_open(struct sevenzip_context_t *sevenzip_context,
+      const char *path)
+{
+   /* Could not open 7zip archive? */
+   if (InFile_Open(&sevenzip_context->archiveStream.file, path))
+      return false;
+
+   if (!sevenzip_read_start_header(&sevenzip_context->archiveStream.file,
+            &sevenzip_context->archive_size, sevenzip_context->start_header))
+      return false;
+
+   FileInStream_CreateVTable(&sevenzip_context->archiveStream);
+   LookToRead_CreateVTable(&sevenzip_context->lookStream, False);
+   sevenzip_context->lookStream.realStream = &sevenzip_context->archiveStream.s;
+   LookToRead_Init(&sevenzip_context->lookStream);
+   CrcGenerateTable();
+   SzArEx_Init(&sevenzip_context->db);
+
+   if (SzArEx_Open(&sevenzip_context->db, &sevenzip_context->lookStream.s,
+         &sevenzip_context->allocImp, &sevenzip_context->allocTempImp) != SZ_OK)
+      return false;
+
+   strlcpy(sevenzip_context->path, path, sizeof(sevenzip_context->path));
+
+   return true;
+}
+
+static void sevenzip_context_release_block(
+      struct sevenzip_context_t *sevenzip_context)
+{
+   IAlloc_Free(&sevenzip_context->allocImp, sevenzip_context->output);
+   sevenzip_context->output      = NULL;
+   sevenzip_context->output_size = 0;
+   sevenzip_context->block_index = 0xFFFFFFFF;
+}
+
+#ifdef HAVE_THREADS
+/* Lowest queued folder, so blocks finish roughly in walk order. */
+static struct sevenzip_block *sevenzip_readahead_next(
+      struct sevenzip_readahead *readahead)
+{
+   unsigned i;
+   struct sevenzip_block *next = NULL;
+
+   for (i = 0; i < readahead->num_blocks; i++)
+   {
+      struct sevenzip_block *block = &readahead->blocks[i];
+
+      if (block->state != SEVENZIP_BLOCK_QUEUED)
+         continue;
+      if (!next || block->folder < next->folder)
+         next = block;
+   }
+
+   return next;
+}
+
+static void sevenzip_readahead_thread(void *data)
+{
+   struct sevenzip_readahead *readahead        = (struct sevenzip_readahead*)data;
+   struct sevenzip_context_t *sevenzip_context = readahead->context;
+   const CSzArEx *db                           = &sevenzip_context->db;
+   CFileInStream archiveStream;
+   CLookToRead lookStream;
+   bool opened;
+
+   /* Each thread reads through its own handle;
+    * the parsed database is shared read-only. */
+   File_Construct(&archiveStream.file);
+   opened = !InFile_Open(&archiveStream.file, sevenzip_context->path);
+   FileInStream_CreateVTable(&archiveStream);
+   LookToRead_CreateVTable(&lookStream, False);
+   lookStream.realStream = &archiveStream.s;
+   LookToRead_Init(&lookStream);
+
+   slock_lock(readahead->lock);
+
+   while (!readahead->quit)
+   {
+      size_t offset                = 0;
+      size_t outSizeProcessed      = 0;
+      size_t output_size           = 0;
+      uint8_t *output              = NULL;
+      uint32_t block_index         = 0xFFFFFFFF;
+      SRes res                     = SZ_ERROR_READ;
+      struct sevenzip_block *block = sevenzip_readahead_next(readahead);
+
+      if (!block)
+      {
+         scond_wait(readahead->cond, readahead->lock);
+         continue;
+      }
+
+      block->state = SEVENZIP_BLOCK_DECODING;
+      slock_unlock(readahead->lock);
+
+      if (opened)
+         res = SzArEx_Extract(db, &lookStream.s,
+               db->FolderStartFileIndex[block->folder], &block_index,
+               &output, &output_size, &offset, &outSizeProcessed,
+               &sevenzip_context->allocImp, &sevenzip_context->allocTempImp);
+
+      if (res != SZ_OK)
+      {
+         IAlloc_Free(&sevenzip_context->allocImp, output);
+         output      = NULL;
+         output_size = 0;
+      }
+
+      slock_lock(readahead->lock);
+      block->data  = output;
+      block->size  = output_size;
+      block->res   = res;
+      block->state = SEVENZIP_BLOCK_READY;
+      scond_broadcast(readahead->cond);
+   }
+
+   slock_unlock(readahead->lock);
+
+   File_Close(&archiveStream.file);
+}
+
+/* Queues the folders following the ones already in flight,
+ * staying within the read-ahead memory budget.
+ * Must be called with the lock held. */
+static void sevenzip_readahead_fill(struct sevenzip_readahead *readahead)
+{
+   unsigned i;
+   uint64_t pending  = 0;
+   CSzArEx *db       = &readahead->context->db;
+
+   for (i = 0; i < readahead->num_blocks; i++)
+      if (readahead->blocks[i].state != SEVENZIP_BLOCK_FREE)
+         pending += readahead->blocks[i].unpack_size;
+
+   for (i = 0; i < readahead->num_blocks; i++)
+   {
+      uint64_t unpack_size;
+      struct sevenzip_block *block = &readahead->blocks[i];
+
+      if (readahead->next_folder >= db->db.NumFolders)
+         break;
+      if (block->state != SEVENZIP_BLOCK_FREE)
+         continue;
+
+      unpack_size = SzFolder_GetUnpackSize(
+            db->db.Folders + readahead->next_folder);
+
+      if (pending && pending + unpack_size > SEVENZIP_READAHEAD_MAX_SIZE)
+         break;
+
+      block->folder      = readahead->next_folder++;
+      block->unpack_size = unpack_size;
+      block->data        = NULL;
+      block->size        = 0;
+      block->res         = SZ_OK;
+      block->state       = SEVENZIP_BLOCK_QUEUED;
+      pending           += unpack_size;
+   }
+
+   scond_broadcast(readahead->cond);
+}
+
+static void sevenzip_readahead_free(struct sevenzip_readahead *readahead)
+{
+   unsigned i;
+
+   if (!readahead)
+      return;
+
+   slock_lock(readahead->lock);
+   readahead->quit = true;
+   scond_broadcast(readahead->cond);
+   slock_unlock(readahead->lock);
+
+   for (i = 0; i < readahead->num_threads; i++)
+      sthread_join(readahead->threads[i]);
+
+   for (i = 0; i < readahead->num_blocks; i++)
+      IAlloc_Free(&readahead->context->allocImp, readahead->blocks[i].data);
+
+   scond_free(readahead->cond);
+   slock_free(readahead->lock);
+   free(readahead);
+}
+
+/* Starts decoding the blocks from @folder onwards in the background.
+ * Returns NULL if there's nothing left to read ahead. */
+static struct sevenzip_readahead *sevenzip_readahead_new(
+      struct sevenzip_context_t *sevenzip_context, uint32_t folder)
+{
+   unsigned i;
+   unsigned num_threads                 = cpu_features_get_core_amount();
+   struct sevenzip_readahead *readahead = NULL;
+
+   if (sevenzip_context->db.db.NumFolders - folder < 2)
+      return NULL;
+
+   if (num_threads < 1)
+      num_threads = 1;
+   if (num_threads > SEVENZIP_MAX_THREADS)
+      num_threads = SEVENZIP_MAX_THREADS;
+
+   readahead = (struct sevenzip_readahead*)calloc(1, sizeof(*readahead));
+   if (!readahead)
+      return NULL;
+
+   readahead->context     = sevenzip_context;
+   readahead->num_blocks  = num_threads * 2;
+   readahead->next_folder = folder;
+   readahead->lock        = slock_new();
+   readahead->cond        = scond_new();
+
+   if (!readahead->lock || !readahead->cond)
+      goto error;
+
+   slock_lock(readahead->lock);
+   sevenzip_readahead_fill(readahead);
+   slock_unlock(readahead->lock);
+
+   for (i = 0; i < num_threads; i++)
+   {
+      readahead->threads[readahead->num_threads] =
+         sthread_create(sevenzip_readahead_thread, readahead);
+      if (readahead->threads[readahead->num_threads])
+         readahead->num_threads++;
+   }
+
+   if (readahead->num_threads == 0)
+      goto error;
+
+   return readahead;
+
+error:
+   if (readahead->cond)
+      scond_free(readahead->cond);
+   if (readahead->lock)
+      slock_free(readahead->lock);
+   free(readahead);
+   return NULL;
+}
+
+/* Makes the read-ahead block for @folder the context's current
+ * block, waiting for it if it's still being decoded.
+ * Returns false if @folder was never queued. */
+static bool sevenzip_readahead_take(struct sevenzip_context_t *sevenzip_context,
+      uint32_t folder, SRes *res)
+{
+   unsigned i;
+   struct sevenzip_readahead *readahead = sevenzip_context->readahead;
+   struct sevenzip_block *block         = NULL;
+
+   slock_lock(readahead->lock);
+
+   for (i = 0; i < readahead->num_blocks; i++)
+   {
+      struct sevenzip_block *cur = &readahead->blocks[i];
+
+      if (cur->state == SEVENZIP_BLOCK_FREE)
+         continue;
+
+      if (cur->folder == folder)
+         block = cur;
+      else if (cur->folder < folder)
+      {
+         /* The walk went past this block without extracting from it.
+          * Blocks still being decoded get dropped on a later call. */
+         if (cur->state == SEVENZIP_BLOCK_QUEUED)
+            cur->state = SEVENZIP_BLOCK_FREE;
+         else if (cur->state == SEVENZIP_BLOCK_READY)
+         {
+            IAlloc_Free(&sevenzip_context->allocImp, cur->data);
+            cur->data  = NULL;
+            cur->state = SEVENZIP_BLOCK_FREE;
+         }
+      }
+   }
+
+   if (!block && readahead->next_folder <= folder)
+   {
+      readahead->next_folder = folder;
+      sevenzip_readahead_fill(readahead);
+
+      for (i = 0; i < readahead->num_blocks; i++)
+         if (     readahead->blocks[i].state  == SEVENZIP_BLOCK_QUEUED
+               && readahead->blocks[i].folder == folder)
+            block = &readahead->blocks[i];
+   }
+
+   if (!block)
+   {
+      slock_unlock(readahead->lock);
+      return false;
+   }
+
+   while (block->state != SEVENZIP_BLOCK_READY)
+      scond_wait(readahead->cond, readahead->lock);
+
+   sevenzip_context_release_block(sevenzip_context);
+
+   *res = block->res;
+   if (block->res == SZ_OK)
+   {
+      sevenzip_context->output      = block->data;
+      sevenzip_context->output_size = block->size;
+      sevenzip_context->block_index = folder;
+   }
+
+   block->data  = NULL;
+   block->state = SEVENZIP_BLOCK_FREE;
+
+   sevenzip_readahead_fill(readahead);
+   slock_unlock(readahead->lock);
+
+   return true;
+}
+#endif
+
+/* Extracts member @index, leaving its data at
+ * sevenzip_context->output + @offset. The decoded block is kept,
+ * so following members of the same block come for free. */
+static SRes sevenzip_context_extract(struct sevenzip_context_t *sevenzip_context,
+      uint32_t index, size_t *offset, size_t *outSizeProcessed)
+{
+   SRes res;
+
+#ifdef HAVE_THREADS
+   uint32_t folder = sevenzip_context->db.FileIndexToFolderIndexMap[index];
+
+   if (     folder != (uint32_t)-1
+         && folder != sevenzip_context->block_index)
+   {
+      /* Moving on to a second block: the caller extracts more
+       * than one member, so decode the ones after it ahead. */
+      if (     !sevenzip_context->readahead
+            &&  sevenzip_context->sequential
+            &&  sevenzip_context->block_index != 0xFFFFFFFF)
+         sevenzip_context->readahead = sevenzip_readahead_new(
+               sevenzip_context, folder);
+
+      if (     sevenzip_context->readahead
+            && sevenzip_readahead_take(sevenzip_context, folder, &res)
+            && res != SZ_OK)
+         return res;
+   }
+#endif
+
+   res = SzArEx_Extract(&sevenzip_context->db,
+         &sevenzip_context->lookStream.s, index,
+         &sevenzip_context->block_index, &sevenzip_context->output,
+         &sevenzip_context->output_size, offset, outSizeProcessed,
+         &sevenzip_context->allocImp, &sevenzip_context->allocTempImp);
+
+   /* Don't serve a block that failed to decode from the cache. */
+   if (res != SZ_OK)
+      sevenzip_context_release_block(sevenzip_context);
+
+   return res;
+}
+
+static void sevenzip_context_close(struct sevenzip_context_t *sevenzip_context)
+{
+#ifdef HAVE_THREADS
+   sevenzip_readahead_free(sevenzip_context->readahead);
+   sevenzip_context->readahead = NULL;
+#endif
+
+   sevenzip_context_release_block(sevenzip_context);
+
+   SzArEx_Free(&sevenzip_context->db, &sevenzip_context->allocImp);
+   File_Close(&sevenzip_context->archiveStream.file);
+}
+
 static void sevenzip_stream_free(void *data)
 {
    struct sevenzip_context_t *sevenzip_context = (struct sevenzip_context_t*)data;
@@ -98,15 +571,136 @@ static void sevenzip_stream_free(void *data)
    if (!sevenzip_context)
       return;
 
-   if (sevenzip_context->output)
+   /* Done with one member of a walk: the data belongs to the
+    * decoded block, which stays around for the next member. */
+   if (sevenzip_context->handle)
    {
-      IAlloc_Free(&sevenzip_context->allocImp, sevenzip_context->output);
-      sevenzip_context->output       = NULL;
       sevenzip_context->handle->data = NULL;
+      sevenzip_context->handle       = NULL;
+      return;
    }
 
-   SzArEx_Free(&sevenzip_context->db, &sevenzip_context->allocImp);
-   File_Close(&sevenzip_context->archiveStream.file);
+   sevenzip_context_close(sevenzip_context);
+}
+
+static void sevenzip_cache_free(struct sevenzip_context_t *sevenzip_context)
+{
+   if (!sevenzip_context)
+      return;
+
+   sevenzip_context_close(sevenzip_context);
+   free(sevenzip_context);
+}
+
+/* Takes the cached archive if it is @path and wasn't modified
+ * since it was opened, otherwise drops whatever was cached. */
+static struct sevenzip_context_t *sevenzip_cache_take(const char *path)
+{
+   CSzFile file;
+   uint64_t archive_size                       = 0;
+   bool unchanged                              = false;
+   struct sevenzip_context_t *sevenzip_context = NULL;
+   uint8_t start_header[SEVENZIP_START_HEADER_SIZE];
+
+#ifdef HAVE_THREADS
+   slock_lock(sevenzip_cache_lock);
+#endif
+   sevenzip_context = sevenzip_cache;
+   sevenzip_cache   = NULL;
+#ifdef HAVE_THREADS
+   slock_unlock(sevenzip_cache_lock);
+#endif
+
+   if (!sevenzip_context)
+      return NULL;
+
+   if (     string_is_equal(sevenzip_context->path, path)
+         && cpu_features_get_time_usec() - sevenzip_context->last_used
+            < SEVENZIP_CACHE_TIMEOUT)
+   {
+      File_Construct(&file);
+      if (!InFile_Open(&file, path))
+      {
+         unchanged =
+               sevenzip_read_start_header(&file, &archive_size, start_header)
+            && archive_size == sevenzip_context->archive_size
+            && !memcmp(start_header, sevenzip_context->start_header,
+                  sizeof(start_header));
+         File_Close(&file);
+      }
+   }
+
+   if (!unchanged)
+   {
+      sevenzip_cache_free(sevenzip_context);
+      return NULL;
+   }
+
+   return sevenzip_context;
+}
+
+static void sevenzip_cache_put(struct sevenzip_context_t *sevenzip_context)
+{
+   struct sevenzip_context_t *old = NULL;
+   uint32_t block_index           = sevenzip_context->block_index;
+
+   /* A block with a single member can't serve another read. */
+   if (block_index != 0xFFFFFFFF
+         && (sevenzip_context->db.db.Folders[block_index].NumUnpackStreams < 2
+            || sevenzip_context->output_size > sevenzip_cache_limit))
+      sevenzip_context_release_block(sevenzip_context);
+
+   sevenzip_context->last_used = cpu_features_get_time_usec();
+
+#ifdef HAVE_THREADS
+   slock_lock(sevenzip_cache_lock);
+#endif
+   old            = sevenzip_cache;
+   sevenzip_cache = sevenzip_context;
+#ifdef HAVE_THREADS
+   slock_unlock(sevenzip_cache_lock);
+#endif
+
+   sevenzip_cache_free(old);
+}
+
+void file_archive_7z_init(void)
+{
+#ifdef HAVE_THREADS
+   if (!sevenzip_cache_lock)
+      sevenzip_cache_lock = slock_new();
+#endif
+}
+
+void file_archive_7z_set_cache_limit(size_t limit)
+{
+   sevenzip_cache_limit = limit;
+}
+
+void file_archive_7z_release_cache(void)
+{
+   struct sevenzip_context_t *old = NULL;
+
+#ifdef HAVE_THREADS
+   slock_lock(sevenzip_cache_lock);
+#endif
+   old            = sevenzip_cache;
+   sevenzip_cache = NULL;
+#ifdef HAVE_THREADS
+   slock_unlock(sevenzip_cache_lock);
+#endif
+
+   sevenzip_cache_free(old);
+}
+
+void file_archive_7z_deinit(void)
+{
+   file_archive_7z_release_cache();
+
+#ifdef HAVE_THREADS
+   slock_free(sevenzip_cache_lock);
+   sevenzip_cache_lock = NULL;
+#endif
 }
 
 /* Extract the relative path (needle) from a 7z archive
@@ -119,162 +713,124 @@ static int sevenzip_file_read(
       const char *needle, void **buf,
       const char *optional_outfile)
 {
-   CFileInStream archiveStream;
-   CLookToRead lookStream;
-   ISzAlloc allocImp;
-   ISzAlloc allocTempImp;
-   CSzArEx db;
-   uint8_t *output      = 0;
+   uint32_t i;
+   bool file_found      = false;
+   uint16_t *temp       = NULL;
+   size_t temp_size     = 0;
    long outsize         = -1;
+   SRes res             = SZ_OK;
+   struct sevenzip_context_t *sevenzip_context = sevenzip_cache_take(path);
 
-   /*These are the allocation routines.
-    * Currently using the non-standard 7zip choices. */
-   allocImp.Alloc       = sevenzip_stream_alloc_impl;
-   allocImp.Free        = sevenzip_stream_free_impl;
-   allocTempImp.Alloc   = sevenzip_stream_alloc_tmp_impl;
-   allocTempImp.Free    = sevenzip_stream_free_impl;
+   if (!sevenzip_context)
+   {
+      sevenzip_context = (struct sevenzip_context_t*)sevenzip_stream_new();
 
-   /* Could not open 7zip archive? */
-   if (InFile_Open(&archiveStream.file, path))
-      return -1;
+      if (!sevenzip_context)
+         return -1;
 
-   FileInStream_CreateVTable(&archiveStream);
-   LookToRead_CreateVTable(&lookStream, False);
-   lookStream.realStream = &archiveStream.s;
-   LookToRead_Init(&lookStream);
-   CrcGenerateTable();
+      if (!sevenzip_context_open(sevenzip_context, path))
+      {
+         sevenzip_cache_free(sevenzip_context);
+         return -1;
+      }
+   }
 
-   db.db.PackSizes               = NULL;
-   db.db.PackCRCsDefined         = NULL;
-   db.db.PackCRCs                = NULL;
-   db.db.Folders                 = NULL;
-   db.db.Files                   = NULL;
-   db.db.NumPackStreams          = 0;
-   db.db.NumFolders              = 0;
-   db.db.NumFiles                = 0;
-   db.startPosAfterHeader        = 0;
-   db.dataPos                    = 0;
-   db.FolderStartPackStreamIndex = NULL;
-   db.PackStreamStartPositions   = NULL;
-   db.FolderStartFileIndex       = NULL;
-   db.FileIndexToFolderIndexMap  = NULL;
-   db.FileNameOffsets            = NULL;
-   db.FileNames.data             = NULL;
-   db.FileNames.size             = 0;
-
-   SzArEx_Init(&db);
-
-   if (SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp) == SZ_OK)
+   for (i = 0; i < sevenzip_context->db.db.NumFiles; i++)
    {
-      uint32_t i;
-      bool file_found      = false;
-      uint16_t *temp       = NULL;
-      size_t temp_size     = 0;
-      uint32_t block_index = 0xFFFFFFFF;
-      SRes res             = SZ_OK;
-
-      for (i = 0; i < db.db.NumFiles; i++)
-      {
-         size_t len;
-         char infile[PATH_MAX_LENGTH];
-         size_t offset                = 0;
-         size_t outSizeProcessed      = 0;
-         const CSzFileItem    *f      = db.db.Files + i;
+      size_t len;
+      char infile[PATH_MAX_LENGTH];
+      size_t offset                = 0;
+      size_t outSizeProcessed      = 0;
+      const CSzFileItem    *f      = sevenzip_context->db.db.Files + i;
 
-         /* We skip over everything which is not a directory.
-          * FIXME: Why continue then if f->IsDir is true?*/
-         if (f->IsDir)
-            continue;
+      /* We skip over everything which is not a directory.
+       * FIXME: Why continue then if f->IsDir is true?*/
+      if (f->IsDir)
+         continue;
 
-         len = SzArEx_GetFileNameUtf16(&db, i, NULL);
+      len = SzArEx_GetFileNameUtf16(&sevenzip_context->db, i, NULL);
 
-         if (len > temp_size)
-         {
-            if (temp)
-               free(temp);
-            temp_size = len;
-            temp = (uint16_t *)malloc(temp_size * sizeof(temp[0]));
+      if (len > temp_size)
+      {
+         if (temp)
+            free(temp);
+         temp_size = len;
+         temp = (uint16_t *)malloc(temp_size * sizeof(temp[0]));
 
-            if (temp == 0)
-            {
-               res = SZ_ERROR_MEM;
-               break;
-            }
+         if (temp == 0)
+         {
+            res = SZ_ERROR_MEM;
+            break;
          }
+      }
 
-         SzArEx_GetFileNameUtf16(&db, i, temp);
-         res       = SZ_ERROR_FAIL;
-         infile[0] = '\0';
+      SzArEx_GetFileNameUtf16(&sevenzip_context->db, i, temp);
+      res       = SZ_ERROR_FAIL;
+      infile[0] = '\0';
 
-         if (temp)
-            res = utf16_to_char_string(temp, infile, sizeof(infile))
-               ? SZ_OK : SZ_ERROR_FAIL;
+      if (temp)
+         res = utf16_to_char_string(temp, infile, sizeof(infile))
+            ? SZ_OK : SZ_ERROR_FAIL;
 
-         if (string_is_equal(infile, needle))
-         {
-            size_t output_size   = 0;
+      if (string_is_equal(infile, needle))
+      {
+         /*RARCH_LOG_OUTPUT("Opened archive %s. Now trying to extract %s\n",
+               path, needle);*/
 
-            /*RARCH_LOG_OUTPUT("Opened archive %s. Now trying to extract %s\n",
-                  path, needle);*/
+         /* C LZMA SDK does not support chunked extraction - see here:
+          * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
+          * */
+         file_found = true;
+         res = sevenzip_context_extract(sevenzip_context, i,
+               &offset, &outSizeProcessed);
 
-            /* C LZMA SDK does not support chunked extraction - see here:
-             * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
-             * */
-            file_found = true;
-            res = SzArEx_Extract(&db, &lookStream.s, i, &block_index,
-                  &output, &output_size, &offset, &outSizeProcessed,
-                  &allocImp, &allocTempImp);
+         if (res != SZ_OK)
+            break; /* This goes to the error section. */
 
-            if (res != SZ_OK)
-               break; /* This goes to the error section. */
+         outsize = outSizeProcessed;
 
-            outsize = outSizeProcessed;
+         if (optional_outfile != NULL)
+         {
+            const void *ptr = (const void*)(sevenzip_context->output + offset);
 
-            if (optional_outfile != NULL)
+            if (!filestream_write_file(optional_outfile, ptr, outsize))
             {
-               const void *ptr = (const void*)(output + offset);
-
-               if (!filestream_write_file(optional_outfile, ptr, outsize))
-               {
-                  /*RARCH_ERR("Could not open outfilepath %s.\n",
-                        optional_outfile);*/
-                  res        = SZ_OK;
-                  file_found = true;
-                  outsize    = -1;
-               }
+               /*RARCH_ERR("Could not open outfilepath %s.\n",
+                     optional_outfile);*/
+               res        = SZ_OK;
+               file_found = true;
+               outsize    = -1;
             }
-            else
-            {
-               /*We could either use the 7Zip allocated buffer,
-                * or create our own and use it.
-                * We would however need to realloc anyways, because RetroArch
-                * expects a \0 at the end, therefore we allocate new,
-                * copy and free the old one. */
-               *buf = malloc(outsize + 1);
-               ((char*)(*buf))[outsize] = '\0';
-               memcpy(*buf,output + offset,outsize);
-            }
-            break;
          }
+         else
+         {
+            /*We could either use the 7Zip allocated buffer,
+             * or create our own and use it.
+             * We would however need to realloc anyways, because RetroArch
+             * expects a \0 at the end, therefore we allocate new,
+             * copy and free the old one. */
+            *buf = malloc(outsize + 1);
+            ((char*)(*buf))[outsize] = '\0';
+            memcpy(*buf, sevenzip_context->output + offset, outsize);
+         }
+         break;
       }
+   }
 
-      if (temp)
-         free(temp);
-      IAlloc_Free(&allocImp, output);
+   if (temp)
+      free(temp);
 
-      if (!(file_found && res == SZ_OK))
-      {
-         /* Error handling
-          *
-          * Failed to open compressed file inside 7zip archive.
-          */
+   if (!(file_found && res == SZ_OK))
+   {
+      /* Error handling
+       *
+       * Failed to open compressed file inside 7zip archive.
+       */
 
-         outsize    = -1;
-      }
+      outsize    = -1;
    }
 
-   SzArEx_Free(&db, &allocImp);
-   File_Close(&archiveStream.file);
+   sevenzip_cache_put(sevenzip_context);
 
    return (int)outsize;
 }
@@ -300,18 +856,14 @@ static int sevenzip_stream_decompress_data_to_file_iterate(void *data)
          (struct sevenzip_context_t*)data;
 
    SRes res                = SZ_ERROR_FAIL;
-   size_t output_size      = 0;
    size_t offset           = 0;
    size_t outSizeProcessed = 0;
 
-   res = SzArEx_Extract(&sevenzip_context->db,
-         &sevenzip_context->lookStream.s, sevenzip_context->index,
-         &sevenzip_context->block_index, &sevenzip_context->output,
-         &output_size, &offset, &outSizeProcessed,
-         &sevenzip_context->allocImp, &sevenzip_context->allocTempImp);
+   res = sevenzip_context_extract(sevenzip_context, sevenzip_context->index,
+         &offset, &outSizeProcessed);
 
    if (res != SZ_OK)
-      return 0;
+      return -1;
 
    if (sevenzip_context->handle)
       sevenzip_context->handle->data = sevenzip_context->output + offset;
@@ -325,6 +877,9 @@ static int sevenzip_parse_file_init(file_archive_transfer_t *state,
    struct sevenzip_context_t *sevenzip_context =
          (struct sevenzip_context_t*)sevenzip_stream_new();
 
+   if (!sevenzip_context)
+      return -1;
+
    if (state->archive_size < SEVENZIP_MAGIC_LEN)
       goto error;
 
@@ -333,19 +888,11 @@ static int sevenzip_parse_file_init(file_archive_transfer_t *state,
 
    state->stream = sevenzip_context;
 
-   /* could not open 7zip archive? */
-   if (InFile_Open(&sevenzip_context->archiveStream.file, file))
-      goto error;
-
-   FileInStream_CreateVTable(&sevenzip_context->archiveStream);
-   LookToRead_CreateVTable(&sevenzip_context->lookStream, False);
-   sevenzip_context->lookStream.realStream = &sevenzip_context->archiveStream.s;
-   LookToRead_Init(&sevenzip_context->lookStream);
-   CrcGenerateTable();
-   SzArEx_Init(&sevenzip_context->db);
+   /* Walks visit members in order, so the blocks
+    * after the current one can be decoded ahead. */
+   sevenzip_context->sequential = true;
 
-   if (SzArEx_Open(&sevenzip_context->db, &sevenzip_context->lookStream.s,
-         &sevenzip_context->allocImp, &sevenzip_context->allocTempImp) != SZ_OK)
+   if (!sevenzip_context_open(sevenzip_context, file))
       goto error;
 
    return 0;
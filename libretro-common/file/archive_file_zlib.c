@@ -23,13 +23,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <compat/strl.h>
 #include <file/archive_file.h>
+#include <file/file_path.h>
 #include <streams/file_stream.h>
 #include <streams/trans_stream.h>
+#include <string/stdstring.h>
 #include <retro_inline.h>
 #include <retro_miscellaneous.h>
 #include <encodings/crc32.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 /* Only for MAX_WBITS */
 #include <compat/zlib.h>
 
@@ -41,6 +48,34 @@
 #define END_OF_CENTRAL_DIR_SIGNATURE 0x06054b50
 #endif
 
+#define ZIP_END_OF_CENTRAL_DIR_SIZE 22
+
+/* Number of parsed central directories kept around */
+#define ZIP_INDEX_CACHE_SIZE 8
+
+struct file_archive_zip_index
+{
+   char path[PATH_MAX_LENGTH];
+   /* What the index was built from; checked on every
+    * lookup to notice the archive changing on disk. */
+   size_t archive_size;
+   uint8_t footer[ZIP_END_OF_CENTRAL_DIR_SIZE];
+   struct file_archive_zip_entry *entries;
+   size_t count;
+   uint32_t *buckets;  /* entry index + 1, 0 when empty */
+   size_t bucket_mask;
+   char *names;
+   unsigned refs;
+   unsigned stamp;
+   bool cached;
+};
+
+static file_archive_zip_index_t *zip_index_cache[ZIP_INDEX_CACHE_SIZE];
+static unsigned zip_index_stamp;
+#ifdef HAVE_THREADS
+static slock_t *zip_index_lock;
+#endif
+
 static INLINE uint32_t read_le(const uint8_t *data, unsigned size)
 {
    unsigned i;
@@ -378,6 +413,350 @@ static int zip_parse_file_iterate_step(file_archive_transfer_t *state,
    return 1;
 }
 
+static INLINE uint32_t zip_index_hash(const char *name)
+{
+   uint32_t hash = 5381;
+
+   while (*name)
+      hash = (hash << 5) + hash + (uint8_t)*name++;
+
+   return hash;
+}
+
+/* Reads the end of central directory record, which ends the
+ * archive unless followed by an archive comment. */
+static bool zip_index_read_footer(RFILE *fp, size_t *archive_size,
+      uint8_t *footer)
+{
+   size_t tail_size, i;
+   uint8_t *tail = NULL;
+   bool ret      = false;
+
+   if (filestream_seek(fp, 0, SEEK_END) < 0)
+      return false;
+   *archive_size = (size_t)filestream_tell(fp);
+   if (*archive_size < ZIP_END_OF_CENTRAL_DIR_SIZE)
+      return false;
+
+   /* Fast path: no comment */
+   if (filestream_seek(fp, (ssize_t)(*archive_size
+               - ZIP_END_OF_CENTRAL_DIR_SIZE), SEEK_SET) >= 0
+         && filestream_read(fp, footer,
+            ZIP_END_OF_CENTRAL_DIR_SIZE) == ZIP_END_OF_CENTRAL_DIR_SIZE
+         && read_le(footer, 4) == END_OF_CENTRAL_DIR_SIGNATURE
+         && read_le(footer + 20, 2) == 0)
+      return true;
+
+   tail_size = MIN(*archive_size, 65535 + ZIP_END_OF_CENTRAL_DIR_SIZE);
+   tail      = (uint8_t*)malloc(tail_size);
+   if (!tail
+         || filestream_seek(fp, (ssize_t)(*archive_size - tail_size), SEEK_SET) < 0
+         || filestream_read(fp, tail, tail_size) != (ssize_t)tail_size)
+      goto end;
+
+   for (i = tail_size - ZIP_END_OF_CENTRAL_DIR_SIZE; ; i--)
+   {
+      if (     read_le(tail + i, 4) == END_OF_CENTRAL_DIR_SIGNATURE
+            && i + ZIP_END_OF_CENTRAL_DIR_SIZE
+            + read_le(tail + i + 20, 2) == tail_size)
+      {
+         memcpy(footer, tail + i, ZIP_END_OF_CENTRAL_DIR_SIZE);
+         ret = true;
+         break;
+      }
+      if (i == 0)
+         break;
+   }
+
+end:
+   free(tail);
+   return ret;
+}
+
+static void zip_index_free(file_archive_zip_index_t *index)
+{
+   if (!index)
+      return;
+
+   free(index->entries);
+   free(index->buckets);
+   free(index->names);
+   free(index);
+}
+
+static file_archive_zip_index_t *zip_index_build(RFILE *fp,
+      const char *path, size_t archive_size, const uint8_t *footer)
+{
+   size_t i, names_used         = 0;
+   uint8_t *directory           = NULL;
+   const uint8_t *entry         = NULL;
+   uint32_t dir_size            = read_le(footer + 12, 4);
+   uint32_t dir_offset          = read_le(footer + 16, 4);
+   size_t max_entries           = read_le(footer + 10, 2);
+   size_t buckets               = 16;
+   file_archive_zip_index_t *index = (file_archive_zip_index_t*)
+      calloc(1, sizeof(*index));
+
+   if (!index || (size_t)dir_offset + dir_size > archive_size)
+      goto error;
+
+   strlcpy(index->path, path, sizeof(index->path));
+   index->archive_size = archive_size;
+   memcpy(index->footer, footer, ZIP_END_OF_CENTRAL_DIR_SIZE);
+
+   directory        = (uint8_t*)malloc(dir_size ? dir_size : 1);
+   index->entries   = (struct file_archive_zip_entry*)
+      calloc(max_entries ? max_entries : 1, sizeof(*index->entries));
+   /* Names are shorter than their directory entries */
+   index->names     = (char*)malloc(dir_size + 1);
+
+   if (!directory || !index->entries || !index->names
+         || filestream_seek(fp, dir_offset, SEEK_SET) < 0
+         || filestream_read(fp, directory, dir_size) != (ssize_t)dir_size)
+      goto error;
+
+   for (entry = directory;
+         index->count < max_entries && entry + 46 <= directory + dir_size; )
+   {
+      struct file_archive_zip_entry *out = &index->entries[index->count];
+      uint32_t namelength = read_le(entry + 28, 2);
+      size_t entry_size   = 46 + namelength
+         + read_le(entry + 30, 2) + read_le(entry + 32, 2);
+
+      if (     read_le(entry, 4) != CENTRAL_FILE_HEADER_SIGNATURE
+            || entry + entry_size > directory + dir_size
+            || namelength >= PATH_MAX_LENGTH)
+         break;
+
+      memcpy(index->names + names_used, entry + 46, namelength);
+      index->names[names_used + namelength] = '\0';
+
+      out->cmode  = read_le(entry + 10, 2);
+      out->crc32  = read_le(entry + 16, 4);
+      out->csize  = read_le(entry + 20, 4);
+      out->size   = read_le(entry + 24, 4);
+      out->offset = read_le(entry + 42, 4);
+
+      names_used += namelength + 1;
+      index->count++;
+      entry      += entry_size;
+   }
+
+   /* The names block is final now; point the entries into it. */
+   for (i = 0, names_used = 0; i < index->count; i++)
+   {
+      index->entries[i].name = index->names + names_used;
+      names_used += strlen(index->entries[i].name) + 1;
+   }
+
+   while (buckets < index->count * 2)
+      buckets *= 2;
+   index->buckets     = (uint32_t*)calloc(buckets, sizeof(*index->buckets));
+   index->bucket_mask = buckets - 1;
+   if (!index->buckets)
+      goto error;
+
+   /* Keep the first of duplicate names, like a linear walk would. */
+   for (i = 0; i < index->count; i++)
+   {
+      size_t slot = zip_index_hash(index->entries[i].name) & index->bucket_mask;
+
+      while (index->buckets[slot])
+      {
+         if (string_is_equal(index->entries[index->buckets[slot] - 1].name,
+                  index->entries[i].name))
+            break;
+         slot = (slot + 1) & index->bucket_mask;
+      }
+      if (!index->buckets[slot])
+         index->buckets[slot] = (uint32_t)(i + 1);
+   }
+
+   free(directory);
+   return index;
+
+error:
+   free(directory);
+   zip_index_free(index);
+   return NULL;
+}
+
+file_archive_zip_index_t *file_archive_zip_index_acquire(const char *path)
+{
+   char archive[PATH_MAX_LENGTH];
+   uint8_t footer[ZIP_END_OF_CENTRAL_DIR_SIZE];
+   size_t archive_size                = 0;
+   unsigned i, slot                   = 0;
+   char *delim                        = NULL;
+   RFILE *fp                          = NULL;
+   file_archive_zip_index_t *index    = NULL;
+
+   strlcpy(archive, path, sizeof(archive));
+   delim = (char*)path_get_archive_delim(archive);
+   if (delim)
+      *delim = '\0';
+
+   fp = filestream_open(archive, RFILE_MODE_READ, -1);
+   if (!fp)
+      return NULL;
+
+   if (!zip_index_read_footer(fp, &archive_size, footer))
+      goto end;
+
+#ifdef HAVE_THREADS
+   slock_lock(zip_index_lock);
+#endif
+
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
+   {
+      file_archive_zip_index_t *cached = zip_index_cache[i];
+
+      if (     cached
+            && cached->archive_size == archive_size
+            && !memcmp(cached->footer, footer, sizeof(footer))
+            && string_is_equal(cached->path, archive))
+      {
+         index = cached;
+         index->refs++;
+         index->stamp = ++zip_index_stamp;
+         break;
+      }
+   }
+
+#ifdef HAVE_THREADS
+   slock_unlock(zip_index_lock);
+#endif
+
+   if (index)
+      goto end;
+
+   index = zip_index_build(fp, archive, archive_size, footer);
+   if (!index)
+      goto end;
+   index->refs   = 1;
+   index->cached = true;
+
+#ifdef HAVE_THREADS
+   slock_lock(zip_index_lock);
+#endif
+
+   /* Replace a stale index of the same archive, else an empty
+    * slot, else the least recently used one. */
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
+   {
+      file_archive_zip_index_t *cached = zip_index_cache[i];
+
+      if (!cached || string_is_equal(cached->path, archive))
+      {
+         slot = i;
+         break;
+      }
+      if (cached->stamp < zip_index_cache[slot]->stamp)
+         slot = i;
+   }
+
+   if (zip_index_cache[slot])
+   {
+      zip_index_cache[slot]->cached = false;
+      if (zip_index_cache[slot]->refs == 0)
+         zip_index_free(zip_index_cache[slot]);
+   }
+   index->stamp           = ++zip_index_stamp;
+   zip_index_cache[slot]  = index;
+
+#ifdef HAVE_THREADS
+   slock_unlock(zip_index_lock);
+#endif
+
+end:
+   filestream_close(fp);
+   return index;
+}
+
+void file_archive_zip_index_release(file_archive_zip_index_t *index)
+{
+   if (!index)
+      return;
+
+#ifdef HAVE_THREADS
+   slock_lock(zip_index_lock);
+#endif
+
+   if (--index->refs == 0 && !index->cached)
+      zip_index_free(index);
+
+#ifdef HAVE_THREADS
+   slock_unlock(zip_index_lock);
+#endif
+}
+
+void file_archive_zip_index_init(void)
+{
+#ifdef HAVE_THREADS
+   if (!zip_index_lock)
+      zip_index_lock = slock_new();
+#endif
+}
+
+void file_archive_zip_index_deinit(void)
+{
+   unsigned i;
+
+   /* Indexes still referenced are freed on their last release. */
+   for (i = 0; i < ZIP_INDEX_CACHE_SIZE; i++)
+   {
+      file_archive_zip_index_t *cached = zip_index_cache[i];
+
+      if (!cached)
+         continue;
+
+      cached->cached     = false;
+      if (cached->refs == 0)
+         zip_index_free(cached);
+      zip_index_cache[i] = NULL;
+   }
+
+#ifdef HAVE_THREADS
+   slock_free(zip_index_lock);
+   zip_index_lock = NULL;
+#endif
+}
+
+size_t file_archive_zip_index_count(const file_archive_zip_index_t *index)
+{
+   return index ? index->count : 0;
+}
+
+const struct file_archive_zip_entry *file_archive_zip_index_at(
+      const file_archive_zip_index_t *index, size_t i)
+{
+   if (!index || i >= index->count)
+      return NULL;
+   return &index->entries[i];
+}
+
+const struct file_archive_zip_entry *file_archive_zip_index_find(
+      const file_archive_zip_index_t *index, const char *name)
+{
+   size_t slot;
+
+   if (!index || !name)
+      return NULL;
+
+   slot = zip_index_hash(name) & index->bucket_mask;
+
+   while (index->buckets[slot])
+   {
+      const struct file_archive_zip_entry *entry =
+         &index->entries[index->buckets[slot] - 1];
+      if (string_is_equal(entry->name, name))
+         return entry;
+      slot = (slot + 1) & index->bucket_mask;
+   }
+
+   return NULL;
+}
+
 const struct file_archive_file_backend zlib_backend = {
    zlib_stream_new,
    zlib_stream_free,
@@ -59,11 +59,22 @@ typedef unsigned char Byte;
 
 #include <retro_inline.h>
 
+#include <encodings/crc32.h>
+
+#ifdef HAVE_THREADS
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+#endif
+
 #define TRUE 1
 #define FALSE 0
 
+#ifndef MAX
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
+#endif
+#ifndef MIN
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
 
 #define SHA1_DIGEST_SIZE 20
 
@@ -271,6 +282,16 @@ struct _cdfl_codec_data {
 	uint8_t*	buffer;
 };
 
+/* a decompressed hunk held in the hunk cache */
+typedef struct _hunk_cache_entry hunk_cache_entry;
+struct _hunk_cache_entry
+{
+	UINT8 *					data;			/* decompressed hunk data */
+	UINT32					hunknum;		/* hunk held here, or ~0 if empty */
+	UINT32					stamp;			/* last use, for LRU eviction */
+	UINT8					loading;		/* still being decompressed */
+};
+
 /* internal representation of an open CHD file */
 struct _chd_file
 {
@@ -284,8 +305,23 @@ struct _chd_file
 
 	map_entry *				map;			/* array of map entries */
 
-	UINT8 *					cache;			/* hunk cache pointer */
-	UINT32					cachehunk;		/* index of currently cached hunk */
+	hunk_cache_entry *		cache;			/* LRU cache of decompressed hunks */
+	UINT32					cachehunks;		/* number of hunk cache entries */
+	UINT32					cachestamp;		/* LRU clock */
+	UINT32					cachehits;		/* reads served from the hunk cache */
+	UINT32					cachemisses;	/* reads that had to decompress */
+	UINT32					readahead;		/* hunks to decompress past the last read */
+
+#ifdef HAVE_THREADS
+	slock_t *				cachelock;		/* protects the hunk cache */
+	scond_t *				cachecond;		/* signalled when the cache changes */
+	slock_t *				codeclock;		/* serializes codec access */
+	slock_t *				filelock;		/* serializes seeking and reading the file */
+	sthread_t *				readthread;		/* read-ahead worker */
+	UINT32					readnext;		/* next hunk the worker should load */
+	UINT32					readend;		/* end of the read-ahead window */
+	UINT8					readquit;		/* tells the worker to exit */
+#endif
 
 	UINT8 *					compare;		/* hunk compare pointer */
 	UINT32					comparehunk;	/* index of current compare data */
@@ -348,8 +384,18 @@ static chd_error header_read(core_file *file, chd_header *header);
 
 
 /* internal hunk read/write */
-static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum);
+static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum, UINT8 *dest);
 static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
+static chd_error hunk_read_locked(chd_file *chd, UINT32 hunknum, UINT8 *dest);
+static UINT32 file_read_at(chd_file *chd, UINT64 offset, void *dest, UINT32 length);
+
+/* internal range decoding */
+static chd_file *hunk_decoder_new(chd_file *chd);
+static void hunk_decoder_free(chd_file *decoder);
+
+/* internal hunk cache management */
+static chd_error hunk_cache_alloc(chd_file *chd, UINT32 hunks, UINT32 readahead);
+static void hunk_cache_free(chd_file *chd);
 
 /* internal map access */
 static chd_error map_read(chd_file *chd);
@@ -1291,6 +1337,7 @@ chd_error chd_open_file(core_file *file, int mode, chd_file *parent, chd_file **
 	chd_file *newchd = NULL;
 	chd_error err;
 	int intfnum;
+	UINT32 readahead = 0;
 
 	/* verify parameters */
 	if (file == NULL)
@@ -1359,12 +1406,28 @@ chd_error chd_open_file(core_file *file, int mode, chd_file *parent, chd_file **
 		err = decompress_v5_map(newchd, &(newchd->header));
 	}
 
-	/* allocate and init the hunk cache */
-	newchd->cache = (UINT8 *)malloc(newchd->header.hunkbytes);
+#ifdef HAVE_THREADS
+	newchd->cachelock = slock_new();
+	newchd->cachecond = scond_new();
+	newchd->codeclock = slock_new();
+	newchd->filelock = slock_new();
+	if (newchd->cachelock == NULL || newchd->cachecond == NULL || newchd->codeclock == NULL || newchd->filelock == NULL)
+		EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+#endif
+
+	/* allocate and init the hunk cache; on a single core the worker
+	   would only steal time from the reader, and without threads
+	   there is no worker */
+#ifdef HAVE_THREADS
+	if (cpu_features_get_core_amount() > 1)
+		readahead = CHD_DEFAULT_READAHEAD_HUNKS;
+#endif
+	err = hunk_cache_alloc(newchd, CHD_DEFAULT_CACHE_HUNKS, readahead);
+	if (err != CHDERR_NONE)
+		EARLY_EXIT(err);
 	newchd->compare = (UINT8 *)malloc(newchd->header.hunkbytes);
-	if (newchd->cache == NULL || newchd->compare == NULL)
+	if (newchd->compare == NULL)
 		EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
-	newchd->cachehunk = ~0;
 	newchd->comparehunk = ~0;
 
 	/* allocate the temporary compressed buffer */
@@ -1501,6 +1564,9 @@ void chd_close(chd_file *chd)
 	if (chd == NULL || chd->cookie != COOKIE_VALUE)
 		return;
 
+	/* stop the read-ahead worker before tearing down what it uses */
+	hunk_cache_free(chd);
+
 	/* deinit the codec */
 	if (chd->header.version < 5)
 	{
@@ -1543,11 +1609,20 @@ void chd_close(chd_file *chd)
 	if (chd->compressed != NULL)
 		free(chd->compressed);
 
-	/* free the hunk cache and compare data */
+	/* free the compare data */
 	if (chd->compare != NULL)
 		free(chd->compare);
-	if (chd->cache != NULL)
-		free(chd->cache);
+
+#ifdef HAVE_THREADS
+	if (chd->cachelock != NULL)
+		slock_free(chd->cachelock);
+	if (chd->cachecond != NULL)
+		scond_free(chd->cachecond);
+	if (chd->codeclock != NULL)
+		slock_free(chd->codeclock);
+	if (chd->filelock != NULL)
+		slock_free(chd->filelock);
+#endif
 
 	/* free the hunk map */
 	if (chd->map != NULL)
@@ -1666,7 +1741,374 @@ chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer)
 		return CHDERR_HUNK_OUT_OF_RANGE;
 
 	/* perform the read */
-	return hunk_read_into_memory(chd, hunknum, (UINT8 *)buffer);
+	if (chd->cachehunks == 0)
+		return hunk_read_locked(chd, hunknum, (UINT8 *)buffer);
+	return hunk_read_into_cache(chd, hunknum, (UINT8 *)buffer);
+}
+
+
+/*-------------------------------------------------
+    chd_set_cache - resize the hunk cache and
+    the read-ahead window
+-------------------------------------------------*/
+
+chd_error chd_set_cache(chd_file *chd, UINT32 hunks, UINT32 readahead)
+{
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+	hunk_cache_free(chd);
+	return hunk_cache_alloc(chd, hunks, readahead);
+}
+
+
+/*-------------------------------------------------
+    chd_get_cache_stats - return the hunk cache
+    hit and miss counts
+-------------------------------------------------*/
+
+void chd_get_cache_stats(chd_file *chd, UINT32 *hits, UINT32 *misses)
+{
+	if (hits != NULL)
+		*hits = (chd != NULL) ? chd->cachehits : 0;
+	if (misses != NULL)
+		*misses = (chd != NULL) ? chd->cachemisses : 0;
+}
+
+
+/*-------------------------------------------------
+    range_copy_hunk - chd_read_range callback
+    that gathers hunks into a flat buffer
+-------------------------------------------------*/
+
+typedef struct _range_copy_state range_copy_state;
+struct _range_copy_state
+{
+	UINT8 *					dest;			/* start of the caller's buffer */
+	UINT32					firsthunk;		/* hunk landing at dest */
+};
+
+static chd_error range_copy_hunk(void *userdata, UINT32 hunknum, const void *data, UINT32 length)
+{
+	range_copy_state *state = (range_copy_state *)userdata;
+
+	memcpy(state->dest + (size_t)(hunknum - state->firsthunk) * length, data, length);
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    chd_read_range - decompress a run of hunks
+    into a buffer using several threads
+-------------------------------------------------*/
+
+chd_error chd_read_range(chd_file *chd, UINT32 firsthunk, UINT32 count, void *buffer, unsigned threads)
+{
+	range_copy_state state;
+
+	state.dest = (UINT8 *)buffer;
+	state.firsthunk = firsthunk;
+	return chd_read_range_stream(chd, firsthunk, count, threads, range_copy_hunk, &state);
+}
+
+
+#ifdef HAVE_THREADS
+/* a slot in the ring of hunks decoded ahead of the consumer */
+typedef struct _range_slot range_slot;
+struct _range_slot
+{
+	UINT8 *					data;			/* decompressed hunk */
+	UINT32					hunknum;		/* hunk held, or ~0 */
+	chd_error				err;			/* result of decompressing it */
+	UINT8					state;			/* RANGE_SLOT_* */
+};
+
+enum
+{
+	RANGE_SLOT_FREE = 0,
+	RANGE_SLOT_BUSY,
+	RANGE_SLOT_DONE
+};
+
+/* shared state of a multi-threaded range read */
+typedef struct _range_state range_state;
+struct _range_state
+{
+	range_slot *			slots;			/* ring of decoded hunks */
+	UINT32					numslots;		/* entries in the ring */
+	UINT32					first;			/* first hunk of the range */
+	UINT32					next;			/* next hunk to hand to a worker */
+	UINT32					end;			/* one past the last hunk */
+	UINT8					abort;			/* tells the workers to stop */
+	slock_t *				lock;			/* protects everything above */
+	scond_t *				cond;			/* signalled on any slot change */
+};
+
+/* one decompression worker with its own codec instances */
+typedef struct _range_worker range_worker;
+struct _range_worker
+{
+	range_state *			state;
+	chd_file *				decoder;		/* private clone of the CHD */
+	sthread_t *				thread;
+};
+
+
+/*-------------------------------------------------
+    range_worker_thread - decompress hunks into
+    free slots until the range is exhausted
+-------------------------------------------------*/
+
+static void range_worker_thread(void *data)
+{
+	range_worker *worker = (range_worker *)data;
+	range_state *state = worker->state;
+
+	slock_lock(state->lock);
+	while (!state->abort && state->next < state->end)
+	{
+		range_slot *slot = &state->slots[(state->next - state->first) % state->numslots];
+		UINT32 hunknum;
+		chd_error err;
+
+		/* wait for the consumer to drain the hunk in this slot */
+		if (slot->state != RANGE_SLOT_FREE)
+		{
+			scond_wait(state->cond, state->lock);
+			continue;
+		}
+
+		hunknum = state->next++;
+		slot->hunknum = hunknum;
+		slot->state = RANGE_SLOT_BUSY;
+		slock_unlock(state->lock);
+
+		err = hunk_read_into_memory(worker->decoder, hunknum, slot->data);
+
+		slock_lock(state->lock);
+		slot->err = err;
+		slot->state = RANGE_SLOT_DONE;
+		scond_broadcast(state->cond);
+	}
+	slock_unlock(state->lock);
+}
+
+
+/*-------------------------------------------------
+    range_read_threaded - fan a range read out
+    across worker threads, delivering in order
+-------------------------------------------------*/
+
+static chd_error range_read_threaded(chd_file *chd, UINT32 firsthunk, UINT32 count, unsigned threads, chd_range_callback callback, void *userdata)
+{
+	range_state state;
+	range_worker *workers;
+	chd_error err = CHDERR_NONE;
+	unsigned started = 0;
+	UINT32 hunknum;
+	unsigned i;
+
+	memset(&state, 0, sizeof(state));
+	state.first = firsthunk;
+	state.next = firsthunk;
+	state.end = firsthunk + count;
+	state.numslots = threads * 2;
+	state.lock = slock_new();
+	state.cond = scond_new();
+	state.slots = (range_slot *)calloc(state.numslots, sizeof(*state.slots));
+	workers = (range_worker *)calloc(threads, sizeof(*workers));
+	if (state.lock == NULL || state.cond == NULL || state.slots == NULL || workers == NULL)
+		EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+
+	for (i = 0; i < state.numslots; i++)
+	{
+		state.slots[i].hunknum = ~0;
+		state.slots[i].data = (UINT8 *)malloc(chd->header.hunkbytes);
+		if (state.slots[i].data == NULL)
+			EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+	}
+
+	for (i = 0; i < threads; i++)
+	{
+		workers[i].state = &state;
+		workers[i].decoder = hunk_decoder_new(chd);
+		if (workers[i].decoder == NULL)
+			EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+	}
+
+	for (i = 0; i < threads; i++)
+	{
+		workers[i].thread = sthread_create(range_worker_thread, &workers[i]);
+		if (workers[i].thread == NULL)
+			break;
+		started++;
+	}
+	if (started == 0)
+		EARLY_EXIT(err = CHDERR_OUT_OF_MEMORY);
+
+	/* hand the hunks over in order as they complete */
+	for (hunknum = firsthunk; hunknum < state.end && err == CHDERR_NONE; hunknum++)
+	{
+		range_slot *slot = &state.slots[(hunknum - firsthunk) % state.numslots];
+
+		slock_lock(state.lock);
+		while (slot->hunknum != hunknum || slot->state != RANGE_SLOT_DONE)
+			scond_wait(state.cond, state.lock);
+		slock_unlock(state.lock);
+
+		err = slot->err;
+		if (err == CHDERR_NONE)
+			err = callback(userdata, hunknum, slot->data, chd->header.hunkbytes);
+
+		slock_lock(state.lock);
+		slot->state = RANGE_SLOT_FREE;
+		scond_broadcast(state.cond);
+		slock_unlock(state.lock);
+	}
+
+cleanup:
+	if (state.lock != NULL && state.cond != NULL)
+	{
+		slock_lock(state.lock);
+		state.abort = 1;
+		scond_broadcast(state.cond);
+		slock_unlock(state.lock);
+	}
+
+	if (workers != NULL)
+	{
+		for (i = 0; i < threads; i++)
+		{
+			if (workers[i].thread != NULL)
+				sthread_join(workers[i].thread);
+			if (workers[i].decoder != NULL)
+				hunk_decoder_free(workers[i].decoder);
+		}
+		free(workers);
+	}
+
+	if (state.slots != NULL)
+	{
+		for (i = 0; i < state.numslots; i++)
+			if (state.slots[i].data != NULL)
+				free(state.slots[i].data);
+		free(state.slots);
+	}
+	if (state.cond != NULL)
+		scond_free(state.cond);
+	if (state.lock != NULL)
+		slock_free(state.lock);
+	return err;
+}
+#endif
+
+
+/*-------------------------------------------------
+    chd_read_range_stream - decompress a run of
+    hunks, handing each to a callback in order
+-------------------------------------------------*/
+
+chd_error chd_read_range_stream(chd_file *chd, UINT32 firsthunk, UINT32 count, unsigned threads, chd_range_callback callback, void *userdata)
+{
+	chd_error err = CHDERR_NONE;
+	UINT8 *buffer;
+	UINT32 hunknum;
+
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE || callback == NULL)
+		return CHDERR_INVALID_PARAMETER;
+
+	/* if we're past the end, fail */
+	if (firsthunk > chd->header.totalhunks || count > chd->header.totalhunks - firsthunk)
+		return CHDERR_HUNK_OUT_OF_RANGE;
+
+#ifdef HAVE_THREADS
+	if (threads == 0)
+		threads = cpu_features_get_core_amount();
+	if (threads > count)
+		threads = count;
+	if (threads > 1)
+		return range_read_threaded(chd, firsthunk, count, threads, callback, userdata);
+#endif
+
+	/* single-threaded: decode straight through the CHD's own codecs */
+	buffer = (UINT8 *)malloc(chd->header.hunkbytes);
+	if (buffer == NULL)
+		return CHDERR_OUT_OF_MEMORY;
+
+	for (hunknum = firsthunk; hunknum < firsthunk + count && err == CHDERR_NONE; hunknum++)
+	{
+		err = hunk_read_locked(chd, hunknum, buffer);
+		if (err == CHDERR_NONE)
+			err = callback(userdata, hunknum, buffer, chd->header.hunkbytes);
+	}
+
+	free(buffer);
+	return err;
+}
+
+
+/*-------------------------------------------------
+    verify_hunk - chd_verify callback hashing
+    the logical data
+-------------------------------------------------*/
+
+typedef struct _verify_state verify_state;
+struct _verify_state
+{
+	UINT64					remaining;		/* logical bytes not hashed yet */
+	UINT32					crc;			/* running CRC32 */
+	MD5_CTX					md5;			/* running MD5, for V3 files */
+};
+
+static chd_error verify_hunk(void *userdata, UINT32 hunknum, const void *data, UINT32 length)
+{
+	verify_state *state = (verify_state *)userdata;
+	UINT32 bytes = (UINT32)MIN((UINT64)length, state->remaining);
+
+	state->crc = encoding_crc32(state->crc, (const uint8_t *)data, bytes);
+	MD5_Update(&state->md5, data, bytes);
+	state->remaining -= bytes;
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    chd_verify - decompress the whole image in
+    parallel, checking every hunk
+-------------------------------------------------*/
+
+chd_error chd_verify(chd_file *chd, unsigned threads, UINT32 *crc)
+{
+	verify_state state;
+	chd_error err;
+
+	/* punt if NULL or invalid */
+	if (chd == NULL || chd->cookie != COOKIE_VALUE)
+		return CHDERR_INVALID_PARAMETER;
+
+	state.remaining = chd->header.logicalbytes;
+	state.crc = 0;
+	MD5_Init(&state.md5);
+
+	err = chd_read_range_stream(chd, 0, chd->header.totalhunks, threads, verify_hunk, &state);
+	if (err != CHDERR_NONE)
+		return err;
+
+	if (crc != NULL)
+		*crc = state.crc;
+
+	/* V3 headers carry the MD5 of the raw data; later versions hash with SHA1 */
+	if (chd->header.version == 3 && memcmp(chd->header.md5, nullmd5, sizeof(nullmd5)) != 0)
+	{
+		UINT8 md5[CHD_MD5_BYTES];
+
+		MD5_Final(md5, &state.md5);
+		if (memcmp(md5, chd->header.md5, sizeof(md5)) != 0)
+			return CHDERR_INVALID_DATA;
+	}
+	return CHDERR_NONE;
 }
 
 
@@ -1717,8 +2159,7 @@ chd_error chd_get_metadata(chd_file *chd, UINT32 searchtag, UINT32 searchindex,
 
 	/* read the metadata */
 	outputlen = MIN(outputlen, metaentry.length);
-	core_fseek(chd->file, metaentry.offset + METADATA_HEADER_SIZE, SEEK_SET);
-	count = core_fread(chd->file, output, outputlen);
+	count = file_read_at(chd, metaentry.offset + METADATA_HEADER_SIZE, output, outputlen);
 	if (count != outputlen)
 		return CHDERR_READ_ERROR;
 
@@ -1962,32 +2403,429 @@ static chd_error header_read(core_file *file, chd_header *header)
     INTERNAL HUNK READ/WRITE
 ***************************************************************************/
 
+#ifdef HAVE_THREADS
+#define HUNK_CACHE_LOCK(chd)		do { if ((chd)->cachelock) slock_lock((chd)->cachelock); } while (0)
+#define HUNK_CACHE_UNLOCK(chd)		do { if ((chd)->cachelock) slock_unlock((chd)->cachelock); } while (0)
+#define HUNK_CACHE_SIGNAL(chd)		do { if ((chd)->cachecond) scond_broadcast((chd)->cachecond); } while (0)
+#define HUNK_CACHE_WAIT(chd)		scond_wait((chd)->cachecond, (chd)->cachelock)
+#else
+#define HUNK_CACHE_LOCK(chd)		do { } while (0)
+#define HUNK_CACHE_UNLOCK(chd)		do { } while (0)
+#define HUNK_CACHE_SIGNAL(chd)		do { } while (0)
+#define HUNK_CACHE_WAIT(chd)		do { } while (0)
+#endif
+
 /*-------------------------------------------------
-    hunk_read_into_cache - read a hunk into
-    the CHD's hunk cache
+    hunk_cache_find - return the cache entry
+    holding the given hunk, or NULL
 -------------------------------------------------*/
 
-static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum)
+static hunk_cache_entry *hunk_cache_find(chd_file *chd, UINT32 hunknum)
 {
+	UINT32 i;
+
+	for (i = 0; i < chd->cachehunks; i++)
+		if (chd->cache[i].hunknum == hunknum)
+			return &chd->cache[i];
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_claim - evict the least recently
+    used idle entry and mark it as loading the
+    given hunk; NULL if every entry is busy
+-------------------------------------------------*/
+
+static hunk_cache_entry *hunk_cache_claim(chd_file *chd, UINT32 hunknum)
+{
+	hunk_cache_entry *victim = NULL;
+	UINT32 i;
+
+	for (i = 0; i < chd->cachehunks; i++)
+	{
+		hunk_cache_entry *entry = &chd->cache[i];
+
+		if (entry->loading)
+			continue;
+		if (entry->hunknum == ~0U)
+		{
+			victim = entry;
+			break;
+		}
+		if (victim == NULL || (UINT32)(chd->cachestamp - entry->stamp) > (UINT32)(chd->cachestamp - victim->stamp))
+			victim = entry;
+	}
+
+	if (victim != NULL)
+	{
+		victim->hunknum = hunknum;
+		victim->stamp = ++chd->cachestamp;
+		victim->loading = 1;
+	}
+	return victim;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_loaded - publish the result of
+    decompressing into a claimed entry
+-------------------------------------------------*/
+
+static void hunk_cache_loaded(chd_file *chd, hunk_cache_entry *entry, chd_error err)
+{
+	entry->loading = 0;
+	if (err != CHDERR_NONE)
+		entry->hunknum = ~0;
+	HUNK_CACHE_SIGNAL(chd);
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_readahead - point the read-ahead
+    worker at the hunks following the given one
+-------------------------------------------------*/
+
+static void hunk_cache_readahead(chd_file *chd, UINT32 hunknum)
+{
+#ifdef HAVE_THREADS
+	if (chd->readthread == NULL)
+		return;
+
+	chd->readnext = hunknum + 1;
+	chd->readend = MIN(hunknum + 1 + chd->readahead, chd->header.totalhunks);
+	HUNK_CACHE_SIGNAL(chd);
+#endif
+}
+
+
+#ifdef HAVE_THREADS
+/*-------------------------------------------------
+    hunk_readahead_thread - decompress the hunks
+    past the last one read ahead of time
+-------------------------------------------------*/
+
+static void hunk_readahead_thread(void *data)
+{
+	chd_file *chd = (chd_file *)data;
+
+	slock_lock(chd->cachelock);
+	while (!chd->readquit)
+	{
+		hunk_cache_entry *entry;
+		UINT32 hunknum;
+		chd_error err;
+
+		/* skip whatever is already cached or being loaded */
+		while (chd->readnext < chd->readend && hunk_cache_find(chd, chd->readnext) != NULL)
+			chd->readnext++;
+
+		if (chd->readnext >= chd->readend)
+		{
+			scond_wait(chd->cachecond, chd->cachelock);
+			continue;
+		}
+
+		hunknum = chd->readnext;
+		entry = hunk_cache_claim(chd, hunknum);
+		if (entry == NULL)
+		{
+			scond_wait(chd->cachecond, chd->cachelock);
+			continue;
+		}
+		chd->readnext++;
+
+		slock_unlock(chd->cachelock);
+		err = hunk_read_locked(chd, hunknum, entry->data);
+		slock_lock(chd->cachelock);
+
+		hunk_cache_loaded(chd, entry, err);
+	}
+	slock_unlock(chd->cachelock);
+}
+#endif
+
+
+/*-------------------------------------------------
+    hunk_cache_alloc - allocate the hunk cache
+    and start the read-ahead worker
+-------------------------------------------------*/
+
+static chd_error hunk_cache_alloc(chd_file *chd, UINT32 hunks, UINT32 readahead)
+{
+	UINT32 i;
+
+	chd->cachehits = 0;
+	chd->cachemisses = 0;
+	chd->cachestamp = 0;
+	if (hunks == 0)
+		return CHDERR_NONE;
+
+	chd->cache = (hunk_cache_entry *)calloc(hunks, sizeof(*chd->cache));
+	if (chd->cache == NULL)
+		return CHDERR_OUT_OF_MEMORY;
+	chd->cachehunks = hunks;
+
+	for (i = 0; i < hunks; i++)
+	{
+		chd->cache[i].hunknum = ~0;
+		chd->cache[i].data = (UINT8 *)malloc(chd->header.hunkbytes);
+		if (chd->cache[i].data == NULL)
+		{
+			hunk_cache_free(chd);
+			return CHDERR_OUT_OF_MEMORY;
+		}
+	}
+
+	/* leave room for the hunk being read next to the ones read ahead */
+	chd->readahead = MIN(readahead, hunks - 1);
+
+#ifdef HAVE_THREADS
+	if (chd->readahead > 0 && chd->cachelock != NULL)
+	{
+		chd->readquit = 0;
+		chd->readnext = 0;
+		chd->readend = 0;
+		chd->readthread = sthread_create(hunk_readahead_thread, chd);
+	}
+#endif
+	return CHDERR_NONE;
+}
+
+
+/*-------------------------------------------------
+    hunk_cache_free - stop the read-ahead worker
+    and free the hunk cache
+-------------------------------------------------*/
+
+static void hunk_cache_free(chd_file *chd)
+{
+	UINT32 i;
+
+#ifdef HAVE_THREADS
+	if (chd->readthread != NULL)
+	{
+		slock_lock(chd->cachelock);
+		chd->readquit = 1;
+		scond_broadcast(chd->cachecond);
+		slock_unlock(chd->cachelock);
+
+		sthread_join(chd->readthread);
+		chd->readthread = NULL;
+	}
+#endif
+
+	if (chd->cache != NULL)
+	{
+		for (i = 0; i < chd->cachehunks; i++)
+			if (chd->cache[i].data != NULL)
+				free(chd->cache[i].data);
+		free(chd->cache);
+	}
+	chd->cache = NULL;
+	chd->cachehunks = 0;
+	chd->readahead = 0;
+}
+
+
+/*-------------------------------------------------
+    hunk_read_into_cache - read a hunk through
+    the hunk cache into memory at the given
+    location
+-------------------------------------------------*/
+
+static chd_error hunk_read_into_cache(chd_file *chd, UINT32 hunknum, UINT8 *dest)
+{
+	hunk_cache_entry *entry;
 	chd_error err;
 
+	HUNK_CACHE_LOCK(chd);
+
 	/* track the max */
 	if (hunknum > chd->maxhunk)
 		chd->maxhunk = hunknum;
 
+	/* wait out the read-ahead worker if it is loading this very hunk */
+	while ((entry = hunk_cache_find(chd, hunknum)) != NULL && entry->loading)
+		HUNK_CACHE_WAIT(chd);
+
 	/* if we're already in the cache, we're done */
-	if (chd->cachehunk == hunknum)
+	if (entry != NULL)
+	{
+		chd->cachehits++;
+		entry->stamp = ++chd->cachestamp;
+		memcpy(dest, entry->data, chd->header.hunkbytes);
+		hunk_cache_readahead(chd, hunknum);
+		HUNK_CACHE_UNLOCK(chd);
 		return CHDERR_NONE;
-	chd->cachehunk = ~0;
+	}
 
 	/* otherwise, read the data */
-	err = hunk_read_into_memory(chd, hunknum, chd->cache);
-	if (err != CHDERR_NONE)
-		return err;
+	chd->cachemisses++;
+	entry = hunk_cache_claim(chd, hunknum);
+	HUNK_CACHE_UNLOCK(chd);
 
-	/* mark the hunk successfully cached in */
-	chd->cachehunk = hunknum;
-	return CHDERR_NONE;
+	if (entry == NULL)
+		err = hunk_read_locked(chd, hunknum, dest);
+	else
+		err = hunk_read_locked(chd, hunknum, entry->data);
+
+	HUNK_CACHE_LOCK(chd);
+	if (entry != NULL)
+	{
+		hunk_cache_loaded(chd, entry, err);
+		if (err == CHDERR_NONE)
+			memcpy(dest, entry->data, chd->header.hunkbytes);
+	}
+	if (err == CHDERR_NONE)
+		hunk_cache_readahead(chd, hunknum);
+	HUNK_CACHE_UNLOCK(chd);
+	return err;
+}
+
+
+/*-------------------------------------------------
+    hunk_read_locked - read a hunk into memory
+    while holding the file and codec lock
+-------------------------------------------------*/
+
+static chd_error hunk_read_locked(chd_file *chd, UINT32 hunknum, UINT8 *dest)
+{
+	chd_error err;
+
+#ifdef HAVE_THREADS
+	if (chd->codeclock != NULL)
+		slock_lock(chd->codeclock);
+#endif
+
+	err = hunk_read_into_memory(chd, hunknum, dest);
+
+#ifdef HAVE_THREADS
+	if (chd->codeclock != NULL)
+		slock_unlock(chd->codeclock);
+#endif
+	return err;
+}
+
+
+/*-------------------------------------------------
+    hunk_decoder_codec - return the codec state
+    used for the given compressor slot
+-------------------------------------------------*/
+
+static void *hunk_decoder_codec(chd_file *chd, int slot)
+{
+	if (chd->codecintf[slot] == NULL)
+		return NULL;
+
+	if (chd->header.version < 5)
+		return (slot == 0) ? &chd->zlib_codec_data : NULL;
+
+	switch (chd->codecintf[slot]->compression)
+	{
+		case CHD_CODEC_CD_LZMA:
+			return &chd->cdlz_codec_data;
+		case CHD_CODEC_CD_ZLIB:
+			return &chd->cdzl_codec_data;
+		case CHD_CODEC_CD_FLAC:
+			return &chd->cdfl_codec_data;
+	}
+	return NULL;
+}
+
+
+/*-------------------------------------------------
+    hunk_decoder_new - clone a CHD with its own
+    codec instances, sharing the file and map
+-------------------------------------------------*/
+
+static chd_file *hunk_decoder_new(chd_file *chd)
+{
+	chd_file *decoder = (chd_file *)malloc(sizeof(chd_file));
+	int i;
+
+	if (decoder == NULL)
+		return NULL;
+	memcpy(decoder, chd, sizeof(chd_file));
+
+	/* everything below is private to the clone or must not be touched by it */
+	memset(&decoder->zlib_codec_data, 0, sizeof(decoder->zlib_codec_data));
+	memset(&decoder->cdzl_codec_data, 0, sizeof(decoder->cdzl_codec_data));
+	memset(&decoder->cdlz_codec_data, 0, sizeof(decoder->cdlz_codec_data));
+	memset(&decoder->cdfl_codec_data, 0, sizeof(decoder->cdfl_codec_data));
+	decoder->cache = NULL;
+	decoder->cachehunks = 0;
+	decoder->compare = NULL;
+	decoder->crcmap = NULL;
+	decoder->crcfree = NULL;
+	decoder->crctable = NULL;
+#ifdef HAVE_THREADS
+	decoder->cachelock = NULL;
+	decoder->cachecond = NULL;
+	decoder->codeclock = NULL;
+	decoder->readthread = NULL;
+#endif
+
+	decoder->compressed = (UINT8 *)malloc(chd->header.hunkbytes);
+	if (decoder->compressed == NULL)
+	{
+		free(decoder);
+		return NULL;
+	}
+
+	for (i = 0; i < ARRAY_LENGTH(decoder->codecintf); i++)
+	{
+		void *codec = hunk_decoder_codec(decoder, i);
+		if (codec != NULL && decoder->codecintf[i]->init != NULL)
+			(*decoder->codecintf[i]->init)(codec, decoder->header.hunkbytes);
+	}
+	return decoder;
+}
+
+
+/*-------------------------------------------------
+    hunk_decoder_free - free a clone made by
+    hunk_decoder_new
+-------------------------------------------------*/
+
+static void hunk_decoder_free(chd_file *decoder)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_LENGTH(decoder->codecintf); i++)
+	{
+		void *codec = hunk_decoder_codec(decoder, i);
+		if (codec != NULL && decoder->codecintf[i]->free != NULL)
+			(*decoder->codecintf[i]->free)(codec);
+	}
+
+	free(decoder->compressed);
+	free(decoder);
+}
+
+
+/*-------------------------------------------------
+    file_read_at - seek to and read from the
+    file, which may be shared between threads
+-------------------------------------------------*/
+
+static UINT32 file_read_at(chd_file *chd, UINT64 offset, void *dest, UINT32 length)
+{
+	UINT32 count;
+
+#ifdef HAVE_THREADS
+	if (chd->filelock != NULL)
+		slock_lock(chd->filelock);
+#endif
+
+	core_fseek(chd->file, offset, SEEK_SET);
+	count = core_fread(chd->file, dest, length);
+
+#ifdef HAVE_THREADS
+	if (chd->filelock != NULL)
+		slock_unlock(chd->filelock);
+#endif
+	return count;
 }
 
 
@@ -2020,9 +2858,8 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 			case V34_MAP_ENTRY_TYPE_COMPRESSED:
             {
                void* codec;
-                  /* read it into the decompression buffer */
-                  core_fseek(chd->file, entry->offset, SEEK_SET);
-               bytes = core_fread(chd->file, chd->compressed, entry->length);
+               /* read it into the decompression buffer */
+               bytes = file_read_at(chd, entry->offset, chd->compressed, entry->length);
                if (bytes != entry->length)
                   return CHDERR_READ_ERROR;
 
@@ -2038,8 +2875,7 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 
 			/* uncompressed data */
 			case V34_MAP_ENTRY_TYPE_UNCOMPRESSED:
-				core_fseek(chd->file, entry->offset, SEEK_SET);
-				bytes = core_fread(chd->file, dest, chd->header.hunkbytes);
+				bytes = file_read_at(chd, entry->offset, dest, chd->header.hunkbytes);
 				if (bytes != chd->header.hunkbytes)
 					return CHDERR_READ_ERROR;
 				break;
@@ -2053,13 +2889,11 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 
 			/* self-referenced data */
 			case V34_MAP_ENTRY_TYPE_SELF_HUNK:
-				if (chd->cachehunk == entry->offset && dest == chd->cache)
-					break;
 				return hunk_read_into_memory(chd, entry->offset, dest);
 
 			/* parent-referenced data */
 			case V34_MAP_ENTRY_TYPE_PARENT_HUNK:
-				err = hunk_read_into_memory(chd->parent, entry->offset, dest);
+				err = hunk_read_locked(chd->parent, entry->offset, dest);
 				if (err != CHDERR_NONE)
 					return err;
 				break;
@@ -2102,8 +2936,7 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 			case COMPRESSION_TYPE_1:
 			case COMPRESSION_TYPE_2:
 			case COMPRESSION_TYPE_3:
-				core_fseek(chd->file, blockoffs, SEEK_SET);
-				core_fread(chd->file, chd->compressed, blocklen);
+				file_read_at(chd, blockoffs, chd->compressed, blocklen);
 				switch (chd->codecintf[rawmap[0]]->compression)
 				{
 					case CHD_CODEC_CD_LZMA:
@@ -2126,8 +2959,7 @@ static chd_error hunk_read_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *des
 				return CHDERR_NONE;
 
 			case COMPRESSION_NONE:
-				core_fseek(chd->file, blockoffs, SEEK_SET);
-				core_fread(chd->file, dest, chd->header.hunkbytes);
+				file_read_at(chd, blockoffs, dest, chd->header.hunkbytes);
 				if (crc16(dest, chd->header.hunkbytes) != blockcrc)
 					return CHDERR_DECOMPRESSION_ERROR;
 				return CHDERR_NONE;
@@ -2259,8 +3091,7 @@ static chd_error metadata_find_entry(chd_file *chd, UINT32 metatag, UINT32 metai
 		UINT32	count;
 
 		/* read the raw header */
-		core_fseek(chd->file, metaentry->offset, SEEK_SET);
-		count = core_fread(chd->file, raw_meta_header, sizeof(raw_meta_header));
+		count = file_read_at(chd, metaentry->offset, raw_meta_header, sizeof(raw_meta_header));
 		if (count != sizeof(raw_meta_header))
 			break;
 
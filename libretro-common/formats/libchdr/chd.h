@@ -244,6 +244,12 @@ extern "C" {
 #define CHD_OPEN_READ				1
 #define CHD_OPEN_READWRITE			2
 
+/* default hunk cache configuration applied by chd_open(); read-ahead
+   only runs with HAVE_THREADS on more than one core, and reuses cache
+   slots, so it costs a worker thread per open file but no memory */
+#define CHD_DEFAULT_CACHE_HUNKS		16
+#define CHD_DEFAULT_READAHEAD_HUNKS	4
+
 /* error types */
 enum _chd_error
 {
@@ -374,6 +380,28 @@ const chd_header *chd_get_header(chd_file *chd);
 /* read one hunk from the CHD file */
 chd_error chd_read(chd_file *chd, UINT32 hunknum, void *buffer);
 
+/* keep up to 'hunks' decompressed hunks in an LRU cache and decompress
+   up to 'readahead' hunks past the last one read on a worker thread;
+   0 disables either. Must not be called while reads are in flight. */
+chd_error chd_set_cache(chd_file *chd, UINT32 hunks, UINT32 readahead);
+
+/* return the hunk cache hits and misses since it was last configured */
+void chd_get_cache_stats(chd_file *chd, UINT32 *hits, UINT32 *misses);
+
+/* receives decompressed hunks from chd_read_range_stream(), in order */
+typedef chd_error (*chd_range_callback)(void *userdata, UINT32 hunknum, const void *data, UINT32 length);
+
+/* decompress 'count' hunks starting at 'firsthunk' into 'buffer', which
+   must hold count * hunkbytes bytes, on 'threads' workers (0 = one per core) */
+chd_error chd_read_range(chd_file *chd, UINT32 firsthunk, UINT32 count, void *buffer, unsigned threads);
+
+/* same as chd_read_range(), but hands each hunk to a callback instead */
+chd_error chd_read_range_stream(chd_file *chd, UINT32 firsthunk, UINT32 count, unsigned threads, chd_range_callback callback, void *userdata);
+
+/* decompress the whole image on 'threads' workers, checking every hunk
+   (and the MD5 of V3 images); optionally returns the CRC32 of the data */
+chd_error chd_verify(chd_file *chd, unsigned threads, UINT32 *crc);
+
 
 
 /* ----- metadata management ----- */
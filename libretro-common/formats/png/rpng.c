@@ -29,6 +29,12 @@
 #include <malloc.h>
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #include <boolean.h>
 #include <formats/image.h>
 #include <formats/rpng.h>
@@ -95,8 +101,7 @@ struct rpng_process
    uint32_t *data;
    uint32_t *palette;
    struct png_ihdr ihdr;
-   uint8_t *prev_scanline;
-   uint8_t *decoded_scanline;
+   uint8_t *prev_scanline; /* All zeroes, the line above the first one. */
    uint8_t *inflate_buf;
    size_t restore_buf_size;
    size_t adam7_restore_buf_size;
@@ -253,11 +258,42 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+#if defined(__SSE2__)
+   if (bpp == 1)
+   {
+      /* RGBA bytes to ARGB words is a swap of bytes 0 and 2. */
+      const __m128i mask_ga = _mm_set1_epi32(0xff00ff00);
+      const __m128i mask_b  = _mm_set1_epi32(0x000000ff);
+
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         __m128i px = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i rb = _mm_or_si128(
+               _mm_slli_epi32(_mm_and_si128(px, mask_b), 16),
+               _mm_and_si128(_mm_srli_epi32(px, 16), mask_b));
+         _mm_storeu_si128((__m128i*)(data + i),
+               _mm_or_si128(_mm_and_si128(px, mask_ga), rb));
+      }
+   }
+#elif defined(__ARM_NEON__)
+   if (bpp == 1)
+   {
+      for (; i + 8 <= width; i += 8, decoded += 32)
+      {
+         uint8x8x4_t px = vld4_u8(decoded);
+         uint8x8_t   r  = px.val[0];
+         px.val[0]      = px.val[2];
+         px.val[2]      = r;
+         vst4_u8((uint8_t*)(data + i), px);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -490,9 +526,6 @@ static void png_reverse_filter_adam7_deinterlace_pass(uint32_t *data,
 
 static void png_reverse_filter_deinit(struct rpng_process *pngp)
 {
-   if (pngp->decoded_scanline)
-      free(pngp->decoded_scanline);
-   pngp->decoded_scanline = NULL;
    if (pngp->prev_scanline)
       free(pngp->prev_scanline);
    pngp->prev_scanline    = NULL;
@@ -562,9 +595,8 @@ static int png_reverse_filter_init(const struct png_ihdr *ihdr,
    pngp->restore_buf_size      = 0;
    pngp->data_restore_buf_size = 0;
    pngp->prev_scanline    = (uint8_t*)calloc(1, pngp->pitch);
-   pngp->decoded_scanline = (uint8_t*)calloc(1, pngp->pitch);
 
-   if (!pngp->prev_scanline || !pngp->decoded_scanline)
+   if (!pngp->prev_scanline)
       goto error;
 
    pngp->h = 0;
@@ -577,44 +609,227 @@ error:
    return -1;
 }
 
+/* Reverse filters work in place on the inflated data, with
+ * prev pointing at the already unfiltered line above. The
+ * vector paths cover 8-bit RGB and RGBA, which is what nearly
+ * all thumbnails and menu assets use. */
+
+#if defined(__SSE2__)
+static INLINE __m128i png_load_px(const uint8_t *p, unsigned bpp)
+{
+   int v = 0;
+   memcpy(&v, p, bpp);
+   return _mm_cvtsi32_si128(v);
+}
+
+static INLINE void png_store_px(uint8_t *p, __m128i px, unsigned bpp)
+{
+   int v = _mm_cvtsi128_si32(px);
+   memcpy(p, &v, bpp);
+}
+
+static INLINE __m128i png_abs_epi16(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static INLINE __m128i png_if_then_else(__m128i c, __m128i t, __m128i e)
+{
+   return _mm_or_si128(_mm_and_si128(c, t), _mm_andnot_si128(c, e));
+}
+#elif defined(__ARM_NEON__)
+static INLINE uint8x8_t png_load_px(const uint8_t *p, unsigned bpp)
+{
+   uint32_t v = 0;
+   memcpy(&v, p, bpp);
+   return vreinterpret_u8_u32(vdup_n_u32(v));
+}
+
+static INLINE void png_store_px(uint8_t *p, uint8x8_t px, unsigned bpp)
+{
+   uint32_t v = vget_lane_u32(vreinterpret_u32_u8(px), 0);
+   memcpy(p, &v, bpp);
+}
+#endif
+
+static void png_unfilter_sub(uint8_t *line,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+   if (bpp == 3 || bpp == 4)
+   {
+#if defined(__SSE2__)
+      __m128i a = _mm_setzero_si128();
+#else
+      uint8x8_t a = vdup_n_u8(0);
+#endif
+
+      for (i = 0; i < pitch; i += bpp)
+      {
+#if defined(__SSE2__)
+         a = _mm_add_epi8(png_load_px(line + i, bpp), a);
+#else
+         a = vadd_u8(png_load_px(line + i, bpp), a);
+#endif
+         png_store_px(line + i, a, bpp);
+      }
+      return;
+   }
+#endif
+
+   for (i = bpp; i < pitch; i++)
+      line[i] += line[i - bpp];
+}
+
+static void png_unfilter_up(uint8_t *line, const uint8_t *prev,
+      unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(line + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(line + i, vaddq_u8(vld1q_u8(line + i), vld1q_u8(prev + i)));
+#endif
+
+   for (; i < pitch; i++)
+      line[i] += prev[i];
+}
+
+static void png_unfilter_avg(uint8_t *line, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+   if (bpp == 3 || bpp == 4)
+   {
+#if defined(__SSE2__)
+      const __m128i one = _mm_set1_epi8(1);
+      __m128i a         = _mm_setzero_si128();
+#else
+      uint8x8_t a       = vdup_n_u8(0);
+#endif
+
+      for (i = 0; i < pitch; i += bpp)
+      {
+#if defined(__SSE2__)
+         /* _mm_avg_epu8 rounds up, PNG wants (a + b) >> 1. */
+         __m128i b   = png_load_px(prev + i, bpp);
+         __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+               _mm_and_si128(_mm_xor_si128(a, b), one));
+         a           = _mm_add_epi8(png_load_px(line + i, bpp), avg);
+#else
+         a = vadd_u8(png_load_px(line + i, bpp),
+               vhadd_u8(a, png_load_px(prev + i, bpp)));
+#endif
+         png_store_px(line + i, a, bpp);
+      }
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      line[i] += prev[i] >> 1;
+   for (i = bpp; i < pitch; i++)
+      line[i] += (line[i - bpp] + prev[i]) >> 1;
+}
+
+static void png_unfilter_paeth(uint8_t *line, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      /* a: left, b: above, c: above left, widened to 16 bits. */
+      __m128i a          = zero;
+      __m128i c          = zero;
+
+      for (i = 0; i < pitch; i += bpp)
+      {
+         __m128i b  = _mm_unpacklo_epi8(png_load_px(prev + i, bpp), zero);
+         __m128i pa = _mm_sub_epi16(b, c);      /* p - a */
+         __m128i pb = _mm_sub_epi16(a, c);      /* p - b */
+         __m128i pc = _mm_add_epi16(pa, pb);    /* p - c */
+         __m128i smallest, nearest;
+
+         pa       = png_abs_epi16(pa);
+         pb       = png_abs_epi16(pb);
+         pc       = png_abs_epi16(pc);
+         smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+         nearest  = png_if_then_else(_mm_cmpeq_epi16(smallest, pa), a,
+               png_if_then_else(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+         a = _mm_add_epi8(png_load_px(line + i, bpp),
+               _mm_packus_epi16(nearest, nearest));
+         png_store_px(line + i, a, bpp);
+
+         a = _mm_unpacklo_epi8(a, zero);
+         c = b;
+      }
+      return;
+   }
+#elif defined(__ARM_NEON__)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+      uint8x8_t c = vdup_n_u8(0);
+
+      for (i = 0; i < pitch; i += bpp)
+      {
+         uint8x8_t b    = png_load_px(prev + i, bpp);
+         uint16x8_t pa  = vabdl_u8(b, c);
+         uint16x8_t pb  = vabdl_u8(a, c);
+         uint16x8_t pc  = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+         uint8x8_t use_a = vmovn_u16(vandq_u16(
+                  vcleq_u16(pa, pb), vcleq_u16(pa, pc)));
+         uint8x8_t use_b = vmovn_u16(vcleq_u16(pb, pc));
+         uint8x8_t nearest = vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+
+         a = vadd_u8(png_load_px(line + i, bpp), nearest);
+         png_store_px(line + i, a, bpp);
+         c = b;
+      }
+      return;
+   }
+#endif
+
+   for (i = 0; i < bpp; i++)
+      line[i] += paeth(0, prev[i], 0);
+   for (i = bpp; i < pitch; i++)
+      line[i] += paeth(line[i - bpp], prev[i], prev[i - bpp]);
+}
+
 static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
       struct rpng_process *pngp, unsigned filter)
 {
-   unsigned i;
+   uint8_t *line       = pngp->inflate_buf;
+   const uint8_t *prev = pngp->h ? line - (pngp->pitch + 1) : pngp->prev_scanline;
 
    switch (filter)
    {
       case PNG_FILTER_NONE:
-         memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+         png_unfilter_sub(line, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_unfilter_up(line, prev, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
+         png_unfilter_avg(line, prev, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+         png_unfilter_paeth(line, prev, pngp->pitch, pngp->bpp);
          break;
 
       default:
@@ -624,26 +839,24 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
    switch (ihdr->color_type)
    {
       case PNG_IHDR_COLOR_GRAY:
-         png_reverse_filter_copy_line_bw(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_bw(data, line, ihdr->width, ihdr->depth);
          break;
       case PNG_IHDR_COLOR_RGB:
-         png_reverse_filter_copy_line_rgb(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_rgb(data, line, ihdr->width, ihdr->depth);
          break;
       case PNG_IHDR_COLOR_PLT:
-         png_reverse_filter_copy_line_plt(data, pngp->decoded_scanline, ihdr->width,
+         png_reverse_filter_copy_line_plt(data, line, ihdr->width,
                ihdr->depth, pngp->palette);
          break;
       case PNG_IHDR_COLOR_GRAY_ALPHA:
-         png_reverse_filter_copy_line_gray_alpha(data, pngp->decoded_scanline, ihdr->width,
+         png_reverse_filter_copy_line_gray_alpha(data, line, ihdr->width,
                ihdr->depth);
          break;
       case PNG_IHDR_COLOR_RGBA:
-         png_reverse_filter_copy_line_rgba(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
+         png_reverse_filter_copy_line_rgba(data, line, ihdr->width, ihdr->depth);
          break;
    }
 
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
-
    return IMAGE_PROCESS_NEXT;
 }
 
@@ -1113,6 +1326,7 @@ error:
       if (rpng->process->stream)
          rpng->process->stream_backend->stream_free(rpng->process->stream);
       free(rpng->process);
+      rpng->process = NULL;
    }
    return IMAGE_PROCESS_ERROR;
 }
@@ -24,12 +24,31 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <compat/zlib.h>
 #include <encodings/crc32.h>
+#include <features/features_cpu.h>
 #include <streams/file_stream.h>
-#include <streams/trans_stream.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 #include "rpng_internal.h"
 
+/* The image is filtered and deflated in horizontal bands of
+ * roughly this many bytes. Bands are independent raw deflate
+ * streams joined with sync flushes (like pigz), so they can be
+ * encoded on several threads and written out as they complete. */
+#define RPNG_ENCODE_BAND_SIZE    (256 * 1024)
+#define RPNG_ENCODE_MAX_THREADS  8
+#define RPNG_ENCODE_LEVEL        Z_DEFAULT_COMPRESSION
+
 #undef GOTO_END_ERROR
 #define GOTO_END_ERROR() do { \
    fprintf(stderr, "[RPNG]: Error in line %d.\n", __LINE__); \
@@ -93,12 +112,17 @@ static bool png_write_ihdr(RFILE *file, const struct png_ihdr *ihdr)
    return true;
 }
 
-static bool png_write_idat(RFILE *file, const uint8_t *data, size_t size)
+/* Writes an IDAT chunk whose payload is stored in data + 8.
+ * The first 8 bytes are scratch space for the chunk header. */
+static bool png_write_idat(RFILE *file, uint8_t *data, size_t size)
 {
-   if (filestream_write(file, data, size) != (ssize_t)size)
+   dword_write_be(data + 0, (uint32_t)size);
+   memcpy(data + 4, "IDAT", 4);
+
+   if (filestream_write(file, data, size + 8) != (ssize_t)(size + 8))
       return false;
 
-   if (!png_write_crc(file, data + sizeof(uint32_t), size - sizeof(uint32_t)))
+   if (!png_write_crc(file, data + sizeof(uint32_t), size + 4))
       return false;
 
    return true;
@@ -145,11 +169,46 @@ static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
    }
 }
 
+/* Sum of absolute values of the filtered bytes, seen as signed. */
 static unsigned count_sad(const uint8_t *data, size_t size)
 {
-   size_t i;
+   size_t i     = 0;
    unsigned cnt = 0;
-   for (i = 0; i < size; i++)
+
+#if defined(__SSE2__)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i sum        = zero;
+
+      for (; i + 16 <= size; i += 16)
+      {
+         __m128i v   = _mm_loadu_si128((const __m128i*)(data + i));
+         /* For a signed byte, |x| == min((uint8)x, (uint8)-x). */
+         __m128i abs = _mm_min_epu8(v, _mm_sub_epi8(zero, v));
+         sum         = _mm_add_epi64(sum, _mm_sad_epu8(abs, zero));
+      }
+
+      cnt = (unsigned)_mm_cvtsi128_si32(sum)
+         + (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+   }
+#elif defined(__ARM_NEON__)
+   {
+      uint32x4_t sum = vdupq_n_u32(0);
+
+      for (; i + 16 <= size; i += 16)
+      {
+         /* vabsq_s8(-128) wraps to -128, which is 128 unsigned. */
+         uint8x16_t abs = vreinterpretq_u8_s8(
+               vabsq_s8(vld1q_s8((const int8_t*)(data + i))));
+         sum            = vpadalq_u16(sum, vpaddlq_u8(abs));
+      }
+
+      cnt = vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1)
+         + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+   }
+#endif
+
+   for (; i < size; i++)
       cnt += abs((int8_t)data[i]);
    return cnt;
 }
@@ -205,69 +264,96 @@ static unsigned filter_paeth(uint8_t *target,
    return count_sad(target, width);
 }
 
-static bool rpng_save_image(const char *path,
-      const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+struct rpng_encode_band
+{
+   uint8_t *out;      /* 8 bytes of chunk header room, then deflated data. */
+   size_t out_size;   /* Size of the deflated data. */
+   size_t in_size;    /* Size of the filtered data. */
+   uint32_t adler;    /* Adler-32 of the filtered data. */
+   bool done;
+   bool ok;
+};
+
+struct rpng_encode_ctx
 {
-   unsigned h;
-   bool ret = true;
-   struct png_ihdr ihdr = {0};
-
-   const struct trans_stream_backend *stream_backend = NULL;
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
+   const uint8_t *data;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   unsigned bpp;
+   unsigned band_rows;
+   unsigned num_bands;
+   struct rpng_encode_band *bands;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+   scond_t *cond;
+   unsigned next_band;
+   /* Bands written out so far; workers stay within
+    * max_ahead bands of it. */
+   unsigned written;
+   unsigned max_ahead;
+   bool abort;
+#endif
+};
+
+static void rpng_encode_copy_line(const struct rpng_encode_ctx *ctx,
+      uint8_t *dst, unsigned y)
+{
+   const uint8_t *src = ctx->data + (size_t)y * ctx->pitch;
+
+   if (ctx->bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, ctx->width);
+   else
+      copy_bgr24_line(dst, src, ctx->width);
+}
+
+/* Filters and deflates one band of rows. Only reads shared
+ * state, so it can run on any thread. */
+static bool rpng_encode_band(const struct rpng_encode_ctx *ctx,
+      unsigned index, struct rpng_encode_band *band)
+{
+   unsigned y;
+   z_stream z;
+   int zret;
+   bool ret                = true;
+   bool z_inited           = false;
+   bool last               = index + 1 == ctx->num_bands;
+   unsigned line_size      = ctx->width * ctx->bpp;
+   unsigned start          = index * ctx->band_rows;
+   unsigned end            = start + ctx->band_rows;
+   uint8_t *filtered_buf   = NULL;
+   uint8_t *encode_target  = NULL;
    uint8_t *rgba_line      = NULL;
+   uint8_t *prev_encoded   = NULL;
    uint8_t *up_filtered    = NULL;
    uint8_t *sub_filtered   = NULL;
    uint8_t *avg_filtered   = NULL;
    uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
-   void *stream            = NULL;
-   uint32_t total_in       = 0;
-   uint32_t total_out      = 0;
-   RFILE *file             = filestream_open(path, RFILE_MODE_WRITE, -1);
-   if (!file)
+   size_t out_cap          = 0;
+
+   if (end > ctx->height)
+      end = ctx->height;
+
+   band->in_size  = (size_t)(line_size + 1) * (end - start);
+   filtered_buf   = (uint8_t*)malloc(band->in_size);
+   prev_encoded   = (uint8_t*)calloc(1, line_size);
+   rgba_line      = (uint8_t*)malloc(line_size);
+   up_filtered    = (uint8_t*)malloc(line_size);
+   sub_filtered   = (uint8_t*)malloc(line_size);
+   avg_filtered   = (uint8_t*)malloc(line_size);
+   paeth_filtered = (uint8_t*)malloc(line_size);
+   if (!filtered_buf || !prev_encoded || !rgba_line || !up_filtered
+         || !sub_filtered || !avg_filtered || !paeth_filtered)
       GOTO_END_ERROR();
 
-   stream_backend = trans_stream_get_zlib_deflate_backend();
+   /* Filters look one row up, which may belong to the previous band. */
+   if (start > 0)
+      rpng_encode_copy_line(ctx, prev_encoded, start - 1);
 
-   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
-      GOTO_END_ERROR();
-
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr(file, &ihdr))
-      GOTO_END_ERROR();
-
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
-
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
-      GOTO_END_ERROR();
-
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
-
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   encode_target = filtered_buf;
+   for (y = start; y < end; y++, encode_target += line_size)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
+      rpng_encode_copy_line(ctx, rgba_line, y);
 
       /* Try every filtering method, and choose the method
        * which has most entries as zero.
@@ -276,11 +362,11 @@ static bool rpng_save_image(const char *path,
        * simple to implement.
        */
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
-         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
+         unsigned none_score  = count_sad(rgba_line, line_size);
+         unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, ctx->width, ctx->bpp);
+         unsigned sub_score   = filter_sub(sub_filtered, rgba_line, ctx->width, ctx->bpp);
+         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, ctx->width, ctx->bpp);
+         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, ctx->width, ctx->bpp);
 
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
@@ -314,62 +400,260 @@ static bool rpng_save_image(const char *path,
          }
 
          *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
+         memcpy(encode_target, chosen_filtered, line_size);
 
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         memcpy(prev_encoded, rgba_line, line_size);
       }
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
-
-   stream = stream_backend->stream_new();
+   band->adler = adler32(adler32(0L, Z_NULL, 0),
+         filtered_buf, (uInt)band->in_size);
 
-   if (!stream)
+   memset(&z, 0, sizeof(z));
+   if (deflateInit2(&z, RPNG_ENCODE_LEVEL, Z_DEFLATED,
+            -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
       GOTO_END_ERROR();
+   z_inited = true;
 
-   stream_backend->set_in(
-         stream,
-         encode_buf,
-         (unsigned)encode_buf_size);
-   stream_backend->set_out(
-         stream,
-         deflate_buf + 8,
-         (unsigned)(encode_buf_size * 2));
-
-   if (!stream_backend->trans(stream, true, &total_in, &total_out, NULL))
-   {
+   /* Room for the chunk header, the zlib header on the first band,
+    * the sync flush marker and the Adler-32 trailer on the last. */
+   out_cap   = deflateBound(&z, (uLong)band->in_size) + 8 + 2 + 6 + 4;
+   band->out = (uint8_t*)malloc(out_cap);
+   if (!band->out)
       GOTO_END_ERROR();
-   }
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0,        ((uint32_t)total_out));
-   if (!png_write_idat(file, deflate_buf, ((size_t)total_out + 8)))
-      GOTO_END_ERROR();
+   z.next_in   = filtered_buf;
+   z.avail_in  = (uInt)band->in_size;
+   z.next_out  = band->out + 8 + 2;
+   z.avail_out = (uInt)(out_cap - 8 - 2 - 4);
 
-   if (!png_write_iend(file))
+   /* Non-final bands end on a byte boundary with an empty stored
+    * block, so the next band's raw stream can be appended as is. */
+   zret = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+   if (last ? zret != Z_STREAM_END : (zret != Z_OK || z.avail_in != 0))
       GOTO_END_ERROR();
 
+   band->out_size = (size_t)(z.next_out - (band->out + 8 + 2));
+
 end:
-   filestream_close(file);
-   free(encode_buf);
-   free(deflate_buf);
+   if (z_inited)
+      deflateEnd(&z);
+   free(filtered_buf);
    free(rgba_line);
    free(prev_encoded);
    free(up_filtered);
    free(sub_filtered);
    free(avg_filtered);
    free(paeth_filtered);
+   return ret;
+}
+
+/* Writes a finished band as one IDAT chunk, adding the zlib header
+ * to the first band and the combined Adler-32 to the last one. */
+static bool rpng_encode_write_band(const struct rpng_encode_ctx *ctx,
+      RFILE *file, unsigned index, uint32_t *adler)
+{
+   struct rpng_encode_band *band = &ctx->bands[index];
+   uint8_t *payload              = band->out + 8 + 2;
+   size_t size                   = band->out_size;
+
+   *adler = index == 0 ? band->adler
+      : (uint32_t)adler32_combine(*adler, band->adler, (z_off_t)band->in_size);
 
-   if (stream_backend)
+   if (index == 0)
    {
-      if (stream)
+      /* CMF/FLG for a 32K window at the default level. */
+      payload   -= 2;
+      size      += 2;
+      payload[0] = 0x78;
+      payload[1] = 0x9c;
+   }
+
+   if (index + 1 == ctx->num_bands)
+   {
+      dword_write_be(payload + size, *adler);
+      size += 4;
+   }
+
+   return png_write_idat(file, payload - 8, size);
+}
+
+#ifdef HAVE_THREADS
+static void rpng_encode_thread(void *data)
+{
+   struct rpng_encode_ctx *ctx = (struct rpng_encode_ctx*)data;
+
+   for (;;)
+   {
+      unsigned index;
+      bool ok;
+
+      slock_lock(ctx->lock);
+      while (!ctx->abort && ctx->next_band < ctx->num_bands
+            && ctx->next_band >= ctx->written + ctx->max_ahead)
+         scond_wait(ctx->cond, ctx->lock);
+
+      if (ctx->abort || ctx->next_band >= ctx->num_bands)
+      {
+         slock_unlock(ctx->lock);
+         break;
+      }
+      index = ctx->next_band++;
+      slock_unlock(ctx->lock);
+
+      ok = rpng_encode_band(ctx, index, &ctx->bands[index]);
+
+      slock_lock(ctx->lock);
+      ctx->bands[index].ok   = ok;
+      ctx->bands[index].done = true;
+      scond_broadcast(ctx->cond);
+      slock_unlock(ctx->lock);
+   }
+}
+#endif
+
+static bool rpng_save_image(const char *path,
+      const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   bool ret                   = true;
+   struct png_ihdr ihdr       = {0};
+   struct rpng_encode_ctx ctx = {0};
+   uint32_t adler             = 0;
+   unsigned num_threads       = 0;
+#ifdef HAVE_THREADS
+   sthread_t *threads[RPNG_ENCODE_MAX_THREADS] = {NULL};
+#endif
+   RFILE *file                = NULL;
+
+   if (!width || !height)
+      GOTO_END_ERROR();
+
+   file = filestream_open(path, RFILE_MODE_WRITE, -1);
+   if (!file)
+      GOTO_END_ERROR();
+
+   if (filestream_write(file, png_magic, sizeof(png_magic)) != sizeof(png_magic))
+      GOTO_END_ERROR();
+
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr(file, &ihdr))
+      GOTO_END_ERROR();
+
+   ctx.data      = data;
+   ctx.width     = width;
+   ctx.height    = height;
+   ctx.pitch     = pitch;
+   ctx.bpp       = bpp;
+   ctx.band_rows = RPNG_ENCODE_BAND_SIZE / (width * bpp + 1);
+   if (ctx.band_rows < 1)
+      ctx.band_rows = 1;
+   ctx.num_bands = (height + ctx.band_rows - 1) / ctx.band_rows;
+   ctx.bands     = (struct rpng_encode_band*)
+      calloc(ctx.num_bands, sizeof(*ctx.bands));
+   if (!ctx.bands)
+      GOTO_END_ERROR();
+
+#ifdef HAVE_THREADS
+   num_threads = cpu_features_get_core_amount();
+   if (num_threads > RPNG_ENCODE_MAX_THREADS)
+      num_threads = RPNG_ENCODE_MAX_THREADS;
+   if (num_threads > ctx.num_bands)
+      num_threads = ctx.num_bands;
+
+   if (num_threads > 1)
+   {
+      ctx.max_ahead = num_threads * 2;
+      ctx.lock      = slock_new();
+      ctx.cond = scond_new();
+      if (!ctx.lock || !ctx.cond)
+         num_threads = 0;
+   }
+   else
+      num_threads = 0;
+
+   for (i = 0; i < num_threads; i++)
+   {
+      threads[i] = sthread_create(rpng_encode_thread, &ctx);
+      if (!threads[i])
+         break;
+   }
+   num_threads = i;
+#endif
+
+   /* Write bands out in order as soon as each one is ready.
+    * Workers don't get more than max_ahead bands past the last
+    * one written, which bounds how many are held in memory. */
+   for (i = 0; i < ctx.num_bands; i++)
+   {
+      struct rpng_encode_band *band = &ctx.bands[i];
+
+#ifdef HAVE_THREADS
+      if (num_threads)
       {
-         if (stream_backend->stream_free)
-            stream_backend->stream_free(stream);
+         slock_lock(ctx.lock);
+         while (!band->done)
+            scond_wait(ctx.cond, ctx.lock);
+         slock_unlock(ctx.lock);
       }
+      else
+#endif
+      {
+         band->ok   = rpng_encode_band(&ctx, i, band);
+         band->done = true;
+      }
+
+      if (!band->ok)
+         GOTO_END_ERROR();
+
+      if (!rpng_encode_write_band(&ctx, file, i, &adler))
+         GOTO_END_ERROR();
+
+      free(band->out);
+      band->out = NULL;
+
+#ifdef HAVE_THREADS
+      if (num_threads)
+      {
+         slock_lock(ctx.lock);
+         ctx.written = i + 1;
+         scond_broadcast(ctx.cond);
+         slock_unlock(ctx.lock);
+      }
+#endif
+   }
+
+   if (!png_write_iend(file))
+      GOTO_END_ERROR();
+
+end:
+#ifdef HAVE_THREADS
+   if (num_threads)
+   {
+      slock_lock(ctx.lock);
+      ctx.abort = true;
+      scond_broadcast(ctx.cond);
+      slock_unlock(ctx.lock);
+
+      for (i = 0; i < num_threads; i++)
+         sthread_join(threads[i]);
+   }
+   if (ctx.lock)
+      slock_free(ctx.lock);
+   if (ctx.cond)
+      scond_free(ctx.cond);
+#endif
+   if (ctx.bands)
+   {
+      for (i = 0; i < ctx.num_bands; i++)
+         free(ctx.bands[i].out);
+      free(ctx.bands);
    }
+   filestream_close(file);
    return ret;
 }
 
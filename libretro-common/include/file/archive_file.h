@@ -204,6 +204,91 @@ const struct file_archive_file_backend* file_archive_get_file_backend(const char
  **/
 uint32_t file_archive_get_file_crc32(const char *path);
 
+/* One member of a ZIP archive, as recorded in its central directory. */
+struct file_archive_zip_entry
+{
+   const char *name;
+   uint32_t crc32;
+   uint32_t csize;
+   uint32_t size;
+   uint32_t offset;  /* of the member's local file header */
+   unsigned cmode;
+};
+
+typedef struct file_archive_zip_index file_archive_zip_index_t;
+
+/**
+ * file_archive_zip_index_acquire:
+ * @path                         : filename path of a ZIP archive,
+ *                                 optionally followed by #member
+ *
+ * Parses the archive's central directory into an index with
+ * O(1) lookup by name. Indexes of recently used archives are
+ * cached and reused for as long as the archive's size and central
+ * directory record on disk are unchanged, so listing, CRC lookups
+ * and extraction of the same archive share a single parse.
+ *
+ * Returns: the index, to be released with
+ * file_archive_zip_index_release(), or NULL if the archive could
+ * not be parsed.
+ **/
+file_archive_zip_index_t *file_archive_zip_index_acquire(const char *path);
+
+void file_archive_zip_index_release(file_archive_zip_index_t *index);
+
+void file_archive_zip_index_init(void);
+void file_archive_zip_index_deinit(void);
+
+size_t file_archive_zip_index_count(const file_archive_zip_index_t *index);
+
+const struct file_archive_zip_entry *file_archive_zip_index_at(
+      const file_archive_zip_index_t *index, size_t i);
+
+/* Exact, case-sensitive name lookup. Returns NULL if not found. */
+const struct file_archive_zip_entry *file_archive_zip_index_find(
+      const file_archive_zip_index_t *index, const char *name);
+
+/**
+ * file_archive_init:
+ *
+ * Sets up the state the archive backends share between threads.
+ * Call once, before archives are read from more than one thread;
+ * without it, archives must only be read from one thread at a time.
+ **/
+void file_archive_init(void);
+
+/**
+ * file_archive_deinit:
+ *
+ * Frees the archive caches and the state set up by
+ * file_archive_init(). No archive may be in use.
+ **/
+void file_archive_deinit(void);
+
+/**
+ * file_archive_release_cache:
+ *
+ * Drops the data kept to speed up repeated reads of an archive,
+ * such as the last decoded 7z block and its open file. Call once
+ * content has been loaded.
+ **/
+void file_archive_release_cache(void);
+
+/**
+ * file_archive_set_cache_limit:
+ * @limit            : Size in bytes.
+ *
+ * Sets the largest decoded 7z block kept between reads of an
+ * archive. Larger blocks are decoded again for every member read
+ * from them. Call before archives are read.
+ **/
+void file_archive_set_cache_limit(size_t limit);
+
+void file_archive_7z_init(void);
+void file_archive_7z_set_cache_limit(size_t limit);
+void file_archive_7z_release_cache(void);
+void file_archive_7z_deinit(void);
+
 extern const struct file_archive_file_backend zlib_backend;
 extern const struct file_archive_file_backend sevenzip_backend;
 
@@ -42,14 +42,28 @@ struct item_file
    size_t entry_idx;
    void *userdata;
    void *actiondata;
+   /* Where this item's strings start in the list's string pool. */
+   size_t strings_mark;
 };
 
+struct file_list_string_block;
+
 typedef struct file_list
 {
    struct item_file *list;
 
    size_t capacity;
    size_t size;
+
+   /* path, label and alt of every item are carved out of these
+    * blocks, and released together when the list is cleared.
+    * A label or alt overwritten with a longer string is moved to
+    * the heap instead; strings_on_heap counts those. */
+   struct file_list_string_block *strings;
+   size_t strings_on_heap;
+   /* Set once items no longer own the pool in list order, after
+    * which popping an item can't hand its strings back early. */
+   bool strings_unordered;
 } file_list_t;
 
 
@@ -65,6 +79,8 @@ bool file_list_append(file_list_t *userdata, const char *path,
       const char *label, unsigned type, size_t current_directory_ptr,
       size_t entry_index);
 
+bool file_list_reserve(file_list_t *list, size_t nitems);
+
 bool file_list_prepend(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr,
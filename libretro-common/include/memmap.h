@@ -23,6 +23,8 @@
 #ifndef _LIBRETRO_MEMMAP_H
 #define _LIBRETRO_MEMMAP_H
 
+#include <stddef.h>
+
 #if defined(__CELLOS_LV2__) || defined(PSP) || defined(GEKKO) || defined(VITA) || defined(_XBOX) || defined(_3DS) || defined(WIIU)
 /* No mman available */
 #elif defined(_WIN32) && !defined(_XBOX)
@@ -46,4 +48,22 @@ int memsync(void *start, void *end);
 
 int memprotect(void *addr, size_t len);
 
+/**
+ * memmap_file_map:
+ * @path             : path to file.
+ * @len              : size of the file.
+ *
+ * Maps the whole of a regular file privately: the pages are shared
+ * with the page cache until written to, writes go to private
+ * copies and never reach the file. Like filestream_read_file, the
+ * data is followed by a '\0'.
+ *
+ * Returns: the mapped data, or NULL if the file can't be mapped
+ * (not a regular file, empty, too large for the address space, or
+ * no mmap on this platform). Release with memmap_file_unmap.
+ **/
+void *memmap_file_map(const char *path, size_t *len);
+
+void memmap_file_unmap(void *data, size_t len);
+
 #endif
@@ -35,7 +35,9 @@ RETRO_BEGIN_DECLS
 enum intfstream_type
 {
    INTFSTREAM_FILE = 0,
-   INTFSTREAM_MEMORY
+   INTFSTREAM_MEMORY,
+   /* Read-only member of a ZIP archive, opened as "archive.zip#member" */
+   INTFSTREAM_ZIP
 };
 
 typedef struct intfstream_internal intfstream_internal_t;
@@ -0,0 +1,67 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (zip_stream.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIBRETRO_SDK_ZIP_STREAM_H
+#define _LIBRETRO_SDK_ZIP_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Read-only stream over a single member of a ZIP archive, read
+ * straight from the archive file without extracting it first.
+ *
+ * Stored members are read and seeked in place. Deflated members
+ * are inflated on the fly; while reading forward, a checkpoint
+ * of the inflate state is recorded every ZIPSTREAM_SPAN bytes so
+ * that later backward seeks resume from the nearest checkpoint
+ * instead of inflating the member again from the start. */
+
+#define ZIPSTREAM_SPAN (1 << 20)
+
+typedef struct zipstream zipstream_t;
+
+/* path is "archive.zip#member". Without a member, the first
+ * file in the archive is opened. */
+zipstream_t *zipstream_open(const char *path);
+
+int zipstream_close(zipstream_t *stream);
+
+ssize_t zipstream_read(zipstream_t *stream, void *data, size_t len);
+
+ssize_t zipstream_seek(zipstream_t *stream, ssize_t offset, int whence);
+
+ssize_t zipstream_tell(zipstream_t *stream);
+
+/* Uncompressed size of the member. */
+ssize_t zipstream_get_size(zipstream_t *stream);
+
+/* CRC32 of the member, as recorded in the central directory. */
+uint32_t zipstream_get_crc32(zipstream_t *stream);
+
+RETRO_END_DECLS
+
+#endif
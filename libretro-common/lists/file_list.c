@@ -29,6 +29,195 @@
 #include <string/stdstring.h>
 #include <compat/strcasestr.h>
 
+#define FILE_LIST_STRING_BLOCK_SIZE 4096
+
+struct file_list_string_block
+{
+   struct file_list_string_block *next;
+   /* Offset of data[0] within the whole pool. */
+   size_t base;
+   size_t size;
+   size_t used;
+   char data[1];
+};
+
+static size_t file_list_strings_top(const file_list_t *list)
+{
+   if (!list->strings)
+      return 0;
+   return list->strings->base + list->strings->used;
+}
+
+static char *file_list_strdup(file_list_t *list, const char *str)
+{
+   char *ptr                             = NULL;
+   size_t len                            = strlen(str) + 1;
+   struct file_list_string_block *block  = list->strings;
+
+   if (!block || block->size - block->used < len)
+   {
+      size_t size = FILE_LIST_STRING_BLOCK_SIZE;
+
+      /* Grow geometrically so that big lists
+       * only ever need a handful of blocks. */
+      if (block && block->size * 2 > size)
+         size = block->size * 2;
+      if (size < len)
+         size = len;
+
+      block = (struct file_list_string_block*)
+         malloc(sizeof(*block) + size);
+
+      if (!block)
+         return NULL;
+
+      block->next   = list->strings;
+      block->base   = file_list_strings_top(list);
+      block->size   = size;
+      block->used   = 0;
+      list->strings = block;
+   }
+
+   ptr          = block->data + block->used;
+   memcpy(ptr, str, len);
+   block->used += len;
+
+   return ptr;
+}
+
+/* Hands back everything allocated from @mark onwards. */
+static void file_list_strings_rewind(file_list_t *list, size_t mark)
+{
+   struct file_list_string_block *block = list->strings;
+
+   while (block && block->next && block->base > mark)
+   {
+      list->strings = block->next;
+      free(block);
+      block         = list->strings;
+   }
+
+   if (block && mark >= block->base)
+      block->used = mark - block->base;
+}
+
+static void file_list_strings_free(file_list_t *list)
+{
+   struct file_list_string_block *block = list->strings;
+
+   while (block)
+   {
+      struct file_list_string_block *next = block->next;
+      free(block);
+      block = next;
+   }
+
+   list->strings = NULL;
+}
+
+/* Releases an item string that is about to be dropped. Pool
+ * strings go with their block; only heap ones are freed here. */
+static void file_list_strings_release(file_list_t *list, char *str)
+{
+   struct file_list_string_block *block = list->strings;
+
+   if (!str || !list->strings_on_heap)
+      return;
+
+   for (; block; block = block->next)
+      if (str >= block->data && str < block->data + block->size)
+         return;
+
+   free(str);
+   list->strings_on_heap--;
+}
+
+static void file_list_strings_release_item(file_list_t *list, size_t idx)
+{
+   file_list_strings_release(list, list->list[idx].path);
+   file_list_strings_release(list, list->list[idx].label);
+   file_list_strings_release(list, list->list[idx].alt);
+}
+
+/* Overwrites the label or alt of item @idx. The new string is
+ * copied over the old one when it fits, and put on the heap when
+ * it doesn't, so that updating an item over and over doesn't keep
+ * growing the pool. Only an item's first string comes from it. */
+static char *file_list_strings_replace(file_list_t *list, size_t idx,
+      char *old, const char *str)
+{
+   size_t len = 0;
+   char *copy = NULL;
+
+   if (!str)
+   {
+      file_list_strings_release(list, old);
+      return NULL;
+   }
+
+   if (!old)
+   {
+      /* The string lands past later items' strings, which can
+       * then no longer be handed back by popping them. */
+      if (idx + 1 != list->size)
+         list->strings_unordered = true;
+      return file_list_strdup(list, str);
+   }
+
+   len = strlen(str);
+
+   if (len <= strlen(old))
+   {
+      memmove(old, str, len + 1);
+      return old;
+   }
+
+   copy = strdup(str);
+
+   if (!copy)
+      return old;
+
+   list->strings_on_heap++;
+   file_list_strings_release(list, old);
+
+   return copy;
+}
+
+/* Empties the pool. If it had to grow into several blocks, they
+ * are merged into one big enough to hold the same again. */
+static void file_list_strings_reset(file_list_t *list)
+{
+   size_t size                          = 0;
+   struct file_list_string_block *block = list->strings;
+
+   list->strings_unordered              = false;
+
+   if (!block)
+      return;
+
+   if (!block->next)
+   {
+      block->used = 0;
+      return;
+   }
+
+   for (; block; block = block->next)
+      size += block->size;
+
+   file_list_strings_free(list);
+
+   block = (struct file_list_string_block*)malloc(sizeof(*block) + size);
+
+   if (!block)
+      return;
+
+   block->next   = NULL;
+   block->base   = 0;
+   block->size   = size;
+   block->used   = 0;
+   list->strings = block;
+}
+
 /**
  * file_list_capacity:
  * @list             : pointer to file list
@@ -66,11 +255,12 @@ static void file_list_add(file_list_t *list, unsigned idx,
    list->list[idx].entry_idx     = entry_idx;
    list->list[idx].userdata      = NULL;
    list->list[idx].actiondata    = NULL;
+   list->list[idx].strings_mark  = file_list_strings_top(list);
 
    if (label)
-      list->list[idx].label      = strdup(label);
+      list->list[idx].label      = file_list_strdup(list, label);
    if (path)
-      list->list[idx].path       = strdup(path);
+      list->list[idx].path       = file_list_strdup(list, path);
 
    list->size++;
 }
@@ -91,27 +281,48 @@ static bool file_list_expand_if_needed(file_list_t *list)
    return true;
 }
 
+/**
+ * file_list_reserve:
+ * @list             : pointer to file list
+ * @nitems           : number of items to make room for.
+ *
+ * Grows the list's capacity so that it can hold at least
+ * @nitems items without reallocating.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool file_list_reserve(file_list_t *list, size_t nitems)
+{
+   struct item_file *items = NULL;
+
+   if (!list)
+      return false;
+
+   if (nitems <= list->capacity)
+      return true;
+
+   items = realloc_file_list_capacity(list, nitems);
+   if (!items)
+      return false;
+
+   list->list     = items;
+   list->capacity = nitems;
+   return true;
+}
+
 bool file_list_prepend(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr,
       size_t entry_idx)
 {
-   unsigned i;
-   
    if (!file_list_expand_if_needed(list))
       return false;
 
-   for (i = (unsigned)list->size; i > 0; i--)
+   if (list->size)
    {
-      struct item_file *copy = (struct item_file*)
-         calloc(1, sizeof(struct item_file));
-      
-      memcpy(copy, &list->list[i-1], sizeof(struct item_file));
-
-      memcpy(&list->list[i-1], &list->list[i], sizeof(struct item_file));
-      memcpy(&list->list[i],             copy, sizeof(struct item_file));
-
-      free(copy);
+      memmove(&list->list[1], &list->list[0],
+            list->size * sizeof(struct item_file));
+      list->strings_unordered = true;
    }
 
    file_list_add(list, 0, path, label, type,
@@ -156,13 +367,18 @@ void file_list_pop(file_list_t *list, size_t *directory_ptr)
    if (list->size != 0)
    {
       --list->size;
-      if (list->list[list->size].path)
-         free(list->list[list->size].path);
-      list->list[list->size].path = NULL;
 
-      if (list->list[list->size].label)
-         free(list->list[list->size].label);
+      file_list_strings_release_item(list, list->size);
+
+      if (list->size == 0)
+         file_list_strings_reset(list);
+      else if (!list->strings_unordered)
+         file_list_strings_rewind(list,
+               list->list[list->size].strings_mark);
+
+      list->list[list->size].path  = NULL;
       list->list[list->size].label = NULL;
+      list->list[list->size].alt   = NULL;
    }
 
    if (directory_ptr)
@@ -180,22 +396,12 @@ void file_list_free(file_list_t *list)
    {
       file_list_free_userdata(list, i);
       file_list_free_actiondata(list, i);
-       
-      if (list->list[i].path)
-         free(list->list[i].path);
-      list->list[i].path = NULL;
-
-      if (list->list[i].label)
-         free(list->list[i].label);
-      list->list[i].label = NULL;
-
-      if (list->list[i].alt)
-         free(list->list[i].alt);
-      list->list[i].alt = NULL;
+      file_list_strings_release_item(list, i);
    }
    if (list->list)
       free(list->list);
    list->list = NULL;
+   file_list_strings_free(list);
    free(list);
 }
 
@@ -208,20 +414,14 @@ void file_list_clear(file_list_t *list)
 
    for (i = 0; i < list->size; i++)
    {
-      if (list->list[i].path)
-         free(list->list[i].path);
-      list->list[i].path = NULL;
-
-      if (list->list[i].label)
-         free(list->list[i].label);
+      file_list_strings_release_item(list, i);
+      list->list[i].path  = NULL;
       list->list[i].label = NULL;
-
-      if (list->list[i].alt)
-         free(list->list[i].alt);
-      list->list[i].alt = NULL;
+      list->list[i].alt   = NULL;
    }
 
    list->size = 0;
+   file_list_strings_reset(list);
 }
 
 void file_list_copy(const file_list_t *src, file_list_t *dst)
@@ -233,28 +433,16 @@ void file_list_copy(const file_list_t *src, file_list_t *dst)
 
    if (dst->list)
    {
-      for (item = dst->list; item < &dst->list[dst->size]; ++item)
-      {
-         if (!item)
-            continue;
-
-         if (item->path)
-            free(item->path);
-         item->path = NULL;
-
-         if (item->label)
-            free(item->label);
-         item->label = NULL;
-
-         if (item->alt)
-            free(item->alt);
-         item->alt = NULL;
-      }
+      size_t i;
 
+      for (i = 0; i < dst->size; i++)
+         file_list_strings_release_item(dst, i);
       free(dst->list);
       dst->list = NULL;
    }
 
+   file_list_strings_reset(dst);
+
    dst->size     = 0;
    dst->capacity = 0;
    dst->list     = (struct item_file*)malloc(src->size * sizeof(struct item_file));
@@ -268,14 +456,16 @@ void file_list_copy(const file_list_t *src, file_list_t *dst)
 
    for (item = dst->list; item < &dst->list[dst->size]; ++item)
    {
+      item->strings_mark = file_list_strings_top(dst);
+
       if (item->path)
-         item->path  = strdup(item->path);
+         item->path  = file_list_strdup(dst, item->path);
 
       if (item->label)
-         item->label = strdup(item->label);
+         item->label = file_list_strdup(dst, item->label);
 
       if (item->alt)
-         item->alt   = strdup(item->alt);
+         item->alt   = file_list_strdup(dst, item->alt);
    }
 }
 
@@ -285,12 +475,8 @@ void file_list_set_label_at_offset(file_list_t *list, size_t idx,
    if (!list)
       return;
 
-   if (list->list[idx].label)
-      free(list->list[idx].label);
-   list->list[idx].alt      = NULL;
-
-   if (label)
-      list->list[idx].label = strdup(label);
+   list->list[idx].label = file_list_strings_replace(list, idx,
+         list->list[idx].label, label);
 }
 
 void file_list_get_label_at_offset(const file_list_t *list, size_t idx,
@@ -310,12 +496,8 @@ void file_list_set_alt_at_offset(file_list_t *list, size_t idx,
    if (!list || !alt)
       return;
 
-   if (list->list[idx].alt)
-      free(list->list[idx].alt);
-   list->list[idx].alt      = NULL;
-
-   if (alt)
-      list->list[idx].alt   = strdup(alt);
+   list->list[idx].alt = file_list_strings_replace(list, idx,
+         list->list[idx].alt, alt);
 }
 
 void file_list_get_alt_at_offset(const file_list_t *list, size_t idx,
@@ -352,11 +534,15 @@ static int file_list_type_cmp(const void *a_, const void *b_)
 
 void file_list_sort_on_alt(file_list_t *list)
 {
+   if (list->size > 1)
+      list->strings_unordered = true;
    qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
 }
 
 void file_list_sort_on_type(file_list_t *list)
 {
+   if (list->size > 1)
+      list->strings_unordered = true;
    qsort(list->list, list->size, sizeof(list->list[0]), file_list_type_cmp);
 }
 
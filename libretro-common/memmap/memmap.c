@@ -21,8 +21,15 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <memmap.h>
 
+#if defined(HAVE_MMAN) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
 #ifndef PROT_READ
 #define PROT_READ         0x1  /* Page can be read */
 #endif
@@ -160,3 +167,81 @@ int memprotect(void *addr, size_t len)
 {
    return mprotect(addr, len, PROT_READ | PROT_WRITE | PROT_EXEC);
 }
+
+#if defined(HAVE_MMAN) && !defined(_WIN32)
+/* Bytes reserved for a mapping of @len bytes: whole pages,
+ * with at least one zero byte past the end of the file. */
+static size_t memmap_file_reserved_size(size_t len)
+{
+   size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+   return (len + page) & ~(page - 1);
+}
+#endif
+
+void *memmap_file_map(const char *path, size_t *len)
+{
+#if defined(HAVE_MMAN) && !defined(_WIN32)
+   struct stat st;
+   size_t size;
+   size_t reserved;
+   uint8_t *data = (uint8_t*)MAP_FAILED;
+   int fd        = open(path, O_RDONLY);
+
+   if (fd < 0)
+      return NULL;
+
+   if (     fstat(fd, &st) != 0
+         || !S_ISREG(st.st_mode)
+         || st.st_size <= 0
+         || (uint64_t)st.st_size >= (uint64_t)(size_t)-1 / 2)
+      goto end;
+
+   size     = (size_t)st.st_size;
+   reserved = memmap_file_reserved_size(size);
+
+   /* Reserve room for the terminator first, then put the file
+    * over the start of it. When the file ends on a page boundary
+    * the terminator lands in the anonymous page after it,
+    * otherwise in the zeroed remainder of the file's last page. */
+   data = (uint8_t*)mmap(NULL, reserved, PROT_READ | PROT_WRITE,
+#ifdef MAP_ANONYMOUS
+         MAP_PRIVATE | MAP_ANONYMOUS,
+#else
+         MAP_PRIVATE | MAP_ANON,
+#endif
+         -1, 0);
+
+   if (data == (uint8_t*)MAP_FAILED)
+      goto end;
+
+   if (mmap(data, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+   {
+      munmap(data, reserved);
+      data = (uint8_t*)MAP_FAILED;
+      goto end;
+   }
+
+   *len = size;
+
+end:
+   close(fd);
+   return data == (uint8_t*)MAP_FAILED ? NULL : data;
+#else
+   (void)path;
+   (void)len;
+   return NULL;
+#endif
+}
+
+void memmap_file_unmap(void *data, size_t len)
+{
+#if defined(HAVE_MMAN) && !defined(_WIN32)
+   if (data)
+      munmap(data, memmap_file_reserved_size(len));
+#else
+   (void)data;
+   (void)len;
+#endif
+}
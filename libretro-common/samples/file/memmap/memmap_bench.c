@@ -0,0 +1,148 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (memmap_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <memmap.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+#include <streams/file_stream.h>
+
+/* Loads a content file the way content loading does (read it,
+ * CRC it, let the "core" write a few bytes) once by reading it into
+ * the heap and once by mapping it, each in a child process so the
+ * peak resident set size reported covers one load only. On Linux
+ * the resident set is also split into anonymous memory and file
+ * pages, which the kernel can drop and share with the page cache.
+ * Usage: memmap_bench content_file */
+
+enum bench_mode
+{
+   BENCH_READ = 0,
+   BENCH_MAP
+};
+
+static const char *bench_mode_names[] = { "read", "map" };
+
+static long bench_status_kb(const char *field)
+{
+   long kb = -1;
+#ifdef __linux__
+   char line[256];
+   size_t len = strlen(field);
+   FILE *fp   = fopen("/proc/self/status", "r");
+
+   if (!fp)
+      return -1;
+
+   while (fgets(line, sizeof(line), fp))
+      if (!strncmp(line, field, len) && line[len] == ':')
+      {
+         kb = strtol(line + len + 1, NULL, 10);
+         break;
+      }
+
+   fclose(fp);
+#endif
+   return kb;
+}
+
+static int bench_load(const char *path, enum bench_mode mode)
+{
+   struct rusage usage;
+   size_t i;
+   retro_time_t start;
+   retro_time_t loaded;
+   retro_time_t total;
+   uint32_t crc    = 0;
+   uint8_t *data   = NULL;
+   ssize_t len     = 0;
+   size_t map_len  = 0;
+
+   start = cpu_features_get_time_usec();
+
+   if (mode == BENCH_MAP)
+   {
+      data = (uint8_t*)memmap_file_map(path, &map_len);
+      len  = (ssize_t)map_len;
+   }
+   else if (!filestream_read_file(path, (void**)&data, &len))
+      data = NULL;
+
+   if (!data)
+   {
+      fprintf(stderr, "%s: failed to load %s\n", bench_mode_names[mode], path);
+      return 1;
+   }
+
+   loaded = cpu_features_get_time_usec() - start;
+   crc    = encoding_crc32(0, data, len);
+
+   /* A core patching a few bytes of its copy. */
+   for (i = 0; i < (size_t)len; i += len / 16 + 1)
+      data[i] ^= 0xff;
+
+   total = cpu_features_get_time_usec() - start;
+
+   getrusage(RUSAGE_SELF, &usage);
+
+   printf("%-4s: %10ld bytes, load %9.2f ms, load+CRC %9.2f ms, "
+         "peak RSS %8ld KB (anon %8ld KB, file %8ld KB), CRC32 %08x, terminated %s\n",
+         bench_mode_names[mode], (long)len, loaded / 1000.0, total / 1000.0,
+         usage.ru_maxrss, bench_status_kb("RssAnon"), bench_status_kb("RssFile"),
+         crc, data[len] == '\0' ? "yes" : "no");
+
+   if (mode == BENCH_MAP)
+      memmap_file_unmap(data, map_len);
+   else
+      free(data);
+
+   return 0;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned mode;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s content_file\n", argv[0]);
+      return 1;
+   }
+
+   for (mode = BENCH_READ; mode <= BENCH_MAP; mode++)
+   {
+      pid_t pid = fork();
+
+      if (pid == 0)
+         return bench_load(argv[1], (enum bench_mode)mode);
+      if (pid > 0)
+         waitpid(pid, NULL, 0);
+   }
+
+   return 0;
+}
@@ -0,0 +1,152 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (sevenzip_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/archive_file.h>
+#include <file/file_path.h>
+#include <features/features_cpu.h>
+#include <lists/string_list.h>
+#include <encodings/crc32.h>
+
+/* Extracts every member of a 7z archive twice: once walking the
+ * archive into a directory, the way the decompression task does,
+ * and once reading each member into memory by name, the way
+ * content is loaded from "archive.7z#member" paths. Prints the
+ * time taken and the CRC32 of every member.
+ * Usage: sevenzip_bench archive.7z output_dir */
+
+struct bench_state
+{
+   const char *output_dir;
+   uint64_t bytes;
+   unsigned members;
+   unsigned errors;
+};
+
+static struct bench_state bench;
+
+static int bench_extract_cb(const char *name, const char *valid_exts,
+      const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
+      uint32_t crc32, struct archive_extract_userdata *userdata)
+{
+   char path[PATH_MAX_LENGTH];
+
+   /* The 7z walk signals the end with an empty name. */
+   if (!name || !*name)
+      return 0;
+
+   fill_pathname_join(path, bench.output_dir,
+         path_basename(name), sizeof(path));
+
+   if (file_archive_perform_mode(path, valid_exts,
+            cdata, cmode, csize, size, crc32, userdata))
+   {
+      bench.bytes += size;
+      bench.members++;
+   }
+   else
+      bench.errors++;
+
+   return 1;
+}
+
+static retro_time_t bench_walk(const char *archive)
+{
+   file_archive_transfer_t transfer;
+   struct archive_extract_userdata userdata;
+   bool returnerr     = true;
+   retro_time_t start = cpu_features_get_time_usec();
+
+   memset(&transfer, 0, sizeof(transfer));
+   memset(&userdata, 0, sizeof(userdata));
+
+   transfer.type = ARCHIVE_TRANSFER_INIT;
+
+   while (file_archive_parse_file_iterate(&transfer, &returnerr, archive,
+            NULL, bench_extract_cb, &userdata) == 0);
+
+   return cpu_features_get_time_usec() - start;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   retro_time_t total;
+   retro_time_t start;
+   uint64_t bytes           = 0;
+   unsigned errors          = 0;
+   struct string_list *list = NULL;
+
+   if (argc < 3)
+   {
+      fprintf(stderr, "Usage: %s archive.7z output_dir\n", argv[0]);
+      return 1;
+   }
+
+   bench.output_dir = argv[2];
+
+   total = bench_walk(argv[1]);
+
+   printf("walk: %u members, %.1f MB in %8.2f ms, %7.1f MB/s, %u errors\n",
+         bench.members, bench.bytes / 1000000.0, total / 1000.0,
+         total ? (double)bench.bytes / total : 0.0, bench.errors);
+
+   list = file_archive_get_file_list(argv[1], NULL);
+   if (!list)
+   {
+      fprintf(stderr, "Failed to list %s.\n", argv[1]);
+      return 1;
+   }
+
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < list->size; i++)
+   {
+      char path[PATH_MAX_LENGTH];
+      void *buf      = NULL;
+      ssize_t length = 0;
+
+      snprintf(path, sizeof(path), "%s#%s", argv[1], list->elems[i].data);
+
+      if (!file_archive_compressed_read(path, &buf, NULL, &length)
+            || length < 0)
+      {
+         errors++;
+         continue;
+      }
+
+      printf("%s %08x\n", list->elems[i].data,
+            encoding_crc32(0, (const uint8_t*)buf, length));
+      bytes += length;
+      free(buf);
+   }
+   total = cpu_features_get_time_usec() - start;
+
+   printf("read by name: %u members, %.1f MB in %8.2f ms, %7.1f MB/s, %u errors\n",
+         (unsigned)list->size, bytes / 1000000.0, total / 1000.0,
+         total ? (double)bytes / total : 0.0, errors);
+
+   string_list_free(list);
+   return 0;
+}
@@ -0,0 +1,229 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (chd_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+
+#include "chd.h"
+#include "cdrom.h"
+
+/* Replays a sector-access trace against a CHD image with several
+ * hunk cache and read-ahead configurations, reporting the time
+ * spent in chd_read and the cache hit rate of each, then times
+ * chd_verify on one thread and on every core.
+ * The trace is a text file with one sector number per line; without
+ * one, a synthetic trace of sequential runs with short seeks back
+ * (streamed audio/video interleaved with data lookups) is used.
+ * Usage: chd_bench image.chd [trace.txt] */
+
+struct bench_config
+{
+   unsigned hunks;
+   unsigned readahead;
+};
+
+static const unsigned bench_verify_threads[] = { 1, 0 };
+
+static const struct bench_config bench_configs[] = {
+   {  0, 0 },
+   {  1, 0 },
+   { 16, 0 },
+   { 16, 4 },
+   { 64, 8 },
+};
+
+static uint32_t *load_trace(const char *path, size_t *count)
+{
+   size_t cap       = 1024;
+   uint32_t *trace  = (uint32_t*)malloc(cap * sizeof(*trace));
+   unsigned long sector;
+   FILE *fp         = fopen(path, "r");
+
+   *count = 0;
+   if (!fp || !trace)
+      goto error;
+
+   while (fscanf(fp, "%lu", &sector) == 1)
+   {
+      if (*count == cap)
+      {
+         uint32_t *tmp = (uint32_t*)realloc(trace, cap * 2 * sizeof(*trace));
+         if (!tmp)
+            goto error;
+         trace  = tmp;
+         cap   *= 2;
+      }
+      trace[(*count)++] = (uint32_t)sector;
+   }
+
+   fclose(fp);
+   return trace;
+
+error:
+   if (fp)
+      fclose(fp);
+   free(trace);
+   return NULL;
+}
+
+static uint32_t *make_trace(uint32_t sectors, size_t *count)
+{
+   size_t i;
+   uint32_t seed    = 1;
+   uint32_t pos     = 0;
+   uint32_t *trace  = (uint32_t*)malloc(65536 * sizeof(*trace));
+
+   if (!trace)
+      return NULL;
+
+   for (i = 0; i < 65536; i++)
+   {
+      seed = seed * 1103515245u + 12345u;
+
+      /* Mostly sequential, now and then a short hop back
+       * or a long seek somewhere else on the disc. */
+      switch ((seed >> 16) % 64)
+      {
+         case 0:
+            pos = (seed >> 8) % sectors;
+            break;
+         case 1:
+         case 2:
+            pos = pos > 32 ? pos - 32 : 0;
+            break;
+         default:
+            pos++;
+            break;
+      }
+
+      if (pos >= sectors)
+         pos = 0;
+      trace[i] = pos;
+   }
+
+   *count = 65536;
+   return trace;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   chd_file *chd               = NULL;
+   const chd_header *header    = NULL;
+   uint32_t *trace             = NULL;
+   uint8_t *buffer             = NULL;
+   size_t count                = 0;
+   unsigned unitbytes;
+   unsigned units_per_hunk;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s image.chd [trace.txt]\n", argv[0]);
+      return 1;
+   }
+
+   if (chd_open(argv[1], CHD_OPEN_READ, NULL, &chd) != CHDERR_NONE)
+   {
+      fprintf(stderr, "Failed to open %s.\n", argv[1]);
+      return 1;
+   }
+
+   header         = chd_get_header(chd);
+   unitbytes      = header->unitbytes ? header->unitbytes : CD_FRAME_SIZE;
+   units_per_hunk = header->hunkbytes / unitbytes;
+   buffer         = (uint8_t*)malloc(header->hunkbytes);
+
+   if (argc > 2)
+      trace = load_trace(argv[2], &count);
+   else
+      trace = make_trace(header->totalhunks * units_per_hunk, &count);
+
+   if (!trace || !buffer || !units_per_hunk)
+   {
+      fprintf(stderr, "Failed to set up the trace.\n");
+      goto end;
+   }
+
+   printf("%s: %u hunks of %u bytes, %u sectors per hunk, %u accesses\n",
+         argv[1], header->totalhunks, header->hunkbytes,
+         units_per_hunk, (unsigned)count);
+
+   for (i = 0; i < sizeof(bench_configs) / sizeof(bench_configs[0]); i++)
+   {
+      size_t j;
+      retro_time_t start, total;
+      uint32_t hits          = 0;
+      uint32_t misses        = 0;
+      unsigned errors        = 0;
+      const struct bench_config *config = &bench_configs[i];
+
+      chd_set_cache(chd, config->hunks, config->readahead);
+
+      start = cpu_features_get_time_usec();
+      for (j = 0; j < count; j++)
+      {
+         uint32_t hunknum = trace[j] / units_per_hunk;
+
+         if (hunknum >= header->totalhunks)
+            continue;
+         if (chd_read(chd, hunknum, buffer) != CHDERR_NONE)
+            errors++;
+      }
+      total = cpu_features_get_time_usec() - start;
+
+      chd_get_cache_stats(chd, &hits, &misses);
+
+      printf("cache %3u, read-ahead %2u: %8.2f ms, %6.2f us/access, "
+            "hit rate %5.1f%% (%u hits, %u misses, %u errors)\n",
+            config->hunks, config->readahead,
+            total / 1000.0, (double)total / count,
+            hits + misses ? 100.0 * hits / (hits + misses) : 0.0,
+            hits, misses, errors);
+   }
+
+   for (i = 0; i < sizeof(bench_verify_threads) / sizeof(bench_verify_threads[0]); i++)
+   {
+      retro_time_t start, total;
+      uint32_t crc  = 0;
+      chd_error err;
+
+      start = cpu_features_get_time_usec();
+      err   = chd_verify(chd, bench_verify_threads[i], &crc);
+      total = cpu_features_get_time_usec() - start;
+
+      printf("verify, %u thread(s): %8.2f ms, %7.1f MB/s, CRC32 %08x (%s)\n",
+            bench_verify_threads[i] ? bench_verify_threads[i] : cpu_features_get_core_amount(),
+            total / 1000.0,
+            total ? (double)header->logicalbytes / total : 0.0,
+            crc, chd_error_string(err));
+   }
+
+end:
+   free(trace);
+   free(buffer);
+   chd_close(chd);
+   return 0;
+}
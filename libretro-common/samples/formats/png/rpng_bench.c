@@ -0,0 +1,228 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpng_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <formats/image.h>
+#include <formats/rpng.h>
+#include <streams/file_stream.h>
+
+/* Without file arguments, encodes synthetic 1080p and 4K frames and
+ * reports the average time per rpng_save_image_argb call.
+ * With file arguments (e.g. a thumbnail directory), decodes every
+ * PNG given and reports the total and per-image decode time.
+ * Usage: rpng_bench [iterations] [corpus.png ...] */
+
+struct bench_size
+{
+   const char *name;
+   unsigned width;
+   unsigned height;
+};
+
+static const struct bench_size bench_sizes[] = {
+   { "1080p", 1920, 1080 },
+   { "4K",    3840, 2160 },
+};
+
+/* Something screenshot-like: smooth gradients with flat
+ * regions and a bit of noise, so every filter gets picked. */
+static void fill_image(uint32_t *data, unsigned width, unsigned height)
+{
+   unsigned x, y;
+   uint32_t seed = 1;
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         uint32_t r, g, b;
+         seed = seed * 1103515245u + 12345u;
+
+         if (((x / 64) + (y / 64)) & 1)
+         {
+            r = (x * 255) / width;
+            g = (y * 255) / height;
+            b = ((x + y) >> 2) & 0xff;
+         }
+         else
+            r = g = b = 0x20;
+
+         if ((seed >> 16) % 8 == 0)
+            b ^= (seed >> 24) & 0x0f;
+
+         data[y * width + x] = 0xff000000u | (r << 16) | (g << 8) | b;
+      }
+   }
+}
+
+/* Decodes a PNG already in memory, the same way task_image does. */
+static bool decode_image(void *buf, size_t len,
+      unsigned *width, unsigned *height)
+{
+   int retval;
+   uint32_t *data = NULL;
+   bool ret       = false;
+   rpng_t *rpng   = rpng_alloc();
+
+   if (!rpng)
+      return false;
+
+   if (!rpng_set_buf_ptr(rpng, buf) || !rpng_start(rpng))
+      goto end;
+
+   while (rpng_iterate_image(rpng));
+
+   if (!rpng_is_valid(rpng))
+      goto end;
+
+   do
+   {
+      retval = rpng_process_image(rpng, (void**)&data, len, width, height);
+   } while (retval == IMAGE_PROCESS_NEXT);
+
+   ret = retval == IMAGE_PROCESS_END;
+
+end:
+   rpng_free(rpng);
+   free(data);
+   return ret;
+}
+
+static void bench_decode(int argc, char *argv[], unsigned iterations)
+{
+   int i;
+   unsigned j;
+   unsigned decoded    = 0;
+   uint64_t pixels     = 0;
+   retro_time_t total  = 0;
+
+   for (i = 0; i < argc; i++)
+   {
+      retro_time_t start;
+      unsigned width  = 0;
+      unsigned height = 0;
+      void *buf       = NULL;
+      void *scratch   = NULL;
+      ssize_t len     = 0;
+
+      if (!filestream_read_file(argv[i], &buf, &len))
+         continue;
+
+      /* rpng scribbles over the chunk headers while parsing,
+       * so each iteration gets a fresh copy of the file. */
+      scratch = malloc(len);
+      if (!scratch)
+      {
+         free(buf);
+         continue;
+      }
+
+      for (j = 0; j < iterations; j++)
+      {
+         bool ok;
+
+         memcpy(scratch, buf, len);
+         start  = cpu_features_get_time_usec();
+         ok     = decode_image(scratch, len, &width, &height);
+         total += cpu_features_get_time_usec() - start;
+
+         if (!ok)
+            break;
+      }
+
+      if (j == iterations)
+      {
+         decoded++;
+         pixels += (uint64_t)width * height;
+      }
+      else
+         fprintf(stderr, "Failed to decode %s.\n", argv[i]);
+
+      free(scratch);
+      free(buf);
+   }
+
+   if (!decoded)
+      return;
+
+   printf("decode: %u images, %.2f Mpixels: %8.2f ms total, %.1f us/image (%u iterations)\n",
+         decoded, pixels / 1000000.0, total / 1000.0 / iterations,
+         (double)total / iterations / decoded, iterations);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, j;
+   unsigned iterations = 5;
+   const char *path    = "/tmp/rpng_bench.png";
+
+   if (argc > 1)
+      iterations = (unsigned)strtoul(argv[1], NULL, 0);
+   if (!iterations)
+      iterations = 1;
+
+   if (argc > 2)
+   {
+      bench_decode(argc - 2, argv + 2, iterations);
+      return 0;
+   }
+
+   for (i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++)
+   {
+      retro_time_t start, total;
+      const struct bench_size *size = &bench_sizes[i];
+      uint32_t *data = (uint32_t*)malloc(
+            size->width * size->height * sizeof(uint32_t));
+
+      if (!data)
+         return 1;
+
+      fill_image(data, size->width, size->height);
+
+      start = cpu_features_get_time_usec();
+      for (j = 0; j < iterations; j++)
+      {
+         if (!rpng_save_image_argb(path, data,
+                  size->width, size->height,
+                  size->width * sizeof(uint32_t)))
+         {
+            fprintf(stderr, "Failed to encode %s.\n", size->name);
+            free(data);
+            return 1;
+         }
+      }
+      total = cpu_features_get_time_usec() - start;
+
+      printf("%-6s %4ux%-4u: %8.2f ms/encode (%u iterations)\n",
+            size->name, size->width, size->height,
+            total / 1000.0 / iterations, iterations);
+
+      free(data);
+   }
+
+   return 0;
+}
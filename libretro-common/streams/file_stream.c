@@ -488,7 +488,11 @@ error:
 int filestream_flush(RFILE *stream)
 {
 #if defined(HAVE_BUFFERED_IO)
-   return fflush(stream->fp);
+   /* Unbuffered streams have no FILE, and fflush(NULL)
+    * would flush every stream of the process. */
+   if ((stream->hints & RFILE_HINT_UNBUFFERED) == 0)
+      return fflush(stream->fp);
+   return 0;
 #else
    return 0;
 #endif
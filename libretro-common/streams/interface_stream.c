@@ -20,11 +20,15 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
 #include <streams/memory_stream.h>
+#ifdef HAVE_ZLIB
+#include <streams/zip_stream.h>
+#endif
 
 struct intfstream_internal
 {
@@ -45,6 +49,12 @@ struct intfstream_internal
       memstream_t *fp;
       bool writable;
    } memory;
+#ifdef HAVE_ZLIB
+   struct
+   {
+      zipstream_t *fp;
+   } zip;
+#endif
 };
 
 bool intfstream_resize(intfstream_internal_t *intf, intfstream_info_t *info)
@@ -55,6 +65,7 @@ bool intfstream_resize(intfstream_internal_t *intf, intfstream_info_t *info)
    switch (intf->type)
    {
       case INTFSTREAM_FILE:
+      case INTFSTREAM_ZIP:
          break;
       case INTFSTREAM_MEMORY:
          intf->memory.buf.data = info->memory.buf.data;
@@ -86,6 +97,15 @@ bool intfstream_open(intfstream_internal_t *intf, const char *path,
          if (!intf->memory.fp)
             return false;
          break;
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         intf->zip.fp = zipstream_open(path);
+         if (!intf->zip.fp)
+            return false;
+         break;
+#else
+         return false;
+#endif
    }
 
    return true;
@@ -103,6 +123,12 @@ int intfstream_close(intfstream_internal_t *intf)
       case INTFSTREAM_MEMORY:
          memstream_close(intf->memory.fp);
          return 0;
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         return zipstream_close(intf->zip.fp);
+#else
+         break;
+#endif
    }
 
    return -1;
@@ -124,6 +150,7 @@ void *intfstream_init(intfstream_info_t *info)
    switch (intf->type)
    {
       case INTFSTREAM_FILE:
+      case INTFSTREAM_ZIP:
          break;
       case INTFSTREAM_MEMORY:
          intf->memory.writable = info->memory.writable;
@@ -151,6 +178,12 @@ int intfstream_seek(intfstream_internal_t *intf, int offset, int whence)
          return (int)filestream_seek(intf->file.fp, (int)offset, whence);
       case INTFSTREAM_MEMORY:
          return (int)memstream_seek(intf->memory.fp, offset, whence);
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         return (int)zipstream_seek(intf->zip.fp, offset, whence);
+#else
+         break;
+#endif
    }
 
    return -1;
@@ -167,6 +200,12 @@ ssize_t intfstream_read(intfstream_internal_t *intf, void *s, size_t len)
          return filestream_read(intf->file.fp, s, len);
       case INTFSTREAM_MEMORY:
          return memstream_read(intf->memory.fp, s, len);
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         return zipstream_read(intf->zip.fp, s, len);
+#else
+         break;
+#endif
    }
 
    return 0;
@@ -184,6 +223,9 @@ ssize_t intfstream_write(intfstream_internal_t *intf,
          return filestream_write(intf->file.fp, s, len);
       case INTFSTREAM_MEMORY:
          return memstream_write(intf->memory.fp, s, len);
+      case INTFSTREAM_ZIP:
+         /* Archive members are read-only */
+         break;
    }
 
    return 0;
@@ -201,6 +243,8 @@ char *intfstream_gets(intfstream_internal_t *intf,
          return filestream_gets(intf->file.fp, buffer, len);
       case INTFSTREAM_MEMORY:
          return memstream_gets(intf->memory.fp, buffer, len);
+      case INTFSTREAM_ZIP:
+         break;
    }
 
    return NULL;
@@ -217,6 +261,17 @@ int intfstream_getc(intfstream_internal_t *intf)
          return filestream_getc(intf->file.fp);
       case INTFSTREAM_MEMORY:
          return memstream_getc(intf->memory.fp);
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         {
+            unsigned char c;
+            if (zipstream_read(intf->zip.fp, &c, 1) == 1)
+               return c;
+            return EOF;
+         }
+#else
+         break;
+#endif
    }
 
    return 0;
@@ -233,6 +288,12 @@ int intfstream_tell(intfstream_internal_t *intf)
          return (int)filestream_tell(intf->file.fp);
       case INTFSTREAM_MEMORY:
          return (int)memstream_pos(intf->memory.fp);
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         return (int)zipstream_tell(intf->zip.fp);
+#else
+         break;
+#endif
    }
 
    return -1;
@@ -248,6 +309,11 @@ void intfstream_rewind(intfstream_internal_t *intf)
       case INTFSTREAM_MEMORY:
          memstream_rewind(intf->memory.fp);
          break;
+      case INTFSTREAM_ZIP:
+#ifdef HAVE_ZLIB
+         zipstream_seek(intf->zip.fp, 0, SEEK_SET);
+#endif
+         break;
    }
 }
 
@@ -264,5 +330,7 @@ void intfstream_putc(intfstream_internal_t *intf, int c)
       case INTFSTREAM_MEMORY:
          memstream_putc(intf->memory.fp, c);
          break;
+      case INTFSTREAM_ZIP:
+         break;
    }
 }
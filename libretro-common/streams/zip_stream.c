@@ -0,0 +1,459 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (zip_stream.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <compat/zlib.h>
+#include <file/archive_file.h>
+#include <file/file_path.h>
+#include <retro_inline.h>
+#include <retro_miscellaneous.h>
+#include <streams/file_stream.h>
+#include <streams/zip_stream.h>
+#include <string/stdstring.h>
+
+#define ZIPSTREAM_WINDOW_SIZE 32768
+#define ZIPSTREAM_INPUT_SIZE  65536
+
+#define ZIPSTREAM_LOCAL_FILE_HEADER_SIGNATURE   0x04034b50
+
+/* Enough inflate state to resume decompression at a
+ * deflate block boundary. */
+struct zipstream_checkpoint
+{
+   size_t in;     /* compressed bytes consumed */
+   size_t out;    /* uncompressed bytes produced */
+   int bits;      /* unused bits in the byte before 'in' */
+   uint8_t window[ZIPSTREAM_WINDOW_SIZE];
+};
+
+struct zipstream
+{
+   RFILE *fp;
+   size_t data_offset;  /* start of the member's data in the archive */
+   size_t csize;
+   size_t size;
+   size_t pos;          /* current position in the member */
+   uint32_t crc;
+   unsigned cmode;
+
+   /* Inflate state, deflated members only */
+   z_stream z;
+   bool z_inited;
+   size_t in_read;      /* compressed bytes read from the archive */
+   size_t win_pos;
+   uint8_t *window;     /* last ZIPSTREAM_WINDOW_SIZE bytes inflated */
+   uint8_t *input;
+
+   struct zipstream_checkpoint **index;
+   size_t index_count;
+   size_t index_cap;
+};
+
+static INLINE uint32_t zipstream_read_le(const uint8_t *data, unsigned size)
+{
+   unsigned i;
+   uint32_t val = 0;
+
+   size *= 8;
+   for (i = 0; i < size; i += 8)
+      val |= (uint32_t)*data++ << i;
+
+   return val;
+}
+
+static bool zipstream_read_at(RFILE *fp, size_t offset,
+      void *data, size_t len)
+{
+   if (filestream_seek(fp, (ssize_t)offset, SEEK_SET) < 0)
+      return false;
+   return filestream_read(fp, data, len) == (ssize_t)len;
+}
+
+/* Finds the member in the archive's central directory index and
+ * fills in its sizes, CRC, compression mode and data offset. */
+static bool zipstream_find_member(zipstream_t *stream, const char *path,
+      const char *member)
+{
+   size_t i;
+   uint8_t header[30];
+   ssize_t archive_size;
+   const struct file_archive_zip_entry *found = NULL;
+   file_archive_zip_index_t *index = file_archive_zip_index_acquire(path);
+   bool ret                        = false;
+
+   if (!index)
+      return false;
+
+   /* An exact name match wins; otherwise take the first file
+    * whose name contains the member, like the other archive
+    * readers do. */
+   if (member && *member)
+      found = file_archive_zip_index_find(index, member);
+
+   for (i = 0; !found && i < file_archive_zip_index_count(index); i++)
+   {
+      const struct file_archive_zip_entry *entry =
+         file_archive_zip_index_at(index, i);
+      size_t namelength = strlen(entry->name);
+
+      if (namelength == 0 || entry->name[namelength - 1] == '/'
+            || entry->name[namelength - 1] == '\\')
+         continue;
+      if (!member || !*member || strstr(entry->name, member))
+         found = entry;
+   }
+
+   if (!found)
+      goto end;
+
+   stream->cmode = found->cmode;
+   stream->crc   = found->crc32;
+   stream->csize = found->csize;
+   stream->size  = found->size;
+
+   /* The local header's name and extra lengths can differ
+    * from the central directory's. */
+   if (!zipstream_read_at(stream->fp, found->offset, header, sizeof(header))
+         || zipstream_read_le(header, 4) != ZIPSTREAM_LOCAL_FILE_HEADER_SIGNATURE)
+      goto end;
+
+   stream->data_offset = found->offset + 30
+      + zipstream_read_le(header + 26, 2)
+      + zipstream_read_le(header + 28, 2);
+
+   if (filestream_seek(stream->fp, 0, SEEK_END) < 0)
+      goto end;
+   archive_size = filestream_tell(stream->fp);
+   ret = archive_size >= 0
+      && stream->data_offset + stream->csize <= (size_t)archive_size;
+
+end:
+   file_archive_zip_index_release(index);
+   return ret;
+}
+
+/* Rewinds the inflater to a checkpoint, or to the start of
+ * the member if there is none. */
+static bool zipstream_inflate_restore(zipstream_t *stream,
+      const struct zipstream_checkpoint *point)
+{
+   if (stream->z_inited)
+      inflateEnd(&stream->z);
+
+   memset(&stream->z, 0, sizeof(stream->z));
+   stream->z_inited = inflateInit2(&stream->z, -MAX_WBITS) == Z_OK;
+   if (!stream->z_inited)
+      return false;
+
+   stream->in_read = 0;
+   stream->pos     = 0;
+   stream->win_pos = 0;
+
+   if (!point)
+      return true;
+
+   if (point->bits)
+   {
+      uint8_t byte;
+      if (!zipstream_read_at(stream->fp,
+               stream->data_offset + point->in - 1, &byte, 1))
+         return false;
+      inflatePrime(&stream->z, point->bits, byte >> (8 - point->bits));
+   }
+
+   inflateSetDictionary(&stream->z, point->window, ZIPSTREAM_WINDOW_SIZE);
+
+   /* The ring now holds exactly the checkpoint's window, oldest
+    * byte first, so the next byte written overwrites it. */
+   memcpy(stream->window, point->window, ZIPSTREAM_WINDOW_SIZE);
+   stream->win_pos = ZIPSTREAM_WINDOW_SIZE;
+   stream->in_read = point->in;
+   stream->pos     = point->out;
+   return true;
+}
+
+static void zipstream_add_checkpoint(zipstream_t *stream)
+{
+   struct zipstream_checkpoint *point = NULL;
+   size_t last_out = stream->index_count
+      ? stream->index[stream->index_count - 1]->out : 0;
+
+   /* Only the first forward pass extends the index, keeping it
+    * sorted by output offset. */
+   if (stream->pos < last_out + ZIPSTREAM_SPAN)
+      return;
+
+   if (stream->index_count == stream->index_cap)
+   {
+      size_t cap = stream->index_cap ? stream->index_cap * 2 : 16;
+      struct zipstream_checkpoint **index = (struct zipstream_checkpoint**)
+         realloc(stream->index, cap * sizeof(*index));
+      if (!index)
+         return;
+      stream->index     = index;
+      stream->index_cap = cap;
+   }
+
+   point = (struct zipstream_checkpoint*)malloc(sizeof(*point));
+   if (!point)
+      return;
+
+   point->in   = stream->in_read - stream->z.avail_in;
+   point->out  = stream->pos;
+   point->bits = stream->z.data_type & 7;
+
+   /* Unroll the ring, oldest byte first. */
+   memcpy(point->window, stream->window + stream->win_pos,
+         ZIPSTREAM_WINDOW_SIZE - stream->win_pos);
+   memcpy(point->window + ZIPSTREAM_WINDOW_SIZE - stream->win_pos,
+         stream->window, stream->win_pos);
+
+   stream->index[stream->index_count++] = point;
+}
+
+/* Inflates up to len bytes at the current position into data,
+ * or discards them if data is NULL. */
+static ssize_t zipstream_inflate(zipstream_t *stream,
+      uint8_t *data, size_t len)
+{
+   size_t done = 0;
+
+   while (done < len && stream->pos < stream->size)
+   {
+      int ret;
+      size_t produced;
+      uInt avail_out;
+
+      if (stream->z.avail_in == 0)
+      {
+         size_t chunk = MIN(ZIPSTREAM_INPUT_SIZE,
+               stream->csize - stream->in_read);
+
+         if (chunk == 0 || !zipstream_read_at(stream->fp,
+                  stream->data_offset + stream->in_read,
+                  stream->input, chunk))
+            return -1;
+
+         stream->z.next_in  = stream->input;
+         stream->z.avail_in = (uInt)chunk;
+         stream->in_read   += chunk;
+      }
+
+      if (stream->win_pos == ZIPSTREAM_WINDOW_SIZE)
+         stream->win_pos = 0;
+
+      avail_out           = (uInt)MIN(ZIPSTREAM_WINDOW_SIZE - stream->win_pos,
+            len - done);
+      stream->z.next_out  = stream->window + stream->win_pos;
+      stream->z.avail_out = avail_out;
+
+      ret = inflate(&stream->z, Z_BLOCK);
+      if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+         return -1;
+
+      produced = avail_out - stream->z.avail_out;
+      if (data)
+         memcpy(data + done, stream->window + stream->win_pos, produced);
+      stream->win_pos += produced;
+      stream->pos     += produced;
+      done            += produced;
+
+      if (ret == Z_STREAM_END)
+         break;
+
+      /* At the end of a deflate block that isn't the last one */
+      if ((stream->z.data_type & 128) && !(stream->z.data_type & 64))
+         zipstream_add_checkpoint(stream);
+   }
+
+   return (ssize_t)done;
+}
+
+zipstream_t *zipstream_open(const char *path)
+{
+   char archive[PATH_MAX_LENGTH];
+   const char *member  = NULL;
+   const char *delim   = path_get_archive_delim(path);
+   zipstream_t *stream = (zipstream_t*)calloc(1, sizeof(*stream));
+
+   if (!stream)
+      return NULL;
+
+   strlcpy(archive, path, sizeof(archive));
+   if (delim)
+   {
+      archive[delim - path] = '\0';
+      member                = delim + 1;
+   }
+
+   stream->fp = filestream_open(archive, RFILE_MODE_READ, -1);
+   if (!stream->fp || !zipstream_find_member(stream, archive, member))
+      goto error;
+
+   switch (stream->cmode)
+   {
+      case 0: /* stored */
+         if (stream->csize != stream->size)
+            goto error;
+         break;
+      case 8: /* deflated */
+         stream->window = (uint8_t*)malloc(ZIPSTREAM_WINDOW_SIZE);
+         stream->input  = (uint8_t*)malloc(ZIPSTREAM_INPUT_SIZE);
+         if (!stream->window || !stream->input
+               || !zipstream_inflate_restore(stream, NULL))
+            goto error;
+         break;
+      default:
+         goto error;
+   }
+
+   return stream;
+
+error:
+   zipstream_close(stream);
+   return NULL;
+}
+
+int zipstream_close(zipstream_t *stream)
+{
+   size_t i;
+
+   if (!stream)
+      return -1;
+
+   if (stream->z_inited)
+      inflateEnd(&stream->z);
+   for (i = 0; i < stream->index_count; i++)
+      free(stream->index[i]);
+   free(stream->index);
+   free(stream->window);
+   free(stream->input);
+   if (stream->fp)
+      filestream_close(stream->fp);
+   free(stream);
+   return 0;
+}
+
+ssize_t zipstream_read(zipstream_t *stream, void *data, size_t len)
+{
+   if (!stream || !data)
+      return -1;
+
+   if (len > stream->size - stream->pos)
+      len = stream->size - stream->pos;
+   if (len == 0)
+      return 0;
+
+   if (stream->cmode == 0)
+   {
+      if (!zipstream_read_at(stream->fp,
+               stream->data_offset + stream->pos, data, len))
+         return -1;
+      stream->pos += len;
+      return (ssize_t)len;
+   }
+
+   return zipstream_inflate(stream, (uint8_t*)data, len);
+}
+
+ssize_t zipstream_seek(zipstream_t *stream, ssize_t offset, int whence)
+{
+   size_t target;
+
+   if (!stream)
+      return -1;
+
+   switch (whence)
+   {
+      case SEEK_SET:
+         break;
+      case SEEK_CUR:
+         offset += (ssize_t)stream->pos;
+         break;
+      case SEEK_END:
+         offset += (ssize_t)stream->size;
+         break;
+      default:
+         return -1;
+   }
+
+   if (offset < 0 || (size_t)offset > stream->size)
+      return -1;
+   target = (size_t)offset;
+
+   if (stream->cmode == 8 && target != stream->pos)
+   {
+      const struct zipstream_checkpoint *point = NULL;
+      size_t lo = 0;
+      size_t hi = stream->index_count;
+
+      /* Last checkpoint at or before the target */
+      while (lo < hi)
+      {
+         size_t mid = (lo + hi) / 2;
+         if (stream->index[mid]->out <= target)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      if (lo > 0)
+         point = stream->index[lo - 1];
+
+      /* Going backwards, or far enough forwards that a
+       * checkpoint beats inflating what lies in between */
+      if (target < stream->pos || (point && point->out > stream->pos))
+         if (!zipstream_inflate_restore(stream, point))
+            return -1;
+
+      if (zipstream_inflate(stream, NULL, target - stream->pos) < 0
+            || stream->pos != target)
+         return -1;
+   }
+
+   stream->pos = target;
+   return 0;
+}
+
+ssize_t zipstream_tell(zipstream_t *stream)
+{
+   if (!stream)
+      return -1;
+   return (ssize_t)stream->pos;
+}
+
+ssize_t zipstream_get_size(zipstream_t *stream)
+{
+   if (!stream)
+      return -1;
+   return (ssize_t)stream->size;
+}
+
+uint32_t zipstream_get_crc32(zipstream_t *stream)
+{
+   if (!stream)
+      return 0;
+   return stream->crc;
+}
@@ -43,6 +43,7 @@
 
 #include "../menu_driver.h"
 #include "../menu_animation.h"
+#include "../menu_thumbnail_cache.h"
 
 #include "../widgets/menu_entry.h"
 #include "../widgets/menu_list.h"
@@ -84,7 +85,11 @@ typedef struct
    float y;
    uintptr_t icon;
    uintptr_t content_icon;
-   char fullpath[4096];
+   /* Points right past the node, where its
+    * copy of the path is kept. */
+   char *fullpath;
+   /* Room there, so pooled nodes can be reused. */
+   size_t fullpath_size;
 } xmb_node_t;
 
 enum
@@ -147,6 +152,41 @@ enum
    XMB_TEXTURE_LAST
 };
 
+/* Must be a power of two, and larger than the amount of
+ * entries that can be on screen at the same time. */
+#define XMB_ENTRY_CACHE_SIZE    64
+/* Frames after which a cached entry is fetched again, for
+ * values which change without any menu input. */
+#define XMB_ENTRY_CACHE_MAX_AGE 60
+
+/* Entries ahead of the selection whose thumbnails get loaded
+ * in advance. */
+#define XMB_THUMBNAIL_PREFETCH  4
+
+enum xmb_entry_value_type
+{
+   XMB_ENTRY_VALUE_NONE = 0,
+   XMB_ENTRY_VALUE_TEXT,
+   XMB_ENTRY_VALUE_OFF,
+   XMB_ENTRY_VALUE_ON
+};
+
+/* What xmb_draw_items needs from a menu entry, so that
+ * it doesn't have to rebuild it from scratch every frame. */
+typedef struct
+{
+   const file_list_t *list;
+   size_t idx;
+   unsigned generation;
+   uint64_t frame;
+   unsigned type;
+   enum msg_hash_enums enum_idx;
+   enum xmb_entry_value_type value_type;
+   char label[255];
+   char sublabel[255];
+   char value[255];
+} xmb_entry_cache_t;
+
 enum
 {
    XMB_SYSTEM_TAB_MAIN = 0,
@@ -178,6 +218,10 @@ typedef struct xmb_handle
    float alpha;
    uintptr_t thumbnail;
    uintptr_t savestate_thumbnail;
+   menu_thumbnail_cache_t *thumbnail_cache;
+   /* Whether thumbnail is borrowed from thumbnail_cache. */
+   bool thumbnail_cached;
+   size_t thumbnail_prefetch_ptr;
    float thumbnail_width;
    float thumbnail_height;
    float savestate_thumbnail_width;
@@ -316,6 +360,10 @@ typedef struct xmb_handle
 
    unsigned tabs[8];
    unsigned system_tab_end;
+
+   /* Bumped whenever cached entries may have gone stale. */
+   unsigned entry_cache_generation;
+   xmb_entry_cache_t entry_cache[XMB_ENTRY_CACHE_SIZE];
 } xmb_handle_t;
 
 float gradient_dark_purple[16] = {
@@ -409,26 +457,103 @@ const char* xmb_theme_ident(void)
    return "monochrome";
 }
 
+/* Nodes released by cleared lists are kept here and handed out
+ * again, so that moving through the menu doesn't keep going
+ * back to the heap for every entry. Every node is still its own
+ * allocation, so lists that free() theirs remain fine. */
+#define XMB_NODE_POOL_SIZE 1024
+
+static xmb_node_t *xmb_node_pool[XMB_NODE_POOL_SIZE];
+static unsigned xmb_node_pool_count = 0;
+
 /* NOTE: This exists because calloc()ing xmb_node_t is expensive
- * when you can have big lists like MAME and fba playlists */
-static xmb_node_t *xmb_alloc_node(void)
+ * when you can have big lists like MAME and fba playlists.
+ * The path is stored in the same allocation and sized to fit,
+ * rather than taking up 4KB in every entry. A pooled node is
+ * grown if its path doesn't fit. */
+static xmb_node_t *xmb_alloc_node(const char *fullpath)
 {
-   xmb_node_t *node = (xmb_node_t*)malloc(sizeof(*node));
+   size_t len       = fullpath ? strlen(fullpath) : 0;
+   xmb_node_t *node = NULL;
+
+   if (xmb_node_pool_count)
+   {
+      node = xmb_node_pool[--xmb_node_pool_count];
+
+      if (node->fullpath_size < len + 1)
+      {
+         xmb_node_t *grown = (xmb_node_t*)
+            realloc(node, sizeof(*node) + len + 1);
+
+         if (!grown)
+         {
+            free(node);
+            return NULL;
+         }
+
+         node                = grown;
+         node->fullpath_size = len + 1;
+      }
+   }
+   else
+   {
+      node = (xmb_node_t*)malloc(sizeof(*node) + len + 1);
+
+      if (!node)
+         return NULL;
+
+      node->fullpath_size = len + 1;
+   }
 
    node->alpha = node->label_alpha  = 0;
    node->zoom  = node->x = node->y  = 0;
    node->icon  = node->content_icon = 0;
-   node->fullpath[0] = 0;
+   node->fullpath = (char*)(node + 1);
+
+   if (len)
+      memcpy(node->fullpath, fullpath, len);
+   node->fullpath[len] = '\0';
 
    return node;
 }
 
-/* NOTE: This is faster than memcpy()ing xmb_node_t in most cases
- * because most nodes have small (less than 200 bytes) fullpath */
+static void xmb_free_node(xmb_node_t *node)
+{
+   if (!node)
+      return;
+
+   if (xmb_node_pool_count < XMB_NODE_POOL_SIZE)
+      xmb_node_pool[xmb_node_pool_count++] = node;
+   else
+      free(node);
+}
+
+static void xmb_free_node_pool(void)
+{
+   while (xmb_node_pool_count)
+      free(xmb_node_pool[--xmb_node_pool_count]);
+}
+
+/* Releases the node of entry @i of @list, if any. */
+static void xmb_free_list_node(file_list_t *list, size_t i)
+{
+   xmb_node_t *node = (xmb_node_t*)
+      menu_entries_get_userdata_at_offset(list, i);
+
+   if (!node)
+      return;
+
+   xmb_free_node(node);
+   list->list[i].userdata = NULL;
+}
+
 static xmb_node_t *xmb_copy_node(void *p)
 {
    xmb_node_t *old_node = (xmb_node_t*)p;
-   xmb_node_t *new_node = (xmb_node_t*)malloc(sizeof(*new_node));
+   xmb_node_t *new_node = xmb_alloc_node(old_node->fullpath);
+
+   if (!new_node)
+      return NULL;
 
    new_node->alpha        = old_node->alpha;
    new_node->label_alpha  = old_node->label_alpha;
@@ -438,8 +563,6 @@ static xmb_node_t *xmb_copy_node(void *p)
    new_node->icon         = old_node->icon;
    new_node->content_icon = old_node->content_icon;
 
-   strlcpy(new_node->fullpath, old_node->fullpath, sizeof(old_node->fullpath));
-
    return new_node;
 }
 
@@ -566,6 +689,141 @@ static INLINE float xmb_item_y(xmb_handle_t *xmb, int i, size_t current)
    return iy;
 }
 
+/**
+ * xmb_calculate_visible_range:
+ * @xmb              : XMB handle.
+ * @height           : Height of the screen.
+ * @margin           : Distance off screen items still count as visible.
+ * @list_size        : Number of entries in the list.
+ * @current          : Selected entry.
+ * @first            : First visible entry.
+ * @last             : Last visible entry.
+ *
+ * Finds the entries whose resting position lies within @margin
+ * of the screen. Only entries within the animation threshold of
+ * xmb_selection_pointer_changed() are animated, everything else
+ * is moved to its resting position right away.
+ **/
+static void xmb_calculate_visible_range(xmb_handle_t *xmb,
+      unsigned height, float margin, size_t list_size, size_t current,
+      size_t *first, size_t *last)
+{
+   size_t i;
+   float top    = xmb->margins.screen.top;
+
+   *first       = 0;
+   *last        = list_size ? list_size - 1 : 0;
+
+   if (current >= list_size)
+      return;
+
+   for (i = current; i > 0; i--)
+   {
+      if (top + xmb_item_y(xmb, (int)(i - 1), current)
+            + xmb->icon.size < -margin)
+      {
+         *first = i;
+         break;
+      }
+   }
+
+   for (i = current + 1; i < list_size; i++)
+   {
+      if (top + xmb_item_y(xmb, (int)i, current) > height + margin)
+      {
+         *last  = i - 1;
+         break;
+      }
+   }
+}
+
+/**
+ * xmb_entry_cache_get:
+ * @xmb              : XMB handle.
+ * @list             : List the entry belongs to.
+ * @i                : Index of the entry.
+ *
+ * Returns: cached draw data for entry @i of @list, building it
+ * when missing or stale.
+ **/
+static xmb_entry_cache_t *xmb_entry_cache_get(xmb_handle_t *xmb,
+      file_list_t *list, size_t i)
+{
+   menu_entry_t entry;
+   xmb_entry_cache_t *cache = &xmb->entry_cache[
+      i & (XMB_ENTRY_CACHE_SIZE - 1)];
+
+   if (     cache->list       == list
+         && cache->idx        == i
+         && cache->generation == xmb->entry_cache_generation
+         && xmb->frame_count - cache->frame < XMB_ENTRY_CACHE_MAX_AGE)
+      return cache;
+
+   entry.path[0]       = '\0';
+   entry.label[0]      = '\0';
+   entry.sublabel[0]   = '\0';
+   entry.value[0]      = '\0';
+   entry.rich_label[0] = '\0';
+   entry.enum_idx      = MSG_UNKNOWN;
+   entry.entry_idx     = 0;
+   entry.idx           = 0;
+   entry.type          = 0;
+   entry.spacing       = 0;
+
+   menu_entry_get(&entry, 0, i, list, true);
+
+   cache->list       = list;
+   cache->idx        = i;
+   cache->generation = xmb->entry_cache_generation;
+   cache->frame      = xmb->frame_count;
+   cache->type       = entry.type;
+   cache->enum_idx   = entry.enum_idx;
+
+   strlcpy(cache->label, !string_is_empty(entry.rich_label)
+         ? entry.rich_label : entry.path, sizeof(cache->label));
+   strlcpy(cache->sublabel, entry.sublabel, sizeof(cache->sublabel));
+   strlcpy(cache->value, entry.value, sizeof(cache->value));
+
+   if (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_DISABLED)) ||
+      (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_OFF))))
+      cache->value_type = XMB_ENTRY_VALUE_OFF;
+   else if (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_ENABLED)) ||
+         (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_ON))))
+      cache->value_type = XMB_ENTRY_VALUE_ON;
+   else
+   {
+      enum msg_file_type type = msg_hash_to_file_type(msg_hash_calculate(entry.value));
+
+      switch (type)
+      {
+         case FILE_TYPE_IN_CARCHIVE:
+         case FILE_TYPE_COMPRESSED:
+         case FILE_TYPE_MORE:
+         case FILE_TYPE_CORE:
+         case FILE_TYPE_DIRECT_LOAD:
+         case FILE_TYPE_RDB:
+         case FILE_TYPE_CURSOR:
+         case FILE_TYPE_PLAIN:
+         case FILE_TYPE_DIRECTORY:
+         case FILE_TYPE_MUSIC:
+         case FILE_TYPE_IMAGE:
+         case FILE_TYPE_MOVIE:
+            cache->value_type = XMB_ENTRY_VALUE_NONE;
+            break;
+         default:
+            cache->value_type = XMB_ENTRY_VALUE_TEXT;
+            break;
+      }
+   }
+
+   return cache;
+}
+
+static INLINE void xmb_entry_cache_invalidate(xmb_handle_t *xmb)
+{
+   xmb->entry_cache_generation++;
+}
+
 static void xmb_draw_icon(
       menu_display_frame_info_t menu_disp_info,
       int icon_size,
@@ -906,20 +1164,27 @@ end:
    string_list_free(list);
 }
 
-static void xmb_update_thumbnail_path(void *data, unsigned i)
+/**
+ * xmb_get_thumbnail_path:
+ * @xmb              : XMB handle.
+ * @i                : Index of the entry.
+ * @content          : Name to look the thumbnail up by.
+ * @path             : Thumbnail path of entry @i.
+ * @len              : Size of @path.
+ *
+ * Returns: false if entry @i has no thumbnail, otherwise true.
+ **/
+static bool xmb_get_thumbnail_path(xmb_handle_t *xmb, unsigned i,
+      const char *content, char *path, size_t len)
 {
    menu_entry_t entry;
    char tmp_new[PATH_MAX_LENGTH];
    char             *tmp    = NULL;
    char *scrub_char_pointer = NULL;
    settings_t     *settings = config_get_ptr();
-   xmb_handle_t     *xmb    = (xmb_handle_t*)data;
    playlist_t     *playlist = NULL;
    const char    *core_name = NULL;
 
-   if (!xmb)
-      return;
-
    entry.path[0]       = '\0';
    entry.label[0]      = '\0';
    entry.sublabel[0]   = '\0';
@@ -941,21 +1206,12 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
 
       if (node)
       {
-         fill_pathname_join(
-               xmb->thumbnail_file_path,
-               node->fullpath,
-               entry.path,
-               sizeof(xmb->thumbnail_file_path));
-
-         return;
+         fill_pathname_join(path, node->fullpath, entry.path, len);
+         return true;
       }
    }
    else if (filebrowser_get_type() != FILEBROWSER_NONE)
-   {
-      xmb->thumbnail_file_path[0] = '\0';
-      xmb->thumbnail = 0;
-      return;
-   }
+      return false;
 
    menu_driver_ctl(RARCH_MENU_CTL_PLAYLIST_GET, &playlist);
 
@@ -966,27 +1222,25 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
 
       if (string_is_equal(core_name, "imageviewer"))
       {
-         strlcpy(xmb->thumbnail_file_path, entry.label,
-               sizeof(xmb->thumbnail_file_path));
-         return;
+         strlcpy(path, entry.label, len);
+         return true;
       }
    }
 
    fill_pathname_join(
-         xmb->thumbnail_file_path,
+         path,
          settings->paths.directory_thumbnails,
          xmb->thumbnail_system,
-         sizeof(xmb->thumbnail_file_path));
+         len);
 
-   fill_pathname_join(xmb->thumbnail_file_path, xmb->thumbnail_file_path,
-         xmb_thumbnails_ident(), sizeof(xmb->thumbnail_file_path));
+   fill_pathname_join(path, path, xmb_thumbnails_ident(), len);
 
    /* Scrub characters that are not cross-platform and/or violate the
     * No-Intro filename standard:
     * http://datomatic.no-intro.org/stuff/The%20Official%20No-Intro%20Convention%20(20071030).zip
     * Replace these characters in the entry name with underscores.
     */
-   tmp = strdup(xmb->thumbnail_content);
+   tmp = strdup(content);
 
    while((scrub_char_pointer = strpbrk(tmp, "&*/:`<>?\\|")))
       *scrub_char_pointer = '_';
@@ -994,16 +1248,50 @@ static void xmb_update_thumbnail_path(void *data, unsigned i)
    /* Look for thumbnail file with this scrubbed filename */
    tmp_new[0] = '\0';
 
-   fill_pathname_join(tmp_new,
-         xmb->thumbnail_file_path,
-         tmp, sizeof(tmp_new));
-   strlcpy(xmb->thumbnail_file_path,
-         tmp_new, sizeof(xmb->thumbnail_file_path));
+   fill_pathname_join(tmp_new, path, tmp, sizeof(tmp_new));
+   strlcpy(path, tmp_new, len);
    free(tmp);
 
-   strlcat(xmb->thumbnail_file_path,
-         file_path_str(FILE_PATH_PNG_EXTENSION),
-         sizeof(xmb->thumbnail_file_path));
+   strlcat(path, file_path_str(FILE_PATH_PNG_EXTENSION), len);
+
+   return true;
+}
+
+static void xmb_unset_thumbnail(xmb_handle_t *xmb)
+{
+   /* Textures handed out by the thumbnail cache stay owned by it. */
+   if (!xmb->thumbnail_cached)
+      video_driver_texture_unload(&xmb->thumbnail);
+
+   xmb->thumbnail        = 0;
+   xmb->thumbnail_cached = false;
+}
+
+static void xmb_set_cached_thumbnail(xmb_handle_t *xmb,
+      uintptr_t texture, unsigned width, unsigned height)
+{
+   if (!xmb->thumbnail_cached)
+      video_driver_texture_unload(&xmb->thumbnail);
+
+   xmb->thumbnail        = texture;
+   xmb->thumbnail_cached = true;
+   xmb->thumbnail_height = xmb->thumbnail_width
+      * (float)height / (float)width;
+}
+
+static void xmb_update_thumbnail_path(void *data, unsigned i)
+{
+   xmb_handle_t     *xmb    = (xmb_handle_t*)data;
+
+   if (!xmb)
+      return;
+
+   if (!xmb_get_thumbnail_path(xmb, i, xmb->thumbnail_content,
+            xmb->thumbnail_file_path, sizeof(xmb->thumbnail_file_path)))
+   {
+      xmb->thumbnail_file_path[0] = '\0';
+      xmb_unset_thumbnail(xmb);
+   }
 }
 
 static void xmb_update_savestate_thumbnail_path(void *data, unsigned i)
@@ -1067,15 +1355,116 @@ static void xmb_update_savestate_thumbnail_path(void *data, unsigned i)
 
 static void xmb_update_thumbnail_image(void *data)
 {
-   xmb_handle_t *xmb = (xmb_handle_t*)data;
+   settings_t *settings = config_get_ptr();
+   xmb_handle_t *xmb    = (xmb_handle_t*)data;
    if (!xmb)
       return;
 
+   menu_thumbnail_cache_set_limit(xmb->thumbnail_cache,
+         settings->uints.menu_thumbnail_cache_size * 1024 * 1024);
+
+   if (settings->uints.menu_thumbnail_cache_size && xmb->thumbnail_cache)
+   {
+      uintptr_t texture = 0;
+      unsigned width    = 0;
+      unsigned height   = 0;
+
+      if (menu_thumbnail_cache_get(xmb->thumbnail_cache,
+               xmb->thumbnail_file_path, &texture, &width, &height))
+         xmb_set_cached_thumbnail(xmb, texture, width, height);
+      else if (path_file_exists(xmb->thumbnail_file_path))
+         menu_thumbnail_cache_load(xmb->thumbnail_cache,
+               xmb->thumbnail_file_path);
+      else
+         xmb_unset_thumbnail(xmb);
+      return;
+   }
+
    if (path_file_exists(xmb->thumbnail_file_path))
       task_push_image_load(xmb->thumbnail_file_path,
             menu_display_handle_thumbnail_upload, NULL);
    else
-      xmb->thumbnail = 0;
+      xmb_unset_thumbnail(xmb);
+}
+
+static void xmb_thumbnail_cache_loaded(void *userdata, const char *path,
+      uintptr_t texture, unsigned width, unsigned height)
+{
+   xmb_handle_t *xmb = (xmb_handle_t*)userdata;
+
+   if (!xmb || !string_is_equal(path, xmb->thumbnail_file_path))
+      return;
+
+   /* Fetch it again so the cache pins it while on screen. */
+   if (menu_thumbnail_cache_get(xmb->thumbnail_cache, path,
+            &texture, &width, &height))
+      xmb_set_cached_thumbnail(xmb, texture, width, height);
+}
+
+/**
+ * xmb_prefetch_thumbnails:
+ * @xmb              : XMB handle.
+ * @selection        : Selected entry.
+ * @reset_content    : Whether thumbnails are looked up by path only.
+ *
+ * Starts loading the thumbnails of the entries following the
+ * selection in the scroll direction, and of the one before it.
+ * Loads for entries that went out of range are cancelled.
+ **/
+static void xmb_prefetch_thumbnails(xmb_handle_t *xmb,
+      size_t selection, bool reset_content)
+{
+   unsigned k;
+   char path[PATH_MAX_LENGTH];
+   settings_t *settings = config_get_ptr();
+   size_t end           = menu_entries_get_end();
+   int dir              = selection < xmb->thumbnail_prefetch_ptr ? -1 : 1;
+
+   if (!settings->uints.menu_thumbnail_cache_size || !xmb->thumbnail_cache)
+      return;
+
+   xmb->thumbnail_prefetch_ptr = selection;
+
+   menu_thumbnail_cache_prefetch_begin(xmb->thumbnail_cache);
+
+   if (!string_is_empty(xmb->thumbnail_file_path))
+      menu_thumbnail_cache_load(xmb->thumbnail_cache,
+            xmb->thumbnail_file_path);
+
+   for (k = 0; k <= XMB_THUMBNAIL_PREFETCH; k++)
+   {
+      menu_entry_t e;
+      /* The entry behind the selection goes last. */
+      size_t i = (k < XMB_THUMBNAIL_PREFETCH)
+         ? selection + dir * (int)(k + 1)
+         : selection - dir;
+
+      if (i >= end)
+         continue;
+
+      e.path[0]       = '\0';
+      e.label[0]      = '\0';
+      e.sublabel[0]   = '\0';
+      e.value[0]      = '\0';
+      e.rich_label[0] = '\0';
+      e.enum_idx      = MSG_UNKNOWN;
+      e.entry_idx     = 0;
+      e.idx           = 0;
+      e.type          = 0;
+      e.spacing       = 0;
+
+      if (!reset_content)
+         menu_entry_get(&e, 0, i, NULL, true);
+
+      path[0] = '\0';
+
+      if (     xmb_get_thumbnail_path(xmb, (unsigned)i, e.path,
+                  path, sizeof(path))
+            && path_file_exists(path))
+         menu_thumbnail_cache_load(xmb->thumbnail_cache, path);
+   }
+
+   menu_thumbnail_cache_prefetch_end(xmb->thumbnail_cache);
 }
 
 static void xmb_set_thumbnail_system(void *data, char*s, size_t len)
@@ -1125,6 +1514,8 @@ static void xmb_selection_pointer_changed(
    unsigned i, end, height;
    menu_animation_ctx_tag tag;
    size_t num                 = 0;
+   size_t first               = 0;
+   size_t last                = 0;
    int threshold              = 0;
    menu_list_t     *menu_list = NULL;
    file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
@@ -1159,7 +1550,13 @@ static void xmb_selection_pointer_changed(
    menu_animation_ctl(MENU_ANIMATION_CTL_KILL_BY_TAG, &tag);
    menu_entries_ctl(MENU_ENTRIES_CTL_SET_START, &num);
 
-   for (i = 0; i < end; i++)
+   /* Entries beyond the threshold are never drawn, and get moved
+    * into place the next time the selection brings them close,
+    * so huge lists don't have to be walked in full. */
+   xmb_calculate_visible_range(xmb, height, threshold,
+         end, selection, &first, &last);
+
+   for (i = (unsigned)first; end && i <= last; i++)
    {
       float iy, real_iy;
       float ia         = xmb->items.passive.alpha;
@@ -1190,6 +1587,7 @@ static void xmb_selection_pointer_changed(
                xmb_set_thumbnail_content(xmb, e.path, sizeof(e.path));
                xmb_update_thumbnail_path(xmb, i);
                xmb_update_thumbnail_image(xmb);
+               xmb_prefetch_thumbnails(xmb, selection, false);
             }
             else if (((e.type == FILE_TYPE_IMAGE || e.type == FILE_TYPE_IMAGEVIEWER ||
                         e.type == FILE_TYPE_RDB || e.type == FILE_TYPE_RDB_ENTRY)
@@ -1198,12 +1596,14 @@ static void xmb_selection_pointer_changed(
                xmb_set_thumbnail_content(xmb, e.path, sizeof(e.path));
                xmb_update_thumbnail_path(xmb, i);
                xmb_update_thumbnail_image(xmb);
+               xmb_prefetch_thumbnails(xmb, selection, false);
             }
             else if (filebrowser_get_type() != FILEBROWSER_NONE)
             {
                xmb_reset_thumbnail_content(xmb);
                xmb_update_thumbnail_path(xmb, i);
                xmb_update_thumbnail_image(xmb);
+               xmb_prefetch_thumbnails(xmb, selection, true);
             }
          }
          xmb_update_savestate_thumbnail_path(xmb, i);
@@ -1390,7 +1790,7 @@ static void xmb_list_open_new(xmb_handle_t *xmb,
 
 static xmb_node_t *xmb_node_allocate_userdata(xmb_handle_t *xmb, unsigned i)
 {
-   xmb_node_t *node = xmb_alloc_node();
+   xmb_node_t *node = xmb_alloc_node(NULL);
 
    if (!node)
    {
@@ -1925,6 +2325,10 @@ static void xmb_refresh_horizontal_list(xmb_handle_t *xmb)
    if (xmb->horizontal_list)
       xmb_init_horizontal_list(xmb);
 
+   /* Cached thumbnails may belong to entries that are gone. */
+   xmb_unset_thumbnail(xmb);
+   menu_thumbnail_cache_clear(xmb->thumbnail_cache);
+
    xmb_context_reset_horizontal_list(xmb);
 }
 
@@ -2019,6 +2423,8 @@ static void xmb_populate_entries(void *data,
    if (!xmb)
       return;
 
+   xmb_entry_cache_invalidate(xmb);
+
    if (menu_driver_ctl(RARCH_MENU_CTL_IS_PREVENT_POPULATE, NULL))
    {
       xmb_selection_pointer_changed(xmb, false);
@@ -2190,7 +2596,7 @@ static void xmb_draw_items(
       size_t current, size_t cat_selection_ptr, float *color,
       unsigned width, unsigned height)
 {
-   size_t i;
+   size_t i, first, last;
    math_matrix_4x4 mymat;
    menu_display_ctx_rotate_draw_t rotate_draw;
    xmb_node_t *core_node       = NULL;
@@ -2207,6 +2613,11 @@ static void xmb_draw_items(
 
    end = file_list_get_size(list);
 
+   /* Entries beyond the animation threshold sit at their resting
+    * position, so everything outside this range is off screen. */
+   xmb_calculate_visible_range(xmb, height, xmb->icon.size * 10,
+         end, current, &first, &last);
+
    rotate_draw.matrix       = &mymat;
    rotate_draw.rotation     = 0;
    rotate_draw.scale_x      = 1;
@@ -2221,16 +2632,20 @@ static void xmb_draw_items(
    if (list == xmb->selection_buf_old)
       i = 0;
 
+   if (i < first)
+      i = first;
+   if (end > last + 1)
+      end = last + 1;
+
    menu_display_blend_begin();
 
    for (; i < end; i++)
    {
       float icon_x, icon_y, label_offset;
       menu_animation_ctx_ticker_t ticker;
-      char ticker_str[PATH_MAX_LENGTH];
       char name[255];
       char value[255];
-      menu_entry_t entry;
+      xmb_entry_cache_t *entry          = NULL;
       const float half_size             = xmb->icon.size / 2.0f;
       uintptr_t texture_switch          = 0;
       xmb_node_t *   node               = (xmb_node_t*)
@@ -2241,18 +2656,7 @@ static void xmb_draw_items(
       if (!node)
          continue;
 
-      entry.path[0]       = '\0';
-      entry.label[0]      = '\0';
-      entry.sublabel[0]   = '\0';
-      entry.value[0]      = '\0';
-      entry.rich_label[0] = '\0';
-      entry.enum_idx      = MSG_UNKNOWN;
-      entry.entry_idx     = 0;
-      entry.idx           = 0;
-      entry.type          = 0;
-      entry.spacing       = 0;
-
-      ticker_str[0] = name[0] = value[0] = '\0';
+      name[0] = value[0] = '\0';
 
       icon_y = xmb->margins.screen.top + node->y + half_size;
 
@@ -2268,54 +2672,30 @@ static void xmb_draw_items(
       if (icon_x < -half_size || icon_x > width)
          continue;
 
-      menu_entry_get(&entry, 0, i, list, true);
+      entry = xmb_entry_cache_get(xmb, list, i);
 
-      if (entry.type == FILE_TYPE_CONTENTLIST_ENTRY)
-         fill_short_pathname_representation(entry.path, entry.path,
-               sizeof(entry.path));
-
-      if (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_DISABLED)) ||
-         (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_OFF))))
-      {
-         if (xmb->textures.list[XMB_TEXTURE_SWITCH_OFF])
-            texture_switch = xmb->textures.list[XMB_TEXTURE_SWITCH_OFF];
-         else
-            do_draw_text = true;
-      }
-      else if (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_ENABLED)) ||
-            (string_is_equal(entry.value, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_ON))))
-      {
-         if (xmb->textures.list[XMB_TEXTURE_SWITCH_ON])
-            texture_switch = xmb->textures.list[XMB_TEXTURE_SWITCH_ON];
-         else
-            do_draw_text = true;
-      }
-      else
+      switch (entry->value_type)
       {
-         enum msg_file_type type = msg_hash_to_file_type(msg_hash_calculate(entry.value));
-
-         switch (type)
-         {
-            case FILE_TYPE_IN_CARCHIVE:
-            case FILE_TYPE_COMPRESSED:
-            case FILE_TYPE_MORE:
-            case FILE_TYPE_CORE:
-            case FILE_TYPE_DIRECT_LOAD:
-            case FILE_TYPE_RDB:
-            case FILE_TYPE_CURSOR:
-            case FILE_TYPE_PLAIN:
-            case FILE_TYPE_DIRECTORY:
-            case FILE_TYPE_MUSIC:
-            case FILE_TYPE_IMAGE:
-            case FILE_TYPE_MOVIE:
-               break;
-            default:
+         case XMB_ENTRY_VALUE_OFF:
+            if (xmb->textures.list[XMB_TEXTURE_SWITCH_OFF])
+               texture_switch = xmb->textures.list[XMB_TEXTURE_SWITCH_OFF];
+            else
                do_draw_text = true;
-               break;
-         }
+            break;
+         case XMB_ENTRY_VALUE_ON:
+            if (xmb->textures.list[XMB_TEXTURE_SWITCH_ON])
+               texture_switch = xmb->textures.list[XMB_TEXTURE_SWITCH_ON];
+            else
+               do_draw_text = true;
+            break;
+         case XMB_ENTRY_VALUE_TEXT:
+            do_draw_text = true;
+            break;
+         default:
+            break;
       }
 
-      if (string_is_empty(entry.value))
+      if (string_is_empty(entry->value))
       {
          if (xmb->savestate_thumbnail ||
                (!string_is_equal
@@ -2328,19 +2708,17 @@ static void xmb_draw_items(
             ticker_limit = 70;
       }
 
-      menu_entry_get_rich_label((unsigned)i, ticker_str, sizeof(ticker_str));
-
       ticker.s        = name;
       ticker.len      = ticker_limit;
       ticker.idx      = frame_count / 20;
-      ticker.str      = ticker_str;
+      ticker.str      = entry->label;
       ticker.selected = (i == current);
 
       menu_animation_ticker(&ticker);
 
       label_offset = xmb->margins.label.top;
       if (i == current && width > 320 && height > 240
-         && !string_is_empty(entry.sublabel))
+         && !string_is_empty(entry->sublabel))
       {
          char entry_sublabel[255];
 
@@ -2348,7 +2726,7 @@ static void xmb_draw_items(
 
          label_offset      = - xmb->margins.label.top;
 
-         word_wrap(entry_sublabel, entry.sublabel, 50, true);
+         word_wrap(entry_sublabel, entry->sublabel, 50, true);
 
          xmb_draw_text(menu_disp_info, xmb, entry_sublabel,
                node->x + xmb->margins.screen.left +
@@ -2368,7 +2746,7 @@ static void xmb_draw_items(
       ticker.s        = value;
       ticker.len      = 35;
       ticker.idx      = frame_count / 20;
-      ticker.str      = entry.value;
+      ticker.str      = entry->value;
       ticker.selected = (i == current);
 
       menu_animation_ticker(&ticker);
@@ -2394,7 +2772,7 @@ static void xmb_draw_items(
          math_matrix_4x4 mymat;
          menu_display_ctx_rotate_draw_t rotate_draw;
          uintptr_t texture        = xmb_icon_get_id(xmb, core_node, node,
-                                    entry.enum_idx, entry.type, (i == current));
+                                    entry->enum_idx, entry->type, (i == current));
          float x                  = icon_x;
          float y                  = icon_y;
          float rotation           = 0;
@@ -2469,14 +2847,20 @@ static void xmb_render(void *data, bool is_idle)
    if (menu_animation_get_ideal_delta_time(&delta))
       menu_animation_update(delta.ideal);
 
-   if (pointer_enable || mouse_enable)
+   if ((pointer_enable || mouse_enable) && end)
    {
+      size_t first, last;
+      unsigned height;
       size_t selection  = menu_navigation_get_selection();
       int16_t pointer_y = menu_input_pointer_state(MENU_POINTER_Y_AXIS);
       int16_t mouse_y   = menu_input_mouse_state(MENU_MOUSE_Y_AXIS)
          + (xmb->cursor.size/2);
 
-      for (i = 0; i < end; i++)
+      video_driver_get_size(NULL, &height);
+      xmb_calculate_visible_range(xmb, height, 0, end, selection,
+            &first, &last);
+
+      for (i = first; i <= last; i++)
       {
          float item_y1     = xmb->margins.screen.top
             + xmb_item_y(xmb, (int)i, selection);
@@ -3357,6 +3741,9 @@ static void *xmb_init(void **userdata, bool video_is_threaded)
    if (xmb->horizontal_list)
       xmb_init_horizontal_list(xmb);
 
+   xmb->thumbnail_cache         = menu_thumbnail_cache_new(
+         xmb_thumbnail_cache_loaded, xmb);
+
    xmb_init_ribbon(xmb);
 
    return menu;
@@ -3399,8 +3786,13 @@ static void xmb_free(void *data)
 
       video_coord_array_free(&xmb->raster_block.carr);
       video_coord_array_free(&xmb->raster_block2.carr);
+
+      menu_thumbnail_cache_free(xmb->thumbnail_cache);
+      xmb->thumbnail_cache = NULL;
    }
 
+   xmb_free_node_pool();
+
    font_driver_bind_block(NULL, NULL);
 
 }
@@ -3437,7 +3829,7 @@ static bool xmb_load_image(void *userdata, void *data, enum menu_image_type type
             struct texture_image *img  = (struct texture_image*)data;
             xmb->thumbnail_height      = xmb->thumbnail_width
                * (float)img->height / (float)img->width;
-            video_driver_texture_unload(&xmb->thumbnail);
+            xmb_unset_thumbnail(xmb);
             video_driver_texture_load(data,
                   TEXTURE_FILTER_MIPMAP_LINEAR, &xmb->thumbnail);
          }
@@ -3716,10 +4108,11 @@ static void xmb_list_insert(void *userdata,
    if (!xmb || !list)
       return;
 
-   node = (xmb_node_t*)menu_entries_get_userdata_at_offset(list, i);
+   xmb_entry_cache_invalidate(xmb);
 
-   if (!node)
-      node = xmb_alloc_node();
+   xmb_free_list_node(list, i);
+
+   node = xmb_alloc_node(fullpath);
 
    if (!node)
    {
@@ -3729,9 +4122,6 @@ static void xmb_list_insert(void *userdata,
 
    current           = (int)selection;
 
-   if (!string_is_empty(fullpath))
-      strlcpy(node->fullpath, fullpath, sizeof(node->fullpath));
-
    node->alpha       = xmb->items.passive.alpha;
    node->zoom        = xmb->items.passive.zoom;
    node->label_alpha = node->alpha;
@@ -3757,15 +4147,7 @@ static void xmb_list_clear(file_list_t *list)
    menu_animation_ctl(MENU_ANIMATION_CTL_KILL_BY_TAG, &tag);
 
    for (i = 0; i < size; ++i)
-   {
-      xmb_node_t *node = (xmb_node_t*)
-         menu_entries_get_userdata_at_offset(list, i);
-
-      if (!node)
-         continue;
-
-      file_list_free_userdata(list, i);
-   }
+      xmb_free_list_node(list, i);
 }
 
 static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst)
@@ -3778,8 +4160,8 @@ static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst)
 
    for (i = 0; i < size; ++i)
    {
-      file_list_free_userdata(dst, i);
-      file_list_free_actiondata(dst, i); /* this one was allocated by us */
+      xmb_free_list_node(dst, i);
+      menu_entries_free_actiondata(dst, i); /* this one was allocated by us */
    }
 
    file_list_copy(src, dst);
@@ -3796,9 +4178,12 @@ static void xmb_list_deep_copy(const file_list_t *src, file_list_t *dst)
 
       if (src_adata)
       {
-         void *data = malloc(sizeof(menu_file_list_cbs_t));
-         memcpy(data, src_adata, sizeof(menu_file_list_cbs_t));
-         file_list_set_actiondata(dst, i, data);
+         menu_file_list_cbs_t *data = menu_entries_cbs_new();
+         if (data)
+         {
+            memcpy(data, src_adata, sizeof(menu_file_list_cbs_t));
+            file_list_set_actiondata(dst, i, data);
+         }
       }
    }
 }
@@ -3815,6 +4200,8 @@ static void xmb_list_cache(void *data, enum menu_list_type type, unsigned action
    if (!xmb)
       return;
 
+   xmb_entry_cache_invalidate(xmb);
+
    /* Check whether to enable the horizontal animation. */
    if (settings->bools.menu_horizontal_animation)
    {
@@ -3858,69 +4245,65 @@ static void xmb_list_cache(void *data, enum menu_list_type type, unsigned action
 
          stack_size = menu_stack->size;
 
-         if (menu_stack->list[stack_size - 1].label)
-            free(menu_stack->list[stack_size - 1].label);
-         menu_stack->list[stack_size - 1].label = NULL;
-
          switch (xmb_get_system_tab(xmb, (unsigned)xmb->categories.selection_ptr))
          {
             case XMB_SYSTEM_TAB_MAIN:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_MAIN_MENU));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_MAIN_MENU));
                menu_stack->list[stack_size - 1].type =
                   MENU_SETTINGS;
                break;
             case XMB_SYSTEM_TAB_SETTINGS:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_SETTINGS_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_SETTINGS_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_SETTINGS_TAB;
                break;
 #ifdef HAVE_IMAGEVIEWER
             case XMB_SYSTEM_TAB_IMAGES:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_IMAGES_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_IMAGES_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_IMAGES_TAB;
                break;
 #endif
             case XMB_SYSTEM_TAB_MUSIC:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_MUSIC_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_MUSIC_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_MUSIC_TAB;
                break;
 #ifdef HAVE_FFMPEG
             case XMB_SYSTEM_TAB_VIDEO:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_VIDEO_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_VIDEO_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_VIDEO_TAB;
                break;
 #endif
             case XMB_SYSTEM_TAB_HISTORY:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_HISTORY_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_HISTORY_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_HISTORY_TAB;
                break;
 #ifdef HAVE_NETWORKING
             case XMB_SYSTEM_TAB_NETPLAY:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_NETPLAY_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_NETPLAY_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_NETPLAY_TAB;
                break;
 #endif
             case XMB_SYSTEM_TAB_ADD:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_ADD_TAB));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_ADD_TAB));
                menu_stack->list[stack_size - 1].type =
                   MENU_ADD_TAB;
                break;
             default:
-               menu_stack->list[stack_size - 1].label =
-                  strdup(msg_hash_to_str(MENU_ENUM_LABEL_HORIZONTAL_MENU));
+               file_list_set_label_at_offset(menu_stack, stack_size - 1,
+                  msg_hash_to_str(MENU_ENUM_LABEL_HORIZONTAL_MENU));
                menu_stack->list[stack_size - 1].type =
                   MENU_SETTING_HORIZONTAL_MENU;
                break;
@@ -3943,7 +4326,8 @@ static void xmb_context_destroy(void *data)
    for (i = 0; i < XMB_TEXTURE_LAST; i++)
       video_driver_texture_unload(&xmb->textures.list[i]);
 
-   video_driver_texture_unload(&xmb->thumbnail);
+   xmb_unset_thumbnail(xmb);
+   menu_thumbnail_cache_clear(xmb->thumbnail_cache);
    video_driver_texture_unload(&xmb->savestate_thumbnail);
 
    xmb_context_destroy_horizontal_list(xmb);
@@ -4167,6 +4551,10 @@ static int xmb_pointer_tap(void *userdata,
       menu_entry_t *entry, unsigned action)
 {
    unsigned header_height = menu_display_get_header_height();
+   xmb_handle_t *xmb      = (xmb_handle_t*)userdata;
+
+   if (xmb)
+      xmb_entry_cache_invalidate(xmb);
 
    if (y < header_height)
    {
@@ -4186,10 +4574,23 @@ static int xmb_pointer_tap(void *userdata,
    return 0;
 }
 
+static int xmb_iterate(void *data, void *userdata, enum menu_action action)
+{
+   xmb_handle_t *xmb = (xmb_handle_t*)userdata;
+
+   /* Same conditions under which RGUI redraws its framebuffer. */
+   if (xmb && (action != MENU_ACTION_NOOP
+            || menu_entries_ctl(MENU_ENTRIES_CTL_NEEDS_REFRESH, NULL)
+            || menu_display_get_update_pending()))
+      xmb_entry_cache_invalidate(xmb);
+
+   return generic_menu_iterate(data, userdata, action);
+}
+
 menu_ctx_driver_t menu_ctx_xmb = {
    NULL,
    xmb_messagebox,
-   generic_menu_iterate,
+   xmb_iterate,
    xmb_render,
    xmb_frame,
    xmb_init,
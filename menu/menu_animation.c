@@ -28,6 +28,10 @@
 
 #define IDEAL_DELTA_TIME (1.0 / 60.0 * 1000000.0)
 
+/* Upper bound on simultaneously running tweens. Menu drivers only
+ * animate what is (nearly) on screen, which stays well below this. */
+#define MENU_ANIMATION_MAX_TWEENS 1024
+
 struct tween
 {
    bool        alive;
@@ -43,10 +47,9 @@ struct tween
 
 struct menu_animation
 {
-   struct tween *list;
+   struct tween list[MENU_ANIMATION_MAX_TWEENS];
    bool need_defrag;
 
-   size_t capacity;
    size_t size;
    size_t first_dead;
 };
@@ -312,6 +315,33 @@ static void menu_animation_ticker_generic(uint64_t idx,
    *width = max_width;
 }
 
+static int menu_animation_defrag_cmp(const void *a, const void *b)
+{
+   const struct tween *ta = (const struct tween *)a;
+   const struct tween *tb = (const struct tween *)b;
+
+   return tb->alive - ta->alive;
+}
+
+/* defragments and shrinks the tween list when possible */
+static void menu_animation_defrag(void)
+{
+   size_t i;
+
+   qsort(anim.list, anim.size, sizeof(anim.list[0]), menu_animation_defrag_cmp);
+
+   for (i = anim.size-1; i > 0; i--)
+   {
+      if (anim.list[i].alive)
+         break;
+
+      anim.size--;
+   }
+
+   anim.first_dead = anim.size;
+   anim.need_defrag = false;
+}
+
 bool menu_animation_push(menu_animation_ctx_entry_t *entry)
 {
    struct tween t;
@@ -444,15 +474,20 @@ bool menu_animation_push(menu_animation_ctx_entry_t *entry)
    if (!t.easing || t.duration == 0 || t.initial_value == t.target_value)
       return false;
 
+   if (anim.size >= MENU_ANIMATION_MAX_TWEENS && anim.need_defrag)
+      menu_animation_defrag();
+
    if (anim.first_dead < anim.size && !anim.list[anim.first_dead].alive)
       target = &anim.list[anim.first_dead++];
    else
    {
-      if (anim.size >= anim.capacity)
+      /* Out of tweens, skip straight to the end instead. */
+      if (anim.size >= MENU_ANIMATION_MAX_TWEENS)
       {
-         anim.capacity++;
-         anim.list = (struct tween*)realloc(anim.list,
-               anim.capacity * sizeof(struct tween));
+         *t.subject = t.target_value;
+         if (t.cb)
+            t.cb();
+         return false;
       }
 
       target = &anim.list[anim.size++];
@@ -465,33 +500,6 @@ bool menu_animation_push(menu_animation_ctx_entry_t *entry)
    return true;
 }
 
-static int menu_animation_defrag_cmp(const void *a, const void *b)
-{
-   const struct tween *ta = (const struct tween *)a;
-   const struct tween *tb = (const struct tween *)b;
-
-   return tb->alive - ta->alive;
-}
-
-/* defragments and shrinks the tween list when possible */
-static void menu_animation_defrag()
-{
-   size_t i;
-
-   qsort(anim.list, anim.size, sizeof(anim.list[0]), menu_animation_defrag_cmp);
-
-   for (i = anim.size-1; i > 0; i--)
-   {
-      if (anim.list[i].alive)
-         break;
-
-      anim.size--;
-   }
-
-   anim.first_dead = anim.size;
-   anim.need_defrag = false;
-}
-
 bool menu_animation_update(float delta_time)
 {
    unsigned i;
@@ -630,8 +638,6 @@ bool menu_animation_ctl(enum menu_animation_ctl_state state, void *data)
                   anim.list[i].subject = NULL;
             }
 
-            free(anim.list);
-
             memset(&anim, 0, sizeof(menu_animation_t));
          }
          cur_time                  = 0;
@@ -1999,8 +1999,8 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
 
             if (list->list)
             {
-               file_list_free_userdata  (list->list, list->idx);
-               file_list_free_actiondata(list->list, list->idx);
+               file_list_free_userdata     (list->list, list->idx);
+               menu_entries_free_actiondata(list->list, list->idx);
             }
          }
          break;
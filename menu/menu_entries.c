@@ -36,6 +36,50 @@ static size_t menu_entries_begin                   = 0;
 static rarch_setting_t *menu_entries_list_settings = NULL;
 static menu_list_t *menu_entries_list              = NULL;
 
+/* Callback tables of cleared entries, kept around to be handed
+ * to the next list instead of going back to the heap. Each one
+ * is still its own allocation and may be free()d as usual. */
+#define MENU_ENTRIES_CBS_POOL_SIZE 1024
+
+static menu_file_list_cbs_t *menu_entries_cbs_pool[MENU_ENTRIES_CBS_POOL_SIZE];
+static unsigned menu_entries_cbs_pool_count        = 0;
+
+menu_file_list_cbs_t *menu_entries_cbs_new(void)
+{
+   menu_file_list_cbs_t *cbs = NULL;
+
+   if (!menu_entries_cbs_pool_count)
+      return (menu_file_list_cbs_t*)calloc(1, sizeof(*cbs));
+
+   cbs = menu_entries_cbs_pool[--menu_entries_cbs_pool_count];
+   memset(cbs, 0, sizeof(*cbs));
+
+   return cbs;
+}
+
+void menu_entries_free_actiondata(const file_list_t *list, size_t idx)
+{
+   menu_file_list_cbs_t *cbs = menu_entries_get_actiondata_at_offset(
+         list, idx);
+
+   if (!cbs)
+      return;
+
+   if (menu_entries_cbs_pool_count < MENU_ENTRIES_CBS_POOL_SIZE)
+   {
+      menu_entries_cbs_pool[menu_entries_cbs_pool_count++] = cbs;
+      list->list[idx].actiondata = NULL;
+   }
+   else
+      file_list_free_actiondata(list, idx);
+}
+
+static void menu_entries_cbs_pool_free(void)
+{
+   while (menu_entries_cbs_pool_count)
+      free(menu_entries_cbs_pool[--menu_entries_cbs_pool_count]);
+}
+
 void menu_entries_get_at_offset(const file_list_t *list, size_t idx,
       const char **path, const char **label, unsigned *file_type,
       size_t *entry_idx, const char **alt)
@@ -77,7 +121,7 @@ static bool menu_entries_clear(file_list_t *list)
    menu_driver_list_clear(list);
 
    for (i = 0; i < list->size; i++)
-      file_list_free_actiondata(list, i);
+      menu_entries_free_actiondata(list, i);
 
    if (list)
       file_list_clear(list);
@@ -360,147 +404,161 @@ error:
    return false;
 }
 
-void menu_entries_append(file_list_t *list, const char *path, const char *label,
-      unsigned type, size_t directory_ptr, size_t entry_idx)
+/* Binding an entry's callbacks means running it past every
+ * menu_cbs_init_bind_* table, which dominates the cost of filling
+ * a list. The result only depends on the entry's label, type,
+ * enum and setting plus the menu it is being added to, so when a
+ * list is filled with runs of alike entries (e.g. a directory
+ * with thousands of files) the previous entry's bindings are
+ * reused as they are. */
+static struct
 {
-   menu_ctx_list_t list_info;
+   const file_list_t *list;
    size_t idx;
-   const char *menu_path           = NULL;
-   menu_file_list_cbs_t *cbs       = NULL;
-   if (!list || !label)
-      return;
-
-   file_list_append(list, path, label, type, directory_ptr, entry_idx);
-
-   menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
-
-   idx                = list->size - 1;
-
-   list_info.list     = list;
-   list_info.path     = path;
-   list_info.fullpath = NULL;
-
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
-
-   list_info.label    = label;
-   list_info.idx      = idx;
-
-   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
-
-   if (list_info.fullpath)
-      free(list_info.fullpath);
-
-   file_list_free_actiondata(list, idx);
-   cbs = (menu_file_list_cbs_t*)
-      calloc(1, sizeof(menu_file_list_cbs_t));
+   bool by_label;
+   unsigned type;
+   enum msg_hash_enums enum_idx;
+   enum msg_hash_enums menu_enum_idx;
+   char *label;
+   char *menu_label;
+   menu_file_list_cbs_t cbs;
+} menu_entries_bind_cache;
+
+static void menu_entries_bind_cache_clear(void)
+{
+   if (menu_entries_bind_cache.label)
+      free(menu_entries_bind_cache.label);
+   if (menu_entries_bind_cache.menu_label)
+      free(menu_entries_bind_cache.menu_label);
+   memset(&menu_entries_bind_cache, 0, sizeof(menu_entries_bind_cache));
+}
 
-   if (!cbs)
+static void menu_entries_bind(file_list_t *list, size_t idx,
+      menu_file_list_cbs_t *cbs,
+      const char *path, const char *label,
+      enum msg_hash_enums enum_idx, unsigned type, bool by_label)
+{
+   const char *menu_label             = NULL;
+   enum msg_hash_enums menu_enum_idx  = MSG_UNKNOWN;
+
+   menu_entries_get_last_stack(NULL, &menu_label, NULL,
+         &menu_enum_idx, NULL);
+
+   /* Only reuse bindings while the same list is being filled
+    * in order, i.e. within a single displaylist build. */
+   if (     menu_entries_bind_cache.list     == list
+         && menu_entries_bind_cache.idx + 1  == idx
+         && menu_entries_bind_cache.by_label == by_label
+         && menu_entries_bind_cache.type     == type
+         && menu_entries_bind_cache.enum_idx == enum_idx
+         && menu_entries_bind_cache.menu_enum_idx == menu_enum_idx
+         && menu_entries_bind_cache.label
+         && menu_entries_bind_cache.menu_label
+         && menu_label
+         && string_is_equal(menu_entries_bind_cache.label, label)
+         && string_is_equal(menu_entries_bind_cache.menu_label, menu_label))
+   {
+      memcpy(cbs, &menu_entries_bind_cache.cbs, sizeof(*cbs));
+      menu_entries_bind_cache.idx = idx;
       return;
+   }
 
-   file_list_set_actiondata(list, idx, cbs);
+   cbs->enum_idx = enum_idx;
 
-   cbs->enum_idx = MSG_UNKNOWN;
-   cbs->setting  = menu_setting_find(label);
+   if (by_label)
+      cbs->setting = menu_setting_find(label);
+   else if (enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
+         && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY)
+      cbs->setting = menu_setting_find_enum(enum_idx);
 
    menu_cbs_init(list, cbs, path, label, type, idx);
+
+   menu_entries_bind_cache_clear();
+
+   menu_entries_bind_cache.list          = list;
+   menu_entries_bind_cache.idx           = idx;
+   menu_entries_bind_cache.by_label      = by_label;
+   menu_entries_bind_cache.type          = type;
+   menu_entries_bind_cache.enum_idx      = enum_idx;
+   menu_entries_bind_cache.menu_enum_idx = menu_enum_idx;
+   menu_entries_bind_cache.label         = strdup(label);
+   menu_entries_bind_cache.menu_label    = menu_label
+      ? strdup(menu_label) : NULL;
+   memcpy(&menu_entries_bind_cache.cbs, cbs, sizeof(*cbs));
 }
 
-void menu_entries_append_enum(file_list_t *list, const char *path,
-      const char *label,
-      enum msg_hash_enums enum_idx,
-      unsigned type, size_t directory_ptr, size_t entry_idx)
+static void menu_entries_insert(file_list_t *list, size_t idx,
+      const char *path, const char *label,
+      enum msg_hash_enums enum_idx, unsigned type, bool by_label)
 {
    menu_ctx_list_t list_info;
-   size_t idx;
    const char *menu_path           = NULL;
    menu_file_list_cbs_t *cbs       = NULL;
-   if (!list || !label)
-      return;
-
-   file_list_append(list, path, label, type, directory_ptr, entry_idx);
 
    menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
 
-   idx                   = list->size - 1;
-
-   list_info.fullpath    = NULL;
-
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
    list_info.list        = list;
    list_info.path        = path;
+   list_info.fullpath    = NULL;
    list_info.label       = label;
    list_info.idx         = idx;
 
-   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
+   if (!string_is_empty(menu_path))
+      list_info.fullpath = menu_path;
 
-   if (list_info.fullpath)
-      free(list_info.fullpath);
+   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
 
-   file_list_free_actiondata(list, idx);
-   cbs = (menu_file_list_cbs_t*)
-      calloc(1, sizeof(menu_file_list_cbs_t));
+   menu_entries_free_actiondata(list, idx);
+   cbs = menu_entries_cbs_new();
 
    if (!cbs)
       return;
 
    file_list_set_actiondata(list, idx, cbs);
 
-   cbs->enum_idx = enum_idx;
-
-   if (enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
-       && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY) {
-      cbs->setting  = menu_setting_find_enum(enum_idx);
-   }
-
-   menu_cbs_init(list, cbs, path, label, type, idx);
+   menu_entries_bind(list, idx, cbs, path, label,
+         enum_idx, type, by_label);
 }
 
-void menu_entries_prepend(file_list_t *list, const char *path, const char *label,
-      enum msg_hash_enums enum_idx,
+void menu_entries_append(file_list_t *list, const char *path, const char *label,
       unsigned type, size_t directory_ptr, size_t entry_idx)
 {
-   menu_ctx_list_t list_info;
-   size_t idx;
-   const char *menu_path           = NULL;
-   menu_file_list_cbs_t *cbs       = NULL;
    if (!list || !label)
       return;
 
-   file_list_prepend(list, path, label, type, directory_ptr, entry_idx);
-
-   menu_entries_get_last_stack(&menu_path, NULL, NULL, NULL, NULL);
-
-   idx              = 0;
-
-   list_info.fullpath    = NULL;
+   if (!file_list_append(list, path, label, type, directory_ptr, entry_idx))
+      return;
 
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
-   list_info.list        = list;
-   list_info.path        = path;
-   list_info.label       = label;
-   list_info.idx         = idx;
+   menu_entries_insert(list, list->size - 1, path, label,
+         MSG_UNKNOWN, type, true);
+}
 
-   menu_driver_ctl(RARCH_MENU_CTL_LIST_INSERT, &list_info);
+void menu_entries_append_enum(file_list_t *list, const char *path,
+      const char *label,
+      enum msg_hash_enums enum_idx,
+      unsigned type, size_t directory_ptr, size_t entry_idx)
+{
+   if (!list || !label)
+      return;
 
-   if (list_info.fullpath)
-      free(list_info.fullpath);
+   if (!file_list_append(list, path, label, type, directory_ptr, entry_idx))
+      return;
 
-   file_list_free_actiondata(list, idx);
-   cbs = (menu_file_list_cbs_t*)
-      calloc(1, sizeof(menu_file_list_cbs_t));
+   menu_entries_insert(list, list->size - 1, path, label,
+         enum_idx, type, false);
+}
 
-   if (!cbs)
+void menu_entries_prepend(file_list_t *list, const char *path, const char *label,
+      enum msg_hash_enums enum_idx,
+      unsigned type, size_t directory_ptr, size_t entry_idx)
+{
+   if (!list || !label)
       return;
 
-   file_list_set_actiondata(list, idx, cbs);
-
-   cbs->enum_idx = enum_idx;
-   cbs->setting  = menu_setting_find_enum(cbs->enum_idx);
+   if (!file_list_prepend(list, path, label, type, directory_ptr, entry_idx))
+      return;
 
-   menu_cbs_init(list, cbs, path, label, type, idx);
+   menu_entries_insert(list, 0, path, label, enum_idx, type, false);
 }
 
 menu_file_list_cbs_t *menu_entries_get_last_stack_actiondata(void)
@@ -575,6 +633,8 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
       case MENU_ENTRIES_CTL_DEINIT:
          menu_entries_ctl(MENU_ENTRIES_CTL_SETTINGS_DEINIT, NULL);
          menu_entries_ctl(MENU_ENTRIES_CTL_LIST_DEINIT, NULL);
+         menu_entries_bind_cache_clear();
+         menu_entries_cbs_pool_free();
 
          menu_entries_need_refresh        = false;
          menu_entries_nonblocking_refresh = false;
@@ -614,6 +674,7 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
       case MENU_ENTRIES_CTL_SETTINGS_DEINIT:
          menu_setting_free(menu_entries_list_settings);
          menu_entries_list_settings = NULL;
+         menu_entries_bind_cache_clear();
          break;
       case MENU_ENTRIES_CTL_SETTINGS_INIT:
          menu_setting_ctl(MENU_SETTING_CTL_NEW, &menu_entries_list_settings);
@@ -172,6 +172,10 @@ void *menu_entries_get_userdata_at_offset(
 menu_file_list_cbs_t *menu_entries_get_actiondata_at_offset(
       const file_list_t *list, size_t idx);
 
+menu_file_list_cbs_t *menu_entries_cbs_new(void);
+
+void menu_entries_free_actiondata(const file_list_t *list, size_t idx);
+
 void menu_entries_get_last(const file_list_t *list,
       const char **path, const char **label,
       unsigned *file_type, size_t *entry_idx);
@@ -3037,7 +3037,7 @@ static bool setting_append_list(
       case SETTINGS_LIST_SAVING:
          {
             unsigned i;
-            struct bool_entry bool_entries[11];
+            struct bool_entry bool_entries[12];
 
             START_GROUP(list, list_info, &group_info, msg_hash_to_str(MENU_ENUM_LABEL_VALUE_SAVING_SETTINGS), parent_group);
             parent_group = msg_hash_to_str(MENU_ENUM_LABEL_SAVING_SETTINGS);
@@ -3111,6 +3111,12 @@ static bool setting_append_list(
             bool_entries[10].default_value  = default_screenshots_in_content_dir;
             bool_entries[10].flags          = SD_FLAG_ADVANCED;
 
+            bool_entries[11].target         = &settings->bools.savestate_file_compression;
+            bool_entries[11].name_enum_idx  = MENU_ENUM_LABEL_SAVESTATE_FILE_COMPRESSION;
+            bool_entries[11].SHORT_enum_idx = MENU_ENUM_LABEL_VALUE_SAVESTATE_FILE_COMPRESSION;
+            bool_entries[11].default_value  = savestate_file_compression;
+            bool_entries[11].flags          = SD_FLAG_ADVANCED;
+
             for (i = 0; i < ARRAY_SIZE(bool_entries); i++)
             {
                CONFIG_BOOL(
@@ -3775,6 +3781,54 @@ static bool setting_append_list(
             menu_settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
             settings_data_list_current_add_flags(list, list_info, SD_FLAG_LAKKA_ADVANCED);
 
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.video_frame_delay_auto,
+                  MENU_ENUM_LABEL_VIDEO_FRAME_DELAY_AUTO,
+                  MENU_ENUM_LABEL_VALUE_VIDEO_FRAME_DELAY_AUTO,
+                  frame_delay_auto,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_NONE
+                  );
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_LAKKA_ADVANCED);
+
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.run_ahead_enabled,
+                  MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,
+                  MENU_ENUM_LABEL_VALUE_RUN_AHEAD_ENABLED,
+                  run_ahead_enabled,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_NONE
+                  );
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_LAKKA_ADVANCED);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.run_ahead_frames,
+                  MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,
+                  MENU_ENUM_LABEL_VALUE_RUN_AHEAD_FRAMES,
+                  run_ahead_frames,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            menu_settings_list_current_add_range(list, list_info, 1, 6, 1, true, true);
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_LAKKA_ADVANCED);
+
 #if !defined(RARCH_MOBILE)
             CONFIG_BOOL(
                   list, list_info,
@@ -5550,6 +5604,20 @@ static bool setting_append_list(
                   general_write_handler,
                   general_read_handler);
             menu_settings_list_current_add_range(list, list_info, 0, 3, 1, true, true);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.menu_thumbnail_cache_size,
+                  MENU_ENUM_LABEL_THUMBNAIL_CACHE_SIZE,
+                  MENU_ENUM_LABEL_VALUE_THUMBNAIL_CACHE_SIZE,
+                  menu_thumbnail_cache_size,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            menu_settings_list_current_add_range(list, list_info, 0, 1024, 8, true, true);
+            settings_data_list_current_add_flags(list, list_info, SD_FLAG_ADVANCED);
          }
 
          CONFIG_BOOL(
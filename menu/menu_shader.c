@@ -39,6 +39,12 @@ static char default_cgp[PATH_MAX_LENGTH];
 static char default_slangp[PATH_MAX_LENGTH];
 static struct video_shader *menu_driver_shader = NULL;
 
+/* Shader settings from before the first preset the video driver
+ * is still building, put back if it reports that it failed. */
+static char menu_shader_revert_path[PATH_MAX_LENGTH];
+static bool menu_shader_revert_enable = false;
+static bool menu_shader_revert_valid  = false;
+
 struct video_shader *menu_shader_get(void)
 {
    return menu_driver_shader;
@@ -255,14 +261,29 @@ void menu_shader_manager_set_preset(void *data,
    struct video_shader *shader   = (struct video_shader*)data;
    config_file_t *conf           = NULL;
    bool refresh                  = false;
+   char failed[PATH_MAX_LENGTH];
    settings_t *settings          = config_get_ptr();
 
+   /* Drop failures of shaders set before this one. */
+   video_driver_get_shader_failed(failed, sizeof(failed));
+
    if (!video_driver_set_shader((enum rarch_shader_type)type, preset_path))
    {
       configuration_set_bool(settings, settings->bools.video_shader_enable, false);
       return;
    }
 
+   /* The driver may still be building the preset. */
+   if (!video_driver_is_shader_pending())
+      menu_shader_revert_valid = false;
+   else if (!menu_shader_revert_valid)
+   {
+      strlcpy(menu_shader_revert_path, settings->paths.path_shader,
+            sizeof(menu_shader_revert_path));
+      menu_shader_revert_enable = settings->bools.video_shader_enable;
+      menu_shader_revert_valid  = true;
+   }
+
    /* Makes sure that we use Menu Preset shader on driver reinit.
     * Only do this when the cgp actually works to avoid potential errors. */
    strlcpy(settings->paths.path_shader,
@@ -295,6 +316,52 @@ void menu_shader_manager_set_preset(void *data,
 #endif
 }
 
+/**
+ * menu_shader_manager_poll:
+ *
+ * Puts the shader settings back when the video driver reports
+ * that a preset set with menu_shader_manager_set_preset() failed
+ * to build after the fact, so a broken preset isn't saved as
+ * the active one. Runs on the main thread, once per frame.
+ **/
+void menu_shader_manager_poll(void)
+{
+#ifdef HAVE_SHADER_MANAGER
+   char failed[PATH_MAX_LENGTH];
+   bool pending         = false;
+   settings_t *settings = NULL;
+
+   if (!menu_shader_revert_valid)
+      return;
+
+   /* A failure clears pending, so check in this order. */
+   pending = video_driver_is_shader_pending();
+
+   if (!video_driver_get_shader_failed(failed, sizeof(failed)))
+   {
+      if (!pending)
+         menu_shader_revert_valid = false;
+      return;
+   }
+
+   settings = config_get_ptr();
+
+   if (menu_shader_revert_valid
+         && string_is_equal(settings->paths.path_shader, failed))
+   {
+      RARCH_LOG("Reverting to previous shader: \"%s\".\n",
+            menu_shader_revert_path);
+      strlcpy(settings->paths.path_shader, menu_shader_revert_path,
+            sizeof(settings->paths.path_shader));
+      configuration_set_bool(settings,
+            settings->bools.video_shader_enable,
+            menu_shader_revert_enable);
+   }
+
+   menu_shader_revert_valid = false;
+#endif
+}
+
 /**
  * menu_shader_manager_save_preset:
  * @basename                 : basename of preset
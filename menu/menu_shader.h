@@ -51,6 +51,8 @@ bool menu_shader_manager_init(void);
 void menu_shader_manager_set_preset(
       void *data, unsigned type, const char *preset_path);
 
+void menu_shader_manager_poll(void);
+
 /**
  * menu_shader_manager_save_preset:
  * @basename                 : basename of preset
@@ -0,0 +1,387 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <formats/image.h>
+#include <queues/task_queue.h>
+#include <string/stdstring.h>
+
+#include "menu_thumbnail_cache.h"
+
+#include "../gfx/video_driver.h"
+#include "../msg_hash.h"
+#include "../tasks/tasks_internal.h"
+
+/* Thumbnails are decoded on the task queue and uploaded from its
+ * callback on the main thread. Every entry, loaded or not, lives
+ * on a single list; the cache only ever holds a handful of them,
+ * so lookups simply walk it.
+ *
+ * An entry whose load is still in flight when it gets dropped is
+ * detached from the cache instead of freed, since the task still
+ * refers to it. Its callback then frees it. */
+
+struct menu_thumbnail_entry
+{
+   char *path;
+   uint32_t hash;
+   uintptr_t texture;
+   unsigned width;
+   unsigned height;
+   size_t size;
+   unsigned last_used;
+   unsigned round;
+   bool pending;
+   menu_thumbnail_cache_t *cache;
+   struct menu_thumbnail_entry *next;
+};
+
+struct menu_thumbnail_cache
+{
+   struct menu_thumbnail_entry *entries;
+   /* Last entry handed out by menu_thumbnail_cache_get(),
+    * which is on screen and must not be evicted. */
+   struct menu_thumbnail_entry *pinned;
+   menu_thumbnail_cache_cb_t cb;
+   void *userdata;
+   size_t size;
+   size_t max_size;
+   unsigned usage_counter;
+   unsigned round;
+};
+
+struct menu_thumbnail_task_finder
+{
+   struct menu_thumbnail_entry *entry;
+   retro_task_t *task;
+};
+
+static bool menu_thumbnail_cache_task_finder(retro_task_t *task,
+      void *user_data)
+{
+   struct menu_thumbnail_task_finder *finder =
+      (struct menu_thumbnail_task_finder*)user_data;
+
+   if (!task || task->user_data != finder->entry)
+      return false;
+
+   finder->task = task;
+   return true;
+}
+
+static struct menu_thumbnail_entry *menu_thumbnail_cache_find(
+      menu_thumbnail_cache_t *cache, const char *path)
+{
+   struct menu_thumbnail_entry *entry = NULL;
+   uint32_t hash                      = msg_hash_calculate(path);
+
+   for (entry = cache->entries; entry; entry = entry->next)
+      if (entry->hash == hash && string_is_equal(entry->path, path))
+         return entry;
+
+   return NULL;
+}
+
+static void menu_thumbnail_cache_unlink(menu_thumbnail_cache_t *cache,
+      struct menu_thumbnail_entry *entry)
+{
+   struct menu_thumbnail_entry **link = &cache->entries;
+
+   while (*link && *link != entry)
+      link = &(*link)->next;
+
+   if (*link)
+      *link = entry->next;
+
+   entry->next = NULL;
+
+   if (cache->pinned == entry)
+      cache->pinned = NULL;
+}
+
+static void menu_thumbnail_cache_entry_free(
+      struct menu_thumbnail_entry *entry)
+{
+   if (entry->texture)
+      video_driver_texture_unload(&entry->texture);
+   free(entry->path);
+   free(entry);
+}
+
+static void menu_thumbnail_cache_drop(menu_thumbnail_cache_t *cache,
+      struct menu_thumbnail_entry *entry)
+{
+   menu_thumbnail_cache_unlink(cache, entry);
+
+   if (entry->pending)
+   {
+      task_finder_data_t find_data;
+      struct menu_thumbnail_task_finder finder;
+
+      finder.entry       = entry;
+      finder.task        = NULL;
+      find_data.func     = menu_thumbnail_cache_task_finder;
+      find_data.userdata = &finder;
+
+      /* The task may already be done and only waiting for its
+       * callback, in which case there is nothing to cancel. */
+      if (task_queue_find(&find_data) && finder.task)
+         task_queue_cancel_task(finder.task);
+
+      entry->cache = NULL;
+      return;
+   }
+
+   cache->size -= entry->size;
+   menu_thumbnail_cache_entry_free(entry);
+}
+
+static void menu_thumbnail_cache_evict(menu_thumbnail_cache_t *cache,
+      struct menu_thumbnail_entry *keep)
+{
+   while (cache->size > cache->max_size)
+   {
+      struct menu_thumbnail_entry *entry  = NULL;
+      struct menu_thumbnail_entry *oldest = NULL;
+
+      for (entry = cache->entries; entry; entry = entry->next)
+      {
+         if (entry->pending || entry == keep || entry == cache->pinned)
+            continue;
+         if (!oldest || entry->last_used < oldest->last_used)
+            oldest = entry;
+      }
+
+      if (!oldest)
+         break;
+
+      menu_thumbnail_cache_drop(cache, oldest);
+   }
+}
+
+static void menu_thumbnail_cache_handle_upload(void *task_data,
+      void *user_data, const char *err)
+{
+   struct texture_image *img          = (struct texture_image*)task_data;
+   struct menu_thumbnail_entry *entry =
+      (struct menu_thumbnail_entry*)user_data;
+   menu_thumbnail_cache_t *cache      = entry ? entry->cache : NULL;
+
+   if (!cache || !img || !img->pixels)
+   {
+      if (cache)
+         menu_thumbnail_cache_unlink(cache, entry);
+      if (entry)
+         menu_thumbnail_cache_entry_free(entry);
+      goto end;
+   }
+
+   video_driver_texture_load(img,
+         TEXTURE_FILTER_MIPMAP_LINEAR, &entry->texture);
+
+   entry->pending   = false;
+   entry->width     = img->width;
+   entry->height    = img->height;
+   entry->size      = img->width * img->height * sizeof(uint32_t);
+   entry->last_used = cache->usage_counter++;
+   cache->size     += entry->size;
+
+   menu_thumbnail_cache_evict(cache, entry);
+
+   if (cache->cb)
+      cache->cb(cache->userdata, entry->path, entry->texture,
+            entry->width, entry->height);
+
+end:
+   if (img)
+   {
+      image_texture_free(img);
+      free(img);
+   }
+}
+
+menu_thumbnail_cache_t *menu_thumbnail_cache_new(
+      menu_thumbnail_cache_cb_t cb, void *userdata)
+{
+   menu_thumbnail_cache_t *cache = (menu_thumbnail_cache_t*)
+      calloc(1, sizeof(*cache));
+
+   if (!cache)
+      return NULL;
+
+   cache->cb       = cb;
+   cache->userdata = userdata;
+
+   return cache;
+}
+
+void menu_thumbnail_cache_free(menu_thumbnail_cache_t *cache)
+{
+   if (!cache)
+      return;
+
+   menu_thumbnail_cache_clear(cache);
+   free(cache);
+}
+
+/**
+ * menu_thumbnail_cache_clear:
+ * @cache              : Thumbnail cache.
+ *
+ * Unloads every cached texture and cancels pending loads,
+ * e.g. when the video context goes away.
+ **/
+void menu_thumbnail_cache_clear(menu_thumbnail_cache_t *cache)
+{
+   if (!cache)
+      return;
+
+   while (cache->entries)
+      menu_thumbnail_cache_drop(cache, cache->entries);
+
+   cache->size   = 0;
+   cache->pinned = NULL;
+}
+
+void menu_thumbnail_cache_set_limit(menu_thumbnail_cache_t *cache,
+      size_t max_size)
+{
+   if (!cache || cache->max_size == max_size)
+      return;
+
+   cache->max_size = max_size;
+   menu_thumbnail_cache_evict(cache, NULL);
+}
+
+/**
+ * menu_thumbnail_cache_get:
+ * @cache              : Thumbnail cache.
+ * @path               : Path of the thumbnail image.
+ * @texture            : Uploaded texture, owned by the cache.
+ * @width              : Width of the image.
+ * @height             : Height of the image.
+ *
+ * Looks up a loaded thumbnail. The returned texture stays valid
+ * until another thumbnail is fetched or the cache is cleared.
+ *
+ * Returns: true if @path is loaded, otherwise false.
+ **/
+bool menu_thumbnail_cache_get(menu_thumbnail_cache_t *cache,
+      const char *path, uintptr_t *texture,
+      unsigned *width, unsigned *height)
+{
+   struct menu_thumbnail_entry *entry = NULL;
+
+   if (!cache || string_is_empty(path))
+      return false;
+
+   entry = menu_thumbnail_cache_find(cache, path);
+
+   if (!entry || entry->pending)
+      return false;
+
+   entry->last_used = cache->usage_counter++;
+   cache->pinned    = entry;
+
+   *texture         = entry->texture;
+   *width           = entry->width;
+   *height          = entry->height;
+
+   return true;
+}
+
+/**
+ * menu_thumbnail_cache_load:
+ * @cache              : Thumbnail cache.
+ * @path               : Path of the thumbnail image.
+ *
+ * Starts loading @path in the background unless it is already
+ * loaded or on its way. The cache callback fires once it is
+ * ready. Requests made between menu_thumbnail_cache_prefetch_begin()
+ * and menu_thumbnail_cache_prefetch_end() keep their load alive.
+ *
+ * Returns: true if @path is loaded or being loaded.
+ **/
+bool menu_thumbnail_cache_load(menu_thumbnail_cache_t *cache,
+      const char *path)
+{
+   struct menu_thumbnail_entry *entry = NULL;
+
+   if (!cache || !cache->max_size || string_is_empty(path))
+      return false;
+
+   entry = menu_thumbnail_cache_find(cache, path);
+
+   if (entry)
+   {
+      entry->round = cache->round;
+      return true;
+   }
+
+   entry = (struct menu_thumbnail_entry*)calloc(1, sizeof(*entry));
+   if (!entry)
+      return false;
+
+   entry->path    = strdup(path);
+   entry->hash    = msg_hash_calculate(path);
+   entry->round   = cache->round;
+   entry->pending = true;
+   entry->cache   = cache;
+
+   if (!entry->path || !task_push_image_load(path,
+            menu_thumbnail_cache_handle_upload, entry))
+   {
+      free(entry->path);
+      free(entry);
+      return false;
+   }
+
+   entry->next    = cache->entries;
+   cache->entries = entry;
+
+   return true;
+}
+
+void menu_thumbnail_cache_prefetch_begin(menu_thumbnail_cache_t *cache)
+{
+   if (cache)
+      cache->round++;
+}
+
+/**
+ * menu_thumbnail_cache_prefetch_end:
+ * @cache              : Thumbnail cache.
+ *
+ * Cancels every pending load that was not requested again since
+ * the matching menu_thumbnail_cache_prefetch_begin(), i.e. those
+ * that scrolled out of range.
+ **/
+void menu_thumbnail_cache_prefetch_end(menu_thumbnail_cache_t *cache)
+{
+   struct menu_thumbnail_entry *entry = NULL;
+   struct menu_thumbnail_entry *next  = NULL;
+
+   if (!cache)
+      return;
+
+   for (entry = cache->entries; entry; entry = next)
+   {
+      next = entry->next;
+
+      if (entry->pending && entry->round != cache->round)
+         menu_thumbnail_cache_drop(cache, entry);
+   }
+}
@@ -0,0 +1,57 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MENU_THUMBNAIL_CACHE_H
+#define _MENU_THUMBNAIL_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Called from the main thread once a requested thumbnail
+ * has been decoded and uploaded. */
+typedef void (*menu_thumbnail_cache_cb_t)(void *userdata,
+      const char *path, uintptr_t texture,
+      unsigned width, unsigned height);
+
+typedef struct menu_thumbnail_cache menu_thumbnail_cache_t;
+
+menu_thumbnail_cache_t *menu_thumbnail_cache_new(
+      menu_thumbnail_cache_cb_t cb, void *userdata);
+
+void menu_thumbnail_cache_free(menu_thumbnail_cache_t *cache);
+
+void menu_thumbnail_cache_clear(menu_thumbnail_cache_t *cache);
+
+void menu_thumbnail_cache_set_limit(menu_thumbnail_cache_t *cache,
+      size_t max_size);
+
+bool menu_thumbnail_cache_get(menu_thumbnail_cache_t *cache,
+      const char *path, uintptr_t *texture,
+      unsigned *width, unsigned *height);
+
+bool menu_thumbnail_cache_load(menu_thumbnail_cache_t *cache,
+      const char *path);
+
+void menu_thumbnail_cache_prefetch_begin(menu_thumbnail_cache_t *cache);
+
+void menu_thumbnail_cache_prefetch_end(menu_thumbnail_cache_t *cache);
+
+RETRO_END_DECLS
+
+#endif
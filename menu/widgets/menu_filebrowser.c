@@ -117,12 +117,17 @@ void filebrowser_parse(void *data, unsigned type_data)
    }
    else
    {
+      /* Large directories would otherwise regrow the list
+       * a dozen times over while it is being filled. */
+      file_list_reserve(info->list, info->list->size + list_size + 1);
+
       for (i = 0; i < list_size; i++)
       {
          char label[PATH_MAX_LENGTH];
          bool is_dir                   = false;
          enum msg_hash_enums enum_idx  = MSG_UNKNOWN;
          enum msg_file_type file_type  = FILE_TYPE_NONE;
+         enum rarch_content_type media_type = RARCH_CONTENT_NONE;
          const char *path              = str_list->elems[i].data;
 
          label[0] = '\0';
@@ -182,13 +187,16 @@ void filebrowser_parse(void *data, unsigned type_data)
                file_type = FILE_TYPE_PLAYLIST_COLLECTION;
          }
 
-         if (!is_dir && path_is_media_type(path) == RARCH_CONTENT_MUSIC)
+         if (!is_dir)
+            media_type = path_is_media_type(path);
+
+         if (!is_dir && media_type == RARCH_CONTENT_MUSIC)
             file_type = FILE_TYPE_MUSIC;
          else if (!is_dir && 
                (settings->bools.multimedia_builtin_mediaplayer_enable ||
                 settings->bools.multimedia_builtin_imageviewer_enable))
          {
-            switch (path_is_media_type(path))
+            switch (media_type)
             {
                case RARCH_CONTENT_MOVIE:
 #ifdef HAVE_FFMPEG
@@ -360,6 +360,7 @@ enum msg_hash_enums
    MSG_FAILED_TO_LOAD_STATE,
    MSG_FAILED_TO_UNDO_LOAD_STATE,
    MSG_FAILED_TO_UNDO_SAVE_STATE,
+   MSG_RUN_AHEAD_FAILED_TO_ROLL_BACK,
    MSG_RESET,
    MSG_AUDIO_MUTED,
    MSG_AUDIO_UNMUTED,
@@ -621,6 +622,9 @@ enum msg_hash_enums
    MENU_LABEL(VIDEO_GPU_SCREENSHOT),
    MENU_LABEL(VIDEO_BLACK_FRAME_INSERTION),
    MENU_LABEL(VIDEO_FRAME_DELAY),
+   MENU_LABEL(VIDEO_FRAME_DELAY_AUTO),
+   MENU_LABEL(RUN_AHEAD_ENABLED),
+   MENU_LABEL(RUN_AHEAD_FRAMES),
    MENU_LABEL(VIDEO_VSYNC),
    MENU_LABEL(VIDEO_HARD_SYNC),
    MENU_LABEL(VIDEO_HARD_SYNC_FRAMES),
@@ -693,6 +697,7 @@ enum msg_hash_enums
    MENU_LABEL(XMB_SHOW_ADD),
    MENU_LABEL(XMB_RIBBON_ENABLE),
    MENU_LABEL(THUMBNAILS),
+   MENU_LABEL(THUMBNAIL_CACHE_SIZE),
    MENU_LABEL(TIMEDATE_ENABLE),
    MENU_LABEL(BATTERY_LEVEL_ENABLE),
    MENU_LABEL(MATERIALUI_MENU_COLOR_THEME),
@@ -1042,6 +1047,7 @@ enum msg_hash_enums
    MENU_LABEL(SAVESTATE_AUTO_SAVE),
    MENU_LABEL(SAVESTATE_AUTO_LOAD),
    MENU_LABEL(SAVESTATE_THUMBNAIL_ENABLE),
+   MENU_LABEL(SAVESTATE_FILE_COMPRESSION),
 
    MENU_LABEL(SUSPEND_SCREENSAVER_ENABLE),
    MENU_LABEL(DPI_OVERRIDE_ENABLE),
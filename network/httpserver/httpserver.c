@@ -28,12 +28,14 @@
 #include "../../retroarch.h"
 #include "../../core.h"
 #include "../../gfx/video_driver.h"
+#include "../../audio/audio_driver.h"
 #include "../../managers/core_option_manager.h"
 #include "../../cheevos/cheevos.h"
 #include "../../content.h"
 
 #define BASIC_INFO "info"
 #define MEMORY_MAP "memoryMap"
+#define STATS      "stats"
 
 static struct mg_callbacks s_httpserver_callbacks;
 static struct mg_context   *s_httpserver_ctx       = NULL;
@@ -551,6 +553,54 @@ static int httpserver_handle_mmaps(struct mg_connection* conn, void* cbdata)
    return httpserver_handle_get_mmaps(conn, cbdata);
 }
 
+/*============================================================
+STATS
+============================================================ */
+
+static int httpserver_handle_stats(struct mg_connection* conn, void* cbdata)
+{
+   video_frame_time_stats_t video_stats;
+   audio_buffer_stats_t audio_stats;
+
+   video_driver_get_frame_time_stats(&video_stats);
+   audio_driver_get_buffer_stats(&audio_stats);
+
+   mg_printf(conn,
+         "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n"
+         "{"
+         "\"frameTime\":"
+         "{"
+         "\"p50\":%u,"
+         "\"p95\":%u,"
+         "\"p99\":%u,"
+         "\"samples\":%u"
+         "},"
+         "\"frames\":%" PRIu64 ","
+         "\"droppedFrames\":%" PRIu64 ","
+         "\"audioBuffer\":"
+         "{"
+         "\"fill\":%.1f,"
+         "\"fillAvg\":%.1f,"
+         "\"fillMin\":%.1f,"
+         "\"samples\":%u,"
+         "\"underruns\":%" PRIu64
+         "}"
+         "}",
+         (unsigned)video_stats.p50,
+         (unsigned)video_stats.p95,
+         (unsigned)video_stats.p99,
+         video_stats.samples,
+         video_stats.frames,
+         video_stats.dropped,
+         audio_stats.fill_current,
+         audio_stats.fill_avg,
+         audio_stats.fill_min,
+         audio_stats.samples,
+         audio_stats.underruns);
+
+   return 1;
+}
+
 /*============================================================
 HTTP SERVER
 ============================================================ */
@@ -578,6 +628,8 @@ int httpserver_init(unsigned port)
    mg_set_request_handler(s_httpserver_ctx, "/" MEMORY_MAP, httpserver_handle_mmaps, NULL);
    mg_set_request_handler(s_httpserver_ctx, "/" MEMORY_MAP "/", httpserver_handle_mmaps, NULL);
 
+   mg_set_request_handler(s_httpserver_ctx, "/" STATS, httpserver_handle_stats, NULL);
+
    return 0;
 }
 
@@ -15,6 +15,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -24,6 +25,7 @@
 #endif
 
 #include <compat/strl.h>
+#include <streams/file_stream.h>
 
 #include "performance_counters.h"
 
@@ -120,6 +122,137 @@ void retro_perf_log(void)
    log_counters(perf_counters_libretro, perf_ptr_libretro);
 }
 
+#ifdef HAVE_FRAME_TRACE
+/* Must be a power of two. Roughly two minutes at 60 FPS. */
+#define FRAME_TRACE_MAX_RECORDS (1 << 16)
+
+struct frame_trace_record
+{
+   retro_time_t begin;
+   retro_time_t end;
+   uint32_t frame;
+   unsigned event;
+};
+
+static const char *frame_trace_event_names[FRAME_TRACE_LAST] = {
+   "input_poll",
+   "core_run",
+   "audio_flush",
+   "video_frame",
+   "video_filter",
+   "present",
+   "sleep"
+};
+
+bool frame_trace_enabled = false;
+
+static struct frame_trace_record *frame_trace_records;
+static uint64_t frame_trace_count;
+static uint32_t frame_trace_frame;
+static retro_time_t frame_trace_start[FRAME_TRACE_LAST];
+
+void frame_trace_set_enabled(bool enable)
+{
+   if (enable && !frame_trace_records)
+      frame_trace_records = (struct frame_trace_record*)
+         calloc(FRAME_TRACE_MAX_RECORDS, sizeof(*frame_trace_records));
+
+   frame_trace_enabled = enable && frame_trace_records;
+}
+
+void frame_trace_deinit(void)
+{
+   free(frame_trace_records);
+   frame_trace_records = NULL;
+   frame_trace_enabled = false;
+   frame_trace_count   = 0;
+   frame_trace_frame   = 0;
+}
+
+void frame_trace_begin(enum frame_trace_event event)
+{
+   frame_trace_start[event] = cpu_features_get_time_usec();
+}
+
+void frame_trace_end(enum frame_trace_event event)
+{
+   struct frame_trace_record *record = &frame_trace_records[
+      frame_trace_count++ & (FRAME_TRACE_MAX_RECORDS - 1)];
+
+   record->begin = frame_trace_start[event];
+   record->end   = cpu_features_get_time_usec();
+   record->frame = frame_trace_frame;
+   record->event = event;
+}
+
+void frame_trace_next_frame(void)
+{
+   frame_trace_frame++;
+}
+
+static bool frame_trace_write(RFILE *file, const char *str)
+{
+   size_t len = strlen(str);
+   return filestream_write(file, str, len) == (ssize_t)len;
+}
+
+bool frame_trace_dump(const char *path)
+{
+   uint64_t i, first;
+   char line[256];
+   bool ret     = true;
+   RFILE *file  = NULL;
+
+   if (!frame_trace_records || !path || !*path)
+      return false;
+
+   file = filestream_open(path, RFILE_MODE_WRITE, -1);
+
+   if (!file)
+   {
+      RARCH_ERR("[PERF]: Failed to open frame trace \"%s\".\n", path);
+      return false;
+   }
+
+   first = frame_trace_count > FRAME_TRACE_MAX_RECORDS
+      ? frame_trace_count - FRAME_TRACE_MAX_RECORDS : 0;
+
+   ret = frame_trace_write(file,
+         "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+         "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+         "\"args\":{\"name\":\"RetroArch\"}}");
+
+   for (i = first; ret && i < frame_trace_count; i++)
+   {
+      const struct frame_trace_record *record =
+         &frame_trace_records[i & (FRAME_TRACE_MAX_RECORDS - 1)];
+
+      snprintf(line, sizeof(line),
+            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%lld,\"dur\":%lld,\"args\":{\"frame\":%u}}",
+            frame_trace_event_names[record->event],
+            (long long)record->begin,
+            (long long)(record->end - record->begin),
+            (unsigned)record->frame);
+      ret = frame_trace_write(file, line);
+   }
+
+   if (ret)
+      ret = frame_trace_write(file, "\n]}\n");
+   filestream_close(file);
+
+   if (!ret)
+   {
+      RARCH_ERR("[PERF]: Failed to write frame trace \"%s\".\n", path);
+      return false;
+   }
+
+   RARCH_LOG("[PERF]: Wrote %u frame trace events to \"%s\".\n",
+         (unsigned)(frame_trace_count - first), path);
+   return true;
+}
+#endif
+
 void rarch_timer_tick(rarch_timer_t *timer)
 {
    if (!timer)
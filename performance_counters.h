@@ -89,6 +89,56 @@ void rarch_perf_register(struct retro_perf_counter *perf);
  **/
 #define performance_counter_stop_plus(is_perfcnt_enable, perf) performance_counter_stop_internal(is_perfcnt_enable, perf)
 
+#ifdef HAVE_FRAME_TRACE
+enum frame_trace_event
+{
+   FRAME_TRACE_INPUT_POLL = 0,
+   FRAME_TRACE_CORE_RUN,
+   FRAME_TRACE_AUDIO_FLUSH,
+   FRAME_TRACE_VIDEO_FRAME,
+   FRAME_TRACE_VIDEO_FILTER,
+   FRAME_TRACE_PRESENT,
+   FRAME_TRACE_SLEEP,
+   FRAME_TRACE_LAST
+};
+
+extern bool frame_trace_enabled;
+
+void frame_trace_set_enabled(bool enable);
+
+/* Frees the trace ring buffer and everything recorded in it. */
+void frame_trace_deinit(void);
+
+void frame_trace_begin(enum frame_trace_event event);
+
+void frame_trace_end(enum frame_trace_event event);
+
+void frame_trace_next_frame(void);
+
+/**
+ * frame_trace_dump:
+ * @path               : Path of the trace file.
+ *
+ * Writes the frames still in the trace ring buffer out
+ * as a Chrome trace-event JSON file, which can be loaded
+ * in chrome://tracing or Perfetto.
+ *
+ * Returns: true (1) on success, otherwise false (0).
+ **/
+bool frame_trace_dump(const char *path);
+
+#define FRAME_TRACE_BEGIN(event) \
+   do { if (frame_trace_enabled) frame_trace_begin(event); } while (0)
+#define FRAME_TRACE_END(event) \
+   do { if (frame_trace_enabled) frame_trace_end(event); } while (0)
+#define FRAME_TRACE_NEXT_FRAME() \
+   do { if (frame_trace_enabled) frame_trace_next_frame(); } while (0)
+#else
+#define FRAME_TRACE_BEGIN(event)
+#define FRAME_TRACE_END(event)
+#define FRAME_TRACE_NEXT_FRAME()
+#endif
+
 void rarch_timer_tick(rarch_timer_t *timer);
 
 bool rarch_timer_is_running(rarch_timer_t *timer);
@@ -85,6 +85,7 @@ HAVE_UPDATE_ASSETS=yes     # Disable downloading assets with online updater
 HAVE_PRESERVE_DYLIB=no     # Enable dlclose() for Valgrind support
 HAVE_PARPORT=auto          # Parallel port joypad support
 HAVE_IMAGEVIEWER=yes       # Built-in image viewer support.
+HAVE_FRAME_TRACE=no        # Per-frame timing tracer (needs perfcnt_enable)
 HAVE_MMAP=auto             # MMAP support
 HAVE_QT=no                 # Qt companion support
 HAVE_QT_WRAPPER=no
@@ -94,13 +94,41 @@ extern "C" {
 #define av_frame_free avcodec_free_frame
 #endif
 
+/* Raw frames copied from the core, waiting to be scaled. */
+#define MAX_FRAMES 32
+/* Scaled frames waiting to be encoded. */
+#define MAX_CONV_FRAMES 8
+#define MAX_QUEUED_FRAMES 64
+
+/* Queue entry for a frame the core flagged as a dupe. */
+#define FF_FRAME_REPEAT -1
+/* Queue entry for a frame which was dropped because the
+ * frame pool ran dry. Its timestamp is skipped. */
+#define FF_FRAME_SKIP   -2
+
+struct ff_frame
+{
+   struct ffemu_video_data attr;
+   uint8_t *data;
+   AVFrame *av;
+   /* Frames with a zero refcount are free for reuse. */
+   unsigned refcount;
+};
+
+struct ff_frame_queue
+{
+   int entries[MAX_QUEUED_FRAMES];
+   unsigned head;
+   unsigned count;
+   unsigned max_depth;
+};
+
 struct ff_video_info
 {
    AVCodecContext *codec;
    AVCodec *encoder;
 
-   AVFrame *conv_frame;
-   uint8_t *conv_frame_buf;
+   struct ff_frame conv_frames[MAX_CONV_FRAMES];
    int64_t frame_cnt;
 
    uint8_t *outbuf;
@@ -204,16 +232,28 @@ typedef struct ffmpeg
    
    struct ffemu_params params;
 
-   scond_t *cond;
-   slock_t *cond_lock;
+   /* Protects everything below. */
    slock_t *lock;
+   /* Signalled when raw frames are queued for scaling. */
+   scond_t *scale_cond;
+   /* Signalled when scaled frames or audio are queued for encoding. */
+   scond_t *encode_cond;
+   /* Signalled when frames, queue entries or audio space are released. */
+   scond_t *free_cond;
    fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
-   sthread_t *thread;
 
-   volatile bool alive;
-   volatile bool can_sleep;
+   struct ff_frame frames[MAX_FRAMES];
+   struct ff_frame_queue scale_queue;
+   struct ff_frame_queue encode_queue;
+   /* Newest scaled frame, reused for dupes. */
+   int last_conv;
+   unsigned frames_dropped;
+
+   sthread_t *scale_thread;
+   sthread_t *encode_thread;
+
+   bool alive;
+   bool scale_done;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -388,6 +428,7 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
 
 static bool ffmpeg_init_video(ffmpeg_t *handle)
 {
+   unsigned i;
    size_t size;
    struct ff_config_param *params = &handle->config;
    struct ff_video_info *video    = &handle->video;
@@ -512,15 +553,24 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
 
    size = avpicture_get_size(video->pix_fmt, param->out_width,
          param->out_height);
-   video->conv_frame_buf = (uint8_t*)av_malloc(size);
-   video->conv_frame = av_frame_alloc();
 
-   avpicture_fill((AVPicture*)video->conv_frame, video->conv_frame_buf,
-         video->pix_fmt, param->out_width, param->out_height);
+   for (i = 0; i < MAX_CONV_FRAMES; i++)
+   {
+      struct ff_frame *frame = &video->conv_frames[i];
+
+      frame->data = (uint8_t*)av_mallocz(size);
+      frame->av   = av_frame_alloc();
+
+      if (!frame->data || !frame->av)
+         return false;
+
+      avpicture_fill((AVPicture*)frame->av, frame->data,
+            video->pix_fmt, param->out_width, param->out_height);
 
-   video->conv_frame->width  = param->out_width;
-   video->conv_frame->height = param->out_height;
-   video->conv_frame->format = video->pix_fmt;
+      frame->av->width  = param->out_width;
+      frame->av->height = param->out_height;
+      frame->av->format = video->pix_fmt;
+   }
 
    return true;
 }
@@ -653,75 +703,119 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
    return avformat_write_header(handle->muxer.ctx, NULL) >= 0;
 }
 
-#define MAX_FRAMES 32
-
-static void ffmpeg_thread(void *data);
+static void ffmpeg_scale_thread(void *data);
+static void ffmpeg_encode_thread(void *data);
 
 static bool init_thread(ffmpeg_t *handle)
 {
-   handle->lock = slock_new();
-   handle->cond_lock = slock_new();
-   handle->cond = scond_new();
-   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
+   unsigned i;
+   /* Pad by a scanline, sws tends to read a bit past the end. */
+   size_t frame_size = (handle->params.fb_height + 1) *
+      handle->params.fb_width * handle->video.pix_size;
+
+   handle->lock        = slock_new();
+   handle->scale_cond  = scond_new();
+   handle->encode_cond = scond_new();
+   handle->free_cond   = scond_new();
+   handle->audio_fifo  = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
 
-   handle->alive = true;
-   handle->can_sleep = true;
-   handle->thread = sthread_create(ffmpeg_thread, handle);
+   for (i = 0; i < MAX_FRAMES; i++)
+   {
+      handle->frames[i].data = (uint8_t*)av_malloc(frame_size);
+      retro_assert(handle->frames[i].data);
+   }
 
-   retro_assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   handle->last_conv     = -1;
+   handle->alive         = true;
+   handle->scale_thread  = sthread_create(ffmpeg_scale_thread, handle);
+   handle->encode_thread = sthread_create(ffmpeg_encode_thread, handle);
+
+   retro_assert(handle->lock && handle->scale_cond &&
+      handle->encode_cond && handle->free_cond && handle->audio_fifo &&
+      handle->scale_thread && handle->encode_thread);
 
    return true;
 }
 
 static void deinit_thread(ffmpeg_t *handle)
 {
-   if (!handle->thread)
+   if (!handle->scale_thread)
       return;
 
-   slock_lock(handle->cond_lock);
+   /* The threads drain whatever is still queued before exiting. */
+   slock_lock(handle->lock);
    handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
+   scond_signal(handle->scale_cond);
+   scond_broadcast(handle->free_cond);
+   slock_unlock(handle->lock);
 
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
+   sthread_join(handle->scale_thread);
+   sthread_join(handle->encode_thread);
 
    slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
+   scond_free(handle->scale_cond);
+   scond_free(handle->encode_cond);
+   scond_free(handle->free_cond);
 
-   handle->thread = NULL;
+   handle->scale_thread  = NULL;
+   handle->encode_thread = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
+   unsigned i;
+
    if (handle->audio_fifo)
    {
       fifo_free(handle->audio_fifo);
       handle->audio_fifo = NULL;
    }
-   
-   if (handle->attr_fifo)
+
+   for (i = 0; i < MAX_FRAMES; i++)
    {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
+      av_free(handle->frames[i].data);
+      handle->frames[i].data = NULL;
    }
+}
+
+static void ff_frame_queue_push(struct ff_frame_queue *queue, int entry)
+{
+   queue->entries[(queue->head + queue->count) % MAX_QUEUED_FRAMES] = entry;
+   queue->count++;
+
+   if (queue->count > queue->max_depth)
+      queue->max_depth = queue->count;
+}
+
+static int ff_frame_queue_pop(struct ff_frame_queue *queue)
+{
+   int entry   = queue->entries[queue->head];
+   queue->head = (queue->head + 1) % MAX_QUEUED_FRAMES;
+   queue->count--;
+   return entry;
+}
 
-   if (handle->video_fifo)
+/* Returns the index of a free frame in the pool, or -1. */
+static int ff_frame_pool_acquire(struct ff_frame *pool, unsigned size)
+{
+   unsigned i;
+
+   for (i = 0; i < size; i++)
    {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      if (!pool[i].refcount)
+      {
+         pool[i].refcount = 1;
+         return i;
+      }
    }
+
+   return -1;
 }
 
 static void ffmpeg_free(void *data)
 {
+   unsigned i;
    ffmpeg_t *handle = (ffmpeg_t*)data;
    if (!handle)
       return;
@@ -743,8 +837,11 @@ static void ffmpeg_free(void *data)
       av_free(handle->video.codec);
    }
 
-   av_frame_free(&handle->video.conv_frame);
-   av_free(handle->video.conv_frame_buf);
+   for (i = 0; i < MAX_CONV_FRAMES; i++)
+   {
+      av_frame_free(&handle->video.conv_frames[i].av);
+      av_free(handle->video.conv_frames[i].data);
+   }
 
    scaler_ctx_gen_reset(&handle->video.scaler);
 
@@ -814,9 +911,8 @@ static bool ffmpeg_push_video(void *data,
 {
    unsigned y;
    bool drop_frame;
-   struct ffemu_video_data attr_data;
    ffmpeg_t *handle = (ffmpeg_t*)data;
-   int offset = 0;
+   int index        = FF_FRAME_REPEAT;
 
    if (!handle || !vid)
       return false;
@@ -829,52 +925,54 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
+   slock_lock(handle->lock);
 
-      if (!handle->alive)
-         return false;
+   /* Only block when the queue itself is full. Running out of
+    * frame buffers drops the frame instead, so a slow encoder
+    * doesn't stall the core. */
+   while (handle->alive && handle->scale_queue.count >= MAX_QUEUED_FRAMES)
+      scond_wait(handle->free_cond, handle->lock);
 
-      if (avail >= sizeof(*vid))
-         break;
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
+   }
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
+   if (!vid->is_dupe)
+   {
+      index = ff_frame_pool_acquire(handle->frames, MAX_FRAMES);
+      if (index < 0)
       {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
+         index = FF_FRAME_SKIP;
+         handle->frames_dropped++;
       }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
    }
 
-   slock_lock(handle->lock);
-
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   attr_data = *vid;
-
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
-   else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
-
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   slock_unlock(handle->lock);
 
-   for (y = 0; y < attr_data.height; y++, offset += vid->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)vid->data + offset, attr_data.pitch);
+   if (index >= 0)
+   {
+      struct ff_frame *frame = &handle->frames[index];
+      const uint8_t *src     = (const uint8_t*)vid->data;
+
+      /* Tightly pack our frame to conserve memory.
+       * libretro tends to use a very large pitch.
+       */
+      frame->attr       = *vid;
+      frame->attr.data  = frame->data;
+      frame->attr.pitch = vid->width * handle->video.pix_size;
+
+      for (y = 0; y < vid->height; y++, src += vid->pitch)
+         memcpy(frame->data + y * frame->attr.pitch, src, frame->attr.pitch);
+   }
 
+   /* Only this thread pushes to the scale queue,
+    * so the space checked above is still there. */
+   slock_lock(handle->lock);
+   ff_frame_queue_push(&handle->scale_queue, index);
+   scond_signal(handle->scale_cond);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -882,6 +980,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct ffemu_audio_data *audio_data)
 {
+   size_t size;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -890,38 +989,22 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
 
-      if (!handle->alive)
-         return false;
-
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
+   slock_lock(handle->lock);
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+   while (handle->alive && fifo_write_avail(handle->audio_fifo) < size)
+      scond_wait(handle->free_cond, handle->lock);
 
-      slock_unlock(handle->cond_lock);
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
    }
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+   scond_signal(handle->encode_cond);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -962,7 +1045,7 @@ static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
 }
 
 static void ffmpeg_scale_input(ffmpeg_t *handle,
-      const struct ffemu_video_data *vid)
+      const struct ffemu_video_data *vid, AVFrame *frame)
 {
    /* Attempt to preserve more information if we scale down. */
    bool shrunk = handle->params.out_width < vid->width
@@ -979,18 +1062,17 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
             shrunk ? SWS_BILINEAR : SWS_POINT, NULL, NULL, NULL);
 
       sws_scale(handle->video.sws, (const uint8_t* const*)&vid->data,
-            &linesize, 0, vid->height, handle->video.conv_frame->data,
-            handle->video.conv_frame->linesize);
+            &linesize, 0, vid->height, frame->data, frame->linesize);
    }
    else
    {
       video_frame_record_scale(
             &handle->video.scaler,
-            handle->video.conv_frame->data[0],
+            frame->data[0],
             vid->data,
             handle->params.out_width,
             handle->params.out_height,
-            handle->video.conv_frame->linesize[0],
+            frame->linesize[0],
             vid->width,
             vid->height,
             vid->pitch,
@@ -998,17 +1080,13 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
    }
 }
 
-static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
-      const struct ffemu_video_data *vid)
+static bool ffmpeg_push_video_thread(ffmpeg_t *handle, AVFrame *frame)
 {
    AVPacket pkt;
 
-   if (!vid->is_dupe)
-      ffmpeg_scale_input(handle, vid);
-
-   handle->video.conv_frame->pts = handle->video.frame_cnt;
+   frame->pts = handle->video.frame_cnt;
 
-   if (!encode_video(handle, &pkt, handle->video.conv_frame))
+   if (!encode_video(handle, &pkt, frame))
       return false;
 
    if (pkt.size)
@@ -1289,62 +1367,22 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
 
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
-   bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width * 
-         handle->params.fb_height * handle->video.pix_size);
-   size_t audio_buf_size = handle->config.audio_enable ? 
-      (handle->audio.codec->frame_size * 
-       handle->params.channels * sizeof(int16_t)) : 0;
-   void *audio_buf = NULL;
-
-   if (audio_buf_size)
-      audio_buf = av_malloc(audio_buf_size);
-   /* Try pushing data in an interleaving pattern to 
-    * ease the work of the muxer a bit. */
-
-   do
+   /* The worker threads have drained the queues by now,
+    * only a partial audio frame can be left over. */
+   if (handle->config.audio_enable)
    {
-      struct ffemu_video_data attr_buf;
+      size_t audio_buf_size = handle->audio.codec->frame_size *
+         handle->params.channels * sizeof(int16_t);
+      void *audio_buf       = av_malloc(audio_buf_size);
 
-      did_work = false;
+      if (audio_buf)
+         ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
 
-      if (handle->config.audio_enable)
-      {
-         if (fifo_read_avail(handle->audio_fifo) >= audio_buf_size)
-         {
-            struct ffemu_audio_data aud = {0};
-
-            fifo_read(handle->audio_fifo, audio_buf, audio_buf_size);
-
-            aud.frames = handle->audio.codec->frame_size;
-            aud.data = audio_buf;
-
-            ffmpeg_push_audio_thread(handle, &aud, true);
-            did_work = true;
-         }
-      }
-
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
-      {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
-
-         did_work = true;
-      }
-   } while (did_work);
-
-   /* Flush out last audio. */
-   if (handle->config.audio_enable)
-      ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
+      av_free(audio_buf);
+   }
 
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
-
-   av_free(video_buf);
-   av_free(audio_buf);
 }
 
 static bool ffmpeg_finalize(void *data)
@@ -1359,6 +1397,10 @@ static bool ffmpeg_finalize(void *data)
    /* Flush out data still in buffers (internal, and FFmpeg internal). */
    ffmpeg_flush_buffers(handle);
 
+   RARCH_LOG("[FFmpeg]: %u frames dropped, max queue depth %u (scale) / %u (encode).\n",
+         handle->frames_dropped, handle->scale_queue.max_depth,
+         handle->encode_queue.max_depth);
+
    deinit_thread_buf(handle);
 
    /* Write final data. */
@@ -1367,91 +1409,175 @@ static bool ffmpeg_finalize(void *data)
    return true;
 }
 
-static void ffmpeg_thread(void *data)
+/* Converts raw frames from the core into the output format and
+ * hands them over to the encoder thread. */
+static void ffmpeg_scale_thread(void *data)
+{
+   ffmpeg_t *ff = (ffmpeg_t*)data;
+
+   slock_lock(ff->lock);
+
+   for (;;)
+   {
+      int index, conv;
+
+      while (ff->alive && !ff->scale_queue.count)
+         scond_wait(ff->scale_cond, ff->lock);
+
+      if (!ff->scale_queue.count)
+         break;
+
+      index = ff_frame_queue_pop(&ff->scale_queue);
+      scond_broadcast(ff->free_cond);
+
+      if (index == FF_FRAME_SKIP)
+         conv = FF_FRAME_SKIP;
+      else if (index == FF_FRAME_REPEAT && ff->last_conv >= 0)
+      {
+         conv = ff->last_conv;
+         ff->video.conv_frames[conv].refcount++;
+      }
+      else
+      {
+         while ((conv = ff_frame_pool_acquire(
+                     ff->video.conv_frames, MAX_CONV_FRAMES)) < 0)
+            scond_wait(ff->free_cond, ff->lock);
+
+         if (index >= 0)
+         {
+            slock_unlock(ff->lock);
+            ffmpeg_scale_input(ff, &ff->frames[index].attr,
+                  ff->video.conv_frames[conv].av);
+            slock_lock(ff->lock);
+
+            ff->frames[index].refcount--;
+         }
+
+         /* Hold on to the newest frame so dupes can reuse it. */
+         if (ff->last_conv >= 0)
+            ff->video.conv_frames[ff->last_conv].refcount--;
+         ff->last_conv = conv;
+         ff->video.conv_frames[conv].refcount++;
+         scond_broadcast(ff->free_cond);
+      }
+
+      while (ff->encode_queue.count >= MAX_QUEUED_FRAMES)
+         scond_wait(ff->free_cond, ff->lock);
+
+      ff_frame_queue_push(&ff->encode_queue, conv);
+      scond_signal(ff->encode_cond);
+   }
+
+   if (ff->last_conv >= 0)
+      ff->video.conv_frames[ff->last_conv].refcount--;
+   ff->last_conv  = -1;
+   ff->scale_done = true;
+   scond_signal(ff->encode_cond);
+
+   slock_unlock(ff->lock);
+}
+
+/* Encodes and muxes scaled frames and audio. This is the only
+ * thread touching the codecs and the muxer until finalize. */
+static void ffmpeg_encode_thread(void *data)
 {
    size_t audio_buf_size;
    void *audio_buf = NULL;
    ffmpeg_t *ff    = (ffmpeg_t*)data;
-   /* For some reason, FFmpeg has a tendency to crash 
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-
-   retro_assert(video_buf);
 
    audio_buf_size = ff->config.audio_enable ? 
       (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
    audio_buf      = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
-   while (ff->alive)
-   {
-      struct ffemu_video_data attr_buf;
+   slock_lock(ff->lock);
 
+   for (;;)
+   {
+      int conv         = 0;
       bool avail_video = false;
       bool avail_audio = false;
 
-      slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+      for (;;)
+      {
+         avail_video = ff->encode_queue.count > 0;
+         avail_audio = audio_buf &&
+            fifo_read_avail(ff->audio_fifo) >= audio_buf_size;
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
+         if (avail_video || avail_audio || ff->scale_done)
+            break;
+
+         scond_wait(ff->encode_cond, ff->lock);
+      }
 
       if (!avail_video && !avail_audio)
-      {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
+         break;
 
-         slock_unlock(ff->cond_lock);
-      }
+      if (avail_video)
+         conv = ff_frame_queue_pop(&ff->encode_queue);
+      if (avail_audio)
+         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
+      scond_broadcast(ff->free_cond);
 
-      if (avail_video && video_buf)
+      slock_unlock(ff->lock);
+
+      /* Try pushing data in an interleaving pattern to 
+       * ease the work of the muxer a bit. */
+      if (avail_video)
       {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
+         if (conv == FF_FRAME_SKIP)
+            ff->video.frame_cnt++;
+         else
+            ffmpeg_push_video_thread(ff, ff->video.conv_frames[conv].av);
       }
 
-      if (avail_audio && audio_buf)
+      if (avail_audio)
       {
          struct ffemu_audio_data aud = {0};
 
-         slock_lock(ff->lock);
-         fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
          aud.frames = ff->audio.codec->frame_size;
-         aud.data = audio_buf;
+         aud.data   = audio_buf;
 
          ffmpeg_push_audio_thread(ff, &aud, true);
       }
+
+      slock_lock(ff->lock);
+
+      if (avail_video && conv >= 0)
+      {
+         ff->video.conv_frames[conv].refcount--;
+         scond_broadcast(ff->free_cond);
+      }
    }
 
-   av_free(video_buf);
+   slock_unlock(ff->lock);
+
    av_free(audio_buf);
 }
 
+static bool ffmpeg_get_stats(void *data, record_stats_t *stats)
+{
+   ffmpeg_t *handle = (ffmpeg_t*)data;
+
+   if (!handle || !handle->scale_thread)
+      return false;
+
+   slock_lock(handle->lock);
+   stats->frames_dropped     = handle->frames_dropped;
+   stats->scale_queue_depth  = handle->scale_queue.count;
+   stats->scale_queue_max    = handle->scale_queue.max_depth;
+   stats->encode_queue_depth = handle->encode_queue.count;
+   stats->encode_queue_max   = handle->encode_queue.max_depth;
+   slock_unlock(handle->lock);
+
+   return true;
+}
+
 const record_driver_t ffemu_ffmpeg = {
    ffmpeg_new,
    ffmpeg_free,
    ffmpeg_push_video,
    ffmpeg_push_audio,
    ffmpeg_finalize,
+   ffmpeg_get_stats,
    "ffmpeg",
 };
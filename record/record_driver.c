@@ -456,6 +456,16 @@ bool recording_init(void)
    return true;
 }
 
+bool recording_driver_get_stats(record_stats_t *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+
+   if (!recording_data || !recording_driver || !recording_driver->get_stats)
+      return false;
+
+   return recording_driver->get_stats(recording_data, stats);
+}
+
 void *recording_driver_get_data_ptr(void)
 {
    return recording_data;
@@ -80,6 +80,19 @@ struct ffemu_audio_data
    size_t frames;
 };
 
+/* Encoder health, readable while recording is running. */
+typedef struct record_stats
+{
+   /* Frames dropped because the encoder fell behind. */
+   unsigned frames_dropped;
+   /* Current and peak number of frames waiting to be scaled. */
+   unsigned scale_queue_depth;
+   unsigned scale_queue_max;
+   /* Current and peak number of frames waiting to be encoded. */
+   unsigned encode_queue_depth;
+   unsigned encode_queue_max;
+} record_stats_t;
+
 typedef struct record_driver
 {
    void *(*init)(const struct ffemu_params *params);
@@ -87,6 +100,7 @@ typedef struct record_driver
    bool  (*push_video)(void *data,const struct ffemu_video_data *video_data);
    bool  (*push_audio)(void *data, const struct ffemu_audio_data *audio_data);
    bool  (*finalize)(void *data);
+   bool  (*get_stats)(void *data, record_stats_t *stats);
    const char *ident;
 } record_driver_t;
 
@@ -166,6 +180,17 @@ void recording_set_state(bool state);
 
 void recording_push_audio(const int16_t *data, size_t samples);
 
+/**
+ * recording_driver_get_stats:
+ * @stats                   : Filled with the encoder statistics.
+ *
+ * Must be called from the main thread.
+ *
+ * Returns: true (1) if recording is running and the driver
+ * reports statistics, otherwise false (0).
+ **/
+bool recording_driver_get_stats(record_stats_t *stats);
+
 void *recording_driver_get_data_ptr(void);
 
 void recording_driver_clear_data_ptr(void);
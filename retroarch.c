@@ -34,6 +34,10 @@
 #include <setjmp.h>
 #include <math.h>
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
 #include <boolean.h>
 #include <string/stdstring.h>
 #include <lists/string_list.h>
@@ -44,6 +48,8 @@
 #include <audio/audio_mixer.h>
 #include <compat/posix_string.h>
 #include <file/file_path.h>
+#include <file/archive_file.h>
+#include <streams/file_stream.h>
 #include <retro_assert.h>
 #include <retro_miscellaneous.h>
 #include <queues/message_queue.h>
@@ -62,6 +68,7 @@
 #ifdef HAVE_MENU
 #include "menu/menu_driver.h"
 #include "menu/menu_event.h"
+#include "menu/menu_shader.h"
 #include "menu/widgets/menu_dialog.h"
 #include "menu/widgets/menu_input_dialog.h"
 #endif
@@ -113,6 +120,7 @@
 
 #include "version.h"
 #include "version_git.h"
+#include "performance_counters.h"
 
 #include "retroarch.h"
 
@@ -155,7 +163,8 @@ enum
    RA_OPT_VERSION,
    RA_OPT_EOF_EXIT,
    RA_OPT_LOG_FILE,
-   RA_OPT_MAX_FRAMES
+   RA_OPT_MAX_FRAMES,
+   RA_OPT_BENCHMARK
 };
 
 enum  runloop_state
@@ -244,6 +253,19 @@ static bool runloop_missing_bios                           = false;
 static bool runloop_autosave                               = false;
 static retro_time_t frame_limit_minimum_time               = 0.0;
 static retro_time_t frame_limit_last_time                  = 0.0;
+static struct retro_perf_counter core_run_perf;
+static struct retro_perf_counter rewind_perf;
+
+/* Frames run by --benchmark when --max-frames is not given. */
+#define BENCHMARK_DEFAULT_FRAMES 3600
+
+static struct
+{
+   /* Where the report is written; empty when not benchmarking. */
+   char path[PATH_MAX_LENGTH];
+   retro_time_t startup_time;
+   retro_time_t run_start;
+} runloop_benchmark;
 
 extern bool input_driver_flushing_input;
 
@@ -546,7 +568,14 @@ static void retroarch_print_help(const char *arg0)
          "Not relevant for all platforms.");
    puts("      --max-frames=NUMBER\n"
         "                        Runs for the specified number of frames, "
-        "then exits.\n");
+        "then exits.");
+   puts("      --benchmark=FILE  Runs headless and uncapped with null "
+         "drivers, then writes\n"
+        "                        a JSON performance report to FILE. "
+        "Combine with --bsvplay\n"
+        "                        for deterministic input and --max-frames "
+        "to set the length\n"
+        "                        (default: 3600 frames).\n");
 }
 
 #define FFMPEG_RECORD_ARG "r:"
@@ -619,6 +648,7 @@ static void retroarch_parse_input(int argc, char *argv[])
       { "features",     0, NULL, RA_OPT_FEATURES },
       { "subsystem",    1, NULL, RA_OPT_SUBSYSTEM },
       { "max-frames",   1, NULL, RA_OPT_MAX_FRAMES },
+      { "benchmark",    1, NULL, RA_OPT_BENCHMARK },
       { "eof-exit",     0, NULL, RA_OPT_EOF_EXIT },
       { "version",      0, NULL, RA_OPT_VERSION },
 #ifdef HAVE_FILE_LOGGER
@@ -663,6 +693,7 @@ static void retroarch_parse_input(int argc, char *argv[])
    *global->name.ups                     = '\0';
    *global->name.bps                     = '\0';
    *global->name.ips                     = '\0';
+   runloop_benchmark.path[0]             = '\0';
 
    rarch_ctl(RARCH_CTL_UNSET_OVERRIDES_ACTIVE, NULL);
 
@@ -1005,6 +1036,11 @@ static void retroarch_parse_input(int argc, char *argv[])
             runloop_max_frames  = (unsigned)strtoul(optarg, NULL, 10);
             break;
 
+         case RA_OPT_BENCHMARK:
+            strlcpy(runloop_benchmark.path, optarg,
+                  sizeof(runloop_benchmark.path));
+            break;
+
          case RA_OPT_SUBSYSTEM:
             path_set(RARCH_PATH_SUBSYSTEM, optarg);
             break;
@@ -1083,6 +1119,234 @@ static void retroarch_parse_input(int argc, char *argv[])
    if (retroarch_override_setting_is_set(RARCH_OVERRIDE_SETTING_STATE_PATH, NULL) &&
          path_is_directory(global->name.savestate))
       dir_set(RARCH_DIR_SAVESTATE, global->name.savestate);
+
+   if (!string_is_empty(runloop_benchmark.path) && !runloop_max_frames)
+      runloop_max_frames = BENCHMARK_DEFAULT_FRAMES;
+}
+
+/**
+ * retroarch_benchmark_apply_settings:
+ *
+ * Forces the settings --benchmark needs: null drivers so it can run
+ * without a display or sound card, and no vsync, audio sync or frame
+ * limiting so frames run as fast as the core and frontend allow.
+ *
+ * Has to be applied again whenever the configuration is reloaded.
+ **/
+static void retroarch_benchmark_apply_settings(void)
+{
+   settings_t *settings = config_get_ptr();
+
+   if (string_is_empty(runloop_benchmark.path))
+      return;
+
+   strlcpy(settings->arrays.video_driver, "null",
+         sizeof(settings->arrays.video_driver));
+   strlcpy(settings->arrays.audio_driver, "null",
+         sizeof(settings->arrays.audio_driver));
+   strlcpy(settings->arrays.input_driver, "null",
+         sizeof(settings->arrays.input_driver));
+   strlcpy(settings->arrays.input_joypad_driver, "null",
+         sizeof(settings->arrays.input_joypad_driver));
+
+   configuration_set_bool(settings, settings->bools.video_vsync, false);
+   configuration_set_bool(settings, settings->bools.video_threaded, false);
+   configuration_set_bool(settings, settings->bools.video_fps_show, false);
+   configuration_set_bool(settings,
+         settings->bools.video_frame_delay_auto, false);
+   configuration_set_bool(settings, settings->bools.audio_sync, false);
+   configuration_set_bool(settings, settings->bools.pause_nonactive, false);
+#ifdef HAVE_MENU
+   configuration_set_bool(settings,
+         settings->bools.menu_throttle_framerate, false);
+#endif
+   /* Never persist the forced drivers. */
+   configuration_set_bool(settings,
+         settings->bools.config_save_on_exit, false);
+   configuration_set_uint(settings, settings->uints.video_frame_delay, 0);
+   configuration_set_float(settings, settings->floats.fastforward_ratio,
+         0.0f);
+
+   rarch_ctl(RARCH_CTL_SET_PERFCNT_ENABLE, NULL);
+}
+
+static bool retroarch_benchmark_write(RFILE *file, const char *str)
+{
+   size_t len = strlen(str);
+   return filestream_write(file, str, len) == (ssize_t)len;
+}
+
+static bool retroarch_benchmark_write_string(RFILE *file, const char *str)
+{
+   char buf[256];
+   size_t len = 0;
+
+   buf[len++] = '"';
+
+   for (; str && *str; str++)
+   {
+      unsigned char c = (unsigned char)*str;
+
+      /* Leave room for the longest escape and the terminator. */
+      if (len > sizeof(buf) - 8)
+      {
+         if (filestream_write(file, buf, len) != (ssize_t)len)
+            return false;
+         len = 0;
+      }
+
+      if (c == '"' || c == '\\')
+      {
+         buf[len++] = '\\';
+         buf[len++] = c;
+      }
+      else if (c < 0x20)
+         len += snprintf(buf + len, sizeof(buf) - len, "\\u%04x", c);
+      else
+         buf[len++] = c;
+   }
+
+   buf[len++] = '"';
+
+   return filestream_write(file, buf, len) == (ssize_t)len;
+}
+
+static bool retroarch_benchmark_write_counters(RFILE *file,
+      struct retro_perf_counter **counters, unsigned num)
+{
+   unsigned i;
+   char line[256];
+   bool first = true;
+
+   if (!retroarch_benchmark_write(file, "["))
+      return false;
+
+   for (i = 0; i < num; i++)
+   {
+      if (!counters[i] || !counters[i]->call_cnt)
+         continue;
+
+      if (!retroarch_benchmark_write(file,
+               first ? "\n      {\"ident\":" : ",\n      {\"ident\":"))
+         return false;
+      if (!retroarch_benchmark_write_string(file, counters[i]->ident))
+         return false;
+
+      snprintf(line, sizeof(line),
+            ",\"calls\":%llu,\"totalTicks\":%llu,\"avgTicks\":%llu}",
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->total,
+            (unsigned long long)counters[i]->total /
+            (unsigned long long)counters[i]->call_cnt);
+      if (!retroarch_benchmark_write(file, line))
+         return false;
+      first = false;
+   }
+
+   return retroarch_benchmark_write(file, first ? "]" : "\n    ]");
+}
+
+/**
+ * retroarch_benchmark_report:
+ * @path               : Path of the JSON report.
+ *
+ * Writes the --benchmark report. Performance counter ticks are
+ * nanoseconds on Linux and macOS, and CPU specific elsewhere.
+ *
+ * Returns: true (1) if the report was written, otherwise false (0).
+ **/
+static bool retroarch_benchmark_report(const char *path)
+{
+   char line[1024];
+   video_frame_time_stats_t frame_stats;
+   long peak_rss_kib             = -1;
+   bool netplay                  = false;
+   bool ret                      = false;
+   RFILE *file                   = NULL;
+   settings_t *settings          = config_get_ptr();
+   rarch_system_info_t *system   = runloop_get_system_info();
+   retro_time_t run_time         = cpu_features_get_time_usec()
+      - runloop_benchmark.run_start;
+#if defined(__linux__) || defined(__APPLE__)
+   struct rusage usage;
+
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+   {
+#ifdef __APPLE__
+      /* Reported in bytes rather than kilobytes. */
+      peak_rss_kib = (long)(usage.ru_maxrss / 1024);
+#else
+      peak_rss_kib = (long)usage.ru_maxrss;
+#endif
+   }
+#endif
+#ifdef HAVE_NETWORKING
+   netplay = netplay_driver_ctl(RARCH_NETPLAY_CTL_IS_ENABLED, NULL);
+#endif
+
+   video_driver_get_frame_time_stats(&frame_stats);
+
+   file = filestream_open(path, RFILE_MODE_WRITE, -1);
+
+   if (!file)
+   {
+      RARCH_ERR("[Benchmark]: Failed to open report \"%s\".\n", path);
+      return false;
+   }
+
+   snprintf(line, sizeof(line), ",\n  \"frames\":%llu,\n"
+         "  \"runTimeUsec\":%lld,\n"
+         "  \"fps\":%.3f,\n"
+         "  \"startupTimeUsec\":%lld,\n"
+         "  \"frameTimeUsec\":{\"p50\":%lld,\"p95\":%lld,\"p99\":%lld},\n"
+         "  \"droppedFrames\":%llu,\n"
+         "  \"peakRssKiB\":%ld,\n"
+         "  \"rewind\":%s,\n"
+         "  \"netplay\":%s,\n"
+         "  \"runAhead\":%s,\n"
+         "  \"perfCounters\":{\n    \"frontend\":",
+         (unsigned long long)frame_stats.frames,
+         (long long)run_time,
+         run_time > 0 ? (double)frame_stats.frames * 1000000.0 / run_time : 0.0,
+         (long long)runloop_benchmark.startup_time,
+         (long long)frame_stats.p50,
+         (long long)frame_stats.p95,
+         (long long)frame_stats.p99,
+         (unsigned long long)frame_stats.dropped,
+         peak_rss_kib,
+         settings->bools.rewind_enable ? "true" : "false",
+         netplay ? "true" : "false",
+         settings->bools.run_ahead_enabled ? "true" : "false");
+
+   ret = retroarch_benchmark_write(file, "{\n  \"core\":")
+      && retroarch_benchmark_write_string(file, system->info.library_name)
+      && retroarch_benchmark_write(file, ",\n  \"coreVersion\":")
+      && retroarch_benchmark_write_string(file,
+            system->info.library_version)
+      && retroarch_benchmark_write(file, ",\n  \"content\":")
+      && retroarch_benchmark_write_string(file, path_get(RARCH_PATH_CONTENT))
+      && retroarch_benchmark_write(file, line)
+      && retroarch_benchmark_write_counters(file,
+            retro_get_perf_counter_rarch(), retro_get_perf_count_rarch())
+      && retroarch_benchmark_write(file, ",\n    \"core\":")
+      && retroarch_benchmark_write_counters(file,
+            retro_get_perf_counter_libretro(), retro_get_perf_count_libretro())
+      && retroarch_benchmark_write(file, "\n  }\n}\n");
+   filestream_close(file);
+
+   if (!ret)
+   {
+      RARCH_ERR("[Benchmark]: Failed to write report \"%s\".\n", path);
+      return false;
+   }
+
+   RARCH_LOG("[Benchmark]: %llu frames in %.3f s (%.2f FPS), "
+         "report written to \"%s\".\n",
+         (unsigned long long)frame_stats.frames,
+         run_time / 1000000.0,
+         run_time > 0 ? (double)frame_stats.frames * 1000000.0 / run_time : 0.0,
+         path);
+   return true;
 }
 
 static bool retroarch_init_state(void)
@@ -1205,7 +1469,8 @@ static void retroarch_main_init_media(void)
  **/
 bool retroarch_main_init(int argc, char *argv[])
 {
-   bool init_failed = false;
+   bool init_failed        = false;
+   retro_time_t init_start = cpu_features_get_time_usec();
 
    retroarch_init_state();
 
@@ -1240,6 +1505,7 @@ bool retroarch_main_init(int argc, char *argv[])
 
    retroarch_validate_cpu_features();
    config_load();
+   retroarch_benchmark_apply_settings();
 
    rarch_ctl(RARCH_CTL_TASK_INIT, NULL);
 
@@ -1277,6 +1543,9 @@ bool retroarch_main_init(int argc, char *argv[])
       }
    }
 
+   /* Core and game overrides reload the configuration. */
+   retroarch_benchmark_apply_settings();
+
    drivers_init(DRIVERS_CMD_ALL);
    command_event(CMD_EVENT_COMMAND_INIT, NULL);
    command_event(CMD_EVENT_REMOTE_INIT, NULL);
@@ -1292,6 +1561,13 @@ bool retroarch_main_init(int argc, char *argv[])
    rarch_error_on_init     = false;
    rarch_is_inited         = true;
 
+   if (!string_is_empty(runloop_benchmark.path))
+   {
+      runloop_benchmark.run_start    = cpu_features_get_time_usec();
+      runloop_benchmark.startup_time = runloop_benchmark.run_start
+         - init_start;
+   }
+
    return true;
 
 error:
@@ -1420,8 +1696,12 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          command_event(CMD_EVENT_LOG_FILE_DEINIT, NULL);
 
          rarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
+#ifdef HAVE_FRAME_TRACE
+         frame_trace_deinit();
+#endif
          global_free();
          rarch_ctl(RARCH_CTL_DATA_DEINIT, NULL);
+         file_archive_deinit();
          config_free();
          break;
       case RARCH_CTL_PREINIT:
@@ -1437,6 +1717,8 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
       case RARCH_CTL_MAIN_DEINIT:
          if (!rarch_is_inited)
             return false;
+         if (!string_is_empty(runloop_benchmark.path))
+            retroarch_benchmark_report(runloop_benchmark.path);
          command_event(CMD_EVENT_NETPLAY_DEINIT, NULL);
          command_event(CMD_EVENT_COMMAND_DEINIT, NULL);
          command_event(CMD_EVENT_REMOTE_DEINIT, NULL);
@@ -1480,6 +1762,16 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          }
          rarch_ctl(RARCH_CTL_HTTPSERVER_INIT, NULL);
          retroarch_msg_queue_init();
+         file_archive_init();
+         {
+            /* Let a solid 7z block stay cached between reads
+             * as long as it takes up at most a quarter of RAM. */
+            uint64_t memory = frontend_driver_get_total_memory() / 4;
+
+            if (memory)
+               file_archive_set_cache_limit(memory < (size_t)-1
+                     ? (size_t)memory : (size_t)-1);
+         }
          break;
       case RARCH_CTL_IS_SRAM_LOAD_DISABLED:
          return rarch_is_sram_load_disabled;
@@ -1642,9 +1934,15 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          break;
       case RARCH_CTL_SET_PERFCNT_ENABLE:
          runloop_perfcnt_enable = true;
+#ifdef HAVE_FRAME_TRACE
+         frame_trace_set_enabled(true);
+#endif
          break;
       case RARCH_CTL_UNSET_PERFCNT_ENABLE:
          runloop_perfcnt_enable = false;
+#ifdef HAVE_FRAME_TRACE
+         frame_trace_set_enabled(false);
+#endif
          break;
       case RARCH_CTL_IS_PERFCNT_ENABLE:
          return runloop_perfcnt_enable;
@@ -1695,6 +1993,9 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          break;
       case RARCH_CTL_STATE_FREE:
          runloop_perfcnt_enable            = false;
+#ifdef HAVE_FRAME_TRACE
+         frame_trace_set_enabled(false);
+#endif
          runloop_idle                      = false;
          runloop_paused                    = false;
          runloop_slowmotion                = false;
@@ -2835,9 +3136,12 @@ static enum runloop_state runloop_check_state(
 
       s[0] = '\0';
 
+      performance_counter_init(rewind_perf, "rewind");
+      performance_counter_start_plus(runloop_perfcnt_enable, rewind_perf);
       if (state_manager_check_rewind(runloop_cmd_press(current_input, RARCH_REWIND),
             settings->uints.rewind_granularity, runloop_paused, s, sizeof(s), &t))
          runloop_msg_queue_push(s, 0, t, true);
+      performance_counter_stop_plus(runloop_perfcnt_enable, rewind_perf);
    }
 
    /* Checks if slowmotion toggle/hold was being pressed and/or held. */
@@ -2978,6 +3282,110 @@ void runloop_unset(enum runloop_action action)
    }
 }
 
+#define FRAME_DELAY_MAX          15
+#define FRAME_DELAY_AUTO_WINDOW  32
+
+static const char *frame_delay_auto_counter_names[FRAME_DELAY_MAX + 1] = {
+   "frame_delay_0ms",  "frame_delay_1ms",  "frame_delay_2ms",
+   "frame_delay_3ms",  "frame_delay_4ms",  "frame_delay_5ms",
+   "frame_delay_6ms",  "frame_delay_7ms",  "frame_delay_8ms",
+   "frame_delay_9ms",  "frame_delay_10ms", "frame_delay_11ms",
+   "frame_delay_12ms", "frame_delay_13ms", "frame_delay_14ms",
+   "frame_delay_15ms"
+};
+
+static struct
+{
+   /* Time the core took to produce each of the last frames. */
+   retro_time_t busy[FRAME_DELAY_AUTO_WINDOW];
+   retro_time_t last_start;
+   unsigned count;
+   unsigned delay;
+   /* Frames left before the delay may grow again after a spike. */
+   unsigned cooldown;
+   /* Histogram of the chosen delay; each run is one frame,
+    * its ticks are the perf counter ticks the core run took. */
+   struct retro_perf_counter histogram[FRAME_DELAY_MAX + 1];
+} frame_delay_auto;
+
+/**
+ * runloop_frame_delay_auto_update:
+ * @start              : Time the core started running this frame.
+ * @end                : Time the core handed its frame over.
+ * @ticks              : Perf counter ticks the core run took.
+ * @refresh_rate       : Display refresh rate.
+ *
+ * Picks the frame delay for the next frame. It backs off right away
+ * when a frame ran late, and otherwise moves towards the largest delay
+ * leaving room for the slowest frame of the last window, growing by
+ * at most a millisecond per window.
+ **/
+static void runloop_frame_delay_auto_update(retro_time_t start,
+      retro_time_t end, retro_perf_tick_t ticks, float refresh_rate)
+{
+   unsigned i;
+   retro_time_t period, headroom, slowest, interval, target;
+   struct retro_perf_counter *counter = NULL;
+   retro_time_t busy                  = end - start;
+
+   if (refresh_rate <= 0.0f)
+      return;
+
+   period   = (retro_time_t)(1000000.0f / refresh_rate);
+   /* Leave a quarter of the frame for rendering and presenting. */
+   headroom = period / 4;
+   interval = frame_delay_auto.last_start
+      ? start - frame_delay_auto.last_start : 0;
+
+   frame_delay_auto.last_start = start;
+   frame_delay_auto.busy[frame_delay_auto.count++
+      % FRAME_DELAY_AUTO_WINDOW] = busy;
+
+   counter = &frame_delay_auto.histogram[frame_delay_auto.delay];
+   performance_counter_init((*counter),
+         frame_delay_auto_counter_names[frame_delay_auto.delay]);
+   counter->call_cnt++;
+   counter->total += ticks;
+
+   /* Missed a refresh, or this frame alone leaves no room for the
+    * current delay. Longer gaps come from pausing, not from us. */
+   if (frame_delay_auto.delay && (
+            (interval > period * 3 / 2 && interval < period * 4) ||
+            (retro_time_t)frame_delay_auto.delay * 1000 + busy
+            > period - headroom))
+   {
+      frame_delay_auto.delay   /= 2;
+      frame_delay_auto.cooldown = FRAME_DELAY_AUTO_WINDOW * 2;
+      return;
+   }
+
+   if (frame_delay_auto.cooldown)
+   {
+      frame_delay_auto.cooldown--;
+      return;
+   }
+
+   if (frame_delay_auto.count % FRAME_DELAY_AUTO_WINDOW)
+      return;
+
+   slowest = 0;
+   for (i = 0; i < FRAME_DELAY_AUTO_WINDOW; i++)
+      if (frame_delay_auto.busy[i] > slowest)
+         slowest = frame_delay_auto.busy[i];
+
+   target = (period - headroom - slowest) / 1000;
+
+   if (target < 0)
+      target = 0;
+   else if (target > FRAME_DELAY_MAX)
+      target = FRAME_DELAY_MAX;
+
+   if (target < (retro_time_t)frame_delay_auto.delay)
+      frame_delay_auto.delay = (unsigned)target;
+   else if (target > (retro_time_t)frame_delay_auto.delay)
+      frame_delay_auto.delay++;
+}
+
 /**
  * runloop_iterate:
  *
@@ -2990,6 +3398,8 @@ void runloop_unset(enum runloop_action action)
 int runloop_iterate(unsigned *sleep_ms)
 {
    unsigned i;
+   retro_time_t frame_start                     = 0;
+   retro_perf_tick_t frame_start_ticks          = 0;
    bool input_nonblock_state                    = input_driver_is_nonblock_state();
    settings_t *settings                         = config_get_ptr();
    unsigned max_users                           = *(input_driver_get_uint(INPUT_ACTION_MAX_USERS));
@@ -3020,6 +3430,11 @@ int runloop_iterate(unsigned *sleep_ms)
       runloop_frame_time.callback(delta);
    }
 
+#ifdef HAVE_MENU
+   /* Catch up with shaders the video driver finished building. */
+   menu_shader_manager_poll();
+#endif
+
    switch ((enum runloop_state)
          runloop_check_state(
             settings,
@@ -3049,6 +3464,8 @@ int runloop_iterate(unsigned *sleep_ms)
          break;
    }
 
+   FRAME_TRACE_NEXT_FRAME();
+
    if (runloop_autosave)
       autosave_lock();
 
@@ -3070,10 +3487,52 @@ int runloop_iterate(unsigned *sleep_ms)
       input_push_analog_dpad(auto_binds,    dpad_mode);
    }
 
-   if ((settings->uints.video_frame_delay > 0) && !input_nonblock_state)
+   if (settings->bools.video_frame_delay_auto && !input_nonblock_state)
+   {
+      if (frame_delay_auto.delay > 0)
+      {
+         FRAME_TRACE_BEGIN(FRAME_TRACE_SLEEP);
+         retro_sleep(frame_delay_auto.delay);
+         FRAME_TRACE_END(FRAME_TRACE_SLEEP);
+      }
+      frame_start       = cpu_features_get_time_usec();
+      frame_start_ticks = cpu_features_get_perf_counter();
+   }
+   else if ((settings->uints.video_frame_delay > 0) && !input_nonblock_state)
+   {
+      FRAME_TRACE_BEGIN(FRAME_TRACE_SLEEP);
       retro_sleep(settings->uints.video_frame_delay);
+      FRAME_TRACE_END(FRAME_TRACE_SLEEP);
+   }
+
+   FRAME_TRACE_BEGIN(FRAME_TRACE_CORE_RUN);
+   performance_counter_init(core_run_perf, "core_run");
+   performance_counter_start_plus(runloop_perfcnt_enable, core_run_perf);
+
+   /* Movies record and replay input per poll, which
+    * the extra run-ahead frames would throw off. */
+   if (settings->bools.run_ahead_enabled &&
+         !bsv_movie_ctl(BSV_MOVIE_CTL_IS_INITED, NULL))
+      core_run_ahead(settings->uints.run_ahead_frames,
+            runloop_perfcnt_enable);
+   else
+      core_run();
+   performance_counter_stop_plus(runloop_perfcnt_enable, core_run_perf);
+   FRAME_TRACE_END(FRAME_TRACE_CORE_RUN);
 
-   core_run();
+   if (frame_start)
+   {
+      retro_perf_tick_t ticks = cpu_features_get_perf_counter()
+         - frame_start_ticks;
+      retro_time_t frame_end  = video_driver_get_frame_time_last();
+
+      /* The core didn't hand over a frame, count all of it. */
+      if (frame_end < frame_start)
+         frame_end = cpu_features_get_time_usec();
+
+      runloop_frame_delay_auto_update(frame_start, frame_end, ticks,
+            settings->floats.video_refresh_rate);
+   }
 
 #ifdef HAVE_CHEEVOS
    if (runloop_check_cheevos())
@@ -55,6 +55,9 @@
 #include <retro_miscellaneous.h>
 #include <streams/file_stream.h>
 #include <retro_assert.h>
+#ifdef HAVE_MMAP
+#include <memmap.h>
+#endif
 
 #include <lists/string_list.h>
 #include <string/stdstring.h>
@@ -141,18 +144,51 @@ static bool _content_is_inited                                = false;
 static bool core_does_not_need_content                        = false;
 static uint32_t content_rom_crc                               = 0;
 
-static int content_file_read(const char *path, void **buf, ssize_t *length)
+static int content_file_read(const char *path, void **buf, ssize_t *length,
+      size_t *mapped)
 {
+#ifdef HAVE_MMAP
+   size_t len = 0;
+#endif
+
+   *mapped = 0;
+
 #ifdef HAVE_COMPRESSION
    if (path_contains_compressed_file(path))
    {
       if (file_archive_compressed_read(path, buf, NULL, length))
          return 1;
    }
+#endif
+#ifdef HAVE_MMAP
+   /* Map plain files rather than copying them to the heap.
+    * The pages are shared with the page cache, and a core writing
+    * to its buffer only gets private copies of the pages it touches. */
+   *buf = memmap_file_map(path, &len);
+   if (*buf)
+   {
+      *length = (ssize_t)len;
+      *mapped = len;
+      return 1;
+   }
 #endif
    return filestream_read_file(path, buf, length);
 }
 
+/* Releases a buffer returned by content_file_read. @mapped is the
+ * length it set, which outlives content patched to a shorter size. */
+static void content_file_free(void *buf, size_t mapped)
+{
+#ifdef HAVE_MMAP
+   if (mapped)
+   {
+      memmap_file_unmap(buf, mapped);
+      return;
+   }
+#endif
+   free(buf);
+}
+
 /**
  * content_load_init_wrap:
  * @args                 : Input arguments.
@@ -303,6 +339,8 @@ end:
  * @path         : buffer of the content file.
  * @buf          : size   of the content file.
  * @length       : size of the content file that has been read from.
+ * @mapped       : length of the file mapping behind @buf, or 0 when
+ *                 @buf is a heap allocation, see content_file_free.
  *
  * Read the content file. If read into memory, also performs soft patching
  * (see patch_content function) in case soft patching has not been
@@ -313,14 +351,14 @@ end:
 static bool load_content_into_memory(
       content_information_ctx_t *content_ctx,
       unsigned i, const char *path, void **buf,
-      ssize_t *length)
+      ssize_t *length, size_t *mapped)
 {
    uint8_t *ret_buf          = NULL;
 
    RARCH_LOG("%s: %s.\n",
          msg_hash_to_str(MSG_LOADING_CONTENT_FILE), path);
 
-   if (!content_file_read(path, (void**) &ret_buf, length))
+   if (!content_file_read(path, (void**) &ret_buf, length, mapped))
       return false;
 
    if (*length < 0)
@@ -338,7 +376,10 @@ static bool load_content_into_memory(
 
          /* Attempt to apply a patch. */
          if (!content_ctx->patch_is_blocked)
-            patch_content(
+         {
+            uint8_t *unpatched_buf = ret_buf;
+
+            if (!patch_content(
                   content_ctx->is_ips_pref,
                   content_ctx->is_bps_pref,
                   content_ctx->is_ups_pref,
@@ -346,7 +387,20 @@ static bool load_content_into_memory(
                   content_ctx->name_bps,
                   content_ctx->name_ups,
                   (uint8_t**)&ret_buf,
-                  (void*)length);
+                  (void*)length))
+            {
+               /* A patch went wrong halfway over the content. */
+               content_file_free(ret_buf, *mapped);
+               if (!content_file_read(path, (void**)&ret_buf, length, mapped))
+                  return false;
+            }
+            /* The patched content is a new heap buffer. */
+            else if (ret_buf != unpatched_buf)
+            {
+               content_file_free(unpatched_buf, *mapped);
+               *mapped = 0;
+            }
+         }
 
          content_rom_crc = encoding_crc32(0, ret_buf, *length);
 
@@ -503,7 +557,8 @@ static bool content_file_load(
       content_information_ctx_t *content_ctx,
       char **error_string,
       const struct retro_subsystem_info *special,
-      struct string_list *additional_path_allocs
+      struct string_list *additional_path_allocs,
+      size_t *mapped
       )
 {
    unsigned i;
@@ -542,7 +597,7 @@ static bool content_file_load(
 
          if (!load_content_into_memory(
                   content_ctx,
-                  i, path, (void**)&info[i].data, &len))
+                  i, path, (void**)&info[i].data, &len, &mapped[i]))
          {
             snprintf(msg, sizeof(msg),
                   "%s \"%s\".\n",
@@ -729,6 +784,7 @@ static bool content_file_init(
       char **error_string)
 {
    struct retro_game_info               *info = NULL;
+   size_t                             *mapped = NULL;
    bool ret                                   = 
       path_is_empty(RARCH_PATH_SUBSYSTEM) 
       ? true : false;
@@ -742,21 +798,28 @@ static bool content_file_init(
 
    info                   = (struct retro_game_info*)
       calloc(content->size, sizeof(*info));
+   mapped                 = (size_t*)calloc(content->size, sizeof(*mapped));
 
-   if (info)
+   if (info && mapped)
    {
       unsigned i;
       struct string_list *additional_path_allocs = string_list_new();
       ret = content_file_load(info, content, content_ctx, error_string,
-            special, additional_path_allocs);
+            special, additional_path_allocs, mapped);
       string_list_free(additional_path_allocs);
 
       for (i = 0; i < content->size; i++)
-         free((void*)info[i].data);
-
-      free(info);
+         content_file_free((void*)info[i].data, mapped[i]);
    }
 
+#ifdef HAVE_COMPRESSION
+   /* The core has its copy, don't keep the archive's around. */
+   file_archive_release_cache();
+#endif
+
+   free(info);
+   free(mapped);
+
    return ret;
 }
 
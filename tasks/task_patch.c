@@ -69,39 +69,25 @@ struct bps_data
    size_t modify_offset;
    size_t source_offset;
    size_t target_offset;
-   uint32_t modify_checksum;
-   uint32_t source_checksum;
-   uint32_t target_checksum;
-   size_t source_relative_offset;
-   size_t target_relative_offset;
    size_t output_offset;
+   bool invalid;
 };
 
-struct ups_data
-{
-   const uint8_t *patch_data;
-   const uint8_t *source_data; 
-   uint8_t *target_data;
-   unsigned patch_length;
-   unsigned source_length;
-   unsigned target_length;
-   unsigned patch_offset;
-   unsigned source_offset;
-   unsigned target_offset;
-   unsigned patch_checksum;
-   unsigned source_checksum;
-   unsigned target_checksum;
-};
-
+/* The patch functions write the target to @target_data, which holds
+ * *@target_length bytes. When @target_data is @source_data the patch
+ * is applied over the source. A target that does not fit, or a patch
+ * that cannot be applied over its own source, fails with
+ * PATCH_TARGET_TOO_SMALL before anything is written, and sets
+ * *@target_length to the size of the buffer it needs instead. */
 typedef enum patch_error (*patch_func_t)(const uint8_t*, size_t,
       const uint8_t*, size_t, uint8_t*, size_t*);
 
-static uint8_t bps_read(struct bps_data *bps)
+static uint32_t patch_read_le32(const uint8_t *data)
 {
-   uint8_t data         = bps->modify_data[bps->modify_offset++];
-   bps->modify_checksum = ~(encoding_crc32(
-         ~bps->modify_checksum, &data, 1));
-   return data;
+   return (uint32_t)data[0]
+      | ((uint32_t)data[1] <<  8)
+      | ((uint32_t)data[2] << 16)
+      | ((uint32_t)data[3] << 24);
 }
 
 static uint64_t bps_decode(struct bps_data *bps)
@@ -110,7 +96,16 @@ static uint64_t bps_decode(struct bps_data *bps)
 
    for (;;)
    {
-      uint8_t x  = bps_read(bps);
+      uint8_t x;
+
+      if (     bps->modify_offset >= bps->modify_length
+            || shift > ((uint64_t)1 << 56))
+      {
+         bps->invalid = true;
+         return 0;
+      }
+
+      x          = bps->modify_data[bps->modify_offset++];
       data      += (x & 0x7f) * shift;
       if (x & 0x80)
          break;
@@ -121,191 +116,295 @@ static uint64_t bps_decode(struct bps_data *bps)
    return data;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
-{
-   bps->target_data[bps->output_offset++] = data;
-   bps->target_checksum = ~(encoding_crc32(~bps->target_checksum, &data, 1));
-}
-
-static enum patch_error bps_apply_patch(
-      const uint8_t *modify_data, size_t modify_length,
-      const uint8_t *source_data, size_t source_length,
-      uint8_t *target_data, size_t *target_length)
+/* Copies a TargetCopy run. A run that starts less than @length bytes
+ * back repeats the bytes between @from and @to, so it is copied in
+ * chunks that never overlap, doubling as the repeated part grows. */
+static void bps_target_copy(uint8_t *target,
+      size_t from, size_t to, size_t length)
 {
-   size_t i;
-   uint32_t checksum;
-   size_t modify_source_size;
-   size_t modify_target_size;
-   size_t modify_markup_size;
-   struct bps_data bps;
-   uint32_t modify_source_checksum = 0;
-   uint32_t modify_target_checksum = 0;
-   uint32_t modify_modify_checksum = 0;
-
-   if (modify_length < 19)
-      return PATCH_PATCH_TOO_SMALL;
+   while (length)
+   {
+      size_t chunk = to - from;
 
-   bps.modify_data            = modify_data;
-   bps.source_data            = source_data;
-   bps.target_data            = target_data;
-   bps.modify_length          = modify_length;
-   bps.source_length          = source_length;
-   bps.target_length          = *target_length;
-   bps.modify_offset          = 0;
-   bps.source_offset          = 0;
-   bps.target_offset          = 0;
-   bps.modify_checksum        = ~0;
-   bps.source_checksum        = 0;
-   bps.target_checksum        = ~0;
-   bps.source_relative_offset = 0;
-   bps.target_relative_offset = 0;
-   bps.output_offset          = 0;
-
-   if (  (bps_read(&bps) != 'B') || 
-         (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') || 
-         (bps_read(&bps) != '1'))
-      return PATCH_PATCH_INVALID_HEADER;
+      if (chunk > length)
+         chunk = length;
 
-   modify_source_size  = bps_decode(&bps);
-   modify_target_size  = bps_decode(&bps);
-   modify_markup_size  = bps_decode(&bps);
+      memcpy(target + to, target + from, chunk);
+      to     += chunk;
+      length -= chunk;
+   }
+}
 
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
+/* Runs the patch actions, writing the target only when @apply is set.
+ * Every action is bounds checked either way. @overlap is set when a
+ * SourceCopy reads source bytes that an earlier action has already
+ * overwritten if the patch goes over its own source. */
+static enum patch_error bps_run_actions(struct bps_data *bps,
+      size_t actions_offset, bool apply, bool *overlap)
+{
+   bool in_place      = bps->target_data == bps->source_data;
 
-   if (modify_source_size > bps.source_length)
-      return PATCH_SOURCE_TOO_SMALL;
-   if (modify_target_size > bps.target_length)
-      return PATCH_TARGET_TOO_SMALL;
+   bps->modify_offset = actions_offset;
+   bps->source_offset = 0;
+   bps->target_offset = 0;
+   bps->output_offset = 0;
 
-   while (bps.modify_offset < bps.modify_length - 12)
+   while (bps->modify_offset < bps->modify_length)
    {
-      size_t length = bps_decode(&bps);
-      unsigned mode = length & 3;
+      uint64_t length = bps_decode(bps);
+      unsigned mode   = length & 3;
 
       length = (length >> 2) + 1;
 
+      if (     bps->invalid
+            || length > bps->target_length - bps->output_offset)
+         return PATCH_PATCH_INVALID;
+
       switch (mode)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (bps->output_offset + length > bps->source_length)
+               return PATCH_PATCH_INVALID;
+            /* Over its own source, these bytes are already in place. */
+            if (apply && !in_place)
+               memcpy(bps->target_data + bps->output_offset,
+                     bps->source_data + bps->output_offset, (size_t)length);
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > bps->modify_length - bps->modify_offset)
+               return PATCH_PATCH_INVALID;
+            if (apply)
+               memcpy(bps->target_data + bps->output_offset,
+                     bps->modify_data + bps->modify_offset, (size_t)length);
+            bps->modify_offset += (size_t)length;
             break;
 
          case SOURCE_COPY:
          case TARGET_COPY:
          {
-            int    offset = (int)bps_decode(&bps);
-            bool negative = offset & 1;
+            uint64_t offset = bps_decode(bps);
+            uint64_t delta  = offset >> 1;
+            size_t *base    = (mode == SOURCE_COPY)
+               ? &bps->source_offset : &bps->target_offset;
+            size_t limit    = (mode == SOURCE_COPY)
+               ? bps->source_length : bps->output_offset;
 
-            offset >>= 1;
+            if (bps->invalid)
+               return PATCH_PATCH_INVALID;
 
-            if (negative)
-               offset = -offset;
+            if (offset & 1)
+            {
+               if (delta > *base)
+                  return PATCH_PATCH_INVALID;
+               *base -= (size_t)delta;
+            }
+            else
+            {
+               if (delta > limit - *base)
+                  return PATCH_PATCH_INVALID;
+               *base += (size_t)delta;
+            }
 
             if (mode == SOURCE_COPY)
             {
-               bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
+               if (length > bps->source_length - bps->source_offset)
+                  return PATCH_PATCH_INVALID;
+               if (bps->source_offset < bps->output_offset)
+                  *overlap = true;
+               if (apply)
+                  memmove(bps->target_data + bps->output_offset,
+                        bps->source_data + bps->source_offset, (size_t)length);
+               bps->source_offset += (size_t)length;
             }
             else
             {
-               bps.target_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
+               /* Only bytes already written can be copied back. */
+               if (bps->target_offset >= bps->output_offset)
+                  return PATCH_PATCH_INVALID;
+               if (apply)
+                  bps_target_copy(bps->target_data, bps->target_offset,
+                        bps->output_offset, (size_t)length);
+               bps->target_offset += (size_t)length;
             }
             break;
          }
       }
+
+      bps->output_offset += (size_t)length;
    }
 
-   for (i = 0; i < 32; i += 8)
-      modify_source_checksum |= bps_read(&bps) << i;
-   for (i = 0; i < 32; i += 8)
-      modify_target_checksum |= bps_read(&bps) << i;
+   if (bps->output_offset != bps->target_length)
+      return PATCH_PATCH_INVALID;
+
+   return PATCH_SUCCESS;
+}
+
+static enum patch_error bps_apply_patch(
+      const uint8_t *modify_data, size_t modify_length,
+      const uint8_t *source_data, size_t source_length,
+      uint8_t *target_data, size_t *target_length)
+{
+   enum patch_error err;
+   size_t actions_offset;
+   uint64_t modify_source_size;
+   uint64_t modify_target_size;
+   uint64_t modify_markup_size;
+   struct bps_data bps;
+   uint32_t modify_source_checksum;
+   uint32_t modify_target_checksum;
+   uint32_t modify_modify_checksum;
+   bool overlap                    = false;
+   bool in_place                   = target_data == source_data;
 
-   checksum = ~bps.modify_checksum;
-   for (i = 0; i < 32; i += 8)
-      modify_modify_checksum |= bps_read(&bps) << i;
+   if (modify_length < 19)
+      return PATCH_PATCH_TOO_SMALL;
 
-   bps.source_checksum = encoding_crc32(0,
-         bps.source_data, bps.source_length);
-   bps.target_checksum = ~bps.target_checksum;
+   if (memcmp(modify_data, "BPS1", 4))
+      return PATCH_PATCH_INVALID_HEADER;
 
-   if (bps.source_checksum != modify_source_checksum)
-      return PATCH_SOURCE_CHECKSUM_INVALID;
+   /* The three checksums at the end are read up front, so the
+    * actions are decoded without CRC bookkeeping. */
+   modify_source_checksum = patch_read_le32(modify_data + modify_length - 12);
+   modify_target_checksum = patch_read_le32(modify_data + modify_length - 8);
+   modify_modify_checksum = patch_read_le32(modify_data + modify_length - 4);
 
-   if (bps.target_checksum != modify_target_checksum)
-      return PATCH_TARGET_CHECKSUM_INVALID;
+   bps.modify_data            = modify_data;
+   bps.source_data            = source_data;
+   bps.target_data            = target_data;
+   bps.modify_length          = modify_length - 12;
+   bps.source_length          = source_length;
+   bps.target_length          = 0;
+   bps.modify_offset          = 4;
+   bps.invalid                = false;
 
-   if (checksum != modify_modify_checksum)
-      return PATCH_PATCH_CHECKSUM_INVALID;
+   modify_source_size  = bps_decode(&bps);
+   modify_target_size  = bps_decode(&bps);
+   modify_markup_size  = bps_decode(&bps);
 
-   *target_length = modify_target_size;
+   if (     bps.invalid
+         || modify_markup_size > bps.modify_length - bps.modify_offset
+         || modify_target_size > (size_t)-2)
+      return PATCH_PATCH_INVALID;
 
-   return PATCH_SUCCESS;
-}
+   actions_offset = bps.modify_offset + (size_t)modify_markup_size;
 
-static uint8_t ups_patch_read(struct ups_data *data) 
-{
-   if (data && data->patch_offset < data->patch_length) 
+   if (encoding_crc32(0, modify_data, modify_length - 4)
+         != modify_modify_checksum)
+      return PATCH_PATCH_CHECKSUM_INVALID;
+
+   if (modify_source_size > source_length)
+      return PATCH_SOURCE_TOO_SMALL;
+
+   if (modify_target_size > *target_length)
    {
-      uint8_t n = data->patch_data[data->patch_offset++];
-      data->patch_checksum = 
-         ~(encoding_crc32(~data->patch_checksum, &n, 1));
-      return n;
+      *target_length = (size_t)modify_target_size;
+      return PATCH_TARGET_TOO_SMALL;
    }
-   return 0x00;
-}
 
-static uint8_t ups_source_read(struct ups_data *data) 
-{
-   if (data && data->source_offset < data->source_length) 
+   bps.target_length = (size_t)modify_target_size;
+
+   /* Over its own source the patch must be known to be good
+    * before the first byte is written. */
+   if (in_place)
    {
-      uint8_t n = data->source_data[data->source_offset++];
-      data->source_checksum =  
-         ~(encoding_crc32(~data->source_checksum, &n, 1));
-      return n;
+      err = bps_run_actions(&bps, actions_offset, false, &overlap);
+      if (err != PATCH_SUCCESS)
+         return err;
+
+      if (overlap)
+      {
+         *target_length = bps.target_length;
+         return PATCH_TARGET_TOO_SMALL;
+      }
    }
-   return 0x00;
+
+   if (encoding_crc32(0, source_data, source_length)
+         != modify_source_checksum)
+      return PATCH_SOURCE_CHECKSUM_INVALID;
+
+   err = bps_run_actions(&bps, actions_offset, true, &overlap);
+   if (err != PATCH_SUCCESS)
+      return err;
+
+   if (encoding_crc32(0, target_data, bps.target_length)
+         != modify_target_checksum)
+      return PATCH_TARGET_CHECKSUM_INVALID;
+
+   *target_length = bps.target_length;
+
+   return PATCH_SUCCESS;
 }
 
-static void ups_target_write(struct ups_data *data, uint8_t n) 
+static uint64_t ups_decode(const uint8_t *data, size_t length,
+      size_t *offset, bool *invalid)
 {
+   uint64_t value = 0, shift = 1;
 
-   if (data && data->target_offset < data->target_length) 
+   for (;;)
    {
-      data->target_data[data->target_offset] = n;
-      data->target_checksum = 
-         ~(encoding_crc32(~data->target_checksum, &n, 1));
+      uint8_t x;
+
+      if (*offset >= length || shift > ((uint64_t)1 << 56))
+      {
+         *invalid = true;
+         return 0;
+      }
+
+      x      = data[(*offset)++];
+      value += (x & 0x7f) * shift;
+      if (x & 0x80)
+         break;
+      shift <<= 7;
+      value += shift;
    }
 
-   if (data)
-      data->target_offset++;
+   return value;
 }
 
-static uint64_t ups_decode(struct ups_data *data) 
+/* Runs the XOR records between @patch_offset and @patch_end over
+ * @targetdata, or only checks them when @targetdata is NULL. */
+static enum patch_error ups_run_records(const uint8_t *patchdata,
+      size_t patch_offset, size_t patch_end,
+      uint8_t *targetdata, size_t target_length)
 {
-   uint64_t offset = 0, shift = 1;
-   while (true) 
+   size_t target_offset = 0;
+   bool invalid         = false;
+
+   while (patch_offset < patch_end)
    {
-      uint8_t x = ups_patch_read(data);
-      offset   += (x & 0x7f) * shift;
+      uint64_t length = ups_decode(patchdata, patch_end, &patch_offset, &invalid);
 
-      if (x & 0x80) 
-         break;
-      shift <<= 7;
-      offset += shift;
+      if (invalid)
+         return PATCH_PATCH_INVALID;
+
+      if (length < target_length - target_offset)
+         target_offset += (size_t)length;
+      else
+         target_offset  = target_length;
+
+      for (;;)
+      {
+         uint8_t patch_xor;
+
+         if (patch_offset >= patch_end)
+            return PATCH_PATCH_INVALID;
+
+         patch_xor = patchdata[patch_offset++];
+
+         if (target_offset < target_length)
+         {
+            if (targetdata)
+               targetdata[target_offset] ^= patch_xor;
+            target_offset++;
+         }
+
+         if (patch_xor == 0)
+            break;
+      }
    }
-   return offset;
+
+   return PATCH_SUCCESS;
 }
 
 static enum patch_error ups_apply_patch(
@@ -313,127 +412,98 @@ static enum patch_error ups_apply_patch(
       const uint8_t *sourcedata, size_t sourcelength,
       uint8_t *targetdata, size_t *targetlength)
 {
-   size_t i;
-   struct ups_data data;
-   unsigned source_read_length;
-   unsigned target_read_length;
-   uint32_t patch_result_checksum;
-   uint32_t patch_read_checksum  = 0;
-   uint32_t source_read_checksum = 0;
-   uint32_t target_read_checksum = 0;
-
-   data.patch_data      = patchdata;
-   data.source_data     = sourcedata;
-   data.target_data     = targetdata;
-   data.patch_length    = (unsigned)patchlength;
-   data.source_length   = (unsigned)sourcelength;
-   data.target_length   = (unsigned)*targetlength;
-   data.patch_offset    = 0;
-   data.source_offset   = 0;
-   data.target_offset   = 0;
-   data.patch_checksum  = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
-
-   if (data.patch_length < 18) 
-      return PATCH_PATCH_INVALID;
+   uint64_t source_read_length;
+   uint64_t target_read_length;
+   uint32_t source_read_checksum;
+   uint32_t target_read_checksum;
+   uint32_t patch_read_checksum;
+   uint32_t source_checksum;
+   uint32_t target_checksum;
+   enum patch_error err;
+   size_t target_length;
+   size_t patch_end;
+   size_t patch_offset  = 4;
+   bool invalid         = false;
 
-   if (
-         (ups_patch_read(&data) != 'U') ||
-         (ups_patch_read(&data) != 'P') ||
-         (ups_patch_read(&data) != 'S') ||
-         (ups_patch_read(&data) != '1')
-      )
+   if (patchlength < 18 || memcmp(patchdata, "UPS1", 4))
       return PATCH_PATCH_INVALID;
 
-   source_read_length = (unsigned)ups_decode(&data);
-   target_read_length = (unsigned)ups_decode(&data);
+   patch_end            = patchlength - 12;
+   source_read_checksum = patch_read_le32(patchdata + patchlength - 12);
+   target_read_checksum = patch_read_le32(patchdata + patchlength - 8);
+   patch_read_checksum  = patch_read_le32(patchdata + patchlength - 4);
 
-   if (     (data.source_length != source_read_length)
-         && (data.source_length != target_read_length)) 
-      return PATCH_SOURCE_INVALID;
+   source_read_length   = ups_decode(patchdata, patch_end, &patch_offset, &invalid);
+   target_read_length   = ups_decode(patchdata, patch_end, &patch_offset, &invalid);
 
-   *targetlength = (data.source_length == source_read_length ?
-         target_read_length : source_read_length);
+   if (invalid)
+      return PATCH_PATCH_INVALID;
 
-   if (data.target_length < *targetlength) 
-      return PATCH_TARGET_TOO_SMALL;
+   if (encoding_crc32(0, patchdata, patchlength - 4) != patch_read_checksum)
+      return PATCH_PATCH_INVALID;
 
-   data.target_length = (unsigned)*targetlength;
+   /* UPS patches go both ways, the source tells which. Its size
+    * settles the target size; when both sizes are the same, the
+    * checksum settles the target checksum. */
+   if (sourcelength == source_read_length)
+      target_length = (size_t)target_read_length;
+   else if (sourcelength == target_read_length)
+      target_length = (size_t)source_read_length;
+   else
+      return PATCH_SOURCE_INVALID;
 
-   while (data.patch_offset < data.patch_length - 12) 
+   if (*targetlength < target_length)
    {
-      unsigned length = (unsigned)ups_decode(&data);
-      while (length--) 
-         ups_target_write(&data, ups_source_read(&data));
-      while (true) 
-      {
-         uint8_t patch_xor = ups_patch_read(&data);
-         ups_target_write(&data, patch_xor ^ ups_source_read(&data));
-         if (patch_xor == 0)
-            break;
-      }
+      *targetlength = target_length;
+      return PATCH_TARGET_TOO_SMALL;
    }
 
-   while (data.source_offset < data.source_length) 
-      ups_target_write(&data, ups_source_read(&data));
-   while (data.target_offset < data.target_length) 
-      ups_target_write(&data, ups_source_read(&data));
-
+   /* Check the records before writing any, the target may be
+    * the source. */
+   err = ups_run_records(patchdata, patch_offset, patch_end,
+         NULL, target_length);
+   if (err != PATCH_SUCCESS)
+      return err;
+
+   source_checksum = encoding_crc32(0, sourcedata, sourcelength);
+
+   if (     source_checksum == source_read_checksum
+         && sourcelength    == source_read_length)
+      target_checksum = target_read_checksum;
+   else if (source_checksum == target_read_checksum
+         && sourcelength    == target_read_length)
+      target_checksum = source_read_checksum;
+   else
+      return PATCH_SOURCE_INVALID;
 
-   for (i = 0; i < 4; i++) 
-      source_read_checksum |= ups_patch_read(&data) << (i * 8);
-   for (i = 0; i < 4; i++) 
-      target_read_checksum |= ups_patch_read(&data) << (i * 8);
+   /* The target starts out as the source, cut or padded with zeroes
+    * to size; the patch then only XORs the bytes that differ. Over
+    * its own source, the unchanged runs are not touched at all. */
+   if (targetdata != sourcedata)
+   {
+      size_t copy = sourcelength < target_length
+         ? sourcelength : target_length;
 
-   patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum  = ~data.source_checksum;
-   data.target_checksum  = ~data.target_checksum;
+      memcpy(targetdata, sourcedata, copy);
+      memset(targetdata + copy, 0, target_length - copy);
+   }
 
-   for (i = 0; i < 4; i++) 
-      patch_read_checksum |= ups_patch_read(&data) << (i * 8);
+   ups_run_records(patchdata, patch_offset, patch_end,
+         targetdata, target_length);
 
-   if (patch_result_checksum != patch_read_checksum) 
-      return PATCH_PATCH_INVALID;
+   if (encoding_crc32(0, targetdata, target_length) != target_checksum)
+      return PATCH_TARGET_CHECKSUM_INVALID;
 
-   if (data.source_checksum == source_read_checksum
-         && data.source_length == source_read_length) 
-   {
-      if (data.target_checksum == target_read_checksum
-            && data.target_length == target_read_length) 
-         return PATCH_SUCCESS;
-      return PATCH_TARGET_INVALID;
-   } 
-   else if (data.source_checksum == target_read_checksum
-         && data.source_length == target_read_length) 
-   {
-      if (data.target_checksum == source_read_checksum
-            && data.target_length == source_read_length) 
-         return PATCH_SUCCESS;
-      return PATCH_TARGET_INVALID;
-   } 
+   *targetlength = target_length;
 
-   return PATCH_SOURCE_INVALID;
+   return PATCH_SUCCESS;
 }
 
-static enum patch_error ips_apply_patch(
+static enum patch_error ips_run_records(
       const uint8_t *patchdata, size_t patchlen,
-      const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+      uint8_t *targetdata, size_t *needed, size_t *truncate)
 {
-   uint32_t offset = 5;
-
-   if (patchlen < 8 ||
-         patchdata[0] != 'P' ||
-         patchdata[1] != 'A' ||
-         patchdata[2] != 'T' ||
-         patchdata[3] != 'C' ||
-         patchdata[4] != 'H')
-      return PATCH_PATCH_INVALID;
-
-   memcpy(targetdata, sourcedata, sourcelength);
-
-   *targetlength = sourcelength;
+   size_t offset = 5;
 
    for (;;)
    {
@@ -456,7 +526,7 @@ static enum patch_error ips_apply_patch(
             uint32_t size = patchdata[offset++] << 16;
             size |= patchdata[offset++] << 8;
             size |= patchdata[offset++] << 0;
-            *targetlength = size;
+            *truncate = size;
             return PATCH_SUCCESS;
          }
       }
@@ -472,8 +542,9 @@ static enum patch_error ips_apply_patch(
          if (offset > patchlen - length)
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset++];
+         if (targetdata)
+            memcpy(targetdata + address, patchdata + offset, length);
+         offset += length;
       }
       else /* RLE */
       {
@@ -486,67 +557,130 @@ static enum patch_error ips_apply_patch(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset];
-
+         if (targetdata)
+            memset(targetdata + address, patchdata[offset], length);
          offset++;
       }
 
-      if (address > *targetlength)
-         *targetlength = address;
+      if (address + length > *needed)
+         *needed = address + length;
    }
 
    return PATCH_PATCH_INVALID;
 }
 
+static enum patch_error ips_apply_patch(
+      const uint8_t *patchdata, size_t patchlen,
+      const uint8_t *sourcedata, size_t sourcelength,
+      uint8_t *targetdata, size_t *targetlength)
+{
+   enum patch_error err;
+   size_t needed   = sourcelength;
+   size_t truncate = (size_t)-1;
+
+   if (patchlen < 8 ||
+         patchdata[0] != 'P' ||
+         patchdata[1] != 'A' ||
+         patchdata[2] != 'T' ||
+         patchdata[3] != 'C' ||
+         patchdata[4] != 'H')
+      return PATCH_PATCH_INVALID;
+
+   /* Size the target and check the records before writing any. */
+   err = ips_run_records(patchdata, patchlen, NULL, &needed, &truncate);
+   if (err != PATCH_SUCCESS)
+      return err;
+
+   if (truncate != (size_t)-1 && truncate > needed)
+      needed = truncate;
+
+   if (needed > *targetlength)
+   {
+      *targetlength = needed;
+      return PATCH_TARGET_TOO_SMALL;
+   }
+
+   if (targetdata != sourcedata)
+      memcpy(targetdata, sourcedata, sourcelength);
+   memset(targetdata + sourcelength, 0, needed - sourcelength);
+
+   ips_run_records(patchdata, patchlen, targetdata, &needed, &truncate);
+
+   *targetlength = (truncate != (size_t)-1) ? truncate : needed;
+
+   return PATCH_SUCCESS;
+}
+
+/* @intact is cleared when a patch that failed on its last check
+ * had already been applied over @buf, which then has to be read
+ * again. */
 static bool apply_patch_content(uint8_t **buf,
       ssize_t *size, const char *patch_desc, const char *patch_path,
-      patch_func_t func, void *patch_data, ssize_t patch_size)
+      patch_func_t func, void *patch_data, ssize_t patch_size,
+      bool *intact)
 {
    enum patch_error err     = PATCH_UNKNOWN;
    ssize_t ret_size         = *size;
    uint8_t *ret_buf         = *buf;
-   size_t target_size       = ret_size * 4; /* Just to be sure. */
-   uint8_t *patched_content = (uint8_t*)malloc(target_size);
+   size_t target_size       = ret_size;
+   uint8_t *patched_content = NULL;
 
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
          patch_desc, patch_path);
 
-   if (!patched_content)
+   /* Patch over the content itself when the target fits in it:
+    * no second buffer, and the runs the patch leaves unchanged are
+    * not even copied. Otherwise the patch asks for a new buffer. */
+   err = func((const uint8_t*)patch_data, patch_size, ret_buf,
+         ret_size, ret_buf, &target_size);
+
+   if (err == PATCH_TARGET_TOO_SMALL)
    {
-      RARCH_ERR("%s\n",
-            msg_hash_to_str(MSG_FAILED_TO_ALLOCATE_MEMORY_FOR_PATCHED_CONTENT));
+      patched_content = (uint8_t*)malloc(target_size + 1);
 
-      *buf  = ret_buf;
-      *size = ret_size;
+      if (!patched_content)
+      {
+         RARCH_ERR("%s\n",
+               msg_hash_to_str(MSG_FAILED_TO_ALLOCATE_MEMORY_FOR_PATCHED_CONTENT));
+         return false;
+      }
 
-      return false;
+      err = func((const uint8_t*)patch_data, patch_size, ret_buf,
+            ret_size, patched_content, &target_size);
    }
-
-   err = func((const uint8_t*)patch_data, patch_size, ret_buf,
-         ret_size, patched_content, &target_size);
+   else if (err == PATCH_TARGET_CHECKSUM_INVALID)
+      *intact = false;
 
    if (err == PATCH_SUCCESS)
    {
       RARCH_LOG("%s (%s).\n",
             msg_hash_to_str(MSG_FATAL_ERROR_RECEIVED_IN),
             patch_desc);
-      free(ret_buf);
-      *buf  = patched_content;
+
+      if (patched_content)
+         *buf = patched_content;
+
+      /* Keep the content NUL-terminated like a freshly read file. */
+      if (patched_content || target_size < (size_t)ret_size)
+         (*buf)[target_size] = '\0';
+
       *size = target_size;
    }
    else
+   {
       RARCH_ERR("%s %s: %s #%u\n",
             msg_hash_to_str(MSG_FAILED_TO_PATCH),
             patch_desc,
             msg_hash_to_str(MSG_ERROR),
             (unsigned)err);
+      free(patched_content);
+   }
 
    return true;
 }
 
 static bool try_bps_patch(bool allow_bps, const char *name_bps,
-      uint8_t **buf, ssize_t *size)
+      uint8_t **buf, ssize_t *size, bool *intact)
 {
    if (allow_bps && !string_is_empty(name_bps))
       if (path_is_valid(name_bps) && path_file_exists(name_bps))
@@ -562,7 +696,7 @@ static bool try_bps_patch(bool allow_bps, const char *name_bps,
          {
             ret                      = apply_patch_content(
                   buf, size, "BPS", name_bps,
-                  bps_apply_patch, patch_data, patch_size);
+                  bps_apply_patch, patch_data, patch_size, intact);
          }
 
          if (patch_data)
@@ -573,7 +707,7 @@ static bool try_bps_patch(bool allow_bps, const char *name_bps,
 }
 
 static bool try_ups_patch(bool allow_ups, const char *name_ups,
-      uint8_t **buf, ssize_t *size)
+      uint8_t **buf, ssize_t *size, bool *intact)
 {
    if (allow_ups && !string_is_empty(name_ups))
       if (path_is_valid(name_ups) && path_file_exists(name_ups))
@@ -589,7 +723,7 @@ static bool try_ups_patch(bool allow_ups, const char *name_ups,
          {
             ret                      = apply_patch_content(
                   buf, size, "UPS", name_ups,
-                  ups_apply_patch, patch_data, patch_size);
+                  ups_apply_patch, patch_data, patch_size, intact);
          }
 
          if (patch_data)
@@ -600,7 +734,7 @@ static bool try_ups_patch(bool allow_ups, const char *name_ups,
 }
 
 static bool try_ips_patch(bool allow_ips,
-      const char *name_ips, uint8_t **buf, ssize_t *size)
+      const char *name_ips, uint8_t **buf, ssize_t *size, bool *intact)
 {
    if (allow_ips && !string_is_empty(name_ips))
       if (path_is_valid(name_ips) && path_file_exists(name_ips))
@@ -616,7 +750,7 @@ static bool try_ips_patch(bool allow_ips,
          {
             ret                      = apply_patch_content(
                   buf, size, "IPS", name_ips,
-                  ips_apply_patch, patch_data, patch_size);
+                  ips_apply_patch, patch_data, patch_size, intact);
          }
 
          if (patch_data)
@@ -632,9 +766,14 @@ static bool try_ips_patch(bool allow_ips,
  * @size         : size   of the content file.
  *
  * Apply patch to the content file in-memory.
+ * A target no larger than the content is patched over @buf itself.
+ * Otherwise the patched content goes to a new buffer which replaces
+ * @buf; the original buffer is left to the caller to release.
  *
+ * Returns: false if a failed patch had already been applied over
+ * @buf, which no longer holds the content then, otherwise true.
  **/
-static void patch_content(
+static bool patch_content(
       bool is_ips_pref,
       bool is_bps_pref,
       bool is_ups_pref,
@@ -645,6 +784,7 @@ static void patch_content(
       void *data)
 {
    ssize_t *size    = (ssize_t*)data;
+   bool intact      = true;
    bool allow_ups   = !is_bps_pref && !is_ips_pref;
    bool allow_ips   = !is_ups_pref && !is_bps_pref;
    bool allow_bps   = !is_ups_pref && !is_ips_pref;
@@ -655,14 +795,16 @@ static void patch_content(
    {
       RARCH_WARN("%s\n",
             msg_hash_to_str(MSG_SEVERAL_PATCHES_ARE_EXPLICITLY_DEFINED));
-      return;
+      return true;
    }
 
-   if (     !try_ips_patch(allow_ips, name_ips, buf, size) 
-         && !try_bps_patch(allow_bps, name_bps, buf, size) 
-         && !try_ups_patch(allow_ups, name_ups, buf, size))
+   if (     !try_ips_patch(allow_ips, name_ips, buf, size, &intact) 
+         && !try_bps_patch(allow_bps, name_bps, buf, size, &intact) 
+         && !try_ups_patch(allow_ups, name_ups, buf, size, &intact))
    {
       RARCH_LOG("%s\n",
             msg_hash_to_str(MSG_DID_NOT_FIND_A_VALID_CONTENT_PATCH));
    }
+
+   return intact;
 }
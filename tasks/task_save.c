@@ -21,15 +21,26 @@
 
 #ifdef _WIN32
 #include <direct.h>
+#include <io.h>
+#ifndef _XBOX
+#include <windows.h>
+#endif
 #else
 #include <unistd.h>
 #endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#endif
 #include <errno.h>
 
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+
 #include <compat/strl.h>
 #include <retro_assert.h>
 #include <lists/string_list.h>
 #include <streams/file_stream.h>
+#include <streams/trans_stream.h>
 #include <rthreads/rthreads.h>
 #include <file/file_path.h>
 #include <retro_miscellaneous.h>
@@ -54,6 +65,34 @@
 
 #define SAVE_STATE_CHUNK 4096
 
+/* Compressed savestates start with this header, followed by the
+ * compressed state: magic (8 bytes), codec (4 bytes), CRC32 of the
+ * uncompressed state (4 bytes), then the uncompressed and compressed
+ * sizes (8 bytes each). All numbers are little-endian. Files without
+ * the magic are raw states, which is all older versions wrote. */
+#define SAVE_STATE_MAGIC         "RASTATEZ"
+#define SAVE_STATE_HEADER        32
+#define SAVE_STATE_CODEC_DEFLATE 1
+
+/* State bytes compressed, or compressed bytes read and decompressed,
+ * per call of the task handlers. */
+#define SAVE_STATE_CODEC_CHUNK   (128 * 1024)
+
+/* SRAM is compared and written back in blocks of this size. */
+#define AUTOSAVE_BLOCK_SIZE 4096
+
+/* Intervals a pending change waits for the core to stop
+ * writing to SRAM before it is saved anyway. */
+#define AUTOSAVE_MAX_DEFER  4
+
+/* Partial SRAM writes go through a journal next to the save file:
+ * "RASJ", range count (4 bytes), file size (8 bytes), then per range
+ * its offset and length (8 bytes each) and data, then the CRC32 of
+ * everything before it. All numbers are little-endian. */
+#define SRAM_JOURNAL_MAGIC  "RASJ"
+#define SRAM_JOURNAL_HEADER 16
+#define SRAM_JOURNAL_RANGE  16
+
 static struct string_list *task_save_files = NULL;
 
 struct ram_type
@@ -94,6 +133,19 @@ typedef struct
    int state_slot;
    bool thumbnail_enable;
    bool has_valid_framebuffer;
+   /* Compressed states only. When saving, written counts the state
+    * bytes compressed so far and file_size the bytes written to the
+    * file after the header; when loading, bytes_read counts the bytes
+    * read from the file, file_size is its size and written counts the
+    * state bytes decompressed so far. */
+   bool compress;
+   const struct trans_stream_backend *codec;
+   void *stream;
+   uint8_t *chunk;
+   ssize_t file_size;
+   uint32_t crc;
+   uint32_t header_crc;
+   retro_time_t codec_time;
 } save_task_state_t;
 
 typedef save_task_state_t load_task_data_t;
@@ -106,6 +158,214 @@ static struct save_state_buf undo_save_buf;
  * Can be restored with undo_load_state(). */
 static struct save_state_buf undo_load_buf;
 
+static void sram_put_le(uint8_t *out, uint64_t value, unsigned bytes)
+{
+   unsigned i;
+
+   for (i = 0; i < bytes; i++)
+      out[i] = (uint8_t)(value >> (i * 8));
+}
+
+static uint64_t sram_get_le(const uint8_t *in, unsigned bytes)
+{
+   unsigned i;
+   uint64_t value = 0;
+
+   for (i = 0; i < bytes; i++)
+      value |= (uint64_t)in[i] << (i * 8);
+
+   return value;
+}
+
+/* Makes what has been written to @file durable. Unbuffered
+ * streams have nothing to flush, only the fd is synced. */
+static bool sram_file_sync(RFILE *file)
+{
+   if (filestream_flush(file) != 0)
+      return false;
+#if defined(_WIN32) && !defined(_XBOX)
+   return _commit(filestream_get_fd(file)) == 0;
+#elif defined(__unix__) || defined(__APPLE__)
+   return fsync(filestream_get_fd(file)) == 0;
+#else
+   return true;
+#endif
+}
+
+/* Makes files created, renamed or removed next to @path durable. */
+static void sram_dir_sync(const char *path)
+{
+#if defined(__unix__) || defined(__APPLE__)
+   int fd;
+   char dir[PATH_MAX_LENGTH];
+
+   fill_pathname_basedir(dir, path, sizeof(dir));
+
+   fd = open(dir, O_RDONLY);
+   if (fd < 0)
+      return;
+   fsync(fd);
+   close(fd);
+#endif
+}
+
+static bool sram_write_file_sync(const char *path,
+      const void *data, size_t size)
+{
+   bool ret     = true;
+   RFILE *file  = filestream_open(path, RFILE_MODE_WRITE, -1);
+
+   if (!file)
+      return false;
+
+   ret &= filestream_write(file, data, size) == (ssize_t)size;
+   ret &= sram_file_sync(file);
+   ret &= filestream_close(file) == 0;
+
+   return ret;
+}
+
+/**
+ * sram_write_file_atomic:
+ * @path             : path of the file to replace.
+ * @data             : contents of the new file.
+ * @size             : size of @data.
+ *
+ * Writes @data to a temporary file next to @path and renames it
+ * over @path, so that a crash at any point leaves either the old
+ * or the new file behind, never a mix of both.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool sram_write_file_atomic(const char *path,
+      const void *data, size_t size)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   char journal_path[PATH_MAX_LENGTH];
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", path);
+
+   /* A journal left behind must never be replayed over the new file. */
+   if (path_file_exists(journal_path) && remove(journal_path) != 0)
+      return false;
+
+   if (!sram_write_file_sync(tmp_path, data, size))
+   {
+      remove(tmp_path);
+      return false;
+   }
+
+#if defined(_WIN32) && !defined(_XBOX)
+   if (!MoveFileExA(tmp_path, path,
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+#else
+   if (rename(tmp_path, path) != 0)
+#endif
+   {
+      remove(tmp_path);
+      return false;
+   }
+
+   sram_dir_sync(path);
+   return true;
+}
+
+/**
+ * sram_journal_replay:
+ * @path             : path of the save file.
+ *
+ * Finishes a partial SRAM write that was cut short, if a complete
+ * journal for @path is found. A journal that was not completely
+ * written means the save file itself was never touched. Either
+ * way the journal is removed.
+ **/
+static void sram_journal_replay(const char *path)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   uint32_t i, count;
+   uint64_t file_size;
+   size_t offset;
+   RFILE *file      = NULL;
+   uint8_t *journal = NULL;
+   ssize_t len      = 0;
+   bool ret         = true;
+
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", path);
+
+   if (!path_file_exists(journal_path))
+      return;
+
+   if (     !filestream_read_file(journal_path, (void**)&journal, &len)
+         || len < SRAM_JOURNAL_HEADER + 4
+         || memcmp(journal, SRAM_JOURNAL_MAGIC, 4)
+         || encoding_crc32(0, journal, len - 4)
+         != (uint32_t)sram_get_le(journal + len - 4, 4)
+         || !path_file_exists(path))
+      goto end;
+
+   count     = (uint32_t)sram_get_le(journal + 4, 4);
+   file_size = sram_get_le(journal + 8, 8);
+   offset    = SRAM_JOURNAL_HEADER;
+
+   /* Check every range before writing any. */
+   for (i = 0; i < count; i++)
+   {
+      uint64_t range_offset, range_len;
+
+      if (offset + SRAM_JOURNAL_RANGE > (size_t)len - 4)
+         goto end;
+
+      range_offset = sram_get_le(journal + offset, 8);
+      range_len    = sram_get_le(journal + offset + 8, 8);
+      offset      += SRAM_JOURNAL_RANGE;
+
+      if (     range_len > (size_t)len - 4 - offset
+            || range_offset > file_size
+            || range_len > file_size - range_offset)
+         goto end;
+
+      offset += (size_t)range_len;
+   }
+
+   file = filestream_open(path,
+         RFILE_MODE_READ_WRITE | RFILE_HINT_UNBUFFERED, -1);
+   if (!file)
+      goto end;
+
+   offset = SRAM_JOURNAL_HEADER;
+
+   for (i = 0; i < count; i++)
+   {
+      uint64_t range_offset = sram_get_le(journal + offset, 8);
+      size_t range_len      = (size_t)sram_get_le(journal + offset + 8, 8);
+
+      offset += SRAM_JOURNAL_RANGE;
+      ret    &= filestream_seek(file, (ssize_t)range_offset, SEEK_SET) >= 0
+         && filestream_write(file, journal + offset, range_len)
+         == (ssize_t)range_len;
+      offset += range_len;
+   }
+
+   ret &= sram_file_sync(file);
+   ret &= filestream_close(file) == 0;
+
+   if (ret)
+      RARCH_LOG("Finished interrupted SRAM autosave to \"%s\".\n", path);
+   else
+   {
+      /* Keep the journal for another try. */
+      RARCH_WARN("Failed to finish interrupted SRAM autosave to \"%s\".\n",
+            path);
+      free(journal);
+      return;
+   }
+
+end:
+   free(journal);
+   remove(journal_path);
+}
+
 #ifdef HAVE_THREADS
 typedef struct autosave autosave_t;
 
@@ -130,58 +390,231 @@ struct autosave
    const char *path;
    size_t bufsize;
    unsigned interval;
+
+   /* Set for each block of @buffer not written out yet. */
+   uint8_t *dirty;
+   size_t num_blocks;
+   size_t num_dirty;
+   /* Intervals the dirty blocks have been waiting. */
+   unsigned deferred;
+   /* Whether the file matches @buffer outside the dirty blocks,
+    * so that writing those is enough. */
+   bool file_synced;
 };
 
 static struct autosave_st autosave_state;
 
+/* Size of dirty block @i, the last one can be short. */
+static size_t autosave_block_size(autosave_t *save, size_t i)
+{
+   size_t offset = i * AUTOSAVE_BLOCK_SIZE;
+
+   return MIN(AUTOSAVE_BLOCK_SIZE, save->bufsize - offset);
+}
+
+/* Finds the next run of dirty blocks at or after block *@i. */
+static bool autosave_next_range(autosave_t *save, size_t *i,
+      size_t *offset, size_t *len)
+{
+   size_t end;
+
+   while (*i < save->num_blocks && !save->dirty[*i])
+      (*i)++;
+
+   if (*i >= save->num_blocks)
+      return false;
+
+   for (end = *i; end < save->num_blocks && save->dirty[end]; end++);
+
+   *offset = *i * AUTOSAVE_BLOCK_SIZE;
+   *len    = (end - 1) * AUTOSAVE_BLOCK_SIZE
+      + autosave_block_size(save, end - 1) - *offset;
+   *i      = end;
+
+   return true;
+}
+
+static bool autosave_file_matches(autosave_t *save)
+{
+   bool matches = false;
+   void *buf    = NULL;
+   ssize_t len  = 0;
+
+   if (     path_file_exists(save->path)
+         && filestream_read_file(save->path, &buf, &len))
+      matches = len == (ssize_t)save->bufsize
+         && !memcmp(buf, save->buffer, save->bufsize);
+
+   free(buf);
+   return matches;
+}
+
+/**
+ * autosave_write_ranges:
+ * @save            : pointer to autosave object
+ *
+ * Writes the dirty blocks of @save in place. They are written to
+ * a journal first, so that a crash halfway through can be finished
+ * by sram_journal_replay() when the file is next loaded.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool autosave_write_ranges(autosave_t *save)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   size_t i, offset, len;
+   size_t journal_size = SRAM_JOURNAL_HEADER + 4;
+   size_t pos          = SRAM_JOURNAL_HEADER;
+   uint32_t count      = 0;
+   uint8_t *journal    = NULL;
+   RFILE *file         = NULL;
+   bool ret            = true;
+
+   for (i = 0; autosave_next_range(save, &i, &offset, &len); count++)
+      journal_size += SRAM_JOURNAL_RANGE + len;
+
+   journal = (uint8_t*)malloc(journal_size);
+   if (!journal)
+      return false;
+
+   memcpy(journal, SRAM_JOURNAL_MAGIC, 4);
+   sram_put_le(journal + 4, count, 4);
+   sram_put_le(journal + 8, save->bufsize, 8);
+
+   for (i = 0; autosave_next_range(save, &i, &offset, &len); )
+   {
+      sram_put_le(journal + pos, offset, 8);
+      sram_put_le(journal + pos + 8, len, 8);
+      memcpy(journal + pos + SRAM_JOURNAL_RANGE,
+            (const uint8_t*)save->buffer + offset, len);
+      pos += SRAM_JOURNAL_RANGE + len;
+   }
+
+   sram_put_le(journal + pos, encoding_crc32(0, journal, pos), 4);
+
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", save->path);
+
+   ret = sram_write_file_sync(journal_path, journal, journal_size);
+   free(journal);
+
+   if (!ret)
+      return false;
+
+   sram_dir_sync(journal_path);
+
+   file = filestream_open(save->path,
+         RFILE_MODE_READ_WRITE | RFILE_HINT_UNBUFFERED, -1);
+   if (!file)
+      return false;
+
+   for (i = 0; autosave_next_range(save, &i, &offset, &len); )
+      ret &= filestream_seek(file, (ssize_t)offset, SEEK_SET) >= 0
+         && filestream_write(file, (const uint8_t*)save->buffer + offset, len)
+         == (ssize_t)len;
+
+   ret &= sram_file_sync(file);
+   ret &= filestream_close(file) == 0;
+
+   /* A journal left behind only holds what the file now holds. */
+   if (ret)
+      remove(journal_path);
+
+   return ret;
+}
+
+/**
+ * autosave_write:
+ * @save            : pointer to autosave object
+ *
+ * Writes the dirty blocks of @save out. Small changes go in place
+ * through a journal, large ones and files that do not match the
+ * buffer anymore replace the whole file atomically.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool autosave_write(autosave_t *save)
+{
+   bool ret;
+
+   if (     save->file_synced
+         && save->num_dirty * AUTOSAVE_BLOCK_SIZE * 2 < save->bufsize)
+      ret = autosave_write_ranges(save);
+   else
+      ret = sram_write_file_atomic(save->path, save->buffer, save->bufsize);
+
+   save->file_synced = ret;
+
+   if (ret)
+   {
+      memset(save->dirty, 0, save->num_blocks);
+      save->num_dirty = 0;
+      save->deferred  = 0;
+   }
+
+   return ret;
+}
+
 /**
  * autosave_thread:
  * @data            : pointer to autosave object
  *
  * Callback function for (threaded) autosave.
+ *
+ * Every interval, the blocks of SRAM that changed are copied to the
+ * autosave buffer and marked dirty. They are written out once the
+ * core has left SRAM alone for an interval, or after
+ * AUTOSAVE_MAX_DEFER intervals of steady changes, so bursts of
+ * writes by the core end up in one write to disk.
  **/
 static void autosave_thread(void *data)
 {
    bool first_log   = true;
    autosave_t *save = (autosave_t*)data;
 
+   save->file_synced = autosave_file_matches(save);
+
    while (!save->quit)
    {
-      bool differ;
+      size_t i;
+      bool changed = false;
 
       slock_lock(save->lock);
-      differ = string_is_not_equal_fast(save->buffer, save->retro_buffer,
-            save->bufsize);
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
+      for (i = 0; i < save->num_blocks; i++)
+      {
+         size_t offset        = i * AUTOSAVE_BLOCK_SIZE;
+         size_t len           = autosave_block_size(save, i);
+         uint8_t *block       = (uint8_t*)save->buffer + offset;
+         const uint8_t *retro = (const uint8_t*)save->retro_buffer + offset;
+
+         if (!memcmp(block, retro, len))
+            continue;
+
+         memcpy(block, retro, len);
+         changed = true;
+
+         if (!save->dirty[i])
+         {
+            save->dirty[i] = 1;
+            save->num_dirty++;
+         }
+      }
       slock_unlock(save->lock);
 
-      if (differ)
+      if (save->num_dirty
+            && (!changed || ++save->deferred >= AUTOSAVE_MAX_DEFER))
       {
-         /* Should probably deal with this more elegantly. */
-         RFILE *file = filestream_open(save->path, RFILE_MODE_WRITE, -1);
-
-         if (file)
+         /* Avoid spamming down stderr ... */
+         if (first_log)
          {
-            bool failed = false;
-
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            failed |= filestream_write(file, save->buffer, save->bufsize)
-               != save->bufsize;
-            failed |= filestream_flush(file) != 0;
-            failed |= filestream_close(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+                  save->path, save->interval);
+            first_log = false;
          }
+         else
+            RARCH_LOG("SRAM changed ... autosaving ...\n");
+
+         if (!autosave_write(save))
+            RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
       }
 
       slock_lock(save->cond_lock);
@@ -192,6 +625,10 @@ static void autosave_thread(void *data)
 
       slock_unlock(save->cond_lock);
    }
+
+   /* Do not lose changes still waiting to be coalesced. */
+   if (save->num_dirty && !autosave_write(save))
+      RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
 }
 
 /**
@@ -219,8 +656,11 @@ static autosave_t *autosave_new(const char *path,
    handle->path                  = path;
    handle->buffer                = malloc(size);
    handle->retro_buffer          = data;
+   handle->num_blocks            = (size + AUTOSAVE_BLOCK_SIZE - 1)
+      / AUTOSAVE_BLOCK_SIZE;
+   handle->dirty                 = (uint8_t*)calloc(handle->num_blocks, 1);
 
-   if (!handle->buffer)
+   if (!handle->buffer || !handle->dirty)
       goto error;
 
    memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
@@ -235,7 +675,11 @@ static autosave_t *autosave_new(const char *path,
 
 error:
    if (handle)
+   {
+      free(handle->buffer);
+      free(handle->dirty);
       free(handle);
+   }
    return NULL;
 }
 
@@ -260,6 +704,9 @@ static void autosave_free(autosave_t *handle)
    if (handle->buffer)
       free(handle->buffer);
    handle->buffer = NULL;
+
+   free(handle->dirty);
+   handle->dirty  = NULL;
 }
 
 
@@ -513,6 +960,242 @@ static void undo_save_state_cb(void *task_data,
    }
 }
 
+/**
+ * task_save_state_codec_init:
+ * @state : the state associated with the save or load task
+ * @codec : transcoding backend, NULL if not built in
+ *
+ * Set up @state to compress or decompress the state through @codec.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool task_save_state_codec_init(save_task_state_t *state,
+      const struct trans_stream_backend *codec)
+{
+   if (!codec)
+      return false;
+
+   state->stream = codec->stream_new();
+   state->chunk  = (uint8_t*)malloc(SAVE_STATE_CODEC_CHUNK);
+
+   if (!state->stream || !state->chunk)
+   {
+      if (state->stream)
+         codec->stream_free(state->stream);
+      free(state->chunk);
+      state->stream = NULL;
+      state->chunk  = NULL;
+      return false;
+   }
+
+   state->codec      = codec;
+   state->crc        = 0;
+   state->file_size  = 0;
+   state->codec_time = 0;
+   return true;
+}
+
+static void task_save_state_codec_free(save_task_state_t *state)
+{
+   if (state->stream)
+      state->codec->stream_free(state->stream);
+   free(state->chunk);
+   state->codec  = NULL;
+   state->stream = NULL;
+   state->chunk  = NULL;
+}
+
+static bool task_save_state_write_header(save_task_state_t *state)
+{
+   uint8_t header[SAVE_STATE_HEADER];
+
+   memcpy(header, SAVE_STATE_MAGIC, 8);
+   sram_put_le(header + 8,  SAVE_STATE_CODEC_DEFLATE, 4);
+   sram_put_le(header + 12, state->crc, 4);
+   sram_put_le(header + 16, state->size, 8);
+   sram_put_le(header + 24, state->file_size, 8);
+
+   return filestream_write(state->file, header, sizeof(header))
+      == sizeof(header);
+}
+
+/**
+ * task_save_state_encode:
+ * @state : the state associated with the save task
+ *
+ * Compress the next chunk of the state and write it out. The header
+ * goes in first with a compressed size of zero, so an interrupted
+ * save is not mistaken for a raw state, and is written again with
+ * the final sizes and CRC32 once the whole state is in.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool task_save_state_encode(save_task_state_t *state)
+{
+   enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+   retro_time_t start          = cpu_features_get_time_usec();
+   const uint8_t *in           = (const uint8_t*)state->data + state->written;
+   size_t len                  = MIN(state->size - state->written,
+         SAVE_STATE_CODEC_CHUNK);
+   bool flush                  = state->written + (ssize_t)len == state->size;
+
+   if (state->written == 0 && !task_save_state_write_header(state))
+      return false;
+
+   state->codec->set_in(state->stream, in, (uint32_t)len);
+   state->crc = encoding_crc32(state->crc, in, len);
+
+   /* Everything in is taken unless the output fills up,
+    * and finishing may take a few rounds of output. */
+   do
+   {
+      uint32_t rd = 0;
+      uint32_t wn = 0;
+
+      state->codec->set_out(state->stream, state->chunk,
+            SAVE_STATE_CODEC_CHUNK);
+
+      if (!state->codec->trans(state->stream, flush, &rd, &wn, &err)
+            && err != TRANS_STREAM_ERROR_BUFFER_FULL)
+         return false;
+
+      if (wn && filestream_write(state->file, state->chunk, wn) != wn)
+         return false;
+
+      state->file_size += wn;
+   } while (err == TRANS_STREAM_ERROR_BUFFER_FULL
+         || (flush && err == TRANS_STREAM_ERROR_AGAIN));
+
+   state->written    += len;
+   state->codec_time += cpu_features_get_time_usec() - start;
+
+   if (!flush)
+      return true;
+
+   if (filestream_seek(state->file, 0, SEEK_SET) != 0
+         || !task_save_state_write_header(state))
+      return false;
+
+   RARCH_LOG("Compressed state: %u -> %u bytes (%.1f%%) in %.2f ms.\n",
+         (unsigned)state->size,
+         (unsigned)(state->file_size + SAVE_STATE_HEADER),
+         100.0 * (state->file_size + SAVE_STATE_HEADER) / state->size,
+         state->codec_time / 1000.0);
+   return true;
+}
+
+/**
+ * task_load_state_read_header:
+ * @state : the state associated with the load task
+ *
+ * Check whether the file being loaded is a compressed state and if
+ * so, set @state up to decompress it. Raw states are left alone.
+ *
+ * Returns: false if the file is a compressed state that can't be
+ * loaded, true otherwise.
+ **/
+static bool task_load_state_read_header(save_task_state_t *state)
+{
+   uint8_t header[SAVE_STATE_HEADER];
+   uint64_t size;
+   uint64_t file_size;
+
+   if (state->size < SAVE_STATE_HEADER)
+      return true;
+
+   if (filestream_read(state->file, header, sizeof(header)) != sizeof(header))
+      return false;
+
+   if (memcmp(header, SAVE_STATE_MAGIC, 8))
+   {
+      filestream_rewind(state->file);
+      return true;
+   }
+
+   size      = sram_get_le(header + 16, 8);
+   file_size = sram_get_le(header + 24, 8);
+
+   if (sram_get_le(header + 8, 4) != SAVE_STATE_CODEC_DEFLATE)
+   {
+      RARCH_ERR("State \"%s\" is compressed with an unknown codec.\n",
+            state->path);
+      return false;
+   }
+
+   if (file_size != (uint64_t)(state->size - SAVE_STATE_HEADER)
+         || size == 0 || size >= (uint64_t)((size_t)-1 >> 1))
+   {
+      RARCH_ERR("Compressed state \"%s\" is incomplete.\n", state->path);
+      return false;
+   }
+
+   if (!task_save_state_codec_init(state,
+            trans_stream_get_zlib_inflate_backend()))
+   {
+      RARCH_ERR("Compressed state \"%s\" can't be loaded by this build.\n",
+            state->path);
+      return false;
+   }
+
+   state->header_crc = (uint32_t)sram_get_le(header + 12, 4);
+   state->file_size  = state->size;
+   state->size       = (ssize_t)size;
+   state->bytes_read = SAVE_STATE_HEADER;
+   return true;
+}
+
+/**
+ * task_load_state_decode:
+ * @state : the state associated with the load task
+ *
+ * Read the next chunk of a compressed state and decompress it,
+ * checking the result against the header once it is all in.
+ *
+ * Returns: true if successful, false otherwise.
+ **/
+static bool task_load_state_decode(save_task_state_t *state)
+{
+   uint32_t rd                 = 0;
+   uint32_t wn                 = 0;
+   enum trans_stream_error err = TRANS_STREAM_ERROR_NONE;
+   retro_time_t start          = cpu_features_get_time_usec();
+   uint8_t *out                = (uint8_t*)state->data + state->written;
+   ssize_t len                 = MIN(state->file_size - state->bytes_read,
+         SAVE_STATE_CODEC_CHUNK);
+   bool flush                  = state->bytes_read + len == state->file_size;
+
+   if (filestream_read(state->file, state->chunk, len) != len)
+      return false;
+
+   state->bytes_read += len;
+
+   state->codec->set_in(state->stream, state->chunk, (uint32_t)len);
+   state->codec->set_out(state->stream, out,
+         (uint32_t)(state->size - state->written));
+
+   /* The output has room for the whole state, so all of the input
+    * goes in unless the stream is damaged or ends early. */
+   if (!state->codec->trans(state->stream, flush, &rd, &wn, &err)
+         || rd != (uint32_t)len)
+      return false;
+
+   state->crc         = encoding_crc32(state->crc, out, wn);
+   state->written    += wn;
+   state->codec_time += cpu_features_get_time_usec() - start;
+
+   if (!flush)
+      return true;
+
+   if (err != TRANS_STREAM_ERROR_NONE || state->written != state->size
+         || state->crc != state->header_crc)
+      return false;
+
+   RARCH_LOG("Decompressed state: %u -> %u bytes in %.2f ms.\n",
+         (unsigned)state->file_size, (unsigned)state->size,
+         state->codec_time / 1000.0);
+   return true;
+}
+
 /**
  * task_save_handler_finished:
  * @task : the task to finish
@@ -528,6 +1211,7 @@ static void task_save_handler_finished(retro_task_t *task,
    task_set_finished(task, true);
 
    filestream_close(state->file);
+   task_save_state_codec_free(state);
 
    if (!task_get_error(task) && task_get_cancelled(task))
       task_set_error(task, strdup("Task canceled"));
@@ -556,8 +1240,7 @@ static void task_save_handler_finished(retro_task_t *task,
  **/
 static void task_save_handler(retro_task_t *task)
 {
-   int written;
-   ssize_t remaining;
+   bool failed;
    save_task_state_t *state = (save_task_state_t*)task->state;
 
    if (!state->file)
@@ -566,17 +1249,30 @@ static void task_save_handler(retro_task_t *task)
 
       if (!state->file)
          return;
+
+      /* Without a codec built in, the state is written raw. Saving
+       * should not hold up the next state; the fastest level gets
+       * most of what deflate can do with state data. */
+      if (state->compress && task_save_state_codec_init(state,
+               trans_stream_get_zlib_deflate_backend()))
+         state->codec->define(state->stream, "level", 1);
    }
 
-   remaining       = MIN(state->size - state->written, SAVE_STATE_CHUNK);
-   written         = (int)filestream_write(state->file,
-         (uint8_t*)state->data + state->written, remaining);
+   if (state->codec)
+      failed          = !task_save_state_encode(state);
+   else
+   {
+      ssize_t remaining = MIN(state->size - state->written, SAVE_STATE_CHUNK);
+      int written       = (int)filestream_write(state->file,
+            (uint8_t*)state->data + state->written, remaining);
 
-   state->written += written;
+      state->written   += written;
+      failed            = written != remaining;
+   }
 
    task_set_progress(task, (state->written / (float)state->size) * 100);
 
-   if (task_get_cancelled(task) || written != remaining)
+   if (task_get_cancelled(task) || failed)
    {
       char err[PATH_MAX_LENGTH];
 
@@ -703,6 +1399,7 @@ static void task_load_handler_finished(retro_task_t *task,
 
    if (state->file)
       filestream_close(state->file);
+   task_save_state_codec_free(state);
 
    if (!task_get_error(task) && task_get_cancelled(task))
       task_set_error(task, strdup("Task canceled"));
@@ -723,7 +1420,8 @@ static void task_load_handler_finished(retro_task_t *task,
  **/
 static void task_load_handler(retro_task_t *task)
 {
-   ssize_t remaining, bytes_read;
+   bool failed;
+   ssize_t total;
    save_task_state_t *state = (save_task_state_t*)task->state;
 
    if (!state->file)
@@ -743,21 +1441,41 @@ static void task_load_handler(retro_task_t *task)
 
       filestream_rewind(state->file);
 
+      /* The backup buffer is written back as it is,
+       * so it keeps the file as it is. */
+      if (!state->load_to_backup_buffer
+            && !task_load_state_read_header(state))
+      {
+         task_set_error(task, strdup(msg_hash_to_str(MSG_FAILED_TO_LOAD_STATE)));
+         goto error;
+      }
+
       state->data = malloc(state->size + 1);
 
       if (!state->data)
          goto error;
    }
 
-   remaining          = MIN(state->size - state->bytes_read, SAVE_STATE_CHUNK);
-   bytes_read         = filestream_read(state->file,
-         (uint8_t*)state->data + state->bytes_read, remaining);
-   state->bytes_read += bytes_read;
+   if (state->codec)
+   {
+      total  = state->file_size;
+      failed = !task_load_state_decode(state);
+   }
+   else
+   {
+      ssize_t remaining  = MIN(state->size - state->bytes_read, SAVE_STATE_CHUNK);
+      ssize_t bytes_read = filestream_read(state->file,
+            (uint8_t*)state->data + state->bytes_read, remaining);
+
+      total              = state->size;
+      state->bytes_read += bytes_read;
+      failed             = bytes_read != remaining;
+   }
 
-   if (state->size > 0)
-      task_set_progress(task, (state->bytes_read / (float)state->size) * 100);
+   if (total > 0)
+      task_set_progress(task, (state->bytes_read / (float)total) * 100);
 
-   if (task_get_cancelled(task) || bytes_read != remaining)
+   if (task_get_cancelled(task) || failed)
    {
       if (state->autoload)
       {
@@ -780,7 +1498,7 @@ static void task_load_handler(retro_task_t *task)
       return;
    }
 
-   if (state->bytes_read == state->size)
+   if (state->bytes_read == total)
    {
       char msg[1024];
 
@@ -1009,6 +1727,7 @@ static void task_push_save_state(const char *path, void *data, size_t size, bool
    state->autosave         = autosave;
    state->mute             = autosave; /* don't show OSD messages if we are auto-saving */
    state->thumbnail_enable = settings->bools.savestate_thumbnail_enable;
+   state->compress         = settings->bools.savestate_file_compression;
    state->state_slot       = settings->ints.state_slot;
    state->has_valid_framebuffer  = video_driver_cached_frame_has_valid_framebuffer();
 
@@ -1327,6 +2046,8 @@ bool content_load_ram_file(unsigned slot)
    if (!content_get_memory(&mem_info, &ram, slot))
       return false;
 
+   sram_journal_replay(ram.path);
+
    if (!filestream_read_file(ram.path, &buf, &rc))
       return false;
 
@@ -1410,7 +2131,7 @@ bool content_save_ram_file(unsigned slot)
          msg_hash_to_str(MSG_TO),
          ram.path);
 
-   if (!filestream_write_file(ram.path, mem_info.data, mem_info.size))
+   if (!sram_write_file_atomic(ram.path, mem_info.data, mem_info.size))
    {
       RARCH_ERR("%s.\n",
             msg_hash_to_str(MSG_FAILED_TO_SAVE_SRAM));
@@ -0,0 +1,29 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_BENCH_H
+#define __RARCH_BENCH_H
+
+#include <stdint.h>
+
+/* Helpers shared by the benchmarks in tools/. Each of them builds the
+ * code it measures into its own translation unit; bench.c provides
+ * the frontend logging and messages that code expects. RARCH_ERR goes
+ * to stderr, RARCH_LOG and RARCH_WARN are dropped so that they don't
+ * end up in the timings. */
+
+/* Deterministic pseudo-random numbers, so runs can be compared. */
+uint32_t bench_rand(void);
+
+#endif
@@ -0,0 +1,33 @@
+# Shared rules for the benchmarks in tools/. Each Makefile sets TARGET,
+# OBJS (the bench itself and the libretro-common sources it needs,
+# named after their source files) and optionally DEFINES and LIBS,
+# then includes this file.
+
+LIBRETRO_COMM_DIR=../../libretro-common
+
+CC=gcc
+CFLAGS=-O2 -g $(DEFINES)
+INCLUDES=-I../.. -I../bench_common -I$(LIBRETRO_COMM_DIR)/include
+
+vpath %.c ../bench_common \
+   $(LIBRETRO_COMM_DIR)/compat \
+   $(LIBRETRO_COMM_DIR)/encodings \
+   $(LIBRETRO_COMM_DIR)/features \
+   $(LIBRETRO_COMM_DIR)/file \
+   $(LIBRETRO_COMM_DIR)/formats/json \
+   $(LIBRETRO_COMM_DIR)/hash \
+   $(LIBRETRO_COMM_DIR)/lists \
+   $(LIBRETRO_COMM_DIR)/queues \
+   $(LIBRETRO_COMM_DIR)/rthreads \
+   $(LIBRETRO_COMM_DIR)/streams \
+   $(LIBRETRO_COMM_DIR)/string \
+   $(LIBRETRO_COMM_DIR)/utils
+
+$(TARGET): $(OBJS) bench.o
+	$(CC) $(CFLAGS) $(OBJS) bench.o $(LIBS) -o $@
+
+%.o: %.c
+	$(CC) $(CFLAGS) $(INCLUDES) -c $< -o $@
+
+clean:
+	rm -f $(OBJS) bench.o $(TARGET)
@@ -0,0 +1,268 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times the per-frame achievement test on a large synthetic set. The
+ * set is built as the JSON the server sends and loaded the same way,
+ * with a mix of condition types, sizes, deltas, hit counts and
+ * alternate groups over a pool of shared addresses. Each frame, a
+ * game-like workload bumps counters and rewrites part of a 64 KB
+ * system RAM before the test runs. Frames are timed in batches, and
+ * the mean and the best batch are reported, the latter being steadier
+ * on a busy machine. Awards are counted and summed over (frame, id)
+ * so runs can be compared.
+ * Usage: cheevosbench [achievements] [frames] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+
+#include "../../cheevos/cheevos.c"
+
+#include "bench.h"
+
+#define BENCH_RAM_SIZE  0x10000
+#define BENCH_ADDRESSES 2048
+#define BENCH_BATCH     100
+
+static uint8_t bench_ram[BENCH_RAM_SIZE];
+static unsigned bench_addresses[BENCH_ADDRESSES];
+static unsigned bench_frame;
+static unsigned bench_awards;
+static uint64_t bench_award_sum;
+static settings_t bench_settings;
+static rarch_system_info_t bench_system;
+
+/* Stand-ins for the rest of the frontend. */
+settings_t *config_get_ptr(void) { return &bench_settings; }
+rarch_system_info_t *runloop_get_system_info(void) { return &bench_system; }
+bool command_event(enum event_command action, void *data) { return false; }
+bool core_get_memory(retro_ctx_memory_info_t *info) { return false; }
+bool core_get_system_info(struct retro_system_info *system) { return false; }
+void task_queue_push(retro_task_t *task) { }
+void task_set_finished(retro_task_t *task, bool finished) { }
+
+void runloop_msg_queue_push(const char *msg, unsigned prio,
+      unsigned duration, bool flush) { }
+
+struct http_connection_t *net_http_connection_new(const char *url,
+      const char *method, const char *data) { return NULL; }
+bool net_http_connection_iterate(struct http_connection_t *conn) { return true; }
+bool net_http_connection_done(struct http_connection_t *conn) { return false; }
+void net_http_connection_free(struct http_connection_t *conn) { }
+struct http_t *net_http_new(struct http_connection_t *conn) { return NULL; }
+bool net_http_update(struct http_t *state, size_t *progress, size_t *total) { return true; }
+uint8_t *net_http_data(struct http_t *state, size_t *len, bool accept_error) { return NULL; }
+void net_http_delete(struct http_t *state) { }
+
+void *task_push_http_transfer(const char *url, bool mute, const char *type,
+      retro_task_callback_t cb, void *userdata)
+{
+   const cheevo_t *cheevo = (const cheevo_t*)userdata;
+
+   bench_awards++;
+   bench_award_sum += (uint64_t)bench_frame * 100003u + cheevo->id;
+   return NULL;
+}
+
+static void bench_add_var(char **out, bool delta)
+{
+   static const char sizes[] = "HHHHHH HXMNTLU";
+   char size     = sizes[bench_rand() % (sizeof(sizes) - 1)];
+   unsigned addr = bench_addresses[bench_rand() % BENCH_ADDRESSES];
+
+   if (size == ' ')
+      *out += sprintf(*out, "%s0x%04x", delta ? "d" : "", addr | 0x1000);
+   else
+      *out += sprintf(*out, "%s0x%c%04x", delta ? "d" : "", size, addr);
+}
+
+static void bench_add_cond(char **out)
+{
+   static const char *ops[] = { "=", "!=", "<", "<=", ">", ">=" };
+   unsigned kind = bench_rand() % 16;
+
+   if (kind == 0)
+      *out += sprintf(*out, "P:");
+   else if (kind == 1)
+      *out += sprintf(*out, "R:");
+
+   bench_add_var(out, false);
+   *out += sprintf(*out, "%s", ops[bench_rand() % 6]);
+
+   /* Deltas compare an address with its value on the previous frame. */
+   if (kind >= 2 && kind < 5)
+      bench_add_var(out, true);
+   else
+      *out += sprintf(*out, "%u", bench_rand() % 12);
+
+   if (kind >= 5 && kind < 7)
+      *out += sprintf(*out, ".%u.", 2 + bench_rand() % 30);
+}
+
+static char *bench_make_json(unsigned count)
+{
+   unsigned i;
+   char *json = (char*)malloc(count * 1024 + 256);
+   char *out  = json;
+
+   if (!json)
+      return NULL;
+
+   out += sprintf(out, "{\"Success\":true,\"PatchData\":{\"ID\":1,"
+         "\"Title\":\"Bench\",\"ConsoleID\":1,\"Achievements\":[");
+
+   for (i = 0; i < count; i++)
+   {
+      unsigned j;
+      unsigned conds  = 3 + bench_rand() % 8;
+      unsigned groups = bench_rand() % 3;
+
+      out += sprintf(out, "%s{\"ID\":%u,\"MemAddr\":\"", i ? "," : "", i + 1);
+
+      for (j = 0; j < conds; j++)
+      {
+         if (j)
+            *out++ = '_';
+         bench_add_cond(&out);
+      }
+
+      for (j = 0; j < groups; j++)
+      {
+         unsigned k;
+         unsigned alt = 1 + bench_rand() % 3;
+
+         for (k = 0; k < alt; k++)
+         {
+            *out++ = k ? '_' : 'S';
+            bench_add_cond(&out);
+         }
+      }
+
+      out += sprintf(out, "\",\"Title\":\"Cheevo %u\",\"Description\":\"d\","
+            "\"Points\":5,\"Author\":\"a\",\"Modified\":1,\"Created\":1,"
+            "\"BadgeName\":\"0\",\"Flags\":%u}", i + 1, i % 8 ? 3 : 5);
+   }
+
+   sprintf(out, "],\"Leaderboards\":[]}}");
+   return json;
+}
+
+/* A game frame: counters tick, a few bytes of state move. */
+static void bench_run_frame(void)
+{
+   unsigned i;
+   uint32_t timer = bench_ram[0] | bench_ram[1] << 8
+      | bench_ram[2] << 16 | (uint32_t)bench_ram[3] << 24;
+
+   timer++;
+   bench_ram[0] = timer;
+   bench_ram[1] = timer >> 8;
+   bench_ram[2] = timer >> 16;
+   bench_ram[3] = timer >> 24;
+
+   for (i = 0; i < 48; i++)
+   {
+      unsigned addr = bench_addresses[bench_rand() % BENCH_ADDRESSES];
+      bench_ram[addr] = bench_rand() % 16;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   retro_time_t start, batch, total, best;
+   unsigned count  = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000;
+   unsigned frames = argc > 2 ? strtoul(argv[2], NULL, 10) : 5000;
+   unsigned conds  = 0;
+   char *json      = NULL;
+
+   for (i = 0; i < BENCH_ADDRESSES; i++)
+      bench_addresses[i] = 4 + bench_rand() % (BENCH_RAM_SIZE - 0x1000 - 8);
+
+   if (!count || !(json = bench_make_json(count)))
+   {
+      fprintf(stderr, "Usage: %s [achievements] [frames]\n", argv[0]);
+      return 1;
+   }
+
+   cheevos_locals.meminfo[0].id   = RETRO_MEMORY_SYSTEM_RAM;
+   cheevos_locals.meminfo[0].data = bench_ram;
+   cheevos_locals.meminfo[0].size = BENCH_RAM_SIZE;
+   bench_settings.bools.cheevos_test_unofficial = true;
+
+   if (cheevos_parse(json))
+   {
+      fprintf(stderr, "Failed to load the synthetic set.\n");
+      return 1;
+   }
+
+   cheevos_loaded = true;
+
+   for (i = 0; i < cheevos_locals.core.count; i++)
+   {
+      unsigned j;
+      const cheevos_condition_t *condition = &cheevos_locals.core.cheevos[i].condition;
+
+      for (j = 0; j < condition->count; j++)
+         conds += condition->condsets[j].count;
+   }
+
+   for (i = 0; i < cheevos_locals.unofficial.count; i++)
+   {
+      unsigned j;
+      const cheevos_condition_t *condition = &cheevos_locals.unofficial.cheevos[i].condition;
+
+      for (j = 0; j < condition->count; j++)
+         conds += condition->condsets[j].count;
+   }
+
+   total = 0;
+   batch = 0;
+   best  = 0;
+   for (bench_frame = 0; bench_frame < frames; bench_frame++)
+   {
+      retro_time_t time;
+
+      bench_run_frame();
+
+      start  = cpu_features_get_time_usec();
+      cheevos_test();
+      time   = cpu_features_get_time_usec() - start;
+      total += time;
+      batch += time;
+
+      if ((bench_frame + 1) % BENCH_BATCH == 0)
+      {
+         if (!best || batch < best)
+            best = batch;
+         batch = 0;
+      }
+   }
+
+   if (!best)
+      best = batch * BENCH_BATCH / (frames ? frames : 1);
+
+   printf("%u achievements (%u core, %u unofficial), %u conditions, %u frames: "
+         "%.2f us/frame, best %.2f us/frame, %u awarded, award sum %llu\n",
+         cheevos_locals.core.count + cheevos_locals.unofficial.count,
+         cheevos_locals.core.count, cheevos_locals.unofficial.count,
+         conds, frames, (double)total / frames, (double)best / BENCH_BATCH,
+         bench_awards, (unsigned long long)bench_award_sum);
+
+   cheevos_unload();
+   free(json);
+   return 0;
+}
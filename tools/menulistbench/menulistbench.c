@@ -0,0 +1,206 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Counts the heap traffic of the menu's file lists. Each step does
+ * what a navigation step does to them: the list is cleared and
+ * refilled, every entry gets its alt, and the selection is
+ * deep-copied the way XMB caches it. A few entries then get their
+ * sublabel and label rewritten with strings of varying length, as
+ * happens when values are edited, both on the refilled list and on
+ * one that is filled once and stays open. The allocator is wrapped
+ * at link time, so the counts are those of the real list code; the
+ * first step is left out as it only warms up the lists. Live heap
+ * bytes are reported at the end, and don't grow with the number of
+ * steps if overwrites are bounded.
+ * Usage: menulistbench [entries] [steps] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lists/file_list.h>
+
+#define BENCH_UPDATES 16
+
+/* A header in front of each block keeps its size. */
+#define BENCH_HEADER 16
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static unsigned long bench_allocs;
+static unsigned long long bench_bytes;
+static size_t bench_live;
+
+void *__wrap_malloc(size_t size)
+{
+   char *ptr = (char*)__real_malloc(size + BENCH_HEADER);
+
+   if (!ptr)
+      return NULL;
+
+   *(size_t*)ptr = size;
+   bench_allocs++;
+   bench_bytes  += size;
+   bench_live   += size;
+   return ptr + BENCH_HEADER;
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+   void *ptr = __wrap_malloc(count * size);
+
+   if (ptr)
+      memset(ptr, 0, count * size);
+   return ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+   char *block = (char*)ptr - BENCH_HEADER;
+
+   if (!ptr)
+      return;
+
+   bench_live -= *(size_t*)block;
+   __real_free(block);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   char *block = NULL;
+
+   if (!ptr)
+      return __wrap_malloc(size);
+
+   block       = (char*)ptr - BENCH_HEADER;
+   bench_live -= *(size_t*)block;
+   block       = (char*)__real_realloc(block, size + BENCH_HEADER);
+
+   if (!block)
+      return NULL;
+
+   *(size_t*)block = size;
+   bench_allocs++;
+   bench_bytes    += size;
+   bench_live     += size;
+   return block + BENCH_HEADER;
+}
+
+char *__wrap_strdup(const char *str)
+{
+   size_t len = strlen(str) + 1;
+   char *ptr  = (char*)__wrap_malloc(len);
+
+   if (ptr)
+      memcpy(ptr, str, len);
+   return ptr;
+}
+
+static void bench_fill(file_list_t *list, unsigned entries)
+{
+   unsigned i;
+   char path[64];
+   char label[64];
+
+   file_list_clear(list);
+
+   for (i = 0; i < entries; i++)
+   {
+      snprintf(path,  sizeof(path),  "Some Game Title (Rev %u).zip", i);
+      snprintf(label, sizeof(label), "content_entry_%u", i);
+      file_list_append(list, path, label, 0, 0, i);
+      file_list_set_alt_at_offset(list, i, path);
+   }
+}
+
+static void bench_update(file_list_t *list, unsigned entries, unsigned step)
+{
+   unsigned i;
+   char str[96];
+
+   for (i = 0; i < BENCH_UPDATES; i++)
+   {
+      unsigned idx = (step * 7 + i * 131) % entries;
+
+      snprintf(str, sizeof(str), "Current value: %.*s",
+            (int)((step + i) % 48), "0123456789abcdef0123456789abcdef0123456789abcdef");
+      file_list_set_alt_at_offset(list, idx, str);
+   }
+
+   snprintf(str, sizeof(str), "renamed_%u_%.*s", step,
+         (int)(step % 24), "xxxxxxxxxxxxxxxxxxxxxxxx");
+   file_list_set_label_at_offset(list, step % entries, str);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned step;
+   unsigned long allocs;
+   unsigned long long bytes;
+   size_t live_first          = 0;
+   unsigned entries           = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+   unsigned steps             = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+   file_list_t *list          = (file_list_t*)calloc(1, sizeof(*list));
+   file_list_t *copy          = (file_list_t*)calloc(1, sizeof(*copy));
+   file_list_t *open          = (file_list_t*)calloc(1, sizeof(*open));
+
+   if (!entries || steps < 2 || !list || !copy || !open)
+   {
+      fprintf(stderr, "Usage: %s [entries] [steps]\n", argv[0]);
+      return 1;
+   }
+
+   bench_fill(open, entries);
+
+   allocs = 0;
+   bytes  = 0;
+
+   for (step = 0; step < steps; step++)
+   {
+      if (step == 1)
+      {
+         allocs = bench_allocs;
+         bytes  = bench_bytes;
+      }
+
+      bench_fill(list, entries);
+      file_list_copy(list, copy);
+      bench_update(list, entries, step);
+
+      bench_update(open, entries, step);
+
+      if (step == 1)
+         live_first = bench_live;
+   }
+
+   allocs = bench_allocs - allocs;
+   bytes  = bench_bytes  - bytes;
+
+   printf("%u entries, %u steps: %.1f allocations/step, %.0f bytes/step, "
+         "live %lu bytes after step 2, %lu bytes at the end\n",
+         entries, steps, (double)allocs / (steps - 1),
+         (double)bytes / (steps - 1),
+         (unsigned long)live_first, (unsigned long)bench_live);
+
+   file_list_free(list);
+   file_list_free(copy);
+   file_list_free(open);
+
+   if (bench_live)
+      printf("%lu bytes still live after freeing the lists\n",
+            (unsigned long)bench_live);
+   return 0;
+}
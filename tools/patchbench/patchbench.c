@@ -0,0 +1,351 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Times soft-patching on synthetic translation patches: a source image
+ * of the given size, and a target that keeps most of it but rewrites
+ * text, fills padding and moves blocks around, the way translation
+ * patches for CD images do. Each target is encoded as a BPS and a UPS
+ * patch. Each patch is applied to a separate buffer, then written out
+ * and applied by patch_content() over a copy of the source the way
+ * content loading does, and the result is checked against the target.
+ * The first target has the size of the source and only copies blocks
+ * forward, so both patches apply in place; the second one grows and
+ * copies blocks back, so they have to go to a new buffer.
+ * Usage: patchbench [size_in_MB] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+
+#include "../../tasks/task_patch.c"
+
+#include "bench.h"
+
+#define BENCH_PATCH_PATH "patchbench.tmp"
+
+struct bench_buffer
+{
+   uint8_t *data;
+   size_t size;
+   size_t capacity;
+};
+
+static void bench_put(struct bench_buffer *buf, const void *data, size_t len)
+{
+   if (buf->size + len > buf->capacity)
+   {
+      while (buf->size + len > buf->capacity)
+         buf->capacity = buf->capacity ? buf->capacity * 2 : 65536;
+      buf->data = (uint8_t*)realloc(buf->data, buf->capacity);
+      if (!buf->data)
+      {
+         fprintf(stderr, "Out of memory.\n");
+         exit(1);
+      }
+   }
+
+   memcpy(buf->data + buf->size, data, len);
+   buf->size += len;
+}
+
+static void bench_put_byte(struct bench_buffer *buf, uint8_t data)
+{
+   bench_put(buf, &data, 1);
+}
+
+static void bench_put_number(struct bench_buffer *buf, uint64_t data)
+{
+   for (;;)
+   {
+      uint8_t x = data & 0x7f;
+
+      data >>= 7;
+      if (!data)
+      {
+         bench_put_byte(buf, x | 0x80);
+         break;
+      }
+      bench_put_byte(buf, x);
+      data--;
+   }
+}
+
+static void bench_put_le32(struct bench_buffer *buf, uint32_t data)
+{
+   uint8_t bytes[4];
+
+   bytes[0] = data;
+   bytes[1] = data >> 8;
+   bytes[2] = data >> 16;
+   bytes[3] = data >> 24;
+   bench_put(buf, bytes, 4);
+}
+
+static void bench_put_bps_offset(struct bench_buffer *buf,
+      size_t *base, size_t offset)
+{
+   if (offset >= *base)
+      bench_put_number(buf, (uint64_t)(offset - *base) << 1);
+   else
+      bench_put_number(buf, ((uint64_t)(*base - offset) << 1) | 1);
+   *base = offset;
+}
+
+/* Builds the target along with its BPS patch, one action at a time. */
+static void bench_make_target(const uint8_t *source, size_t source_size,
+      size_t target_size, bool copy_back,
+      uint8_t *target, struct bench_buffer *bps)
+{
+   size_t out           = 0;
+   size_t source_offset = 0;
+   size_t target_offset = 0;
+
+   bench_put(bps, "BPS1", 4);
+   bench_put_number(bps, source_size);
+   bench_put_number(bps, target_size);
+   bench_put_number(bps, 0);
+
+   while (out < target_size)
+   {
+      unsigned kind = bench_rand() % 16;
+      size_t length = 0;
+      size_t i;
+
+      if (kind < 12 && out < source_size)
+      {
+         /* Untouched data. */
+         length = 16384 + bench_rand() % 49152;
+         if (length > source_size - out)
+            length = source_size - out;
+         if (length > target_size - out)
+            length = target_size - out;
+         memcpy(target + out, source + out, length);
+         bench_put_number(bps, ((uint64_t)(length - 1) << 2) | SOURCE_READ);
+      }
+      else if (kind < 14)
+      {
+         /* Rewritten text. */
+         length = 64 + bench_rand() % 960;
+         if (length > target_size - out)
+            length = target_size - out;
+         for (i = 0; i < length; i++)
+            target[out + i] = 0x20 + bench_rand() % 0x60;
+         bench_put_number(bps, ((uint64_t)(length - 1) << 2) | TARGET_READ);
+         bench_put(bps, target + out, length);
+      }
+      else if (kind == 14)
+      {
+         /* Padding: a short pattern, then a run repeating it. */
+         size_t period = 1 + bench_rand() % 4;
+
+         length = period + 256 + bench_rand() % 3840;
+         if (length > target_size - out)
+            length = target_size - out;
+         if (period > length)
+            period = length;
+         for (i = 0; i < period; i++)
+            target[out + i] = bench_rand();
+         for (; i < length; i++)
+            target[out + i] = target[out + i - period];
+         bench_put_number(bps, ((uint64_t)(period - 1) << 2) | TARGET_READ);
+         bench_put(bps, target + out, period);
+         if (length > period)
+         {
+            bench_put_number(bps,
+                  ((uint64_t)(length - period - 1) << 2) | TARGET_COPY);
+            bench_put_bps_offset(bps, &target_offset, out);
+            target_offset += length - period;
+         }
+      }
+      else
+      {
+         /* A block moved from elsewhere in the source. */
+         size_t from;
+
+         length = 1024 + bench_rand() % 15360;
+         if (length > target_size - out)
+            length = target_size - out;
+         if (length > source_size)
+            length = source_size;
+
+         if (copy_back)
+            from = bench_rand() % (source_size - length + 1);
+         else if (out + length < source_size)
+            from = out + bench_rand() % (source_size - length - out + 1);
+         else
+            continue;
+
+         memcpy(target + out, source + from, length);
+         bench_put_number(bps, ((uint64_t)(length - 1) << 2) | SOURCE_COPY);
+         bench_put_bps_offset(bps, &source_offset, from);
+         source_offset += length;
+      }
+
+      out += length;
+   }
+
+   bench_put_le32(bps, encoding_crc32(0, source, source_size));
+   bench_put_le32(bps, encoding_crc32(0, target, target_size));
+   bench_put_le32(bps, encoding_crc32(0, bps->data, bps->size));
+}
+
+static void bench_make_ups(const uint8_t *source, size_t source_size,
+      const uint8_t *target, size_t target_size, struct bench_buffer *ups)
+{
+   size_t i;
+   size_t last = 0;
+   size_t size = source_size > target_size ? source_size : target_size;
+
+   bench_put(ups, "UPS1", 4);
+   bench_put_number(ups, source_size);
+   bench_put_number(ups, target_size);
+
+   for (i = 0; i < size; i++)
+   {
+      uint8_t s = i < source_size ? source[i] : 0;
+      uint8_t t = i < target_size ? target[i] : 0;
+
+      if (s == t)
+         continue;
+
+      bench_put_number(ups, i - last);
+
+      for (; i < size; i++)
+      {
+         s = i < source_size ? source[i] : 0;
+         t = i < target_size ? target[i] : 0;
+         bench_put_byte(ups, s ^ t);
+         if (s == t)
+            break;
+      }
+
+      if (i == size)
+         bench_put_byte(ups, 0);
+      last = i + 1;
+   }
+
+   bench_put_le32(ups, encoding_crc32(0, source, source_size));
+   bench_put_le32(ups, encoding_crc32(0, target, target_size));
+   bench_put_le32(ups, encoding_crc32(0, ups->data, ups->size));
+}
+
+static void bench_apply(const char *name, patch_func_t func,
+      const struct bench_buffer *patch,
+      const uint8_t *source, size_t source_size,
+      const uint8_t *target, size_t target_size)
+{
+   enum patch_error err;
+   retro_time_t start, total;
+   ssize_t content_size;
+   bool intact;
+   size_t length    = target_size;
+   bool is_bps      = func == bps_apply_patch;
+   uint8_t *work    = (uint8_t*)malloc(
+         (source_size > target_size ? source_size : target_size) + 1);
+   uint8_t *content = work;
+
+   if (!work)
+      return;
+
+   start = cpu_features_get_time_usec();
+   err   = func(patch->data, patch->size, source, source_size, work, &length);
+   total = cpu_features_get_time_usec() - start;
+
+   printf("%s, new buffer  : %8.2f ms, %7.1f MB/s, %s\n",
+         name, total / 1000.0, total ? (double)target_size / total : 0.0,
+         err != PATCH_SUCCESS ? "failed"
+         : (length == target_size && !memcmp(work, target, target_size))
+         ? "matches" : "differs");
+
+   /* Content loading reads the patch from disk, then patches over the
+    * content itself when the target fits in it. */
+   if (!filestream_write_file(BENCH_PATCH_PATH, patch->data, patch->size))
+   {
+      fprintf(stderr, "Failed to write \"%s\".\n", BENCH_PATCH_PATH);
+      free(work);
+      return;
+   }
+
+   memcpy(work, source, source_size);
+   content_size = source_size;
+
+   start  = cpu_features_get_time_usec();
+   intact = patch_content(false, is_bps, !is_bps, NULL,
+         is_bps ? BENCH_PATCH_PATH : NULL,
+         is_bps ? NULL : BENCH_PATCH_PATH,
+         &content, &content_size);
+   total  = cpu_features_get_time_usec() - start;
+
+   printf("%s, content load: %8.2f ms, %7.1f MB/s, %s, %s\n",
+         name, total / 1000.0, total ? (double)target_size / total : 0.0,
+         content == work ? "in place" : "new buffer",
+         !intact ? "failed"
+         : ((size_t)content_size == target_size
+            && !memcmp(content, target, target_size))
+         ? "matches" : "differs");
+
+   if (content != work)
+      free(content);
+   free(work);
+   remove(BENCH_PATCH_PATH);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i;
+   size_t source_size = (argc > 1 ? strtoul(argv[1], NULL, 10) : 64) << 20;
+   uint8_t *source    = (uint8_t*)malloc(source_size);
+   uint8_t *target    = (uint8_t*)malloc(source_size + (source_size >> 3));
+
+   if (!source || !target || !source_size)
+   {
+      fprintf(stderr, "Usage: %s [size_in_MB]\n", argv[0]);
+      return 1;
+   }
+
+   for (i = 0; i < source_size; i++)
+      source[i] = bench_rand();
+
+   for (i = 0; i < 2; i++)
+   {
+      struct bench_buffer bps = {0};
+      struct bench_buffer ups = {0};
+      bool copy_back          = i == 1;
+      size_t target_size      = copy_back
+         ? source_size + (source_size >> 3) : source_size;
+
+      bench_make_target(source, source_size, target_size,
+            copy_back, target, &bps);
+      bench_make_ups(source, source_size, target, target_size, &ups);
+
+      printf("%s target, %u -> %u bytes, BPS patch %u bytes, UPS patch %u bytes\n",
+            copy_back ? "grown" : "same size",
+            (unsigned)source_size, (unsigned)target_size,
+            (unsigned)bps.size, (unsigned)ups.size);
+
+      bench_apply("BPS", bps_apply_patch, &bps,
+            source, source_size, target, target_size);
+      bench_apply("UPS", ups_apply_patch, &ups,
+            source, source_size, target, target_size);
+
+      free(bps.data);
+      free(ups.data);
+   }
+
+   free(source);
+   free(target);
+   return 0;
+}
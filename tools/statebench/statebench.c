@@ -0,0 +1,300 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Saves and loads savestates through the save and load task handlers,
+ * once raw and once compressed, the way the task queue runs them, and
+ * reports the file size and time of each and their ratios. Loaded
+ * states are checked against the saved ones.
+ * Pass raw savestates written by cores to get figures per core; with
+ * none, synthetic states laid out like those of a few kinds of core
+ * are used.
+ * Usage: statebench [state_file ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../tasks/task_save.c"
+
+#include "bench.h"
+
+#define BENCH_TEMP_PATH "statebench.tmp"
+
+enum bench_fill
+{
+   BENCH_FILL_ZERO = 0,
+   /* Mostly small values and repeated words: work RAM, tables, code. */
+   BENCH_FILL_SPARSE,
+   /* Smooth 16-bit gradients: frame and texture buffers. */
+   BENCH_FILL_IMAGE,
+   /* Incompressible: sample data, already compressed assets. */
+   BENCH_FILL_NOISE
+};
+
+struct bench_region
+{
+   enum bench_fill fill;
+   size_t size;
+};
+
+struct bench_core
+{
+   const char *name;
+   struct bench_region regions[6];
+};
+
+static const struct bench_core bench_cores[] = {
+   { "synthetic 16-bit console", {
+      { BENCH_FILL_SPARSE,  128 << 10 },
+      { BENCH_FILL_IMAGE,    64 << 10 },
+      { BENCH_FILL_NOISE,    64 << 10 },
+      { BENCH_FILL_ZERO,     32 << 10 } } },
+   { "synthetic 32-bit disc console", {
+      { BENCH_FILL_SPARSE,    1 << 20 },
+      { BENCH_FILL_ZERO,      1 << 20 },
+      { BENCH_FILL_IMAGE,     1 << 20 },
+      { BENCH_FILL_NOISE,   512 << 10 },
+      { BENCH_FILL_ZERO,    512 << 10 } } },
+   { "synthetic 64-bit console", {
+      { BENCH_FILL_SPARSE,    3 << 20 },
+      { BENCH_FILL_IMAGE,     2 << 20 },
+      { BENCH_FILL_ZERO,      3 << 20 },
+      { BENCH_FILL_NOISE,     1 << 20 },
+      { BENCH_FILL_ZERO,      8 << 20 } } },
+};
+
+static settings_t bench_settings;
+
+/* Stand-ins for the rest of the frontend. */
+const char *file_path_str(enum file_path_enum enum_idx) { return ""; }
+bool fill_pathname_application_data(char *s, size_t len) { return false; }
+settings_t *config_get_ptr(void) { return &bench_settings; }
+bool rarch_ctl(enum rarch_ctl_state state, void *data) { return false; }
+bool core_get_memory(retro_ctx_memory_info_t *info) { return false; }
+bool core_serialize(retro_ctx_serialize_info_t *info) { return false; }
+bool core_unserialize(retro_ctx_serialize_info_t *info) { return false; }
+bool core_serialize_size(retro_ctx_size_info_t *info) { return false; }
+bool video_driver_cached_frame_has_valid_framebuffer(void) { return false; }
+
+bool take_screenshot(const char *path, bool silence,
+      bool has_valid_framebuffer)
+{
+   return false;
+}
+
+static uint8_t *bench_make_state(const struct bench_core *core, size_t *size)
+{
+   unsigned i;
+   size_t pos    = 0;
+   uint8_t *data = NULL;
+
+   *size = 0;
+   for (i = 0; i < ARRAY_SIZE(core->regions); i++)
+      *size += core->regions[i].size;
+
+   if (!(data = (uint8_t*)calloc(1, *size)))
+      return NULL;
+
+   for (i = 0; i < ARRAY_SIZE(core->regions); i++)
+   {
+      size_t j;
+      const struct bench_region *region = &core->regions[i];
+      uint8_t *out                      = data + pos;
+
+      switch (region->fill)
+      {
+         case BENCH_FILL_SPARSE:
+            for (j = 0; j < region->size; j++)
+            {
+               uint32_t r = bench_rand();
+
+               if (r % 8 == 0)
+                  out[j] = r >> 8;
+               else if (r % 8 < 3 && j >= 4)
+                  out[j] = out[j - 4];
+               else
+                  out[j] = (r >> 8) % 4;
+            }
+            break;
+         case BENCH_FILL_IMAGE:
+            for (j = 0; j + 1 < region->size; j += 2)
+            {
+               unsigned x = (unsigned)(j / 2) % 320;
+               unsigned y = (unsigned)(j / 2) / 320;
+               unsigned c = ((x / 4) & 0x1f) | (((y / 4) & 0x3f) << 5)
+                  | ((((x + y) / 16) & 0x1f) << 11);
+
+               if (bench_rand() % 16 == 0)
+                  c ^= bench_rand() & 0x0421;
+               out[j]     = c;
+               out[j + 1] = c >> 8;
+            }
+            break;
+         case BENCH_FILL_NOISE:
+            for (j = 0; j < region->size; j++)
+               out[j] = bench_rand();
+            break;
+         case BENCH_FILL_ZERO:
+            break;
+      }
+
+      pos += region->size;
+   }
+
+   return data;
+}
+
+/* Runs a task handler until the task is done, like the task queue
+ * does, and returns the time taken. */
+static retro_time_t bench_run_task(retro_task_t *task,
+      void (*handler)(retro_task_t *task))
+{
+   retro_time_t start = cpu_features_get_time_usec();
+
+   while (!task->finished)
+      handler(task);
+
+   return cpu_features_get_time_usec() - start;
+}
+
+static bool bench_save(const uint8_t *data, size_t size, bool compress,
+      retro_time_t *time, ssize_t *file_size)
+{
+   retro_task_t task;
+   save_task_state_t *state = (save_task_state_t*)calloc(1, sizeof(*state));
+   void *copy               = malloc(size);
+   bool ret;
+
+   if (!state || !copy)
+   {
+      free(state);
+      free(copy);
+      return false;
+   }
+
+   memcpy(copy, data, size);
+   memset(&task, 0, sizeof(task));
+
+   strlcpy(state->path, BENCH_TEMP_PATH, sizeof(state->path));
+   state->data     = copy;
+   state->size     = size;
+   state->compress = compress;
+   task.state      = state;
+
+   *time      = bench_run_task(&task, task_save_handler);
+   ret        = !task.error;
+   *file_size = path_get_size(BENCH_TEMP_PATH);
+
+   free(task.task_data);
+   free(task.error);
+   free(task.title);
+   return ret;
+}
+
+static bool bench_load(const uint8_t *data, size_t size, retro_time_t *time)
+{
+   retro_task_t task;
+   load_task_data_t *result = NULL;
+   save_task_state_t *state = (save_task_state_t*)calloc(1, sizeof(*state));
+   bool ret;
+
+   if (!state)
+      return false;
+
+   memset(&task, 0, sizeof(task));
+   strlcpy(state->path, BENCH_TEMP_PATH, sizeof(state->path));
+   task.state = state;
+
+   *time  = bench_run_task(&task, task_load_handler);
+   result = (load_task_data_t*)task.task_data;
+   ret    = !task.error && result && result->data
+      && result->size == (ssize_t)size
+      && !memcmp(result->data, data, size);
+
+   if (result)
+      free(result->data);
+   free(result);
+   free(task.error);
+   free(task.title);
+   return ret;
+}
+
+static void bench_state(const char *name, const uint8_t *data, size_t size)
+{
+   unsigned pass;
+   retro_time_t save_time[2];
+   retro_time_t load_time[2];
+   ssize_t file_size[2];
+   bool ok[2];
+
+   for (pass = 0; pass < 2; pass++)
+   {
+      ok[pass] = bench_save(data, size, pass == 1,
+            &save_time[pass], &file_size[pass])
+         && bench_load(data, size, &load_time[pass]);
+
+      printf("%s, %s: %10ld bytes, save %8.2f ms, load %8.2f ms, %s\n",
+            name, pass ? "compressed" : "raw       ",
+            (long)file_size[pass],
+            save_time[pass] / 1000.0, load_time[pass] / 1000.0,
+            ok[pass] ? "matches" : "failed");
+   }
+
+   if (ok[0] && ok[1])
+      printf("%s: size %.3f, save time %.2f, load time %.2f\n",
+            name, (double)file_size[1] / file_size[0],
+            save_time[0] ? (double)save_time[1] / save_time[0] : 0.0,
+            load_time[0] ? (double)load_time[1] / load_time[0] : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+
+   if (argc > 1)
+   {
+      for (i = 1; i < argc; i++)
+      {
+         void *data  = NULL;
+         ssize_t len = 0;
+
+         if (!filestream_read_file(argv[i], &data, &len) || len <= 0)
+         {
+            fprintf(stderr, "Failed to read %s.\n", argv[i]);
+            free(data);
+            continue;
+         }
+
+         bench_state(path_basename(argv[i]), (const uint8_t*)data, len);
+         free(data);
+      }
+   }
+   else
+   {
+      for (i = 0; i < (int)ARRAY_SIZE(bench_cores); i++)
+      {
+         size_t size   = 0;
+         uint8_t *data = bench_make_state(&bench_cores[i], &size);
+
+         if (!data)
+            continue;
+
+         bench_state(bench_cores[i].name, data, size);
+         free(data);
+      }
+   }
+
+   remove(BENCH_TEMP_PATH);
+   return 0;
+}